@@ -19,6 +19,7 @@
 #include "rzip.h"
 #include <zlib.h>
 
+#include <algorithm>
 #include <cstring>
 
 const u8 RZipHeader[8] = { '#', 'R', 'Z', 'I', 'P', 'v', 1, '#' };
@@ -164,3 +165,208 @@ size_t RZipFile::Write(const void *data, size_t length)
 	
 	return rv;
 }
+
+RZipParallelWriter::~RZipParallelWriter()
+{
+	Close();
+	for (std::thread& thread : workers)
+		thread.join();
+}
+
+bool RZipParallelWriter::Open(const std::string& path, bool append)
+{
+	verify(file == nullptr);
+
+	file = nowide::fopen(path.c_str(), append ? "r+b" : "wb");
+	if (file == nullptr)
+		return false;
+	bool success;
+	if (append)
+	{
+		u8 header[sizeof(RZipHeader)];
+		u32 chunkSize;
+		success = std::fread(header, sizeof(header), 1, file) == 1
+				&& memcmp(header, RZipHeader, sizeof(header)) == 0
+				&& std::fread(&chunkSize, sizeof(chunkSize), 1, file) == 1
+				&& chunkSize == maxChunkSize
+				&& std::fread(&size, sizeof(size), 1, file) == 1
+				&& std::fseek(file, 0, SEEK_END) == 0;
+	}
+	else
+	{
+		success = std::fwrite(RZipHeader, sizeof(RZipHeader), 1, file) == 1
+				&& std::fwrite(&maxChunkSize, sizeof(maxChunkSize), 1, file) == 1
+				&& std::fwrite(&size, sizeof(size), 1, file) == 1;
+	}
+	if (!success)
+	{
+		std::fclose(file);
+		file = nullptr;
+		size = 0;
+		return false;
+	}
+	const int threads = std::clamp((int)std::thread::hardware_concurrency() - 1, 1, 8);
+	// Limits memory usage when data is produced faster than it can be compressed
+	maxChunks = threads * 2 + 1;
+	activeWorkers = threads;
+	for (int i = 0; i < threads; i++)
+		workers.emplace_back(&RZipParallelWriter::workerThread, this);
+
+	return true;
+}
+
+void RZipParallelWriter::Close(Callback callback)
+{
+	std::unique_lock<std::mutex> lock(mutex);
+	if (closing)
+		return;
+	closing = true;
+	if (workers.empty())
+	{
+		// Open failed
+		finished = true;
+		lock.unlock();
+		if (callback)
+			callback(false);
+		return;
+	}
+	this->callback = callback;
+	lock.unlock();
+	workCond.notify_all();
+}
+
+void RZipParallelWriter::Wait()
+{
+	std::unique_lock<std::mutex> lock(mutex);
+	verify(closing);
+	doneCond.wait(lock, [this]() { return finished; });
+}
+
+void RZipParallelWriter::Write(const void *data, size_t length)
+{
+	const u8 *p = (const u8 *)data;
+	while (length > 0)
+	{
+		size_t l = std::min(length, (size_t)maxChunkSize);
+		u8 *block = allocBlock();
+		memcpy(block, p, l);
+		writeBlock(block, l);
+		p += l;
+		length -= l;
+	}
+}
+
+u8 *RZipParallelWriter::allocBlock()
+{
+	std::unique_lock<std::mutex> lock(mutex);
+	verify(current == nullptr);
+	chunkCond.wait(lock, [this]() { return !freeChunks.empty() || chunks.size() < maxChunks; });
+	if (freeChunks.empty())
+	{
+		chunks.push_back(std::make_unique<Chunk>());
+		current = chunks.back().get();
+		current->data.reset(new u8[maxChunkSize]);
+		// compression output buffer must be 0.1% larger + 12 bytes
+		current->zipped.reset(new u8[maxChunkSize + maxChunkSize / 1000 + 12]);
+	}
+	else
+	{
+		current = freeChunks.back();
+		freeChunks.pop_back();
+	}
+	return current->data.get();
+}
+
+void RZipParallelWriter::writeBlock(u8 *block, size_t size)
+{
+	std::unique_lock<std::mutex> lock(mutex);
+	verify(current != nullptr && block == current->data.get());
+	Chunk *chunk = current;
+	current = nullptr;
+	if (size == 0)
+	{
+		freeChunks.push_back(chunk);
+		return;
+	}
+	chunk->size = (u32)size;
+	this->size += size;
+	toCompress.push_back(chunk);
+	toWrite.push_back(chunk);
+	lock.unlock();
+	workCond.notify_one();
+}
+
+void RZipParallelWriter::workerThread()
+{
+	std::unique_lock<std::mutex> lock(mutex);
+	while (true)
+	{
+		workCond.wait(lock, [this]() { return !toCompress.empty() || closing; });
+		if (toCompress.empty())
+			break;
+		Chunk *chunk = toCompress.front();
+		toCompress.pop_front();
+		lock.unlock();
+
+		uLongf zippedSize = maxChunkSize + maxChunkSize / 1000 + 12;
+		int rc = compress(chunk->zipped.get(), &zippedSize, chunk->data.get(), chunk->size);
+
+		lock.lock();
+		if (rc != Z_OK)
+		{
+			WARN_LOG(SAVESTATE, "Compression error: %d", rc);
+			error = true;
+		}
+		chunk->zippedSize = (u32)zippedSize;
+		chunk->compressed = true;
+		writeChunks(lock);
+	}
+	// The last worker completes the file
+	if (--activeWorkers == 0)
+		finish(lock);
+}
+
+void RZipParallelWriter::writeChunks(std::unique_lock<std::mutex>& lock)
+{
+	// Chunks must be written in order, by one thread at a time
+	while (!writing && !toWrite.empty() && toWrite.front()->compressed)
+	{
+		Chunk *chunk = toWrite.front();
+		toWrite.pop_front();
+		writing = true;
+		bool success = !error;
+		lock.unlock();
+
+		if (success)
+			success = std::fwrite(&chunk->zippedSize, sizeof(chunk->zippedSize), 1, file) == 1
+					&& std::fwrite(chunk->zipped.get(), chunk->zippedSize, 1, file) == 1;
+
+		lock.lock();
+		writing = false;
+		if (!success)
+			error = true;
+		chunk->compressed = false;
+		freeChunks.push_back(chunk);
+		chunkCond.notify_one();
+	}
+}
+
+void RZipParallelWriter::finish(std::unique_lock<std::mutex>& lock)
+{
+	bool success = !error;
+	lock.unlock();
+
+	if (success)
+	{
+		std::fseek(file, sizeof(RZipHeader) + sizeof(maxChunkSize), SEEK_SET);
+		success = std::fwrite(&size, sizeof(size), 1, file) == 1;
+	}
+	success = std::fclose(file) == 0 && success;
+	file = nullptr;
+	if (callback)
+		callback(success);
+
+	lock.lock();
+	finished = true;
+	doneCond.notify_all();
+}
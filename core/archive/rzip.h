@@ -21,6 +21,15 @@
 
 #pragma once
 #include "types.h"
+#include "serialize.h"
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
 
 class RZipFile
 {
@@ -43,3 +52,63 @@ private:
 	u32 chunkIndex = 0;
 	bool write = false;
 };
+
+// Writes an RZIP stream as it is produced. Chunks are compressed in parallel on worker threads
+// and written in order. Close() returns immediately and the completion callback is called
+// from a worker thread once the file is complete.
+class RZipParallelWriter : public Serializer::Stream
+{
+public:
+	using Callback = std::function<void(bool success)>;
+
+	~RZipParallelWriter();
+
+	// Appends to an existing RZIP stream if append is true
+	bool Open(const std::string& path, bool append = false);
+	void Close(Callback callback = nullptr);
+	// Waits until the file is completely written
+	void Wait();
+	// Compresses and writes a buffer. The last chunk is flushed even if not full.
+	void Write(const void *data, size_t length);
+	size_t ChunkSize() const { return maxChunkSize; }
+	// Uncompressed size of the stream
+	u64 Size() const { return size; }
+
+	u8 *allocBlock() override;
+	void writeBlock(u8 *block, size_t size) override;
+
+private:
+	struct Chunk
+	{
+		std::unique_ptr<u8[]> data;
+		u32 size = 0;
+		std::unique_ptr<u8[]> zipped;
+		u32 zippedSize = 0;
+		bool compressed = false;
+	};
+
+	void workerThread();
+	void writeChunks(std::unique_lock<std::mutex>& lock);
+	void finish(std::unique_lock<std::mutex>& lock);
+
+	FILE *file = nullptr;
+	u64 size = 0;
+	const u32 maxChunkSize = 1024 * 1024;
+	std::vector<std::thread> workers;
+	int activeWorkers = 0;
+	std::vector<std::unique_ptr<Chunk>> chunks;
+	size_t maxChunks = 0;
+	std::vector<Chunk *> freeChunks;
+	Chunk *current = nullptr;
+	std::deque<Chunk *> toCompress;
+	std::deque<Chunk *> toWrite;
+	bool writing = false;
+	bool closing = false;
+	bool finished = false;
+	bool error = false;
+	Callback callback;
+	std::mutex mutex;
+	std::condition_variable workCond;
+	std::condition_variable chunkCond;
+	std::condition_variable doneCond;
+};
@@ -7,6 +7,7 @@
 
 #include "cfg/cfg.h"
 #include "stdclass.h"
+#include "deltastate.h"
 
 static int setconfig(char *arg[], int cl)
 {
@@ -80,6 +81,8 @@ static int showhelp()
 	printf("-config	section:key=value     add a virtual config value;\n");
 	printf("                              virtual config values won't be saved to the .cfg file\n");
 	printf("                              unless a different value is written to them\n");
+	printf("-verifystate FILE             check all the states of an incremental savestate\n");
+	printf("-unpackstate FILE OUT         save the last state of an incremental savestate to OUT\n");
 	printf("-help                         display this help\n");
 
 	exit(0);
@@ -97,6 +100,14 @@ void ParseCommandLine(int argc,char* argv[])
 		{
 			showhelp();
 		}
+		else if ((stricmp(*arg, "-verifystate") == 0 || stricmp(*arg, "--verifystate") == 0) && cl >= 1)
+		{
+			exit(deltastate::verifyTool(arg[1], ""));
+		}
+		else if ((stricmp(*arg, "-unpackstate") == 0 || stricmp(*arg, "--unpackstate") == 0) && cl >= 2)
+		{
+			exit(deltastate::verifyTool(arg[1], arg[2]));
+		}
 		else if (stricmp(*arg,"-config")==0 || stricmp(*arg,"--config")==0)
 		{
 			int as=setconfig(arg,cl);
@@ -25,6 +25,10 @@ namespace config {
 // Dynarec
 
 Option<bool> DynarecEnabled("Dynarec.Enabled", true);
+Option<bool> DynarecPersistentCache("Dynarec.PersistentCache", false);
+Option<bool> DynarecAsyncCompile("Dynarec.AsyncCompile", false);
+Option<bool> DynarecTraceCompile("Dynarec.TraceCompile", false);
+Option<bool> DynarecMmuMirror("Dynarec.MmuMirror", false);
 Option<int> Sh4Clock("Sh4Clock", 200);
 
 // General
@@ -36,6 +40,10 @@ Option<int> Language("Dreamcast.Language", 1);		// English
 Option<bool> ForceWindowsCE("Dreamcast.ForceWindowsCE");
 Option<bool> AutoLoadState("Dreamcast.AutoLoadState");
 Option<bool> AutoSaveState("Dreamcast.AutoSaveState");
+Option<bool> IncrementalSavestates("Dreamcast.IncrementalSavestates");
+Option<bool> Rewind("Dreamcast.Rewind");
+Option<int> RewindInterval("Dreamcast.RewindInterval", 2);
+Option<int> RewindBufferSize("Dreamcast.RewindBufferSize", 64);
 Option<int, false> SavestateSlot("Dreamcast.SavestateSlot");
 Option<bool> ForceFreePlay("ForceFreePlay", true);
 Option<bool, false> FetchBoxart("FetchBoxart", true);
@@ -44,6 +52,7 @@ Option<bool, false> BoxartDisplayMode("BoxartDisplayMode", true);
 // Sound
 
 Option<bool> DSPEnabled("aica.DSPEnabled", false);
+Option<bool> BatchAudioRendering("aica.BatchRendering", false);
 #if HOST_CPU == CPU_ARM
 Option<int> AudioBufferSize("aica.BufferSize", 5644);	// 128 ms
 #else
@@ -68,6 +77,7 @@ Option<bool> UseMipmaps("rend.UseMipmaps", true);
 Option<bool> Widescreen("rend.WideScreen");
 Option<bool> SuperWidescreen("rend.SuperWideScreen");
 Option<bool> ShowFPS("rend.ShowFPS");
+Option<bool> ShowTextureStats("rend.ShowTextureStats");
 Option<bool> RenderToTextureBuffer("rend.RenderToTextureBuffer");
 Option<bool> TranslucentPolygonDepthMask("rend.TranslucentPolygonDepthMask");
 Option<bool> ModifierVolumes("rend.ModifierVolumes", true);
@@ -76,6 +86,8 @@ Option<int> MaxFilteredTextureSize("rend.MaxFilteredTextureSize", 256);
 Option<float> ExtraDepthScale("rend.ExtraDepthScale", 1.f);
 Option<bool> CustomTextures("rend.CustomTextures");
 Option<bool> DumpTextures("rend.DumpTextures");
+Option<bool> StrictTextureUpdates("rend.StrictTextureUpdates", true);
+Option<int> TextureCacheBudget("rend.TextureCacheBudget", 512);
 Option<int> ScreenStretching("rend.ScreenStretching", 100);
 Option<bool> Fog("rend.Fog", true);
 Option<bool> FloatVMUs("rend.FloatVMUs");
@@ -116,6 +128,7 @@ Option<int> GDBPort("Debug.GDBPort", debugger::DEFAULT_PORT);
 Option<bool> GDBWaitForConnection("Debug.GDBWaitForConnection");
 Option<bool> UseReios("UseReios");
 Option<bool> FastGDRomLoad("FastGDRomLoad", false);
+Option<bool> NaomiDimmCache("NaomiDimmCache", false);
 
 Option<bool> OpenGlChecks("OpenGlChecks", false, "validate");
 
@@ -356,6 +356,10 @@ using OptionString = Option<std::string>;
 // Dynarec
 
 extern Option<bool> DynarecEnabled;
+extern Option<bool> DynarecPersistentCache;
+extern Option<bool> DynarecAsyncCompile;
+extern Option<bool> DynarecTraceCompile;
+extern Option<bool> DynarecMmuMirror;
 #ifndef LIBRETRO
 extern Option<int> Sh4Clock;
 #endif
@@ -369,6 +373,10 @@ extern Option<int> Language;	// 0 -> JP, 1 -> EN, 2 -> DE, 3 -> FR, 4 -> SP, 5 -
 extern Option<bool> ForceWindowsCE;
 extern Option<bool> AutoLoadState;
 extern Option<bool> AutoSaveState;
+extern Option<bool> IncrementalSavestates;
+extern Option<bool> Rewind;
+extern Option<int> RewindInterval;
+extern Option<int> RewindBufferSize;
 extern Option<int, false> SavestateSlot;
 extern Option<bool> ForceFreePlay;
 extern Option<bool, false> FetchBoxart;
@@ -378,6 +386,7 @@ extern Option<bool, false> BoxartDisplayMode;
 
 constexpr bool LimitFPS = true;
 extern Option<bool> DSPEnabled;
+extern Option<bool> BatchAudioRendering;
 extern Option<int> AudioBufferSize;	//In samples ,*4 for bytes
 extern Option<bool> AutoLatency;
 
@@ -433,6 +442,7 @@ extern Option<bool> UseMipmaps;
 extern Option<bool> Widescreen;
 extern Option<bool> SuperWidescreen;
 extern Option<bool> ShowFPS;
+extern Option<bool> ShowTextureStats;
 extern Option<bool> RenderToTextureBuffer;
 extern Option<bool> TranslucentPolygonDepthMask;
 extern Option<bool> ModifierVolumes;
@@ -445,6 +455,8 @@ extern Option<int> PerPixelLayers;
 extern Option<float> ExtraDepthScale;
 extern Option<bool> CustomTextures;
 extern Option<bool> DumpTextures;
+extern Option<bool> StrictTextureUpdates;
+extern Option<int> TextureCacheBudget;	// in MB, 0 means unlimited
 extern Option<int> ScreenStretching;	// in percent. 150 means stretch from 4/3 to 6/3
 extern Option<bool> Fog;
 extern Option<bool> FloatVMUs;
@@ -475,6 +487,7 @@ extern Option<int> GDBPort;
 extern Option<bool> GDBWaitForConnection;
 extern Option<bool> UseReios;
 extern Option<bool> FastGDRomLoad;
+extern Option<bool> NaomiDimmCache;
 
 extern Option<bool> OpenGlChecks;
 
@@ -357,6 +357,13 @@ static void vblankCallback(Event event, void *param)
 	((CheatManager *)param)->apply();
 }
 
+CheatManager::~CheatManager()
+{
+	// Don't leave a dangling vblank listener
+	if (active || widescreen_cheat != nullptr)
+		EventManager::unlisten(Event::VBlank, vblankCallback, this);
+}
+
 void CheatManager::setActive(bool active)
 {
 	this->active = active;
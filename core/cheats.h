@@ -71,6 +71,7 @@ struct Cheat
 class CheatManager
 {
 public:
+	~CheatManager();
 	void reset(const std::string& gameId);
 	void apply();
 	size_t cheatCount() const { return cheats.size(); }
@@ -0,0 +1,307 @@
+/*
+	Copyright 2026 flyinghead
+
+	This file is part of Flycast.
+
+    Flycast is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 2 of the License, or
+    (at your option) any later version.
+
+    Flycast is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Flycast.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#include "deltastate.h"
+#include "serialize.h"
+#include "archive/rzip.h"
+#include <xxhash.h>
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+
+namespace deltastate
+{
+
+constexpr u32 Magic = 0x54534446;	// FDST
+// Start a new base after this many deltas
+constexpr u32 MaxDeltas = 64;
+
+static u64 hash(const std::vector<u8>& state) {
+	return XXH64(state.data(), state.size(), 7);
+}
+
+// Serializes to a growing buffer
+class VectorStream : public Serializer::Stream
+{
+public:
+	VectorStream(std::vector<u8>& data) : data(data) {}
+
+	u8 *allocBlock() override
+	{
+		size_t offset = data.size();
+		data.resize(offset + BlockSize);
+		return &data[offset];
+	}
+
+	void writeBlock(u8 *block, size_t size) override {
+		data.resize(block - data.data() + size);
+	}
+
+	static constexpr size_t BlockSize = 1024 * 1024;
+
+private:
+	std::vector<u8>& data;
+};
+
+void serialize(std::vector<u8>& state, bool rollback)
+{
+	state.clear();
+	VectorStream stream(state);
+	Serializer ser(stream, VectorStream::BlockSize, rollback);
+	dc_serialize(ser);
+	ser.flush();
+}
+
+bool isDeltaState(const void *data, size_t size)
+{
+	u32 magic;
+	if (size < sizeof(Record))
+		return false;
+	memcpy(&magic, data, sizeof(magic));
+	return magic == Magic;
+}
+
+static Record makeHeader(RecordType type, const std::vector<u8>& state)
+{
+	Record header;
+	header.magic = Magic;
+	header.type = type;
+	header.stateSize = (u32)state.size();
+	header.pageCount = 0;
+	header.hash = hash(state);
+	return header;
+}
+
+void makeDelta(const std::vector<u8>& previous, const std::vector<u8>& state, std::vector<u8>& record)
+{
+	Record header = makeHeader(Delta, state);
+	record.resize(sizeof(Record));
+	for (size_t offset = 0; offset < state.size(); offset += PageSize)
+	{
+		const size_t len = std::min<size_t>(PageSize, state.size() - offset);
+		if (offset + len <= previous.size() && memcmp(&state[offset], &previous[offset], len) == 0)
+			continue;
+		const u32 index = (u32)(offset / PageSize);
+		const u8 *p = (const u8 *)&index;
+		record.insert(record.end(), p, p + sizeof(index));
+		record.insert(record.end(), &state[offset], &state[offset] + len);
+		header.pageCount++;
+	}
+	memcpy(record.data(), &header, sizeof(header));
+}
+
+bool apply(const u8 *&p, const u8 *end, std::vector<u8>& state, Record *record)
+{
+	Record header;
+	if ((size_t)(end - p) < sizeof(header))
+		return false;
+	memcpy(&header, p, sizeof(header));
+	if (header.magic != Magic)
+		return false;
+	const u8 *data = p + sizeof(header);
+	switch (header.type)
+	{
+	case Base:
+		if ((size_t)(end - data) < header.stateSize)
+			return false;
+		state.assign(data, data + header.stateSize);
+		data += header.stateSize;
+		break;
+
+	case Delta:
+		state.resize(header.stateSize);
+		for (u32 i = 0; i < header.pageCount; i++)
+		{
+			u32 index;
+			if ((size_t)(end - data) < sizeof(index))
+				return false;
+			memcpy(&index, data, sizeof(index));
+			data += sizeof(index);
+			const size_t offset = (size_t)index * PageSize;
+			if (offset >= state.size())
+				return false;
+			const size_t len = std::min<size_t>(PageSize, state.size() - offset);
+			if ((size_t)(end - data) < len)
+				return false;
+			memcpy(&state[offset], data, len);
+			data += len;
+		}
+		break;
+
+	default:
+		return false;
+	}
+	if (hash(state) != header.hash)
+		return false;
+	p = data;
+	if (record != nullptr)
+		*record = header;
+	return true;
+}
+
+bool restore(const u8 *data, size_t size, std::vector<u8>& state, Info *info)
+{
+	const u8 *p = data;
+	const u8 *end = data + size;
+	Info stats;
+	Record record;
+	if (!apply(p, end, state, &record) || record.type != Base)
+		return false;
+	while (p < end)
+	{
+		const u8 *start = p;
+		if (!apply(p, end, state, &record))
+			return false;
+		if (record.type == Base)
+			stats = Info();
+		else
+		{
+			stats.deltas++;
+			stats.deltaSize += p - start;
+		}
+	}
+	stats.size = size;
+	if (info != nullptr)
+		*info = stats;
+	return true;
+}
+
+std::unique_ptr<RZipParallelWriter> Chain::save(const std::string& path, std::vector<u8>& state)
+{
+	std::unique_ptr<RZipParallelWriter> writer = std::make_unique<RZipParallelWriter>();
+	bool delta = false;
+	if (path == this->path && !last.empty() && info.deltas < MaxDeltas)
+	{
+		makeDelta(last, state, record);
+		// Compaction: start a new base once the deltas get larger than half a full state
+		delta = info.deltaSize + record.size() <= state.size() / 2
+				// the file must not have been modified since the last save
+				&& writer->Open(path, true);
+		if (delta && writer->Size() != info.size)
+		{
+			WARN_LOG(SAVESTATE, "Savestate %s has been modified. Saving a full state", path.c_str());
+			writer = std::make_unique<RZipParallelWriter>();
+			delta = false;
+		}
+	}
+	if (delta)
+	{
+		writer->Write(record.data(), record.size());
+		info.deltas++;
+		info.deltaSize += record.size();
+	}
+	else
+	{
+		if (!writer->Open(path))
+		{
+			reset();
+			return nullptr;
+		}
+		Record header = makeHeader(Base, state);
+		writer->Write(&header, sizeof(header));
+		writer->Write(state.data(), state.size());
+		info = Info();
+	}
+	info.size = writer->Size();
+	this->path = path;
+	std::swap(last, state);
+
+	return writer;
+}
+
+void Chain::loaded(const std::string& path, std::vector<u8>& state, const Info& info)
+{
+	this->path = path;
+	this->info = info;
+	std::swap(last, state);
+}
+
+void Chain::reset()
+{
+	path.clear();
+	last.clear();
+	last.shrink_to_fit();
+	info = Info();
+}
+
+int verifyTool(const std::string& path, const std::string& outPath)
+{
+	RZipFile zipFile;
+	if (!zipFile.Open(path, false))
+	{
+		fprintf(stderr, "%s: not a savestate\n", path.c_str());
+		return 1;
+	}
+	std::vector<u8> data(zipFile.Size());
+	if (zipFile.Read(data.data(), data.size()) != data.size())
+	{
+		fprintf(stderr, "%s: I/O or decompression error\n", path.c_str());
+		return 1;
+	}
+	zipFile.Close();
+
+	std::vector<u8> state;
+	if (!isDeltaState(data.data(), data.size()))
+	{
+		printf("%s: full savestate, %d bytes\n", path.c_str(), (int)data.size());
+		std::swap(state, data);
+	}
+	else
+	{
+		const u8 *p = data.data();
+		const u8 *end = p + data.size();
+		for (int i = 0; p < end; i++)
+		{
+			const u8 *start = p;
+			Record record;
+			if (!apply(p, end, state, &record) || (i == 0 && record.type != Base))
+			{
+				fprintf(stderr, "#%d: invalid or corrupted record at offset %d\n", i, (int)(start - data.data()));
+				return 1;
+			}
+			if (record.type == Base)
+				printf("#%d: base   %d bytes\n", i, (int)record.stateSize);
+			else
+				printf("#%d: delta  %d bytes, %d pages changed, record %d bytes\n", i, (int)record.stateSize,
+						(int)record.pageCount, (int)(p - start));
+		}
+	}
+	try {
+		Deserializer deser(state.data(), state.size());
+		printf("Savestate version %d OK\n", deser.version());
+	} catch (const Deserializer::Exception& e) {
+		fprintf(stderr, "Invalid savestate: %s\n", e.what());
+		return 1;
+	}
+
+	if (!outPath.empty())
+	{
+		RZipFile out;
+		if (!out.Open(outPath, true) || out.Write(state.data(), state.size()) != state.size())
+		{
+			fprintf(stderr, "%s: write error\n", outPath.c_str());
+			return 1;
+		}
+		out.Close();
+		printf("Full savestate written to %s\n", outPath.c_str());
+	}
+	return 0;
+}
+
+}
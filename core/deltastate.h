@@ -0,0 +1,96 @@
+/*
+	Copyright 2026 flyinghead
+
+	This file is part of Flycast.
+
+    Flycast is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 2 of the License, or
+    (at your option) any later version.
+
+    Flycast is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Flycast.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#pragma once
+#include "types.h"
+
+#include <memory>
+#include <string>
+#include <vector>
+
+class RZipParallelWriter;
+
+//
+// Incremental savestates.
+// A full state (base) is followed by deltas holding only the pages of the state that changed since the previous save.
+// Savestate files are still RZIP streams: each delta is appended to the file as new RZIP chunks.
+//
+namespace deltastate
+{
+
+constexpr u32 PageSize = 4096;
+
+enum RecordType : u32 {
+	Base,
+	Delta
+};
+
+struct Record
+{
+	u32 magic;
+	RecordType type;
+	u32 stateSize;	// size of the full state once the record is applied
+	u32 pageCount;	// number of pages in a delta
+	u64 hash;		// hash of the full state once the record is applied
+};
+
+struct Info
+{
+	u32 deltas = 0;		// number of deltas since the last base
+	u64 deltaSize = 0;	// total size of these deltas
+	u64 size = 0;		// size of the stream
+};
+
+// Serializes the current emulator state
+void serialize(std::vector<u8>& state, bool rollback = false);
+
+// Returns true if the data starts with an incremental savestate record
+bool isDeltaState(const void *data, size_t size);
+
+// Encodes the pages of state that differ from previous as a delta record
+void makeDelta(const std::vector<u8>& previous, const std::vector<u8>& state, std::vector<u8>& record);
+// Applies the record at p to state and advances p. Returns false if the record is invalid or its hash doesn't match.
+bool apply(const u8 *&p, const u8 *end, std::vector<u8>& state, Record *record = nullptr);
+
+// Applies all the records and returns the last full state
+bool restore(const u8 *data, size_t size, std::vector<u8>& state, Info *info = nullptr);
+
+// Keeps the last saved state of a file to write the next save as a delta
+class Chain
+{
+public:
+	// Opens path and writes state to it, either as a delta or as a new base when the deltas get too large.
+	// state is swapped with the previous state. The caller closes the returned writer.
+	std::unique_ptr<RZipParallelWriter> save(const std::string& path, std::vector<u8>& state);
+	// state has been loaded from path. It is swapped with the previous state.
+	void loaded(const std::string& path, std::vector<u8>& state, const Info& info);
+	void reset();
+	const Info& getInfo() const { return info; }
+
+private:
+	std::string path;
+	std::vector<u8> last;
+	Info info;
+	std::vector<u8> record;
+};
+
+// Command line tool: reconstructs and verifies all the states of a file.
+// The last full state is written to outPath as a regular savestate if not empty.
+int verifyTool(const std::string& path, const std::string& outPath);
+
+}
@@ -36,6 +36,7 @@
 #include "hw/arm7/arm7_rec.h"
 #include "network/ggpo.h"
 #include "hw/mem/mem_watch.h"
+#include "rewind.h"
 #include "network/net_handshake.h"
 #include "rend/gui.h"
 #include "network/naomi_network.h"
@@ -404,6 +405,7 @@ void dc_reset(bool hard)
 		NetworkHandshake::term();
 		memwatch::unprotect();
 		memwatch::reset();
+		rewindBuffer.reset();
 	}
 	sh4_sched_reset(hard);
 	pvr::reset(hard);
@@ -412,7 +414,7 @@ void dc_reset(bool hard)
 	mem_Reset(hard);
 }
 
-static void setPlatform(int platform)
+void setPlatform(int platform)
 {
 	if (VRAM_SIZE != 0)
 		addrspace::unprotectVram(0, VRAM_SIZE);
@@ -660,6 +662,7 @@ void Emulator::runInternal()
 	{
 		do {
 			resetRequested = false;
+			rewindFrame = false;
 
 			sh4_cpu.Run();
 
@@ -668,7 +671,11 @@ void Emulator::runInternal()
 				nvmem::saveFiles();
 				dc_reset(false);
 			}
-		} while (resetRequested);
+			else if (rewindFrame && state == Running)
+			{
+				rewindBuffer.update();
+			}
+		} while (resetRequested || (rewindFrame && config::ThreadedRendering && state == Running));
 	}
 }
 
@@ -811,6 +818,7 @@ void dc_loadstate(Deserializer& deser)
 #endif
 	memwatch::unprotect();
 	memwatch::reset();
+	rewindBuffer.reset();
 
 	dc_deserialize(deser);
 
@@ -903,6 +911,7 @@ void Emulator::start()
 		INFO_LOG(DYNAREC, "Using Interpreter");
 	}
 
+	rewindBuffer.start();
 	memwatch::protect();
 
 	if (config::ThreadedRendering)
@@ -989,6 +998,13 @@ bool Emulator::render()
 void Emulator::vblank()
 {
 	EventManager::event(Event::VBlank);
+	if (rewindBuffer.vblank())
+	{
+		// Capture or restore a state at the end of this frame
+		rewindFrame = true;
+		if (config::ThreadedRendering)
+			sh4_cpu.Stop();
+	}
 	// Time out if a frame hasn't been rendered for 50 ms
 	if (sh4_sched_now64() - startTime <= 10000000)
 		return;
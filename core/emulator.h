@@ -33,9 +33,11 @@ void SaveSettings();
 
 int flycast_init(int argc, char* argv[]);
 void dc_reset(bool hard); // for tests only
+void setPlatform(int platform); // for tests only
 void flycast_term();
 void dc_exit();
 void dc_savestate(int index = 0);
+void dc_waitSavestate();
 void dc_loadstate(int index = 0);
 void dc_loadstate(Deserializer& deser);
 
@@ -172,6 +174,7 @@ private:
 	State state = Uninitialized;
 	std::future<void> threadResult;
 	bool resetRequested = false;
+	bool rewindFrame = false;
 	bool singleStep = false;
 	u64 startTime = 0;
 	bool renderTimeout = false;
@@ -97,6 +97,8 @@ const int AICA_TICK = 145125;	// 44.1 KHz / 32
 static int AicaUpdate(int tag, int c, int j)
 {
 	arm::run(32);
+	// The sh4 may access sample RAM before the next update
+	sgc::flushSamples();
 
 	return AICA_TICK;
 }
@@ -122,6 +124,7 @@ static void AicaInternalDMA()
 {
 	if (!CommonData->DEXE)
 		return;
+	sgc::flushSamples();
 
 	// Start dma
 	DEBUG_LOG(AICA, "AICA internal DMA: DGATE %d DDIR %d DLG %x", CommonData->DGATE, CommonData->DDIR, CommonData->DLG);
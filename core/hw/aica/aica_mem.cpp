@@ -22,6 +22,9 @@ template<typename T>
 T readRegInternal(u32 addr)
 {
 	addr &= 0x7FFF;
+	// Channel, common and DSP registers must be up to date
+	if (addr < 0x2818 || addr >= 0x3000)
+		sgc::flushSamples();
 
 	if (addr >= 0x2800 && addr < 0x2818)
 	{
@@ -90,6 +93,9 @@ void writeRegInternal(u32 addr, T data)
 {
 	constexpr size_t sz = sizeof(T);
 	addr &= 0x7FFF;
+	// Queued samples are rendered with the previous register values
+	if (addr < 0x2818 || addr >= 0x3000)
+		sgc::flushSamples();
 
 	if (addr < 0x2000)
 	{
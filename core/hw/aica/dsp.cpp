@@ -24,19 +24,15 @@ namespace dsp
 
 DSPState state;
 
+// Number of leading zeros of a 12-bit value, used by PACK
+static u8 PackExponent[4096];
+
 //float format is ?
 u16 DYNACALL PACK(s32 val)
 {
 	int sign = (val >> 23) & 0x1;
 	u32 temp = (val ^ (val << 1)) & 0xFFFFFF;
-	int exponent = 0;
-	for (int k = 0; k < 12; k++)
-	{
-		if (temp & 0x800000)
-			break;
-		temp <<= 1;
-		exponent += 1;
-	}
+	int exponent = PackExponent[temp >> 12];
 	if (exponent < 12)
 		val <<= exponent;
 	else
@@ -67,6 +63,17 @@ s32 DYNACALL UNPACK(u16 val)
 	return uval;
 }
 
+static void initPackTable()
+{
+	for (u32 i = 0; i < std::size(PackExponent); i++)
+	{
+		int exponent = 0;
+		for (u32 bit = 0x800; bit != 0 && (i & bit) == 0; bit >>= 1)
+			exponent++;
+		PackExponent[i] = exponent;
+	}
+}
+
 void DecodeInst(const u32 *IPtr, Instruction *i)
 {
 	i->TRA = (IPtr[0] >> 9) & 0x7F;
@@ -98,17 +105,6 @@ void DecodeInst(const u32 *IPtr, Instruction *i)
 	i->NXADR = IPtr[3] & 0x80;
 }
 
-#if FEAT_DSPREC == DYNAREC_NONE
-void recInit() {
-}
-
-void recTerm() {
-}
-
-void recompile() {
-}
-#endif
-
 void init()
 {
 	memset(&state, 0, sizeof(state));
@@ -117,6 +113,7 @@ void init()
 	state.MDEC_CT = 1;
 	state.dirty = true;
 
+	initPackTable();
 	recInit();
 }
 
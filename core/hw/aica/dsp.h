@@ -54,6 +54,8 @@ struct DSPState
 		deser >> MDEC_CT;
 		deser.skip(33596 - 4096 * 8 - sizeof(TEMP) - sizeof(MEMS) - sizeof(MIXS) - 4 * 3 - 44,
 				Deserializer::V18);	// other dsp stuff
+		// The program is restored with the aica registers
+		dirty = true;
 	}
 };
 
@@ -19,6 +19,81 @@ namespace aica
 namespace dsp
 {
 
+// Instruction decoded by recompile()
+struct DecodedInstruction
+{
+	Instruction op;
+	u32 step;
+	bool nop;			// empty instruction
+	bool accUsed;		// the ACC result is read by the next instruction
+	bool shiftedUsed;	// SHIFTED is needed by this instruction
+	bool memAccess;		// MRD or MWT on an odd step
+	const s32 *inputs;	// INPUTS source, or nullptr if unused
+	u32 inputShift;
+};
+
+static DecodedInstruction program[128];
+static u32 programSize;
+static const s32 NoInput = 0;
+
+void recInit() {
+}
+
+void recTerm() {
+}
+
+// Decodes the program once and removes the instructions that have no effect:
+// an empty instruction only sets ACC, which is only read by the next instruction.
+void recompile()
+{
+	DecodedInstruction decoded[128];
+	for (u32 step = 0; step < 128; step++)
+	{
+		DecodedInstruction& ins = decoded[step];
+		const u32 *IPtr = DSPData->MPRO + step * 4;
+		DecodeInst(IPtr, &ins.op);
+		const Instruction& op = ins.op;
+		ins.step = step;
+		ins.nop = IPtr[0] == 0 && IPtr[1] == 0 && IPtr[2] == 0 && IPtr[3] == 0;
+		ins.memAccess = (step & 1) && (op.MRD || op.MWT);
+		ins.shiftedUsed = op.TWT || op.FRCL || (ins.memAccess && op.MWT) || (op.ADRL && op.SHIFT == 3) || op.EWT;
+		ins.inputs = nullptr;
+		ins.inputShift = 0;
+		if (op.XSEL || op.YRL || (op.ADRL && op.SHIFT != 3))
+		{
+			if (op.IRA <= 0x1f)
+				ins.inputs = &state.MEMS[op.IRA];
+			else if (op.IRA <= 0x2F)
+			{
+				ins.inputs = &state.MIXS[op.IRA - 0x20];
+				ins.inputShift = 4;		// MIXS is 20 bit
+			}
+			else if (op.IRA <= 0x31)
+			{
+				ins.inputs = (const s32 *)&DSPData->EXTS[op.IRA - 0x30];
+				ins.inputShift = 8;		// EXTS is 16 bits
+			}
+			else
+				ins.inputs = &NoInput;
+		}
+	}
+	programSize = 0;
+	for (u32 step = 0; step < 128; step++)
+	{
+		DecodedInstruction& ins = decoded[step];
+		if (step == 127)
+			ins.accUsed = false;
+		else
+		{
+			const DecodedInstruction& next = decoded[step + 1];
+			ins.accUsed = !next.nop && (next.shiftedUsed || (!next.op.ZERO && next.op.BSEL));
+		}
+		if (!ins.nop || ins.accUsed)
+			program[programSize++] = ins;
+	}
+	DEBUG_LOG(AICA, "DSP program: %d instructions", programSize);
+}
+
 void runStep()
 {
 	if (state.stopped)
@@ -34,15 +109,15 @@ void runStep()
 	s32 FRC_REG = 0;	//13 bit
 	s32 Y_REG = 0;		//24 bit
 	u32 ADRS_REG = 0;	//13 bit
+	const u32 MDEC_CT = state.MDEC_CT;
 
-	for (int step = 0; step < 128; ++step)
+	for (const DecodedInstruction *ins = &program[0]; ins != &program[programSize]; ins++)
 	{
-		u32 *IPtr = DSPData->MPRO + step * 4;
-
-		if (IPtr[0] == 0 && IPtr[1] == 0 && IPtr[2] == 0 && IPtr[3] == 0)
+		const Instruction& op = ins->op;
+		if (ins->nop)
 		{
 			// Empty instruction shortcut
-			X = state.TEMP[state.MDEC_CT & 0x7F];
+			X = state.TEMP[MDEC_CT & 0x7F];
 			Y = FRC_REG;
 
 			ACC = (((s64)X * (s64)Y) >> 12) + X;
@@ -50,167 +125,118 @@ void runStep()
 			continue;
 		}
 
-		u32 TRA = (IPtr[0] >> 9) & 0x7F;
-		bool TWT = IPtr[0] & 0x100;
-
-		bool XSEL = IPtr[1] & 0x8000;
-		u32 YSEL = (IPtr[1] >> 13) & 3;
-		u32 IRA = (IPtr[1] >> 7) & 0x3F;
-		bool IWT = IPtr[1] & 0x40;
-
-		bool EWT = IPtr[2] & 0x1000;
-		bool ADRL = IPtr[2] & 0x80;
-		bool FRCL = IPtr[2] & 0x40;
-		u32 SHIFT = (IPtr[2] >> 4) & 3;
-		bool YRL = IPtr[2] & 8;
-		bool NEGB = IPtr[2] & 4;
-		bool ZERO = IPtr[2] & 2;
-		bool BSEL = IPtr[2] & 1;
-
-		u32 COEF = step;
-
 		// operations are done at 24 bit precision
 
 		// INPUTS RW
-		if (IRA <= 0x1f)
-			INPUTS = state.MEMS[IRA];
-		else if (IRA <= 0x2F)
-			INPUTS = state.MIXS[IRA - 0x20] << 4;		// MIXS is 20 bit
-		else if (IRA <= 0x31)
-			INPUTS = DSPData->EXTS[IRA - 0x30] << 8;	// EXTS is 16 bits
-		else
-			INPUTS = 0;
+		if (ins->inputs != nullptr)
+			INPUTS = *ins->inputs << ins->inputShift;
 
-		if (IWT)
-		{
-			u32 IWA = (IPtr[1] >> 1) & 0x1F;
-			state.MEMS[IWA] = MEMVAL[step & 3];	// MEMVAL was selected in previous MRD
-		}
+		if (op.IWT)
+			state.MEMS[op.IWA] = MEMVAL[ins->step & 3];	// MEMVAL was selected in previous MRD
 
-		// Operand sel
-		// B
-		if (!ZERO)
+		// Y_REG operands are read before YRL
+		if (ins->accUsed)
 		{
-			if (BSEL)
-				B = ACC;
-			else
-				B = state.TEMP[(TRA + state.MDEC_CT) & 0x7F];
-			if (NEGB)
-				B = -B;
-		}
-		else
-		{
-			B = 0;
+			if (op.YSEL == 2)
+				Y = Y_REG >> 11;
+			else if (op.YSEL == 3)
+				Y = (Y_REG >> 4) & 0x0FFF;
 		}
-
-		// X
-		if (XSEL)
-			X = INPUTS;
-		else
-			X = state.TEMP[(TRA + state.MDEC_CT) & 0x7F];
-
-		// Y
-		if (YSEL == 0)
-			Y = FRC_REG;
-		else if (YSEL == 1)
-			Y = ((s32)(s16)DSPData->COEF[COEF]) >> 3;	//COEF is 16 bits
-		else if (YSEL == 2)
-			Y = Y_REG >> 11;
-		else if (YSEL == 3)
-			Y = (Y_REG >> 4) & 0x0FFF;
-
-		if (YRL)
+		if (op.YRL)
 			Y_REG = INPUTS;
 
 		// Shifter
 		// There's a 1-step delay at the output of the X*Y + B adder. So we use the ACC value from the previous step.
-		if (SHIFT == 0 || SHIFT == 3)
-			SHIFTED = ACC;
-		else
-			SHIFTED = ACC << 1;		// x2 scale
+		if (ins->shiftedUsed)
+		{
+			if (op.SHIFT == 0 || op.SHIFT == 3)
+				SHIFTED = ACC;
+			else
+				SHIFTED = ACC << 1;		// x2 scale
 
-		if (SHIFT < 2)
-			SHIFTED = std::min(std::max(SHIFTED, -0x00800000), 0x007FFFFF);
+			if (op.SHIFT < 2)
+				SHIFTED = std::min(std::max(SHIFTED, -0x00800000), 0x007FFFFF);
+		}
 
 		// ACCUM
-		ACC = (((s64)X * (s64)Y) >> 12) + B;
-
-		if (TWT)
+		if (ins->accUsed)
 		{
-			u32 TWA = (IPtr[0] >> 1) & 0x7F;
-			state.TEMP[(TWA + state.MDEC_CT) & 0x7F] = SHIFTED;
+			// Operand sel
+			// B
+			if (!op.ZERO)
+			{
+				if (op.BSEL)
+					B = ACC;
+				else
+					B = state.TEMP[(op.TRA + MDEC_CT) & 0x7F];
+				if (op.NEGB)
+					B = -B;
+			}
+			else
+			{
+				B = 0;
+			}
+
+			// X
+			if (op.XSEL)
+				X = INPUTS;
+			else
+				X = state.TEMP[(op.TRA + MDEC_CT) & 0x7F];
+
+			// Y
+			if (op.YSEL == 0)
+				Y = FRC_REG;
+			else if (op.YSEL == 1)
+				Y = ((s32)(s16)DSPData->COEF[ins->step]) >> 3;	//COEF is 16 bits
+
+			ACC = (((s64)X * (s64)Y) >> 12) + B;
 		}
 
-		if (FRCL)
+		if (op.TWT)
+			state.TEMP[(op.TWA + MDEC_CT) & 0x7F] = SHIFTED;
+
+		if (op.FRCL)
 		{
-			if (SHIFT == 3)
+			if (op.SHIFT == 3)
 				FRC_REG = SHIFTED & 0x0FFF;
 			else
 				FRC_REG = SHIFTED >> 11;
 		}
 
-		if (step & 1)
+		if (ins->memAccess)
 		{
-			bool MWT = IPtr[2] & 0x4000;
-			bool MRD = IPtr[2] & 0x2000;
-
-			if (MRD || MWT)
+			u32 ADDR = DSPData->MADRS[op.MASA];
+			if (op.ADREB)
+				ADDR += ADRS_REG & 0x0FFF;
+			if (op.NXADR)
+				ADDR++;
+			if (!op.TABLE)
 			{
-				bool TABLE = IPtr[2] & 0x8000;
-
-				//bool NOFL = IPtr[3] & 0x8000;
-				//verify(!NOFL);
-				u32 MASA = (IPtr[3] >> 9) & 0x3f;
-				bool ADREB = IPtr[3] & 0x100;
-				bool NXADR = IPtr[3] & 0x80;
-
-				u32 ADDR = DSPData->MADRS[MASA];
-				if (ADREB)
-					ADDR += ADRS_REG & 0x0FFF;
-				if (NXADR)
-					ADDR++;
-				if (!TABLE)
-				{
-					ADDR += state.MDEC_CT;
-					ADDR &= state.RBL;		// RBL is ring buffer length - 1
-				}
-				else
-					ADDR &= 0xFFFF;
-
-				ADDR <<= 1;					// Word -> byte address
-				ADDR += state.RBP;			// RBP is already a byte address
-				if (MRD)			// memory only allowed on odd. DoA inserts NOPs on even
-				{
-					//if (NOFL)
-					//	MEMVAL[(step + 2) & 3] = (*(s16 *)&aica_ram[ADDR]) << 8;
-					//else
-						MEMVAL[(step + 2) & 3] = UNPACK(*(u16 *)&aica_ram[ADDR & ARAM_MASK]);
-				}
-				if (MWT)
-				{
-					// FIXME We should wait for the next step to copy stuff to SRAM (same as read)
-					//if (NOFL)
-					//	*(s16 *)&aica_ram[ADDR] = SHIFTED >> 8;
-					//else
-						*(u16 *)&aica_ram[ADDR & ARAM_MASK] = PACK(SHIFTED);
-				}
+				ADDR += MDEC_CT;
+				ADDR &= state.RBL;		// RBL is ring buffer length - 1
 			}
+			else
+				ADDR &= 0xFFFF;
+
+			ADDR <<= 1;					// Word -> byte address
+			ADDR += state.RBP;			// RBP is already a byte address
+			if (op.MRD)			// memory only allowed on odd. DoA inserts NOPs on even
+				MEMVAL[(ins->step + 2) & 3] = UNPACK(*(u16 *)&aica_ram[ADDR & ARAM_MASK]);
+			if (op.MWT)
+				// FIXME We should wait for the next step to copy stuff to SRAM (same as read)
+				*(u16 *)&aica_ram[ADDR & ARAM_MASK] = PACK(SHIFTED);
 		}
 
-		if (ADRL)
+		if (op.ADRL)
 		{
-			if (SHIFT == 3)
+			if (op.SHIFT == 3)
 				ADRS_REG = SHIFTED >> 12;
 			else
 				ADRS_REG = INPUTS >> 16;
 		}
 
-		if (EWT)
-		{
-			u32 EWA = (IPtr[2] >> 8) & 0x0F;
-			DSPData->EFREG[EWA] = SHIFTED >> 8;
-		}
-
+		if (op.EWT)
+			DSPData->EFREG[op.EWA] = SHIFTED >> 8;
 	}
 	--state.MDEC_CT;
 	if (state.MDEC_CT == 0)
@@ -94,12 +94,28 @@ public:
 		xor_(ADRS_REG, ADRS_REG);
 		mov(MDEC_CT, dword[rbx + dsp_operand(&DSP->MDEC_CT)]);
 
+		Instruction ops[128];
+		bool nop[128];
 		for (int step = 0; step < 128; ++step)
 		{
 			u32 *mpro = &DSPData->MPRO[step * 4];
-			Instruction op;
-			DecodeInst(mpro, &op);
+			DecodeInst(mpro, &ops[step]);
+			nop[step] = mpro[0] == 0 && mpro[1] == 0 && mpro[2] == 0 && mpro[3] == 0;
+		}
+		for (int step = 0; step < 128; ++step)
+		{
+			const Instruction& op = ops[step];
 			const u32 COEF = step;
+			// ACC is only read by the next instruction, if it needs SHIFTED or if B is ACC.
+			// Empty instructions only set ACC.
+			bool accUsed = false;
+			if (step < 127 && !nop[step + 1])
+			{
+				const Instruction& next = ops[step + 1];
+				accUsed = needsShifted(next) || (!next.ZERO && next.BSEL);
+			}
+			if (nop[step] && !accUsed)
+				continue;
 
 			if (op.XSEL || op.YRL || (op.ADRL && op.SHIFT != 3))
 			{
@@ -133,7 +149,7 @@ public:
 
 			// Operand sel
 			// B
-			if (!op.ZERO)
+			if (accUsed && !op.ZERO)
 			{
 				if (op.BSEL)
 					//B = ACC;
@@ -152,57 +168,60 @@ public:
 					neg(B);
 			}
 
-			// X
 			Xbyak::Reg32 X_alias = X;
-			if (op.XSEL)
-				//X = INPUTS;
-				X_alias = INPUTS;
-			else
+			if (accUsed)
 			{
-				//X = DSP->TEMP[(TRA + DSP->MDEC_CT) & 0x7F];
-				if (!op.ZERO && !op.BSEL && !op.NEGB)
-					X_alias = B;
+				// X
+				if (op.XSEL)
+					//X = INPUTS;
+					X_alias = INPUTS;
 				else
 				{
-					mov(eax, MDEC_CT);
-					if (op.TRA)
-						add(eax, op.TRA);
-					and_(eax, 0x7f);
-					mov(X, dword[rbx + rax * 4]);
+					//X = DSP->TEMP[(TRA + DSP->MDEC_CT) & 0x7F];
+					if (!op.ZERO && !op.BSEL && !op.NEGB)
+						X_alias = B;
+					else
+					{
+						mov(eax, MDEC_CT);
+						if (op.TRA)
+							add(eax, op.TRA);
+						and_(eax, 0x7f);
+						mov(X, dword[rbx + rax * 4]);
+					}
 				}
-			}
 
-			// Y
-			if (op.YSEL == 0)
-			{
-				//Y = FRC_REG;
-				mov(Y, dword[rbx + dsp_operand(&DSP->FRC_REG)]);
-			}
-			else if (op.YSEL == 1)
-			{
-				//Y = DSPData->COEF[COEF] >> 3;	//COEF is 16 bits
-				movsx(Y, word[rbp + dspdata_operand(DSPData->COEF, COEF)]);
-				sar(Y, 3);
-			}
-			else if (op.YSEL == 2)
-			{
-				//Y = Y_REG >> 11;
-				mov(Y, Y_REG);
-				sar(Y, 11);
-			}
-			else if (op.YSEL == 3)
-			{
-				//Y = (Y_REG >> 4) & 0x0FFF;
-				mov(Y, Y_REG);
-				sar(Y, 4);
-				and_(Y, 0x0fff);
+				// Y
+				if (op.YSEL == 0)
+				{
+					//Y = FRC_REG;
+					mov(Y, dword[rbx + dsp_operand(&DSP->FRC_REG)]);
+				}
+				else if (op.YSEL == 1)
+				{
+					//Y = DSPData->COEF[COEF] >> 3;	//COEF is 16 bits
+					movsx(Y, word[rbp + dspdata_operand(DSPData->COEF, COEF)]);
+					sar(Y, 3);
+				}
+				else if (op.YSEL == 2)
+				{
+					//Y = Y_REG >> 11;
+					mov(Y, Y_REG);
+					sar(Y, 11);
+				}
+				else if (op.YSEL == 3)
+				{
+					//Y = (Y_REG >> 4) & 0x0FFF;
+					mov(Y, Y_REG);
+					sar(Y, 4);
+					and_(Y, 0x0fff);
+				}
 			}
 
 			if (op.YRL)
 				//Y_REG = INPUTS;
 				mov(Y_REG, INPUTS);
 
-			if (op.TWT || op.FRCL || op.MWT || (op.ADRL && op.SHIFT == 3) || op.EWT)
+			if (needsShifted(op))
 			{
 				// Shifter
 				// There's a 1-step delay at the output of the X*Y + B adder. So we use the ACC value from the previous step.
@@ -244,15 +263,18 @@ public:
 			}
 
 			// ACCUM
-			//ACC = (((s64)X * (s64)Y) >> 12) + B;
-			const Xbyak::Reg64 Xlong = X_alias.cvt64();
-			movsxd(Xlong, X_alias);
-			movsxd(rax, Y);
-			imul(rax, Xlong);
-			sar(rax, 12);
-			mov(ACC, eax);
-			if (!op.ZERO)
-				add(ACC, B);
+			if (accUsed)
+			{
+				//ACC = (((s64)X * (s64)Y) >> 12) + B;
+				const Xbyak::Reg64 Xlong = X_alias.cvt64();
+				movsxd(Xlong, X_alias);
+				movsxd(rax, Y);
+				imul(rax, Xlong);
+				sar(rax, 12);
+				mov(ACC, eax);
+				if (!op.ZERO)
+					add(ACC, B);
+			}
 
 			if (op.TWT)
 			{
@@ -362,6 +384,10 @@ public:
 	}
 
 private:
+	static bool needsShifted(const Instruction& op) {
+		return op.TWT || op.FRCL || op.MWT || (op.ADRL && op.SHIFT == 3) || op.EWT;
+	}
+
 	ptrdiff_t dsp_operand(void *data, int index = 0, u32 element_size = 4)
 	{
 		return ((u8*)data - (u8*)DSP) - offsetof(DSPState, TEMP) + index  * element_size;
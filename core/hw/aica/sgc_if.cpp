@@ -165,6 +165,12 @@ static int beepPeriod;
 static int beepCounter;
 static SampleType beepValue;
 
+// In batch mode, channels are only rendered every MAX_BATCH_SIZE samples or before their state is accessed.
+// Sample RAM writes by the ARM aren't sync points: pending samples are rendered after the writes,
+// so a channel can read the new data up to MAX_BATCH_SIZE samples early, but never late.
+constexpr u32 MAX_BATCH_SIZE = 32;
+static u32 pendingSamples;
+
 #pragma pack(push, 1)
 //All regs are 16b , aligned to 32b (upper bits 0?)
 struct ChannelCommonData
@@ -564,6 +570,24 @@ struct ChannelEx
 			channel.Step(mixl, mixr);
 	}
 
+	// Renders count samples, or until the channel is disabled
+	void StepBatch(u32 count, SampleType *mixl, SampleType *mixr, s32 (*mixs)[16], bool dspEnabled)
+	{
+		const u32 isel = (u32)(VolMix.DSPOut - dsp::state.MIXS);
+		for (u32 i = 0; i < count && enabled; i++)
+		{
+			SampleType oLeft, oRight, oDsp;
+			Step(oLeft, oRight, oDsp);
+
+			mixs[i][isel] += oDsp;
+			if (oLeft + oRight == 0 && !dspEnabled)
+				oLeft = oRight = oDsp >> 4;
+
+			mixl[i] += oLeft;
+			mixr[i] += oRight;
+		}
+	}
+
 	void SetAegState(_EG_state newstate)
 	{
 		StepAEG=AEG_STEP_LUT[newstate];
@@ -1316,6 +1340,7 @@ void init()
 	beepPeriod = 0;
 	beepCounter = 0;
 	beepValue = 0;
+	pendingSamples = 0;
 
 	dsp::init();
 }
@@ -1429,15 +1454,8 @@ constexpr int CDDA_SIZE = 2352 / 2;
 static s16 cdda_sector[CDDA_SIZE];
 static u32 cdda_index = CDDA_SIZE;
 
-void AICA_Sample()
+static void MixSample(SampleType mixl, SampleType mixr)
 {
-	SampleType mixl,mixr;
-	mixl = 0;
-	mixr = 0;
-	memset(dsp::state.MIXS, 0, sizeof(dsp::state.MIXS));
-
-	ChannelEx::StepAll(mixl,mixr);
-	
 	//OK , generated all Channels  , now DSP/ect + final mix ;p
 	//CDDA EXTS input
 	
@@ -1513,8 +1531,51 @@ void AICA_Sample()
 	WriteSample(mixr,mixl);
 }
 
+void flushSamples()
+{
+	if (pendingSamples == 0)
+		return;
+	const u32 count = pendingSamples;
+	pendingSamples = 0;
+
+	// Each channel is rendered for all the samples in turn
+	SampleType mixl[MAX_BATCH_SIZE] {};
+	SampleType mixr[MAX_BATCH_SIZE] {};
+	s32 mixs[MAX_BATCH_SIZE][16] {};
+	const bool dspEnabled = config::DSPEnabled;
+	for (ChannelEx& channel : Chans)
+		if (channel.enabled)
+			channel.StepBatch(count, mixl, mixr, mixs, dspEnabled);
+
+	for (u32 i = 0; i < count; i++)
+	{
+		memcpy(dsp::state.MIXS, mixs[i], sizeof(dsp::state.MIXS));
+		MixSample(mixl[i], mixr[i]);
+	}
+}
+
+void AICA_Sample()
+{
+	if (config::BatchAudioRendering)
+	{
+		if (++pendingSamples == MAX_BATCH_SIZE)
+			flushSamples();
+		return;
+	}
+	flushSamples();
+
+	SampleType mixl = 0;
+	SampleType mixr = 0;
+	memset(dsp::state.MIXS, 0, sizeof(dsp::state.MIXS));
+
+	ChannelEx::StepAll(mixl, mixr);
+
+	MixSample(mixl, mixr);
+}
+
 void serialize(Serializer& ser)
 {
+	flushSamples();
 	for (const ChannelEx& channel : Chans)
 	{
 		u32 addr = channel.SA - &aica_ram[0];
@@ -1554,6 +1615,7 @@ void serialize(Serializer& ser)
 
 void deserialize(Deserializer& deser)
 {
+	pendingSamples = 0;
 	for (ChannelEx& channel : Chans)
 	{
 		channel.quiet = true;
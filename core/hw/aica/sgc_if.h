@@ -8,6 +8,8 @@ namespace sgc
 {
 
 void AICA_Sample();
+// Renders the samples queued by AICA_Sample in batch mode
+void flushSamples();
 
 void WriteChannelReg(u32 channel, u32 reg, int size);
 
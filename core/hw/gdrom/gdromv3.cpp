@@ -703,6 +703,7 @@ void gd_process_spi_cmd()
 			read_params.sector_type = sector_type;//yeah i know , not really many types supported...
 
 			printf_spicmd("SPI_CD_READ - Sector=%d Size=%d/%d DMA=%d",read_params.start_sector,read_params.remaining_sectors,read_params.sector_type,Features.CDRead.DMA);
+			libGDR_Prefetch(read_params.start_sector, read_params.remaining_sectors, read_params.sector_type);
 			if (Features.CDRead.DMA == 1)
 			{
 				gd_set_state(gds_readsector_dma);
@@ -890,6 +891,8 @@ void gd_process_spi_cmd()
 
 			DEBUG_LOG(GDROM, "CDDA StartAddr=%d EndAddr=%d repeats=%d status=%d CurrAddr=%d",cdda.StartAddr.FAD,
 					cdda.EndAddr.FAD, cdda.repeats, cdda.status, cdda.CurrAddr.FAD);
+			if (cdda.status == cdda_t::Playing && cdda.EndAddr.FAD > cdda.CurrAddr.FAD)
+				libGDR_Prefetch(cdda.CurrAddr.FAD, cdda.EndAddr.FAD - cdda.CurrAddr.FAD, 2352);
 
 			gd_set_state(gds_procpacketdone);
 		}
@@ -520,6 +520,11 @@ void unprotectVram(u32 addr, u32 size)
 	}
 }
 
+bool mapRam(void *dest, u32 addr, u32 size, bool writable)
+{
+	return virtmem::map_window(dest, size, MAP_RAM_START_OFFSET + (addr & RAM_MASK), writable);
+}
+
 u32 getVramOffset(void *addr)
 {
 	if (virtmemEnabled())
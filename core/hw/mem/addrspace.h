@@ -79,6 +79,8 @@ bool bm_lockedWrite(u8* address); // FIXME rename?
 
 void protectVram(u32 addr, u32 size);
 void unprotectVram(u32 addr, u32 size);
+// Maps a range of main RAM at the given address of a virtmem window
+bool mapRam(void *dest, u32 addr, u32 size, bool writable);
 u32 getVramOffset(void *addr);
 
 } // namespace addrspace
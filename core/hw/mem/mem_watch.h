@@ -24,6 +24,7 @@
 #include "hw/pvr/pvr_mem.h"
 #include "hw/pvr/elan.h"
 #include "rend/TexCache.h"
+#include "rewind.h"
 #include <unordered_map>
 
 namespace memwatch
@@ -186,7 +187,7 @@ extern ElanRamWatcher elanWatcher;
 
 inline static bool writeAccess(void *p)
 {
-	if (!config::GGPOEnable)
+	if (!config::GGPOEnable && !rewindBuffer.isActive())
 		return false;
 	if (ramWatcher.hit(p))
 	{
@@ -205,7 +206,7 @@ inline static bool writeAccess(void *p)
 
 inline static void protect()
 {
-	if (!config::GGPOEnable)
+	if (!config::GGPOEnable && !rewindBuffer.isActive())
 		return;
 	vramWatcher.protect();
 	ramWatcher.protect();
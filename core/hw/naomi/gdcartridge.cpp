@@ -14,6 +14,13 @@
 #include "stdclass.h"
 #include "emulator.h"
 #include "oslib/storage.h"
+#include "oslib/oslib.h"
+#include "oslib/virtmem.h"
+#include "cfg/option.h"
+
+#include <atomic>
+#include <thread>
+#include <xxhash.h>
 
 /*
 
@@ -440,13 +447,156 @@ void GDCartridge::read_gdrom(Disc *gdrom, u32 sector, u8* dst, u32 count, LoadPr
 	gdrom->ReadSectors(sector + 150, count, dst, 2048, progress);
 }
 
-void GDCartridge::device_start(LoadProgress *progress, std::vector<u8> *digest)
+void GDCartridge::decrypt(u32 size, const u32 *des_subkeys, LoadProgress *progress)
 {
-	if (dimm_data != NULL)
+	// Each 64-bit block is decrypted independently so the work can be split between threads
+	constexpr u32 ChunkSize = 256 * 1024;
+	const u32 chunks = (size + ChunkSize - 1) / ChunkSize;
+	std::atomic<u32> nextChunk { 0 };
+	std::atomic<u32> doneChunks { 0 };
+	auto decryptChunk = [&](u32 chunk) {
+		const u32 end = std::min(size, (chunk + 1) * ChunkSize);
+		for (u32 i = chunk * ChunkSize; i < end; i += 8)
+			*(u64 *)(dimm_data + i) = des_encrypt_decrypt<true>(*(u64 *)(dimm_data + i), des_subkeys);
+		doneChunks++;
+	};
+	std::vector<std::thread> workers;
+	const int threads = std::clamp((int)std::thread::hardware_concurrency() - 1, 0, 7);
+	for (int i = 0; i < threads && i + 1 < (int)chunks; i++)
+		workers.emplace_back([&]() {
+			for (u32 chunk = nextChunk++; chunk < chunks; chunk = nextChunk++)
+				decryptChunk(chunk);
+		});
+	// The calling thread also reports progress
+	bool cancelled = false;
+	for (u32 chunk = nextChunk++; chunk < chunks; chunk = nextChunk++)
 	{
-		free(dimm_data);
-		dimm_data = NULL;
+		if (progress != nullptr)
+		{
+			if (progress->cancelled)
+			{
+				nextChunk = chunks;
+				cancelled = true;
+				break;
+			}
+			progress->label = "Decrypting...";
+			progress->progress = (float)doneChunks / chunks;
+		}
+		decryptChunk(chunk);
+	}
+	for (std::thread& thread : workers)
+		thread.join();
+	if (cancelled)
+		throw LoadCancelledException();
+}
+
+// Follows the decrypted data in the cache file so that the file can be mapped as is
+#pragma pack(push, 1)
+struct GDCartridge::DimmCacheTrailer
+{
+	u32 magic;
+	u32 version;
+	u64 key;
+	u64 hash;		// of the encrypted data
+	u32 fileStart;
+	u32 fileSize;
+	u32 dimmSize;
+};
+#pragma pack(pop)
+
+constexpr u32 DIMM_CACHE_MAGIC = 0x4d4d4944;	// DIMM
+constexpr u32 DIMM_CACHE_VERSION = 2;
+
+std::string GDCartridge::getDimmCachePath(u64 key) const
+{
+	char keyStr[17];
+	sprintf(keyStr, "%08x%08x", (u32)(key >> 32), (u32)key);
+	std::string name = std::string(gdrom_name) + "_" + keyStr;
+	for (char& c : name)
+		if (!isalnum((u8)c) && c != '-' && c != '_')
+			c = '_';
+	return hostfs::getDimmCachePath(name + ".dimm");
+}
+
+u64 GDCartridge::hashEncryptedData(u64 key, u32 size) const
+{
+	return XXH64(dimm_data, size, key);
+}
+
+// Replaces the encrypted data in dimm_data with the decrypted data from the cache file, if it's valid
+bool GDCartridge::loadDimmCache(u64 key, u64 hash, u32 file_start, u32 file_size)
+{
+	std::string path = getDimmCachePath(key);
+	FILE *f = nowide::fopen(path.c_str(), "rb");
+	if (f == nullptr)
+		return false;
+	DimmCacheTrailer trailer;
+	bool valid = std::fseek(f, dimm_data_size, SEEK_SET) == 0
+			&& std::fread(&trailer, sizeof(trailer), 1, f) == 1
+			&& trailer.magic == DIMM_CACHE_MAGIC
+			&& trailer.version == DIMM_CACHE_VERSION
+			&& trailer.key == key
+			&& trailer.hash == hash
+			&& trailer.fileStart == file_start
+			&& trailer.fileSize == file_size
+			&& trailer.dimmSize == dimm_data_size;
+	u8 *data = valid ? (u8 *)virtmem::map_file(f, dimm_data_size) : nullptr;
+	std::fclose(f);
+	if (!valid)
+	{
+		INFO_LOG(NAOMI, "Ignoring outdated DIMM cache %s", path.c_str());
+		return false;
 	}
+	if (data == nullptr)
+		return false;
+	freeDimmData();
+	dimm_data = data;
+	dimm_data_mapped = true;
+	INFO_LOG(NAOMI, "Decrypted data mapped from %s", path.c_str());
+
+	return true;
+}
+
+void GDCartridge::saveDimmCache(u64 key, u64 hash, u32 file_start, u32 file_size)
+{
+	std::string path = getDimmCachePath(key);
+	FILE *f = nowide::fopen(path.c_str(), "wb");
+	if (f == nullptr)
+	{
+		WARN_LOG(NAOMI, "Can't create DIMM cache %s", path.c_str());
+		return;
+	}
+	DimmCacheTrailer trailer;
+	trailer.magic = DIMM_CACHE_MAGIC;
+	trailer.version = DIMM_CACHE_VERSION;
+	trailer.key = key;
+	trailer.hash = hash;
+	trailer.fileStart = file_start;
+	trailer.fileSize = file_size;
+	trailer.dimmSize = dimm_data_size;
+	bool success = std::fwrite(dimm_data, 1, dimm_data_size, f) == dimm_data_size
+			&& std::fwrite(&trailer, sizeof(trailer), 1, f) == 1;
+	success = std::fclose(f) == 0 && success;
+	if (!success)
+	{
+		WARN_LOG(NAOMI, "Error writing DIMM cache %s", path.c_str());
+		nowide::remove(path.c_str());
+	}
+}
+
+void GDCartridge::freeDimmData()
+{
+	if (dimm_data_mapped)
+		virtmem::unmap_file(dimm_data, dimm_data_size);
+	else
+		free(dimm_data);
+	dimm_data = nullptr;
+	dimm_data_mapped = false;
+}
+
+void GDCartridge::device_start(LoadProgress *progress, std::vector<u8> *digest)
+{
+	freeDimmData();
 	dimm_data_size = 0;
 
 	char name[128];
@@ -576,6 +726,7 @@ void GDCartridge::device_start(LoadProgress *progress, std::vector<u8> *digest)
 			u32 file_rounded_size = (file_size + 2047) & ~2048;
 			for (dimm_data_size = 4096; dimm_data_size < file_rounded_size; dimm_data_size <<= 1)
 				;
+			u32 sectors = file_rounded_size / 2048;
 			dimm_data = (u8 *)malloc(dimm_data_size);
 			if (dimm_data == nullptr)
 				throw NaomiCartException("Memory allocation failed");
@@ -583,24 +734,24 @@ void GDCartridge::device_start(LoadProgress *progress, std::vector<u8> *digest)
 				memset(dimm_data + file_rounded_size, 0, dimm_data_size - file_rounded_size);
 
 			// read encrypted data into dimm_data
-			u32 sectors = file_rounded_size / 2048;
 			read_gdrom(gdrom.get(), file_start, dimm_data, sectors, progress);
 
+			u64 hash = 0;
+			if (config::NaomiDimmCache)
+			{
+				// Only the decryption is skipped: the cache is valid if all the encrypted data is the same
+				hash = hashEncryptedData(key, file_rounded_size);
+				if (loadDimmCache(key, hash, file_start, file_size))
+					return;
+			}
+
 			// decrypt loaded data
 			u32 des_subkeys[32];
 			des_generate_subkeys(rev64(key), des_subkeys);
+			decrypt(file_rounded_size, des_subkeys, progress);
 
-			for (u32 i = 0; i < file_rounded_size; i += 8)
-			{
-				if ((i & 0xfff) == 0 && progress != nullptr)
-				{
-					if (progress->cancelled)
-						throw LoadCancelledException();
-					progress->label = "Decrypting...";
-					progress->progress = (float)(i + 8) / file_rounded_size;
-				}
-				*(u64 *)(dimm_data + i) = des_encrypt_decrypt<true>(*(u64 *)(dimm_data + i), des_subkeys);
-			}
+			if (config::NaomiDimmCache)
+				saveDimmCache(key, hash, file_start, file_size);
 		}
 
 		if (!dimm_data)
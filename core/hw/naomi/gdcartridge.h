@@ -23,7 +23,7 @@ public:
 	}
 	~GDCartridge() override
 	{
-		free(dimm_data);
+		freeDimmData();
 	}
 	void Init(LoadProgress *progress = nullptr, std::vector<u8> *digest = nullptr) override
 	{
@@ -37,16 +37,25 @@ public:
 	void SetGDRomName(const char *name, const char *parentName) { this->gdrom_name = name; this->gdrom_parent_name = parentName; }
 
 protected:
+	u64 hashEncryptedData(u64 key, u32 size) const;
+	std::string getDimmCachePath(u64 key) const;
+	bool loadDimmCache(u64 key, u64 hash, u32 file_start, u32 file_size);
+	void saveDimmCache(u64 key, u64 hash, u32 file_start, u32 file_size);
+
 	u8 *dimm_data = nullptr;
 	u32 dimm_data_size = 0;
 
 private:
 	enum { FILENAME_LENGTH=24 };
 
+	struct DimmCacheTrailer;
+
 	const char *gdrom_name = nullptr;
 	const char *gdrom_parent_name = nullptr;
 
 	u32 dimm_cur_address = 0;
+	// dimm_data is a mapping of the decrypted data cache file
+	bool dimm_data_mapped = false;
 
 	static const u32 DES_LEFTSWAP[];
 	static const u32 DES_RIGHTSWAP[];
@@ -71,6 +80,8 @@ private:
 	u64 des_encrypt_decrypt(u64 src, const u32 *des_subkeys);
 	u64 rev64(u64 src);
 	void read_gdrom(Disc *gdrom, u32 sector, u8* dst, u32 count = 1, LoadProgress *progress = nullptr);
+	void decrypt(u32 size, const u32 *des_subkeys, LoadProgress *progress);
+	void freeDimmData();
 };
 
 #endif /* CORE_HW_NAOMI_GDCARTRIDGE_H_ */
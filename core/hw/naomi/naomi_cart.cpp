@@ -42,6 +42,7 @@
 #include "touchscreen.h"
 #include "printer.h"
 #include "oslib/storage.h"
+#include "oslib/virtmem.h"
 #include "network/alienfnt_modem.h"
 #include "netdimm.h"
 
@@ -486,6 +487,31 @@ static void loadDecryptedRom(const std::string& path, const std::string& fileNam
 
 	MD5Sum md5;
 
+	if (files.size() == 1 && fstart[0] == 0 && files[0] != "null")
+	{
+		// Map the file in memory instead of reading it.
+		// Only the parts being used are loaded and the file isn't modified.
+		std::string filePath = folder.empty() ? files[0] : hostfs::storage().getSubPath(folder, files[0]);
+		FILE *fp = hostfs::storage().openFile(filePath, "rb");
+		if (fp != nullptr)
+		{
+			std::fseek(fp, 0, SEEK_END);
+			u8 *romBase = nullptr;
+			// Accessing a mapped page past the end of the file would crash
+			if ((u32)std::ftell(fp) >= romSize)
+				romBase = (u8 *)virtmem::map_file(fp, romSize);
+			if (romBase != nullptr && config::GGPOEnable)
+				md5.add(fp).getDigest(settings.network.md5.game);
+			std::fclose(fp);
+			if (romBase != nullptr)
+			{
+				DEBUG_LOG(NAOMI, "Legacy ROM mapped successfully");
+				CurrentCartridge = new DecryptedCartridge(romBase, romSize, true);
+				return;
+			}
+		}
+	}
+
 	// Allocate space for the rom
 	u8 *romBase = (u8 *)malloc(romSize);
 	if (romBase == nullptr)
@@ -547,7 +573,7 @@ static void loadDecryptedRom(const std::string& path, const std::string& fileNam
 
 	DEBUG_LOG(NAOMI, "Legacy ROM loaded successfully");
 
-	CurrentCartridge = new DecryptedCartridge(romBase, romSize);
+	CurrentCartridge = new DecryptedCartridge(romBase, romSize, false);
 }
 
 void naomi_cart_LoadRom(const std::string& path, const std::string& fileName, LoadProgress *progress)
@@ -728,17 +754,22 @@ int naomi_cart_GetPlatform(const char *path)
 
 Cartridge::Cartridge(u32 size)
 {
-	RomPtr = (u8 *)malloc(size);
-	if (RomPtr == nullptr)
-		throw NaomiCartException("Memory allocation failed");
+	RomPtr = nullptr;
 	RomSize = size;
 	if (size != 0)
+	{
+		RomPtr = (u8 *)malloc(size);
+		if (RomPtr == nullptr)
+			throw NaomiCartException("Memory allocation failed");
 		memset(RomPtr, 0xFF, RomSize);
+	}
 }
 
 Cartridge::~Cartridge()
 {
-	if (RomPtr != NULL)
+	if (RomMapped)
+		virtmem::unmap_file(RomPtr, RomSize);
+	else
 		free(RomPtr);
 }
 
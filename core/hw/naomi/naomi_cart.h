@@ -76,6 +76,8 @@ public:
 protected:
 	u8* RomPtr;
 	u32 RomSize;
+	// RomPtr is a file mapping instead of an allocated block
+	bool RomMapped = false;
 };
 
 class NaomiCartridge : public Cartridge
@@ -106,7 +108,11 @@ protected:
 class DecryptedCartridge : public NaomiCartridge
 {
 public:
-	DecryptedCartridge(u8 *rom_ptr, u32 size) : NaomiCartridge(size) { free(RomPtr); RomPtr = rom_ptr; }
+	DecryptedCartridge(u8 *rom_ptr, u32 size, bool mapped) : NaomiCartridge(0) {
+		RomPtr = rom_ptr;
+		RomSize = size;
+		RomMapped = mapped;
+	}
 };
 
 class M2Cartridge : public NaomiCartridge
@@ -12,6 +12,10 @@
 #ifdef TEST_AUTOMATION
 #include "input/gamepad_device.h"
 #endif
+#if (!defined(NDEBUG) || defined(DEBUGFAST)) && FEAT_SHREC != DYNAREC_NONE
+#include "hw/sh4/dyna/ngen.h"
+#include "hw/sh4/modules/mmu.h"
+#endif
 
 //SPG emulation; Scanline/Raster beam registers & interrupts
 
@@ -214,7 +218,31 @@ static int spg_line_sched(int tag, int cycles, int jitter)
 					VER_SHORTNAME,'n',mspdf,spd_cpu*100/200,spd_vbs,
 					spd_vbs/full_rps,mode,res,fullvbs,
 					spd_fps,fskip/ts);
+#if FEAT_SHREC != DYNAREC_NONE
+				static u64 lastDispatchCount;
+				if (rdv_dispatchCount != lastDispatchCount)
+				{
+					INFO_LOG(DYNAREC, "Block dispatches per frame: %.0f", (rdv_dispatchCount - lastDispatchCount) / (spd_vbs * ts));
+					lastDispatchCount = rdv_dispatchCount;
+				}
+				static MmuDispatchStats lastMmuStats;
+				if (mmuDispatchStats.hits + mmuDispatchStats.misses != lastMmuStats.hits + lastMmuStats.misses)
+				{
+					const double frames = spd_vbs * ts;
+					INFO_LOG(DYNAREC, "MMU dispatch per frame: %.0f hits %.0f misses %.0f translations",
+							(mmuDispatchStats.hits - lastMmuStats.hits) / frames, (mmuDispatchStats.misses - lastMmuStats.misses) / frames,
+							(mmuDispatchStats.translations - lastMmuStats.translations) / frames);
+					lastMmuStats = mmuDispatchStats;
+				}
+#endif
 				
+				static u64 lastAllocationCount;
+				if (tactx_AllocationCount() != lastAllocationCount)
+				{
+					INFO_LOG(PVR, "TA context allocations: %d", (int)(tactx_AllocationCount() - lastAllocationCount));
+					lastAllocationCount = tactx_AllocationCount();
+				}
+
 				fskip=0;
 				last_fps=os_GetSeconds();
 			}
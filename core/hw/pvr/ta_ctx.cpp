@@ -5,6 +5,7 @@
 #include "serialize.h"
 #include "stdclass.h"
 
+#include <atomic>
 #include <mutex>
 #include <vector>
 
@@ -104,24 +105,73 @@ static std::mutex mtx_pool;
 
 static std::vector<TA_context*> ctx_pool;
 static std::vector<TA_context*> ctx_list;
+// Recycled contexts in excess are deleted
+constexpr size_t MaxPooledContexts = 8;
+
+// Largest sizes reached by the rend_context arrays.
+// Contexts are reserved to this size so that once they've been reached,
+// parsing and sorting frames doesn't allocate memory anymore.
+static std::array<size_t, rend_context::ArrayCount> highWaterMarks;
+static std::atomic<u64> allocationCount;
+
+// Must be called with mtx_pool locked
+static void tactx_UpdateHighWaterMarks(TA_context *ctx)
+{
+	u32 allocations = 0;
+	size_t i = 0;
+	ctx->rend.forEachArray([&](auto& array) {
+		if (array.capacity() != ctx->capacities[i])
+			// the array has grown
+			allocations++;
+		highWaterMarks[i] = std::max(highWaterMarks[i], array.size());
+		i++;
+	});
+	allocationCount += allocations;
+}
+
+// Must be called with mtx_pool locked
+static void tactx_Reserve(TA_context *ctx)
+{
+	u32 allocations = 0;
+	size_t i = 0;
+	ctx->rend.forEachArray([&](auto& array) {
+		if (array.capacity() < highWaterMarks[i])
+		{
+			array.reserve(highWaterMarks[i] + highWaterMarks[i] / 8);
+			allocations++;
+		}
+		ctx->capacities[i] = array.capacity();
+		i++;
+	});
+	allocationCount += allocations;
+}
+
+// Must be called with mtx_pool locked
+static void tactx_Reset(TA_context *ctx)
+{
+	tactx_UpdateHighWaterMarks(ctx);
+	ctx->Reset();
+	tactx_Reserve(ctx);
+}
 
 TA_context *tactx_Alloc()
 {
 	TA_context *ctx = nullptr;
 
-	mtx_pool.lock();
+	std::lock_guard<std::mutex> lock(mtx_pool);
 	if (!ctx_pool.empty())
 	{
 		ctx = ctx_pool.back();
 		ctx_pool.pop_back();
 	}
-	mtx_pool.unlock();
-
-	if (ctx == nullptr)
+	else
 	{
 		ctx = new TA_context();
 		ctx->Alloc();
+		allocationCount++;
 	}
+	// the high-water marks may have grown since the context was recycled
+	tactx_Reserve(ctx);
 	return ctx;
 }
 
@@ -129,8 +179,9 @@ static void tactx_Recycle(TA_context* ctx)
 {
 	if (ctx->nextContext != nullptr)
 		tactx_Recycle(ctx->nextContext);
-	mtx_pool.lock();
-	if (ctx_pool.size() > 3)
+	std::lock_guard<std::mutex> lock(mtx_pool);
+	tactx_UpdateHighWaterMarks(ctx);
+	if (ctx_pool.size() >= MaxPooledContexts)
 	{
 		delete ctx;
 	}
@@ -139,7 +190,10 @@ static void tactx_Recycle(TA_context* ctx)
 		ctx->Reset();
 		ctx_pool.push_back(ctx);
 	}
-	mtx_pool.unlock();
+}
+
+u64 tactx_AllocationCount() {
+	return allocationCount;
 }
 
 static TA_context *tactx_Find(u32 addr, bool allocnew)
@@ -162,7 +216,8 @@ static TA_context *tactx_Find(u32 addr, bool allocnew)
 		if (oldCtx != nullptr)
 		{
 			ctx = oldCtx;
-			ctx->Reset();
+			std::lock_guard<std::mutex> lock(mtx_pool);
+			tactx_Reset(ctx);
 		}
 		else
 		{
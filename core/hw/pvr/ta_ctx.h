@@ -5,6 +5,7 @@
 #include "oslib/oslib.h"
 
 #include <algorithm>
+#include <array>
 #include <vector>
 
 class BaseTextureCacheData;
@@ -286,6 +287,26 @@ struct rend_context
 		lightModels.clear();
 	}
 
+	static constexpr size_t ArrayCount = 12;
+
+	// Calls func with each array filled when parsing and sorting a frame
+	template<typename Func>
+	void forEachArray(Func func)
+	{
+		func(verts);
+		func(idx);
+		func(modtrig);
+		func(global_param_mvo);
+		func(global_param_mvo_tr);
+		func(global_param_op);
+		func(global_param_pt);
+		func(global_param_tr);
+		func(render_passes);
+		func(sortedTriangles);
+		func(matrices);
+		func(lightModels);
+	}
+
 	void newRenderPass();
 
 	// For RTT TODO merge with framebufferWidth/Height
@@ -313,6 +334,8 @@ struct TA_context
 	rend_context rend;
 
 	TA_context *nextContext = nullptr;
+	// capacity of the rend_context arrays when the context was last reset
+	std::array<size_t, rend_context::ArrayCount> capacities {};
 	/*
 		Dreamcast games use up to 20k vtx, 30k idx, 1k (in total) parameters.
 		at 30 fps, thats 600kvtx (900 stripped)
@@ -378,6 +401,8 @@ extern tad_context ta_tad;
 TA_context* tactx_Pop(u32 addr);
 void tactx_Term();
 TA_context *tactx_Alloc();
+// Number of memory allocations made for TA contexts and their arrays
+u64 tactx_AllocationCount();
 
 /*
 	Ta Context
@@ -412,11 +437,9 @@ void ta_set_list_type(u32 listType);
 void ta_parse_reset();
 void getRegionTileAddrAndSize(u32& address, u32& size);
 
-void sortTriangles(rend_context& ctx, RenderPass& pass, const RenderPass& previousPass);
-void sortPolyParams(std::vector<PolyParam>& polys, int first, int end, rend_context& ctx);
-void fix_texture_bleeding(const std::vector<PolyParam>& polys, int first, int end, rend_context& ctx);
-void makeIndex(std::vector<PolyParam>& polys, int first, int end, bool merge, rend_context& ctx);
-void makePrimRestartIndex(std::vector<PolyParam>& polys, int first, int end, bool merge, rend_context& ctx);
+// Sorts and indexes the polygons of all render passes
+// Translucent triangles are sorted with a radix sort unless radixSort is false
+void processRenderPasses(rend_context& ctx, bool primRestart, bool radixSort = true);
 
 class TAParserException : public FlycastException
 {
@@ -18,10 +18,26 @@
  */
 #include "ta_ctx.h"
 #include "pvr_mem.h"
+#include "cfg/option.h"
+#include "profiler/fc_profiler.h"
 #include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstring>
+#include <functional>
+#include <mutex>
+#include <thread>
 #include <glm/glm.hpp>
 #include <glm/gtc/type_ptr.hpp>
 
+#if (HOST_CPU == CPU_X86 || HOST_CPU == CPU_X64) && (defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2))
+#define TA_SORT_SSE2
+#include <emmintrin.h>
+#elif HOST_CPU == CPU_ARM64
+#define TA_SORT_NEON
+#include <arm_neon.h>
+#endif
+
 //
 // Check if a vertex has NaN or huge x,y,z values
 //
@@ -63,10 +79,120 @@ static float getProjectedZ(const Vertex *v, const float *mat)
 	return -1 / (mat[2] * v->x + mat[1 * 4 + 2] * v->y + mat[2 * 4 + 2] * v->z + mat[3 * 4 + 2]);
 }
 
-void sortTriangles(rend_context& ctx, RenderPass& pass, const RenderPass& previousPass)
+// Projected z of consecutive vertices, 4 at a time
+static void getProjectedZ(const Vertex *v, u32 count, const float *mat, float *z)
+{
+	u32 i = 0;
+#ifdef TA_SORT_SSE2
+	const __m128 m0 = _mm_set1_ps(mat[2]);
+	const __m128 m1 = _mm_set1_ps(mat[1 * 4 + 2]);
+	const __m128 m2 = _mm_set1_ps(mat[2 * 4 + 2]);
+	const __m128 m3 = _mm_set1_ps(mat[3 * 4 + 2]);
+	for (; i + 4 <= count; i += 4)
+	{
+		const __m128 x = _mm_set_ps(v[i + 3].x, v[i + 2].x, v[i + 1].x, v[i].x);
+		const __m128 y = _mm_set_ps(v[i + 3].y, v[i + 2].y, v[i + 1].y, v[i].y);
+		const __m128 vz = _mm_set_ps(v[i + 3].z, v[i + 2].z, v[i + 1].z, v[i].z);
+		__m128 w = _mm_add_ps(_mm_mul_ps(m0, x), _mm_mul_ps(m1, y));
+		w = _mm_add_ps(_mm_add_ps(w, _mm_mul_ps(m2, vz)), m3);
+		_mm_storeu_ps(&z[i], _mm_div_ps(_mm_set1_ps(-1.f), w));
+	}
+#elif defined(TA_SORT_NEON)
+	for (; i + 4 <= count; i += 4)
+	{
+		float x[4], y[4], vz[4];
+		for (int j = 0; j < 4; j++)
+		{
+			x[j] = v[i + j].x;
+			y[j] = v[i + j].y;
+			vz[j] = v[i + j].z;
+		}
+		float32x4_t w = vaddq_f32(vmulq_n_f32(vld1q_f32(x), mat[2]), vmulq_n_f32(vld1q_f32(y), mat[1 * 4 + 2]));
+		w = vaddq_f32(vaddq_f32(w, vmulq_n_f32(vld1q_f32(vz), mat[2 * 4 + 2])), vdupq_n_f32(mat[3 * 4 + 2]));
+		vst1q_f32(&z[i], vdivq_f32(vdupq_n_f32(-1.f), w));
+	}
+#endif
+	for (; i < count; i++)
+		z[i] = getProjectedZ(&v[i], mat);
+}
+
+// Unsigned integer with the same order as the float value
+static inline u32 sortableKey(float f)
 {
-	int first = previousPass.tr_count;
-	int count = pass.tr_count - first;
+	u32 bits;
+	memcpy(&bits, &f, sizeof(bits));
+	if (bits == 0x80000000)
+		// -0 == 0
+		bits = 0;
+	return (bits & 0x80000000) ? ~bits : bits | 0x80000000;
+}
+
+// Stable LSD radix sort of the triangles by z
+static void radixSort(std::vector<IndexTrig>& triangles, std::vector<u64>& keys, std::vector<u64>& temp, std::vector<IndexTrig>& sorted)
+{
+	const size_t count = triangles.size();
+	keys.resize(count);
+	temp.resize(count);
+	u32 histograms[4][256] {};
+	for (size_t i = 0; i < count; i++)
+	{
+		const u32 key = sortableKey(triangles[i].z);
+		keys[i] = ((u64)key << 32) | i;
+		for (int b = 0; b < 4; b++)
+			histograms[b][(key >> (b * 8)) & 0xff]++;
+	}
+	for (int b = 0; b < 4; b++)
+	{
+		u32 *histogram = histograms[b];
+		const int shift = 32 + b * 8;
+		// skip the digits that are the same for all keys
+		if (histogram[(keys[0] >> shift) & 0xff] == count)
+			continue;
+		u32 offset = 0;
+		for (int d = 0; d < 256; d++)
+		{
+			const u32 n = histogram[d];
+			histogram[d] = offset;
+			offset += n;
+		}
+		for (size_t i = 0; i < count; i++)
+			temp[histogram[(keys[i] >> shift) & 0xff]++] = keys[i];
+		keys.swap(temp);
+	}
+	sorted.resize(count);
+	for (size_t i = 0; i < count; i++)
+		sorted[i] = triangles[(u32)keys[i]];
+	triangles.swap(sorted);
+}
+
+//
+// Index and sorted triangles of a list of polygons. Index offsets are relative to the start of the list index.
+//
+struct ListIndex
+{
+	std::vector<u32> idx;
+	std::vector<SortedTriangle> sortedTriangles;
+	// polygons have been indexed
+	bool indexed;
+	// sortTriangles work buffers
+	std::vector<IndexTrig> triangleList;
+	std::vector<IndexTrig> sortedTriangleList;
+	std::vector<float> projectedZ;
+	std::vector<u64> sortKeys;
+	std::vector<u64> sortTemp;
+
+	void clear()
+	{
+		idx.clear();
+		sortedTriangles.clear();
+		indexed = false;
+	}
+};
+
+static void sortTriangles(const rend_context& ctx, int first, int end, bool useRadixSort, ListIndex& list)
+{
+	FC_PROFILE_SCOPE;
+	int count = end - first;
 	if (count == 0)
 		return;
 
@@ -74,7 +200,7 @@ void sortTriangles(rend_context& ctx, RenderPass& pass, const RenderPass& previo
 	const PolyParam * const pp_end = pp_base + count;
 
 	//make lists of all triangles, with their pid and vid
-	static std::vector<IndexTrig> triangleList;
+	std::vector<IndexTrig>& triangleList = list.triangleList;
 
 	int vtx_count = ctx.verts.size() - pp_base->first;
 	triangleList.reserve(vtx_count);
@@ -87,12 +213,13 @@ void sortTriangles(rend_context& ctx, RenderPass& pass, const RenderPass& previo
 
 		const Vertex *v0 = &ctx.verts[pp->first];
 		const Vertex *v1 = &ctx.verts[pp->first + 1];
-		float z0 = 0, z1 = 0;
+		const float *projZ = nullptr;
 
 		if (pp->isNaomi2())
 		{
-			z0 = getProjectedZ(v0, ctx.matrices[pp->mvMatrix].mat);
-			z1 = getProjectedZ(v1, ctx.matrices[pp->mvMatrix].mat);
+			list.projectedZ.resize(pp->count);
+			getProjectedZ(v0, pp->count, ctx.matrices[pp->mvMatrix].mat, list.projectedZ.data());
+			projZ = list.projectedZ.data();
 		}
 		else
 		{
@@ -111,12 +238,7 @@ void sortTriangles(rend_context& ctx, RenderPass& pass, const RenderPass& previo
 				triangleList.emplace_back((u32)(pp - pp_base),
 						(u32)(v0 - &ctx.verts[0]), (u32)(v1 - &ctx.verts[0]), (u32)(v2 - &ctx.verts[0]));
 				if (pp->isNaomi2())
-				{
-					float z2 = getProjectedZ(v2, ctx.matrices[pp->mvMatrix].mat);
-					triangleList.back().z = std::min(z0, std::min(z1, z2));
-					z0 = z1;
-					z1 = z2;
-				}
+					triangleList.back().z = std::min(projZ[i - 2], std::min(projZ[i - 1], projZ[i]));
 				else
 				{
 					triangleList.back().z = minZ(&ctx.verts[0], triangleList.back().vid);
@@ -130,7 +252,10 @@ void sortTriangles(rend_context& ctx, RenderPass& pass, const RenderPass& previo
 	}
 
 	//sort them
-	std::stable_sort(triangleList.begin(), triangleList.end());
+	if (useRadixSort && triangleList.size() >= 64)
+		radixSort(triangleList, list.sortKeys, list.sortTemp, list.sortedTriangleList);
+	else
+		std::stable_sort(triangleList.begin(), triangleList.end());
 
 	//Merge pids/draw cmds if two different pids are actually equal
 	for (size_t k = 1; k < triangleList.size(); k++)
@@ -146,16 +271,16 @@ void sortTriangles(rend_context& ctx, RenderPass& pass, const RenderPass& previo
 	//re-assemble them into drawing commands
 
 	int idx = -1;
-	int idxSize = ctx.idx.size();
+	int idxSize = list.idx.size();
 
 	for (size_t i = 0; i < triangleList.size(); i++)
 	{
 		int pid = triangleList[i].pid;
 		u32* midx = triangleList[i].vid;
 
-		ctx.idx.emplace_back(midx[0]);
-		ctx.idx.emplace_back(midx[1]);
-		ctx.idx.emplace_back(midx[2]);
+		list.idx.emplace_back(midx[0]);
+		list.idx.emplace_back(midx[1]);
+		list.idx.emplace_back(midx[2]);
 
 		if (idx != pid)
 		{
@@ -163,29 +288,28 @@ void sortTriangles(rend_context& ctx, RenderPass& pass, const RenderPass& previo
 
 			if (idx != -1)
 			{
-				SortedTriangle& last = ctx.sortedTriangles.back();
+				SortedTriangle& last = list.sortedTriangles.back();
 				last.count = cur.first - last.first;
 			}
 
-			ctx.sortedTriangles.push_back(cur);
+			list.sortedTriangles.push_back(cur);
 			idx = pid;
 		}
 	}
 
 	if (!triangleList.empty())
 	{
-		SortedTriangle& last = ctx.sortedTriangles.back();
+		SortedTriangle& last = list.sortedTriangles.back();
 		last.count = idxSize + triangleList.size() * 3 - last.first;
 	}
 	else
 	{
 		// Add a dummy one to signal we're using sorted triangles
-		ctx.sortedTriangles.push_back({ (u32)(&pp_base[0] - &ctx.global_param_tr[0]), 0, 0});
+		list.sortedTriangles.push_back({ (u32)(&pp_base[0] - &ctx.global_param_tr[0]), 0, 0});
 	}
-	pass.sorted_tr_count = ctx.sortedTriangles.size();
 
 #if PRINT_SORT_STATS
-	printf("Reassembled into %d from %d\n", (int)ctx.sortedTriangles.size(), pp_end - pp_base);
+	printf("Reassembled into %d from %d\n", (int)list.sortedTriangles.size(), pp_end - pp_base);
 #endif
 }
 
@@ -194,8 +318,9 @@ static bool operator<(const PolyParam& left, const PolyParam& right)
 	return left.zvZ < right.zvZ;
 }
 
-void sortPolyParams(std::vector<PolyParam>& polys, int first, int end, rend_context& ctx)
+static void sortPolyParams(std::vector<PolyParam>& polys, int first, int end, const rend_context& ctx)
 {
+	FC_PROFILE_SCOPE;
 	if (end - first <= 1)
 		return;
 
@@ -209,8 +334,8 @@ void sortPolyParams(std::vector<PolyParam>& polys, int first, int end, rend_cont
 		}
 		else
 		{
-			Vertex *vtx = &ctx.verts[pp->first];
-			Vertex *vtx_end = vtx + pp->count;
+			const Vertex *vtx = &ctx.verts[pp->first];
+			const Vertex *vtx_end = vtx + pp->count;
 
 			if (pp->isNaomi2())
 			{
@@ -318,8 +443,9 @@ int getTAContextAddresses(u32 *addresses)
 	return count;
 }
 
-void fix_texture_bleeding(const std::vector<PolyParam>& polys, int first, int end, rend_context& ctx)
+static void fix_texture_bleeding(const std::vector<PolyParam>& polys, int first, int end, rend_context& ctx)
 {
+	FC_PROFILE_SCOPE;
 	auto pp_end = polys.begin() + end;
 	for (auto pp = polys.begin() + first; pp != pp_end; ++pp)
 	{
@@ -365,8 +491,11 @@ void fix_texture_bleeding(const std::vector<PolyParam>& polys, int first, int en
 // Create the vertex index, eliminating invalid vertices and merging strips when possible.
 // Use primitive restart when merging strips.
 //
-void makePrimRestartIndex(std::vector<PolyParam>& polys, int first, int end, bool merge, rend_context& ctx)
+static void makePrimRestartIndex(std::vector<PolyParam>& polys, int first, int end, bool merge, const rend_context& ctx, ListIndex& list)
 {
+	FC_PROFILE_SCOPE;
+	std::vector<u32>& idx = list.idx;
+	list.indexed = true;
 	if (first >= (int)polys.size())
 		return;
 	PolyParam *last_poly = nullptr;
@@ -380,14 +509,14 @@ void makePrimRestartIndex(std::vector<PolyParam>& polys, int first, int end, boo
 				&& last_poly->count != 0
 				&& poly->equivalentIgnoreCullingDirection(*last_poly))
 		{
-			ctx.idx.push_back(~0);
+			idx.push_back(~0);
 			dupe_next_vtx = poly->isp.CullMode >= 2 && poly->isp.CullMode != last_poly->isp.CullMode;
 			first_index = last_poly->first;
 		}
 		else
 		{
 			last_poly = poly;
-			first_index = ctx.idx.size();
+			first_index = idx.size();
 		}
 		int last_good_vtx = -1;
 		for (u32 i = 0; i < poly->count; i++)
@@ -409,7 +538,7 @@ void makePrimRestartIndex(std::vector<PolyParam>& polys, int first, int end, boo
 						{
 							if (last_good_vtx >= 0)
 								// reset the strip
-								ctx.idx.push_back(~0);
+								idx.push_back(~0);
 							if (odd && poly->isp.CullMode >= 2)
 								// repeat next vertex to get culling right
 								dupe_next_vtx = true;
@@ -424,20 +553,20 @@ void makePrimRestartIndex(std::vector<PolyParam>& polys, int first, int end, boo
 				last_good_vtx = poly->first + i;
 				if (dupe_next_vtx)
 				{
-					ctx.idx.push_back(last_good_vtx);
+					idx.push_back(last_good_vtx);
 					dupe_next_vtx = false;
 				}
-				ctx.idx.push_back(last_good_vtx);
+				idx.push_back(last_good_vtx);
 			}
 		}
 		if (last_poly == poly)
 		{
 			poly->first = first_index;
-			poly->count = ctx.idx.size() - first_index;
+			poly->count = idx.size() - first_index;
 		}
 		else
 		{
-			last_poly->count = ctx.idx.size() - last_poly->first;
+			last_poly->count = idx.size() - last_poly->first;
 			poly->count = 0;
 		}
 	}
@@ -447,8 +576,11 @@ void makePrimRestartIndex(std::vector<PolyParam>& polys, int first, int end, boo
 // Create the vertex index, eliminating invalid vertices and merging strips when possible.
 // Use degenerate triangles to link strips.
 //
-void makeIndex(std::vector<PolyParam>& polys, int first, int end, bool merge, rend_context& ctx)
+static void makeIndex(std::vector<PolyParam>& polys, int first, int end, bool merge, const rend_context& ctx, ListIndex& list)
 {
+	FC_PROFILE_SCOPE;
+	std::vector<u32>& idx = list.idx;
+	list.indexed = true;
 	if (first >= (int)polys.size())
 		return;
 	PolyParam *last_poly = nullptr;
@@ -463,18 +595,18 @@ void makeIndex(std::vector<PolyParam>& polys, int first, int end, bool merge, re
 				&& last_poly->count != 0
 				&& poly->equivalentIgnoreCullingDirection(*last_poly))
 		{
-			const u32 last_vtx = ctx.idx[last_poly->first + last_poly->count - 1];
-			ctx.idx.push_back(last_vtx);
+			const u32 last_vtx = idx[last_poly->first + last_poly->count - 1];
+			idx.push_back(last_vtx);
 			if (poly->isp.CullMode < 2 || poly->isp.CullMode == last_poly->isp.CullMode)
 			{
 				if (cullingReversed)
-					ctx.idx.push_back(last_vtx);
+					idx.push_back(last_vtx);
 				cullingReversed = false;
 			}
 			else
 			{
 				if (!cullingReversed)
-					ctx.idx.push_back(last_vtx);
+					idx.push_back(last_vtx);
 				cullingReversed = true;
 			}
 			dupe_next_vtx = true;
@@ -483,7 +615,7 @@ void makeIndex(std::vector<PolyParam>& polys, int first, int end, bool merge, re
 		else
 		{
 			last_poly = poly;
-			first_index = ctx.idx.size();
+			first_index = idx.size();
 			cullingReversed = false;
 		}
 		int last_good_vtx = -1;
@@ -501,7 +633,7 @@ void makeIndex(std::vector<PolyParam>& polys, int first, int end, bool merge, re
 						if (last_good_vtx >= 0)
 						{
 							verify(!dupe_next_vtx);
-							ctx.idx.push_back(last_good_vtx);
+							idx.push_back(last_good_vtx);
 							dupe_next_vtx = true;
 						}
 						break;
@@ -514,25 +646,229 @@ void makeIndex(std::vector<PolyParam>& polys, int first, int end, bool merge, re
 				last_good_vtx = poly->first + i;
 				if (dupe_next_vtx)
 				{
-					ctx.idx.push_back(last_good_vtx);
+					idx.push_back(last_good_vtx);
 					dupe_next_vtx = false;
 				}
-				const u32 count = ctx.idx.size() - first_index;
+				const u32 count = idx.size() - first_index;
 				if (((i ^ count) & 1) ^ cullingReversed)
-					ctx.idx.push_back(last_good_vtx);
-				ctx.idx.push_back(last_good_vtx);
+					idx.push_back(last_good_vtx);
+				idx.push_back(last_good_vtx);
 			}
 		}
 		if (last_poly == poly)
 		{
 			poly->first = first_index;
-			poly->count = ctx.idx.size() - first_index;
+			poly->count = idx.size() - first_index;
 		}
 		else
 		{
-			last_poly->count = ctx.idx.size() - last_poly->first;
+			last_poly->count = idx.size() - last_poly->first;
 			poly->count = 0;
 		}
 	}
 }
 
+
+//
+// Small pool of worker threads running the jobs of a frame.
+// The calling thread runs jobs as well and returns once they are all done.
+//
+class RenderJobPool
+{
+public:
+	~RenderJobPool()
+	{
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			stopping = true;
+		}
+		cond.notify_all();
+		for (std::thread& thread : threads)
+			thread.join();
+	}
+
+	void run(size_t count, const std::function<void(size_t)>& func)
+	{
+		const size_t threadCount = std::clamp((int)config::MaxThreads, 1, 8) - 1;
+		if (threadCount == 0 || count <= 1)
+		{
+			for (size_t i = 0; i < count; i++)
+				func(i);
+			return;
+		}
+		{
+			std::unique_lock<std::mutex> lock(mutex);
+			if (threads.empty())
+				for (size_t i = 0; i < threadCount; i++)
+					threads.emplace_back(&RenderJobPool::loop, this);
+			// workers still running the previous jobs must not see the new ones
+			doneCond.wait(lock, [this]() { return activeWorkers == 0; });
+			job = &func;
+			jobCount = count;
+			nextJob = 0;
+			generation++;
+		}
+		cond.notify_all();
+		work();
+		std::unique_lock<std::mutex> lock(mutex);
+		doneCond.wait(lock, [this]() { return activeWorkers == 0; });
+		job = nullptr;
+	}
+
+private:
+	void work()
+	{
+		for (;;)
+		{
+			size_t i = nextJob++;
+			if (i >= jobCount)
+				break;
+			(*job)(i);
+		}
+	}
+
+	void loop()
+	{
+		std::unique_lock<std::mutex> lock(mutex);
+		// threads are started by the first run
+		u32 lastGeneration = 0;
+		for (;;)
+		{
+			cond.wait(lock, [&]() { return stopping || generation != lastGeneration; });
+			if (stopping)
+				break;
+			lastGeneration = generation;
+			activeWorkers++;
+			lock.unlock();
+			fc_profiler::startThread("render jobs");
+			work();
+			fc_profiler::endThread();
+			lock.lock();
+			if (--activeWorkers == 0)
+				doneCond.notify_one();
+		}
+	}
+
+	std::vector<std::thread> threads;
+	std::mutex mutex;
+	std::condition_variable cond;
+	std::condition_variable doneCond;
+	const std::function<void(size_t)> *job = nullptr;
+	size_t jobCount = 0;
+	std::atomic<size_t> nextJob {};
+	u32 generation = 0;
+	int activeWorkers = 0;
+	bool stopping = false;
+};
+static RenderJobPool renderJobs;
+
+// Index of each list of each render pass
+static std::vector<ListIndex> listIndexes;
+
+// Returns the polygons of the given list and their range in a render pass
+static std::vector<PolyParam>& getPassList(rend_context& ctx, u32 passIndex, u32 listType, int& first, int& end)
+{
+	const RenderPass& pass = ctx.render_passes[passIndex];
+	const RenderPass previousPass = passIndex == 0 ? RenderPass{} : ctx.render_passes[passIndex - 1];
+	switch (listType)
+	{
+	case ListType_Opaque:
+		first = previousPass.op_count;
+		end = pass.op_count;
+		return ctx.global_param_op;
+	case ListType_Punch_Through:
+		first = previousPass.pt_count;
+		end = pass.pt_count;
+		return ctx.global_param_pt;
+	default:
+		first = previousPass.tr_count;
+		end = pass.tr_count;
+		return ctx.global_param_tr;
+	}
+}
+
+static void processList(rend_context& ctx, u32 passIndex, u32 listType, bool primRestart, bool radixSort, ListIndex& list)
+{
+	int first, end;
+	std::vector<PolyParam>& polys = getPassList(ctx, passIndex, listType, first, end);
+
+	const bool perPixel = config::RendererType == RenderType::OpenGL_OIT
+			|| config::RendererType == RenderType::DirectX11_OIT
+			|| config::RendererType == RenderType::Vulkan_OIT;
+	list.clear();
+	if (config::RenderResolution > 480 && !config::EmulateFramebuffer)
+		fix_texture_bleeding(polys, first, end, ctx);
+	bool merge = true;
+	if (listType == ListType_Translucent)
+	{
+		if (ctx.render_passes[passIndex].autosort && !perPixel)
+		{
+			if (config::PerStripSorting)
+				sortPolyParams(polys, first, end, ctx);
+			else
+			{
+				// sortTriangles creates the index
+				sortTriangles(ctx, first, end, radixSort, list);
+				return;
+			}
+		}
+		merge = config::PerStripSorting || perPixel;
+	}
+	if (primRestart)
+		makePrimRestartIndex(polys, first, end, merge, ctx, list);
+	else
+		makeIndex(polys, first, end, merge, ctx, list);
+}
+
+static const u32 listTypes[] { ListType_Opaque, ListType_Punch_Through, ListType_Translucent };
+
+// Concatenates the indexes in pass and list order
+static void mergeListIndexes(rend_context& ctx)
+{
+	FC_PROFILE_SCOPE;
+	const size_t passCount = ctx.render_passes.size();
+	u32 sortedCount = 0;
+	for (size_t p = 0; p < passCount; p++)
+	{
+		RenderPass& pass = ctx.render_passes[p];
+		for (size_t l = 0; l < std::size(listTypes); l++)
+		{
+			const ListIndex& list = listIndexes[p * std::size(listTypes) + l];
+			const u32 base = ctx.idx.size();
+			ctx.idx.insert(ctx.idx.end(), list.idx.begin(), list.idx.end());
+			if (list.indexed && base != 0)
+			{
+				int first, end;
+				std::vector<PolyParam>& polys = getPassList(ctx, p, listTypes[l], first, end);
+				// Polygons merged into a previous one or without valid vertices are empty and never drawn
+				for (int i = first; i < end; i++)
+					if (polys[i].count != 0)
+						polys[i].first += base;
+			}
+			for (SortedTriangle tri : list.sortedTriangles)
+			{
+				// the dummy sorted triangle is left untouched
+				if (tri.count != 0)
+					tri.first += base;
+				ctx.sortedTriangles.push_back(tri);
+			}
+			if (!list.sortedTriangles.empty())
+				sortedCount = ctx.sortedTriangles.size();
+		}
+		pass.sorted_tr_count = sortedCount;
+	}
+}
+
+void processRenderPasses(rend_context& ctx, bool primRestart, bool radixSort)
+{
+	FC_PROFILE_SCOPE;
+	const size_t passCount = ctx.render_passes.size();
+	if (listIndexes.size() < passCount * std::size(listTypes))
+		listIndexes.resize(passCount * std::size(listTypes));
+
+	// The lists of all passes use distinct polygons and vertices, and have their own index
+	renderJobs.run(passCount * std::size(listTypes), [&](size_t i) {
+		processList(ctx, i / std::size(listTypes), listTypes[i % std::size(listTypes)], primRestart, radixSort, listIndexes[i]);
+	});
+	mergeListIndexes(ctx);
+}
@@ -13,6 +13,16 @@
 #include <algorithm>
 #include <utility>
 
+#if (HOST_CPU == CPU_X86 || HOST_CPU == CPU_X64) && (defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2))
+#define TA_VTX_SSE2
+#define TA_VTX_SIMD
+#include <emmintrin.h>
+#elif HOST_CPU == CPU_ARM64 || (HOST_CPU == CPU_ARM && defined(__ARM_NEON__))
+#define TA_VTX_NEON
+#define TA_VTX_SIMD
+#include <arm_neon.h>
+#endif
+
 #define TACALL DYNACALL
 #ifdef NDEBUG
 #undef verify
@@ -315,6 +325,21 @@ case num : {\
 	{
 		verify(data < data_end);
 
+		if constexpr (isBatchedVertex(poly_type))
+		{
+			Ta_Dma *end = data;
+			do {
+				verify(end->pcw.ParaType == ParamType_Vertex_Parameter);
+			} while (!(end++)->pcw.EndOfStrip && end < data_end);
+			appendVertices<poly_type>(data, end - data);
+			if (end[-1].pcw.EndOfStrip)
+			{
+				TaCmd = ta_main;
+				EndPolyStrip();
+			}
+			return end;
+		}
+
 					//If SZ64  && 32 bytes
 #define IS_FIST_HALF (poly_size != SZ32 && data == data_end - SZ32)
 
@@ -948,6 +973,225 @@ private:
 		vert_uv1_16(u1, v1);
 	}
 
+	//
+	// Runs of the most common 32-byte vertex types are decoded 4 vertices at a time
+	//
+	static constexpr bool isBatchedVertex(u32 poly_type) {
+		return poly_type <= 4 || poly_type == 7 || poly_type == 8;
+	}
+
+#ifdef TA_VTX_SIMD
+	// Source byte of each output byte of a packed color
+	static constexpr u32 packedColorByte(int i) {
+		return i == Blue ? 0 : i == Green ? 1 : i == Red ? 2 : 3;
+	}
+	// Source component (A, R, G, B) of each output byte of a floating color
+	static constexpr u32 floatColorLane(int i) {
+		return i == Red ? 1 : i == Green ? 2 : i == Blue ? 3 : 0;
+	}
+
+#ifdef TA_VTX_SSE2
+	// Same result as float_to_satu8
+	static inline __m128i floatToSatU8(__m128 v)
+	{
+		v = _mm_and_ps(v, _mm_castsi128_ps(_mm_set1_epi32(0xffff0000)));
+		// NaN gives 1
+		v = _mm_min_ps(_mm_max_ps(_mm_setzero_ps(), v), _mm_set1_ps(1.f));
+		return _mm_cvttps_epi32(_mm_mul_ps(v, _mm_set1_ps(255.f)));
+	}
+
+	template<int From, int To>
+	static inline __m128i moveColorByte(__m128i c)
+	{
+		c = _mm_and_si128(_mm_srli_epi32(c, From * 8), _mm_set1_epi32(0xff));
+		return _mm_slli_epi32(c, To * 8);
+	}
+
+	static void packedColors(u32 *dst, const u32 *src)
+	{
+		__m128i c = _mm_loadu_si128((const __m128i *)src);
+		c = _mm_or_si128(_mm_or_si128(moveColorByte<packedColorByte(0), 0>(c), moveColorByte<packedColorByte(1), 1>(c)),
+				_mm_or_si128(moveColorByte<packedColorByte(2), 2>(c), moveColorByte<packedColorByte(3), 3>(c)));
+		_mm_storeu_si128((__m128i *)dst, c);
+	}
+
+	static void floatColors(u32 *dst, const f32 * const *src)
+	{
+		constexpr int order = _MM_SHUFFLE(floatColorLane(3), floatColorLane(2), floatColorLane(1), floatColorLane(0));
+		__m128i c[4];
+		for (int i = 0; i < 4; i++)
+		{
+			__m128 v = _mm_loadu_ps(src[i]);
+			c[i] = floatToSatU8(_mm_shuffle_ps(v, v, order));
+		}
+		_mm_storeu_si128((__m128i *)dst, _mm_packus_epi16(_mm_packs_epi32(c[0], c[1]), _mm_packs_epi32(c[2], c[3])));
+	}
+
+	static void intensityColors(u32 *dst, const f32 *intensity, const u8 *faceColor)
+	{
+		__m128i sat = floatToSatU8(_mm_loadu_ps(intensity));
+		sat = _mm_packs_epi32(sat, sat);
+		sat = _mm_unpacklo_epi16(sat, sat);
+		// 16-bit factors of 2 vertices. Alpha isn't modulated.
+		const __m128i alphaLane = _mm_set_epi16(Alpha == 3 ? -1 : 0, Alpha == 2 ? -1 : 0, Alpha == 1 ? -1 : 0, Alpha == 0 ? -1 : 0,
+				Alpha == 3 ? -1 : 0, Alpha == 2 ? -1 : 0, Alpha == 1 ? -1 : 0, Alpha == 0 ? -1 : 0);
+		const __m128i alphaFactor = _mm_and_si128(alphaLane, _mm_set1_epi16(256));
+		__m128i f01 = _mm_or_si128(_mm_andnot_si128(alphaLane, _mm_unpacklo_epi32(sat, sat)), alphaFactor);
+		__m128i f23 = _mm_or_si128(_mm_andnot_si128(alphaLane, _mm_unpackhi_epi32(sat, sat)), alphaFactor);
+		u32 face;
+		memcpy(&face, faceColor, sizeof(face));
+		const __m128i color = _mm_unpacklo_epi8(_mm_set1_epi32(face), _mm_setzero_si128());
+		f01 = _mm_srli_epi16(_mm_mullo_epi16(color, f01), 8);
+		f23 = _mm_srli_epi16(_mm_mullo_epi16(color, f23), 8);
+		_mm_storeu_si128((__m128i *)dst, _mm_packus_epi16(f01, f23));
+	}
+#endif // TA_VTX_SSE2
+
+#ifdef TA_VTX_NEON
+	// Same result as float_to_satu8
+	static inline uint32x4_t floatToSatU8(float32x4_t v)
+	{
+		v = vreinterpretq_f32_u32(vandq_u32(vreinterpretq_u32_f32(v), vdupq_n_u32(0xffff0000)));
+		const float32x4_t clamped = vminq_f32(vmaxq_f32(v, vdupq_n_f32(0.f)), vdupq_n_f32(1.f));
+		// NaN gives 1
+		v = vbslq_f32(vceqq_f32(v, v), clamped, vdupq_n_f32(1.f));
+		return vcvtq_u32_f32(vmulq_n_f32(v, 255.f));
+	}
+
+	// Byte indices of 2 colors
+	template<typename F>
+	static constexpr u64 colorIndices(F byteIndex)
+	{
+		u64 indices = 0;
+		for (int i = 0; i < 8; i++)
+			indices |= (u64)((i & ~3) + byteIndex(i & 3)) << (i * 8);
+		return indices;
+	}
+
+	static void packedColors(u32 *dst, const u32 *src)
+	{
+		const uint8x8_t indices = vcreate_u8(colorIndices(packedColorByte));
+		const uint8x16_t c = vld1q_u8((const u8 *)src);
+		vst1q_u8((u8 *)dst, vcombine_u8(vtbl1_u8(vget_low_u8(c), indices), vtbl1_u8(vget_high_u8(c), indices)));
+	}
+
+	static void floatColors(u32 *dst, const f32 * const *src)
+	{
+		const uint8x8_t indices = vcreate_u8(colorIndices(floatColorLane));
+		uint8x8_t c[2];
+		for (int i = 0; i < 2; i++)
+		{
+			const uint16x8_t c16 = vcombine_u16(vmovn_u32(floatToSatU8(vld1q_f32(src[i * 2]))),
+					vmovn_u32(floatToSatU8(vld1q_f32(src[i * 2 + 1]))));
+			c[i] = vtbl1_u8(vmovn_u16(c16), indices);
+		}
+		vst1q_u8((u8 *)dst, vcombine_u8(c[0], c[1]));
+	}
+
+	static void intensityColors(u32 *dst, const f32 *intensity, const u8 *faceColor)
+	{
+		const uint16x4_t sat = vmovn_u32(floatToSatU8(vld1q_f32(intensity)));
+		// 16-bit factors of 2 vertices. Alpha isn't modulated.
+		const u64 alphaLane = 0xffffull << (Alpha * 16);
+		const uint16x8_t alphaMask = vcombine_u16(vcreate_u16(alphaLane), vcreate_u16(alphaLane));
+		const uint16x8_t alphaFactor = vdupq_n_u16(256);
+		uint16x8_t f01 = vbslq_u16(alphaMask, alphaFactor, vcombine_u16(vdup_lane_u16(sat, 0), vdup_lane_u16(sat, 1)));
+		uint16x8_t f23 = vbslq_u16(alphaMask, alphaFactor, vcombine_u16(vdup_lane_u16(sat, 2), vdup_lane_u16(sat, 3)));
+		u32 face;
+		memcpy(&face, faceColor, sizeof(face));
+		const uint16x8_t color = vmovl_u8(vcreate_u8(face | ((u64)face << 32)));
+		f01 = vshrq_n_u16(vmulq_u16(color, f01), 8);
+		f23 = vshrq_n_u16(vmulq_u16(color, f23), 8);
+		vst1q_u8((u8 *)dst, vcombine_u8(vmovn_u16(f01), vmovn_u16(f23)));
+	}
+#endif // TA_VTX_NEON
+
+	template<u32 poly_type>
+	static void decodeVertices4(Vertex *cv, const Ta_Dma *data)
+	{
+		const TA_VertexParam *vp[4];
+		for (int i = 0; i < 4; i++)
+		{
+			vp[i] = (const TA_VertexParam *)&data[i];
+			cv[i].x = vp[i]->vtx0.xyz[0];
+			cv[i].y = vp[i]->vtx0.xyz[1];
+			cv[i].z = vp[i]->vtx0.xyz[2];
+			if constexpr (poly_type == 3 || poly_type == 7)
+			{
+				// same layout
+				cv[i].u = vp[i]->vtx3.u;
+				cv[i].v = vp[i]->vtx3.v;
+			}
+			else if constexpr (poly_type == 4 || poly_type == 8)
+			{
+				cv[i].u = f16(vp[i]->vtx4.u);
+				cv[i].v = f16(vp[i]->vtx4.v);
+			}
+		}
+		alignas(16) u32 col[4];
+		alignas(16) u32 spc[4];
+		if constexpr (poly_type == 0 || poly_type == 3 || poly_type == 4)
+		{
+			alignas(16) u32 packed[4];
+			for (int i = 0; i < 4; i++)
+				packed[i] = vp[i]->vtx0.BaseCol;
+			packedColors(col, packed);
+			if constexpr (poly_type != 0)
+			{
+				for (int i = 0; i < 4; i++)
+					packed[i] = vp[i]->vtx3.OffsCol;
+				packedColors(spc, packed);
+			}
+		}
+		else if constexpr (poly_type == 1)
+		{
+			const f32 *argb[4];
+			for (int i = 0; i < 4; i++)
+				argb[i] = &vp[i]->vtx1.BaseA;
+			floatColors(col, argb);
+		}
+		else
+		{
+			alignas(16) f32 intensity[4];
+			for (int i = 0; i < 4; i++)
+				intensity[i] = vp[i]->vtx2.BaseInt;
+			intensityColors(col, intensity, FaceBaseColor);
+			if constexpr (poly_type != 2)
+			{
+				for (int i = 0; i < 4; i++)
+					intensity[i] = vp[i]->vtx7.OffsInt;
+				intensityColors(spc, intensity, FaceOffsColor);
+			}
+		}
+		for (int i = 0; i < 4; i++)
+		{
+			memcpy(cv[i].col, &col[i], sizeof(cv[i].col));
+			if constexpr (poly_type != 0 && poly_type != 1 && poly_type != 2)
+				memcpy(cv[i].spc, &spc[i], sizeof(cv[i].spc));
+		}
+	}
+#endif // TA_VTX_SIMD
+
+	template<u32 poly_type>
+	static void appendVertices(Ta_Dma *data, u32 count)
+	{
+		u32 i = 0;
+#ifdef TA_VTX_SIMD
+		if (count >= 4)
+		{
+			const size_t first = vd_rc.verts.size();
+			vd_rc.verts.resize(first + (count & ~3));
+			Vertex *cv = &vd_rc.verts[first];
+			for (; i + 4 <= count; i += 4)
+				decodeVertices4<poly_type>(&cv[i], &data[i]);
+			for (u32 j = 0; j < i; j++)
+				update_fz(cv[j].z);
+		}
+#endif
+		for (; i < count; i++)
+			ta_handle_poly<poly_type, 0>(&data[i], nullptr);
+	}
+
 	//Sprites
 	static void AppendSpriteParam(TA_SpriteParam* spr)
 	{
@@ -1152,48 +1396,7 @@ private:
 static void getRegionTileClipping(u32& xmin, u32& xmax, u32& ymin, u32& ymax);
 static void getRegionSettings(int passNumber, RenderPass& pass);
 
-static void parseRenderPass(RenderPass& pass, const RenderPass& previousPass, rend_context& ctx, bool primRestart)
-{
-	const bool perPixel = config::RendererType == RenderType::OpenGL_OIT
-			|| config::RendererType == RenderType::DirectX11_OIT
-			|| config::RendererType == RenderType::Vulkan_OIT;
-	const bool mergeTranslucent = config::PerStripSorting || perPixel;
-
-	if (config::RenderResolution > 480 && !config::EmulateFramebuffer)
-	{
-		fix_texture_bleeding(ctx.global_param_op, previousPass.op_count, pass.op_count, ctx);
-		fix_texture_bleeding(ctx.global_param_pt, previousPass.pt_count, pass.pt_count, ctx);
-		fix_texture_bleeding(ctx.global_param_tr, previousPass.tr_count, pass.tr_count, ctx);
-	}
-	if (primRestart)
-	{
-		makePrimRestartIndex(ctx.global_param_op, previousPass.op_count, pass.op_count, true, ctx);
-		makePrimRestartIndex(ctx.global_param_pt, previousPass.pt_count, pass.pt_count, true, ctx);
-	}
-	else
-	{
-		makeIndex(ctx.global_param_op, previousPass.op_count, pass.op_count, true, ctx);
-		makeIndex(ctx.global_param_pt, previousPass.pt_count, pass.pt_count, true, ctx);
-	}
-	pass.sorted_tr_count = previousPass.sorted_tr_count;
-	if (pass.autosort && !perPixel)
-	{
-		if (config::PerStripSorting)
-			sortPolyParams(ctx.global_param_tr, previousPass.tr_count, pass.tr_count, ctx);
-		else
-			sortTriangles(ctx, pass, previousPass);
-	}
-	// sortTriangles already created the index
-	if (!pass.autosort || perPixel || config::PerStripSorting)
-	{
-		if (primRestart)
-			makePrimRestartIndex(ctx.global_param_tr, previousPass.tr_count, pass.tr_count, mergeTranslucent, ctx);
-		else
-			makeIndex(ctx.global_param_tr, previousPass.tr_count, pass.tr_count, mergeTranslucent, ctx);
-	}
-}
-
-static void ta_parse_vdrc(TA_context* ctx, bool primRestart)
+static void ta_parse_vdrc(TA_context* ctx, bool primRestart, bool radixSort)
 {
 	verify(vd_ctx == nullptr);
 	vd_ctx = ctx;
@@ -1206,7 +1409,6 @@ static void ta_parse_vdrc(TA_context* ctx, bool primRestart)
 
 	TA_context *childCtx = ctx;
 	int pass = 0;
-	RenderPass previousPass{};
 
 	while (childCtx != nullptr)
 	{
@@ -1239,13 +1441,11 @@ static void ta_parse_vdrc(TA_context* ctx, bool primRestart)
 			render_pass.sorted_tr_count = 0;
 			render_pass.mvo_count = vd_rc.global_param_mvo.size();
 			render_pass.mvo_tr_count = vd_rc.global_param_mvo_tr.size();
-
-			parseRenderPass(render_pass, previousPass, vd_rc, primRestart);
-			previousPass = render_pass;
 		}
 		childCtx = childCtx->nextContext;
 		pass++;
 	}
+	processRenderPasses(vd_rc, primRestart, radixSort);
 
 	u32 xmin, xmax, ymin, ymax;
 	getRegionTileClipping(xmin, xmax, ymin, ymax);
@@ -1257,7 +1457,7 @@ static void ta_parse_vdrc(TA_context* ctx, bool primRestart)
 	vd_ctx = nullptr;
 }
 
-static void ta_parse_naomi2(TA_context* ctx, bool primRestart)
+static void ta_parse_naomi2(TA_context* ctx, bool primRestart, bool radixSort)
 {
 	for (PolyParam& pp : ctx->rend.global_param_op)
 	{
@@ -1282,13 +1482,7 @@ static void ta_parse_naomi2(TA_context* ctx, bool primRestart)
 	}
 
 	ctx->rend.newRenderPass();
-	RenderPass previousPass{};
-
-	for (RenderPass& pass : ctx->rend.render_passes)
-	{
-		parseRenderPass(pass, previousPass, ctx->rend, primRestart);
-		previousPass = pass;
-	}
+	processRenderPasses(ctx->rend, primRestart, radixSort);
 
 	u32 xmin, xmax, ymin, ymax;
 	getRegionTileClipping(xmin, xmax, ymin, ymax);
@@ -1298,12 +1492,12 @@ static void ta_parse_naomi2(TA_context* ctx, bool primRestart)
 	ctx->rend.fb_Y_CLIP.max = std::min(ctx->rend.fb_Y_CLIP.max, ymax + 31);
 }
 
-void ta_parse(TA_context *ctx, bool primRestart)
+void ta_parse(TA_context *ctx, bool primRestart, bool radixSort)
 {
 	if (settings.platform.isNaomi2())
-		ta_parse_naomi2(ctx, primRestart);
+		ta_parse_naomi2(ctx, primRestart, radixSort);
 	else
-		ta_parse_vdrc(ctx, primRestart);
+		ta_parse_vdrc(ctx, primRestart, radixSort);
 }
 
 //
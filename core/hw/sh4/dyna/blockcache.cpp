@@ -0,0 +1,473 @@
+/*
+	Copyright 2026 flyinghead
+
+	This file is part of Flycast.
+
+    Flycast is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 2 of the License, or
+    (at your option) any later version.
+
+    Flycast is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Flycast.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#include "types.h"
+
+#if FEAT_SHREC != DYNAREC_NONE
+
+#include "blockcache.h"
+#include "blockmanager.h"
+#include "hw/sh4/sh4_core.h"
+#include "hw/sh4/sh4_mem.h"
+#include "hw/sh4/modules/mmu.h"
+#include "cfg/option.h"
+#include "oslib/oslib.h"
+#include "emulator.h"
+#include "version.h"
+
+#include <mutex>
+#include <unordered_map>
+#include <xxhash.h>
+
+namespace blockcache
+{
+
+constexpr u32 MAGIC = 0x43594453;	// SDYC
+constexpr u32 VERSION = 2;
+
+// Only the fpscr bits used by the decoder
+constexpr u32 FPSCR_DECODE_MASK = 0x00180003;	// SZ | PR | RM
+
+enum EntryFlags : u8 {
+	ReadOnly = 1,
+	HasFpuOp = 2,
+	HasJcond = 4,
+};
+
+#pragma pack(push, 1)
+struct FileHeader
+{
+	u32 magic;
+	u32 version;
+	// Decoding and shil format may change between builds
+	char buildId[16];
+	s32 sh4Clock;
+	u32 ramSize;
+	u32 entryCount;
+};
+
+struct EntryHeader
+{
+	u32 addr;
+	u32 fpuCfg;
+	u32 sh4CodeSize;
+	u32 guestOpcodes;
+	u32 guestCycles;
+	u32 blockType;
+	u32 branchBlock;
+	u32 nextBlock;
+	u64 hash;
+	u32 opsSize;
+	u8 flags;
+};
+#pragma pack(pop)
+
+struct Entry
+{
+	EntryHeader header;
+	std::vector<u8> ops;
+};
+
+static std::unordered_map<u64, Entry> entries;
+static std::string currentGameId;
+static bool dirty;
+static Stats stats;
+// blocks may be compiled on a background thread
+static std::recursive_mutex mutex;
+
+static void getBuildId(char (&buildId)[16])
+{
+	memset(buildId, 0, sizeof(buildId));
+	strncpy(buildId, GIT_HASH, sizeof(buildId) - 1);
+}
+
+static u64 makeKey(u32 addr, u32 fpuCfg) {
+	return ((u64)addr << 32) | (fpuCfg & FPSCR_DECODE_MASK);
+}
+
+static u64 toMicros(std::chrono::steady_clock::duration d) {
+	return std::chrono::duration_cast<std::chrono::microseconds>(d).count();
+}
+
+static bool isActive()
+{
+	return config::DynarecPersistentCache && !currentGameId.empty() && !mmu_enabled();
+}
+
+// The decoder only reads the block code, but the SSA passes of protected blocks
+// also read constants and branch targets in the same 4K pages, so hash all of them.
+static bool hashGuestCode(u32 addr, u32 size, bool readOnly, u64& hash)
+{
+	if (!IsOnRam(addr) || size == 0)
+		return false;
+	u32 start = addr;
+	u32 end = addr + size;
+	if (readOnly)
+	{
+		start &= ~0xfff;
+		end = (end + 0xfff) & ~0xfff;
+	}
+	u32 offset = start & RAM_MASK;
+	if (offset + (end - start) > RAM_SIZE)
+		return false;
+	hash = XXH64(&mem_b[offset], end - start, 7);
+
+	return true;
+}
+
+class OpWriter
+{
+public:
+	OpWriter(std::vector<u8>& data) : data(data) {}
+
+	template<typename T>
+	void write(const T& v) {
+		const u8 *p = (const u8 *)&v;
+		data.insert(data.end(), p, p + sizeof(T));
+	}
+
+	void write(const shil_param& param)
+	{
+		write((u8)param.type);
+		if (param.is_null())
+			return;
+		write(param._imm);
+		if (param.is_reg())
+			for (u32 i = 0; i < param.count(); i++)
+				write(param.version[i]);
+	}
+
+	void write(const shil_opcode& op)
+	{
+		write((u8)op.op);
+		write((u8)op.size);
+		write(op.guest_offs);
+		write((u8)op.delay_slot);
+		write(op.rd);
+		write(op.rd2);
+		write(op.rs1);
+		write(op.rs2);
+		write(op.rs3);
+	}
+
+private:
+	std::vector<u8>& data;
+};
+
+class OpReader
+{
+public:
+	OpReader(const std::vector<u8>& data) : p(data.data()), end(data.data() + data.size()) {}
+
+	template<typename T>
+	bool read(T& v)
+	{
+		if (p + sizeof(T) > end)
+			return false;
+		memcpy(&v, p, sizeof(T));
+		p += sizeof(T);
+		return true;
+	}
+
+	bool read(shil_param& param)
+	{
+		u8 type;
+		if (!read(type))
+			return false;
+		param = shil_param();
+		if (type == FMT_NULL)
+			return true;
+		if (type > FMT_V16)
+			return false;
+		param.type = type;
+		if (!read(param._imm))
+			return false;
+		if (param.is_reg())
+		{
+			if (param.count() + param._imm > sh4_reg_count)
+				return false;
+			for (u32 i = 0; i < param.count(); i++)
+				if (!read(param.version[i]))
+					return false;
+		}
+		return true;
+	}
+
+	bool read(shil_opcode& op)
+	{
+		u8 opcode, size, delaySlot;
+		if (!read(opcode) || !read(size) || !read(op.guest_offs) || !read(delaySlot))
+			return false;
+		if (opcode >= shop_max)
+			return false;
+		op.op = (shilop)opcode;
+		op.size = size;
+		op.delay_slot = delaySlot != 0;
+		op.host_offs = 0;
+		return read(op.rd) && read(op.rd2) && read(op.rs1) && read(op.rs2) && read(op.rs3);
+	}
+
+	bool atEnd() const { return p == end; }
+
+private:
+	const u8 *p;
+	const u8 *end;
+};
+
+bool lookup(RuntimeBlockInfo *block)
+{
+	std::lock_guard<std::recursive_mutex> lock(mutex);
+	if (!isActive())
+		return false;
+	auto start = std::chrono::steady_clock::now();
+	auto it = entries.find(makeKey(block->addr, block->fpu_cfg.full));
+	if (it == entries.end())
+	{
+		stats.misses++;
+		return false;
+	}
+	const EntryHeader& header = it->second.header;
+	const bool readOnly = header.flags & ReadOnly;
+	u64 hash;
+	if (((header.flags & HasFpuOp) && sr.FD == 1)	// let the decoder raise the exception
+			|| bm_CanProtect(block->addr, header.sh4CodeSize) != readOnly
+			|| !hashGuestCode(block->addr, header.sh4CodeSize, readOnly, hash)
+			|| hash != header.hash)
+	{
+		stats.rejected++;
+		stats.misses++;
+		return false;
+	}
+	block->oplist.clear();
+	OpReader reader(it->second.ops);
+	while (!reader.atEnd())
+	{
+		shil_opcode op;
+		if (!reader.read(op))
+		{
+			WARN_LOG(DYNAREC, "blockcache: corrupted entry %08x", block->addr);
+			block->oplist.clear();
+			entries.erase(it);
+			stats.rejected++;
+			stats.misses++;
+			return false;
+		}
+		block->oplist.push_back(op);
+	}
+	block->sh4_code_size = header.sh4CodeSize;
+	block->guest_opcodes = header.guestOpcodes;
+	block->guest_cycles = header.guestCycles;
+	block->BlockType = (BlockEndType)header.blockType;
+	block->BranchBlock = header.branchBlock;
+	block->NextBlock = header.nextBlock;
+	block->has_fpu_op = header.flags & HasFpuOp;
+	block->has_jcond = header.flags & HasJcond;
+
+	stats.hits++;
+	stats.lookupTime += toMicros(std::chrono::steady_clock::now() - start);
+
+	return true;
+}
+
+void record(const RuntimeBlockInfo *block, std::chrono::steady_clock::duration frontendTime)
+{
+	std::lock_guard<std::recursive_mutex> lock(mutex);
+	// Traces span several blocks and depend on which blocks got hot during the session
+	if (!isActive() || block->trace)
+		return;
+	stats.frontendTime += toMicros(frontendTime);
+
+	Entry entry;
+	EntryHeader& header = entry.header;
+	if (!hashGuestCode(block->addr, block->sh4_code_size, block->read_only, header.hash))
+		return;
+	header.addr = block->addr;
+	header.fpuCfg = block->fpu_cfg.full & FPSCR_DECODE_MASK;
+	header.sh4CodeSize = block->sh4_code_size;
+	header.guestOpcodes = block->guest_opcodes;
+	header.guestCycles = block->guest_cycles;
+	header.blockType = block->BlockType;
+	header.branchBlock = block->BranchBlock;
+	header.nextBlock = block->NextBlock;
+	header.flags = (block->read_only ? ReadOnly : 0)
+			| (block->has_fpu_op ? HasFpuOp : 0)
+			| (block->has_jcond ? HasJcond : 0);
+
+	OpWriter writer(entry.ops);
+	for (const shil_opcode& op : block->oplist)
+		writer.write(op);
+	header.opsSize = (u32)entry.ops.size();
+
+	entries[makeKey(header.addr, header.fpuCfg)] = std::move(entry);
+	dirty = true;
+}
+
+static std::string getCachePath(const std::string& gameId)
+{
+	std::string name = gameId;
+	for (char& c : name)
+		if (!isalnum((u8)c) && c != '-' && c != '_')
+			c = '_';
+	return hostfs::getDynarecCachePath(name + ".dyncache");
+}
+
+void load(const std::string& gameId)
+{
+	std::lock_guard<std::recursive_mutex> lock(mutex);
+	if (gameId == currentGameId)
+		return;
+	save();
+	clear();
+	currentGameId = gameId;
+	if (!config::DynarecPersistentCache || gameId.empty())
+		return;
+
+	auto start = std::chrono::steady_clock::now();
+	std::string path = getCachePath(gameId);
+	FILE *f = nowide::fopen(path.c_str(), "rb");
+	if (f == nullptr)
+		return;
+	FileHeader fileHeader;
+	char buildId[16];
+	getBuildId(buildId);
+	if (std::fread(&fileHeader, sizeof(fileHeader), 1, f) != 1
+			|| fileHeader.magic != MAGIC
+			|| fileHeader.version != VERSION
+			|| memcmp(fileHeader.buildId, buildId, sizeof(buildId)) != 0
+			|| fileHeader.sh4Clock != config::Sh4Clock
+			|| fileHeader.ramSize != RAM_SIZE)
+	{
+		INFO_LOG(DYNAREC, "blockcache: ignoring outdated cache %s", path.c_str());
+		std::fclose(f);
+		return;
+	}
+	for (u32 i = 0; i < fileHeader.entryCount; i++)
+	{
+		Entry entry;
+		if (std::fread(&entry.header, sizeof(entry.header), 1, f) != 1)
+			break;
+		entry.ops.resize(entry.header.opsSize);
+		if (std::fread(entry.ops.data(), 1, entry.ops.size(), f) != entry.ops.size())
+			break;
+		u64 key = makeKey(entry.header.addr, entry.header.fpuCfg);
+		entries[key] = std::move(entry);
+	}
+	std::fclose(f);
+	if (entries.size() != fileHeader.entryCount)
+		WARN_LOG(DYNAREC, "blockcache: %s is truncated", path.c_str());
+	stats.loadTime = toMicros(std::chrono::steady_clock::now() - start);
+	INFO_LOG(DYNAREC, "blockcache: loaded %d blocks from %s in %d ms", (int)entries.size(), path.c_str(), (int)(stats.loadTime / 1000));
+}
+
+void save()
+{
+	std::lock_guard<std::recursive_mutex> lock(mutex);
+	if (currentGameId.empty())
+		return;
+	if (stats.hits + stats.misses > 0)
+	{
+		// Decoding+SSA time avoided by the cache hits, based on the average time spent on misses
+		u64 avgFrontend = stats.misses == 0 ? 0 : stats.frontendTime / stats.misses;
+		s64 saved = (s64)(avgFrontend * stats.hits) - (s64)(stats.lookupTime + stats.loadTime);
+		NOTICE_LOG(DYNAREC, "blockcache: %d hits %d misses (%d rejected). Decode+SSA: %d ms, lookup: %d ms, load: %d ms, estimated saving: %d ms",
+				stats.hits, stats.misses, stats.rejected, (int)(stats.frontendTime / 1000), (int)(stats.lookupTime / 1000),
+				(int)(stats.loadTime / 1000), (int)(saved / 1000));
+	}
+	if (!dirty)
+		return;
+	dirty = false;
+	std::string path = getCachePath(currentGameId);
+	FILE *f = nowide::fopen(path.c_str(), "wb");
+	if (f == nullptr)
+	{
+		WARN_LOG(DYNAREC, "blockcache: cannot create %s", path.c_str());
+		return;
+	}
+	FileHeader fileHeader;
+	fileHeader.magic = MAGIC;
+	fileHeader.version = VERSION;
+	getBuildId(fileHeader.buildId);
+	fileHeader.sh4Clock = config::Sh4Clock;
+	fileHeader.ramSize = RAM_SIZE;
+	fileHeader.entryCount = (u32)entries.size();
+	bool success = std::fwrite(&fileHeader, sizeof(fileHeader), 1, f) == 1;
+	for (const auto& it : entries)
+	{
+		if (!success)
+			break;
+		const Entry& entry = it.second;
+		success = std::fwrite(&entry.header, sizeof(entry.header), 1, f) == 1
+				&& std::fwrite(entry.ops.data(), 1, entry.ops.size(), f) == entry.ops.size();
+	}
+	std::fclose(f);
+	if (!success)
+	{
+		WARN_LOG(DYNAREC, "blockcache: error writing %s", path.c_str());
+		nowide::remove(path.c_str());
+	}
+	else {
+		INFO_LOG(DYNAREC, "blockcache: saved %d blocks to %s", (int)entries.size(), path.c_str());
+	}
+}
+
+void clear()
+{
+	std::lock_guard<std::recursive_mutex> lock(mutex);
+	entries.clear();
+	currentGameId.clear();
+	dirty = false;
+	stats = {};
+}
+
+const Stats& getStats() {
+	return stats;
+}
+
+static void emuEventCallback(Event event, void *)
+{
+	switch (event)
+	{
+	case Event::Start:
+		load(settings.content.gameId);
+		break;
+	case Event::Terminate:
+		save();
+		clear();
+		break;
+	default:
+		break;
+	}
+}
+
+void init()
+{
+	EventManager::listen(Event::Start, emuEventCallback);
+	EventManager::listen(Event::Terminate, emuEventCallback);
+}
+
+void term()
+{
+	EventManager::unlisten(Event::Start, emuEventCallback);
+	EventManager::unlisten(Event::Terminate, emuEventCallback);
+	save();
+	clear();
+}
+
+}	// namespace blockcache
+
+#endif	// FEAT_SHREC != DYNAREC_NONE
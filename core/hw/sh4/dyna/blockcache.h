@@ -0,0 +1,59 @@
+/*
+	Copyright 2026 flyinghead
+
+	This file is part of Flycast.
+
+    Flycast is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 2 of the License, or
+    (at your option) any later version.
+
+    Flycast is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Flycast.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#pragma once
+#include "types.h"
+#include <chrono>
+
+struct RuntimeBlockInfo;
+
+//
+// Persistent translation cache.
+// Stores the decoded and optimized shil opcode list of each block so that
+// the decoder and SSA passes can be skipped when the same game is booted again.
+// Entries are keyed by physical address and fpu config, and validated
+// against a hash of the guest code when looked up.
+//
+namespace blockcache
+{
+
+struct Stats
+{
+	u32 hits = 0;
+	u32 misses = 0;
+	u32 rejected = 0;		// entry found but guest code or protection differs
+	u64 frontendTime = 0;	// decoder + SSA time of cache misses (us)
+	u64 lookupTime = 0;		// hash check + opcode list restore time of cache hits (us)
+	u64 loadTime = 0;		// cache file load time (us)
+};
+
+void init();
+void term();
+
+// Fills in the block info and oplist if a valid entry exists for this block
+bool lookup(RuntimeBlockInfo *block);
+// Adds the block to the cache once it's been decoded and optimized. Traces aren't cached.
+void record(const RuntimeBlockInfo *block, std::chrono::steady_clock::duration frontendTime);
+
+void load(const std::string& gameId);
+void save();
+void clear();
+
+const Stats& getStats();
+
+}
@@ -4,8 +4,8 @@
 */
 
 #include <algorithm>
-#include <set>
-#include <map>
+#include <deque>
+#include <mutex>
 #include "blockmanager.h"
 #include "ngen.h"
 
@@ -25,17 +25,25 @@ op_agent_t          oprofHandle;
 #if FEAT_SHREC != DYNAREC_NONE
 
 
-typedef std::vector<RuntimeBlockInfoPtr> bm_List;
-typedef std::set<RuntimeBlockInfoPtr> bm_Set;
-typedef std::map<void*, RuntimeBlockInfoPtr> bm_Map;
+typedef std::vector<RuntimeBlockInfo*> bm_List;
 
-static bm_Set all_temp_blocks;
+static bm_List all_temp_blocks;
+// Discarded blocks. Kept alive until the next cleanup since their code may still be running.
 static bm_List del_blocks;
 
 bool unprotected_pages[RAM_SIZE_MAX/PAGE_SIZE];
-static std::set<RuntimeBlockInfo*> blocks_per_page[RAM_SIZE_MAX/PAGE_SIZE];
-
-static bm_Map blkmap;
+// Head of the intrusive list of protected blocks in each page
+static RuntimeBlockInfo *blocks_per_page[RAM_SIZE_MAX/PAGE_SIZE];
+
+// Host code address of a block, kept inline so that binary searches don't dereference the blocks
+struct BlockMapEntry
+{
+	const u8 *code;
+	RuntimeBlockInfo *block;	// nullptr once the block is discarded
+};
+// All blocks, sorted by host code address. Discarded blocks leave an empty entry until the next compaction.
+static std::vector<BlockMapEntry> blkmap;
+static u32 discardedEntries;
 // Stats
 u32 protected_blocks;
 u32 unprotected_blocks;
@@ -98,11 +106,11 @@ DynarecCodeEntryPtr DYNACALL bm_GetCodeByVAddr(u32 addr)
 	}
 
 	u32 paddr;
-	MmuError rv = mmu_instruction_translation(addr, paddr);
+	MmuError rv = mmu_cached_instruction_translation(addr, paddr);
 	if (rv != MmuError::NONE)
 	{
 		DoMMUException(addr, rv, MMU_TT_IREAD);
-		mmu_instruction_translation(next_pc, paddr);
+		mmu_cached_instruction_translation(next_pc, paddr);
 	}
 
 	return bm_GetCode(paddr);
@@ -110,7 +118,7 @@ DynarecCodeEntryPtr DYNACALL bm_GetCodeByVAddr(u32 addr)
 
 // addr must be a physical address
 // This returns an executable address
-RuntimeBlockInfoPtr DYNACALL bm_GetBlock(u32 addr)
+RuntimeBlockInfo* DYNACALL bm_GetBlock(u32 addr)
 {
 	DynarecCodeEntryPtr cde = bm_GetCode(addr);  // Returns RX ptr
 
@@ -120,33 +128,54 @@ RuntimeBlockInfoPtr DYNACALL bm_GetBlock(u32 addr)
 		return bm_GetBlock((void*)cde);  // Returns RX pointer
 }
 
+// Returns the first entry whose code addr is bigger than code (or end)
+static std::vector<BlockMapEntry>::iterator bm_UpperBound(const void *code)
+{
+	return std::upper_bound(blkmap.begin(), blkmap.end(), (const u8 *)code,
+			[](const u8 *code, const BlockMapEntry& entry) {
+				return code < entry.code;
+			});
+}
+
+// Removes the entries of discarded blocks once they make up half of the map
+static void bm_CompactMap()
+{
+	if (discardedEntries < 1024 || discardedEntries < blkmap.size() / 2)
+		return;
+	blkmap.erase(std::remove_if(blkmap.begin(), blkmap.end(), [](const BlockMapEntry& entry) {
+			return entry.block == nullptr;
+		}), blkmap.end());
+	discardedEntries = 0;
+}
+
 // This takes a RX address and returns the info block ptr (RW space)
-RuntimeBlockInfoPtr bm_GetBlock(void* dynarec_code)
+RuntimeBlockInfo* bm_GetBlock(void* dynarec_code)
 {
 	if (blkmap.empty())
 		return NULL;
 
-	void *dynarecrw = CC_RX2RW(dynarec_code);
-	// Returns a block who's code addr is bigger than dynarec_code (or end)
-	auto iter = blkmap.upper_bound(dynarecrw);
+	const u8 *dynarecrw = (const u8 *)CC_RX2RW(dynarec_code);
+	auto iter = bm_UpperBound(dynarecrw);
 	if (iter == blkmap.begin())
 		return NULL;
 	iter--;  // Need to go back to find the potential candidate
 
-	// However it might be out of bounds, check for that
-	if (!iter->second->containsCode(dynarecrw))
+	// However it might be discarded or out of bounds, check for that
+	if (iter->block == nullptr || !iter->block->containsCode(dynarecrw))
 		return NULL;
 
-	return iter->second;
+	return iter->block;
 }
 
 static void bm_CleanupDeletedBlocks()
 {
+	for (RuntimeBlockInfo *block : del_blocks)
+		delete block;
 	del_blocks.clear();
 }
 
 // Takes RX pointer and returns a RW pointer
-RuntimeBlockInfoPtr bm_GetStaleBlock(void* dynarec_code)
+RuntimeBlockInfo* bm_GetStaleBlock(void* dynarec_code)
 {
 	void *dynarecrw = CC_RX2RW(dynarec_code);
 	if (del_blocks.empty())
@@ -163,17 +192,41 @@ RuntimeBlockInfoPtr bm_GetStaleBlock(void* dynarec_code)
 	return NULL;
 }
 
-void bm_AddBlock(RuntimeBlockInfo* blk)
+void bm_AddBlock(RuntimeBlockInfo* block)
 {
-	RuntimeBlockInfoPtr block(blk);
 	if (block->temp_block)
-		all_temp_blocks.insert(block);
-	auto iter = blkmap.find((void*)blk->code);
-	if (iter != blkmap.end()) {
-		ERROR_LOG(DYNAREC, "DUP: %08X %p %08X %p", iter->second->addr, iter->second->code, block->addr, block->code);
-		die("Duplicated block");
+		all_temp_blocks.push_back(block);
+	// Blocks are usually emitted at increasing addresses so this is an append
+	const u8 *code = (const u8 *)block->code;
+	auto iter = bm_UpperBound(code);
+	if (iter != blkmap.begin() && (iter - 1)->code == code)
+	{
+		iter--;
+		if (iter->block != nullptr) {
+			ERROR_LOG(DYNAREC, "DUP: %08X %p %08X %p", iter->block->addr, iter->block->code, block->addr, block->code);
+			die("Duplicated block");
+		}
+		// Reuse the entry of a discarded block emitted at the same address
+		iter->block = block;
+		discardedEntries--;
+	}
+	else
+	{
+		iter = blkmap.insert(iter, { code, block });
+	}
+	// Drop the entries of discarded blocks whose code has been overwritten
+	auto next = iter + 1;
+	auto end = next;
+	while (end != blkmap.end() && end->code < code + block->host_code_size)
+	{
+		verify(end->block == nullptr);
+		++end;
+	}
+	if (end != next)
+	{
+		discardedEntries -= end - next;
+		blkmap.erase(next, end);
 	}
-	blkmap[(void*)block->code] = block;
 
 	verify((void*)bm_GetCode(block->addr) == (void*)ngen_FailedToFindBlock);
 	FPCA(block->addr) = (DynarecCodeEntryPtr)CC_RW2RX(block->code);
@@ -194,28 +247,39 @@ void bm_AddBlock(RuntimeBlockInfo* blk)
 
 }
 
+// Removes the block from the predecessor lists of the blocks it's linked to
+static void bm_RemoveLinks(RuntimeBlockInfo* block)
+{
+	if (block->pNextBlock != nullptr)
+		block->pNextBlock->RemRef(block);
+	if (block->pBranchBlock != nullptr && block->pBranchBlock != block->pNextBlock)
+		block->pBranchBlock->RemRef(block);
+}
+
 void bm_DiscardBlock(RuntimeBlockInfo* block)
 {
 	// Remove from block map
-	auto it = blkmap.find((void*)block->code);
-	verify(it != blkmap.end());
-	RuntimeBlockInfoPtr block_ptr = it->second;
-
-	blkmap.erase(it);
+	auto it = bm_UpperBound((void*)block->code);
+	verify(it != blkmap.begin() && (it - 1)->block == block);
+	(it - 1)->block = nullptr;
+	discardedEntries++;
 
-	block_ptr->pNextBlock = NULL;
-	block_ptr->pBranchBlock = NULL;
-	block_ptr->Relink();
+	bm_RemoveLinks(block);
+	block->pNextBlock = NULL;
+	block->pBranchBlock = NULL;
+	block->Relink();
 
 	// Remove from jump table
-	verify((void*)bm_GetCode(block_ptr->addr) == CC_RW2RX((void*)block_ptr->code));
-	FPCA(block_ptr->addr) = ngen_FailedToFindBlock;
+	verify((void*)bm_GetCode(block->addr) == CC_RW2RX((void*)block->code));
+	FPCA(block->addr) = ngen_FailedToFindBlock;
+
+	if (block->temp_block)
+		all_temp_blocks.erase(std::find(all_temp_blocks.begin(), all_temp_blocks.end(), block));
 
-	if (block_ptr->temp_block)
-		all_temp_blocks.erase(block_ptr);
+	del_blocks.push_back(block);
+	block->Discard();
 
-	del_blocks.push_back(block_ptr);
-	block_ptr->Discard();
+	bm_CompactMap();
 }
 
 void bm_Periodical_1s()
@@ -264,7 +328,10 @@ void bm_LockPage(u32 addr, u32 size)
 {
 	addr = addr & (RAM_MASK - PAGE_MASK);
 	if (addrspace::virtmemEnabled())
+	{
 		virtmem::region_lock(addrspace::ram_base + 0x0C000000 + addr, size);
+		mmumirror::lockRam(addr, size);
+	}
 	else
 		virtmem::region_lock(&mem_b[addr], size);
 }
@@ -283,9 +350,11 @@ void bm_ResetCache()
 	ngen_ResetBlocks();
 	addrspace::bm_reset();
 
-	for (const auto& it : blkmap)
+	for (const BlockMapEntry& entry : blkmap)
 	{
-		RuntimeBlockInfoPtr block = it.second;
+		RuntimeBlockInfo *block = entry.block;
+		if (block == nullptr)
+			continue;
 		block->relink_data = 0;
 		block->pNextBlock = NULL;
 		block->pBranchBlock = NULL;
@@ -297,11 +366,11 @@ void bm_ResetCache()
 	}
 
 	blkmap.clear();
+	discardedEntries = 0;
 	// blkmap includes temp blocks as well
 	all_temp_blocks.clear();
 
-	for (auto& block_list : blocks_per_page)
-		block_list.clear();
+	memset(blocks_per_page, 0, sizeof(blocks_per_page));
 
 	memset(unprotected_pages, 0, sizeof(unprotected_pages));
 
@@ -323,11 +392,16 @@ void bm_ResetTempCache(bool full)
 {
 	if (!full)
 	{
-		for (const auto& block : all_temp_blocks)
+		for (RuntimeBlockInfo *block : all_temp_blocks)
 		{
 			FPCA(block->addr) = ngen_FailedToFindBlock;
-			blkmap.erase((void*)block->code);
+			bm_RemoveLinks(block);
+			block->Discard();
 		}
+		blkmap.erase(std::remove_if(blkmap.begin(), blkmap.end(), [](const BlockMapEntry& entry) {
+				return entry.block == nullptr || entry.block->temp_block;
+			}), blkmap.end());
+		discardedEntries = 0;
 	}
 	del_blocks.insert(del_blocks.begin(),all_temp_blocks.begin(),all_temp_blocks.end());
 	all_temp_blocks.clear();
@@ -360,9 +434,11 @@ void bm_WriteBlockMap(const std::string& file)
 	if (f)
 	{
 		INFO_LOG(DYNAREC, "Writing block map !");
-		for (auto& it : blkmap)
+		for (const BlockMapEntry& entry : blkmap)
 		{
-			RuntimeBlockInfoPtr& block = it.second;
+			RuntimeBlockInfo *block = entry.block;
+			if (block == nullptr)
+				continue;
 			fprintf(f, "block: %d:%08X:%p:%d:%d:%d\n", block->BlockType, block->addr, block->code, block->host_code_size, block->guest_cycles, block->guest_opcodes);
 			for(size_t j = 0; j < block->oplist.size(); j++)
 				fprintf(f,"\top: %zd:%d:%s\n", j, block->oplist[j].guest_offs, block->oplist[j].dissasm().c_str());
@@ -374,10 +450,10 @@ void bm_WriteBlockMap(const std::string& file)
 
 void sh4_jitsym(FILE* out)
 {
-	for (const auto& it : blkmap)
+	for (const BlockMapEntry& entry : blkmap)
 	{
-		const RuntimeBlockInfoPtr& block = it.second;
-		fprintf(out, "%p %d %08X\n", block->code, block->host_code_size, block->addr);
+		if (entry.block != nullptr)
+			fprintf(out, "%p %d %08X\n", entry.code, entry.block->host_code_size, entry.block->addr);
 	}
 }
 
@@ -498,22 +574,113 @@ RuntimeBlockInfo::~RuntimeBlockInfo()
 	}
 }
 
-void RuntimeBlockInfo::AddRef(const RuntimeBlockInfoPtr& other)
+//
+// Slab allocator for block infos.
+// All the blocks of a dynarec have the same size so there's a single pool in practice.
+// Slabs are never released and reused when blocks are freed.
+// Blocks can be allocated and freed by the background compiler thread.
+//
+class BlockAllocator
+{
+public:
+	void *allocate(size_t size)
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		Pool& pool = getPool(size);
+		if (pool.freeList == nullptr)
+			grow(pool);
+		FreeSlot *slot = pool.freeList;
+		pool.freeList = slot->next;
+		return slot;
+	}
+
+	void release(void *p, size_t size)
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		Pool& pool = getPool(size);
+		FreeSlot *slot = (FreeSlot *)p;
+		slot->next = pool.freeList;
+		pool.freeList = slot;
+	}
+
+private:
+	struct FreeSlot {
+		FreeSlot *next;
+	};
+	struct Pool
+	{
+		size_t slotSize;
+		FreeSlot *freeList;
+	};
+	static constexpr size_t SlabSize = 64 * 1024;
+	static constexpr size_t SlotAlign = alignof(std::max_align_t);
+
+	Pool& getPool(size_t size)
+	{
+		size = (size + SlotAlign - 1) & ~(SlotAlign - 1);
+		for (Pool& pool : pools)
+			if (pool.slotSize == size)
+				return pool;
+		pools.push_back({ size, nullptr });
+		return pools.back();
+	}
+
+	void grow(Pool& pool)
+	{
+		u8 *slab = (u8 *)::operator new(SlabSize);
+		slabs.push_back(slab);
+		for (size_t offset = SlabSize / pool.slotSize * pool.slotSize; offset > 0; )
+		{
+			offset -= pool.slotSize;
+			FreeSlot *slot = (FreeSlot *)&slab[offset];
+			slot->next = pool.freeList;
+			pool.freeList = slot;
+		}
+	}
+
+	std::deque<Pool> pools;
+	std::vector<u8 *> slabs;
+	std::mutex mutex;
+};
+
+// Never destroyed since blocks may be freed during static destruction
+static BlockAllocator& blockAllocator()
+{
+	static BlockAllocator *allocator = new BlockAllocator();
+	return *allocator;
+}
+
+void *RuntimeBlockInfo::operator new(size_t size)
+{
+	return blockAllocator().allocate(size);
+}
+
+void RuntimeBlockInfo::operator delete(void *p, size_t size)
+{
+	blockAllocator().release(p, size);
+}
+
+void RuntimeBlockInfo::AddRef(RuntimeBlockInfo* other)
 { 
 	pre_refs.push_back(other); 
 }
 
-void RuntimeBlockInfo::RemRef(const RuntimeBlockInfoPtr& other)
+void RuntimeBlockInfo::RemRef(RuntimeBlockInfo* other)
 {
 	auto it = std::find(pre_refs.begin(), pre_refs.end(), other);
 	if (it != pre_refs.end())
 		pre_refs.erase(it);
 }
 
+static u32 pageSlot(const RuntimeBlockInfo *block, u32 page)
+{
+	return page == (block->addr & RAM_MASK) / PAGE_SIZE ? 0 : 1;
+}
+
 void RuntimeBlockInfo::Discard()
 {
 	// Update references
-	for (RuntimeBlockInfoPtr& ref : pre_refs)
+	for (RuntimeBlockInfo *ref : pre_refs)
 	{
 		if (ref->pNextBlock == this)
 			ref->pNextBlock = nullptr;
@@ -529,42 +696,60 @@ void RuntimeBlockInfo::Discard()
 		// Remove this block from the per-page block lists
 		for (u32 addr = this->addr & ~PAGE_MASK; addr < this->addr + this->sh4_code_size; addr += PAGE_SIZE)
 		{
-			auto& block_list = blocks_per_page[(addr & RAM_MASK) / PAGE_SIZE];
-			block_list.erase(this);
+			u32 page = (addr & RAM_MASK) / PAGE_SIZE;
+			PageLink& link = pageLinks[pageSlot(this, page)];
+			if (link.prev != nullptr)
+				link.prev->pageLinks[pageSlot(link.prev, page)].next = link.next;
+			else
+				blocks_per_page[page] = link.next;
+			if (link.next != nullptr)
+				link.next->pageLinks[pageSlot(link.next, page)].prev = link.prev;
+			link = {};
 		}
 	}
 }
 
+bool bm_CanProtect(u32 addr, u32 size)
+{
+#ifdef TARGET_NO_EXCEPTIONS
+	return false;
+#endif
+	// Don't write protect rom and BIOS/IP.BIN (Grandia II)
+	if (!IsOnRam(addr) || (addr & 0x1FFF0000) == 0x0c000000)
+		return false;
+	// A block can only be linked in 2 page lists
+	if (size > 0 && ((addr + size - 1) & ~PAGE_MASK) - (addr & ~PAGE_MASK) > PAGE_SIZE)
+		return false;
+	for (u32 page = addr & ~PAGE_MASK; page < addr + size; page += PAGE_SIZE)
+		if (unprotected_pages[(page & RAM_MASK) / PAGE_SIZE])
+			return false;
+	return true;
+}
+
 void RuntimeBlockInfo::SetProtectedFlags()
 {
 #ifdef TARGET_NO_EXCEPTIONS
 	this->read_only = false;
 	return;
 #endif
-	// Don't write protect rom and BIOS/IP.BIN (Grandia II)
-	if (!IsOnRam(addr) || (addr & 0x1FFF0000) == 0x0c000000)
+	if (!bm_CanProtect(addr, sh4_code_size))
 	{
 		this->read_only = false;
 		unprotected_blocks++;
 		return;
 	}
-	for (u32 addr = this->addr & ~PAGE_MASK; addr < this->addr + sh4_code_size; addr += PAGE_SIZE)
-	{
-		if (unprotected_pages[(addr & RAM_MASK) / PAGE_SIZE])
-		{
-			this->read_only = false;
-			unprotected_blocks++;
-			return;
-		}
-	}
 	this->read_only = true;
 	protected_blocks++;
 	for (u32 addr = this->addr & ~PAGE_MASK; addr < this->addr + sh4_code_size; addr += PAGE_SIZE)
 	{
-		auto& block_list = blocks_per_page[(addr & RAM_MASK) / PAGE_SIZE];
-		if (block_list.empty())
+		u32 page = (addr & RAM_MASK) / PAGE_SIZE;
+		RuntimeBlockInfo *head = blocks_per_page[page];
+		if (head == nullptr)
 			bm_LockPage(addr);
-		block_list.insert(this);
+		else
+			head->pageLinks[pageSlot(head, page)].prev = this;
+		pageLinks[pageSlot(this, page)] = { nullptr, head };
+		blocks_per_page[page] = this;
 	}
 }
 
@@ -576,16 +761,13 @@ void bm_RamWriteAccess(u32 addr)
 
 	unprotected_pages[addr / PAGE_SIZE] = true;
 	bm_UnlockPage(addr);
-	std::set<RuntimeBlockInfo*>& block_list = blocks_per_page[addr / PAGE_SIZE];
-	if (!block_list.empty())
+	RuntimeBlockInfo *&block_list = blocks_per_page[addr / PAGE_SIZE];
+	if (block_list != nullptr)
 	{
-		std::vector<RuntimeBlockInfo*> list_copy;
-		list_copy.insert(list_copy.begin(), block_list.begin(), block_list.end());
-		if (!list_copy.empty())
-			DEBUG_LOG(DYNAREC, "bm_RamWriteAccess write access to %08x pc %08x", addr, next_pc);
-		for (auto& block : list_copy)
-			bm_DiscardBlock(block);
-		verify(block_list.empty());
+		DEBUG_LOG(DYNAREC, "bm_RamWriteAccess write access to %08x pc %08x", addr, next_pc);
+		// Discarding a block removes it from the list
+		while (block_list != nullptr)
+			bm_DiscardBlock(block_list);
 	}
 }
 
@@ -654,12 +836,14 @@ void print_blocks()
 		INFO_LOG(DYNAREC, "Writing blocks to %p", f);
 	}
 
-	for (auto it : blkmap)
+	for (const BlockMapEntry& entry : blkmap)
 	{
-		RuntimeBlockInfoPtr blk = it.second;
+		RuntimeBlockInfo *blk = entry.block;
+		if (blk == nullptr)
+			continue;
 		if (f)
 		{
-			fprintf(f,"block: %p\n",blk.get());
+			fprintf(f,"block: %p\n",blk);
 			fprintf(f,"vaddr: %08X\n",blk->vaddr);
 			fprintf(f,"paddr: %08X\n",blk->addr);
 			fprintf(f,"code: %p\n",blk->code);
@@ -4,15 +4,12 @@
 #include "decoder.h"
 #include "stdclass.h"
 
-#include <memory>
-
 typedef void (*DynarecCodeEntryPtr)();
-struct RuntimeBlockInfo;
-typedef std::shared_ptr<RuntimeBlockInfo> RuntimeBlockInfoPtr;
 
 struct RuntimeBlockInfo
 {
-	bool Setup(u32 pc,fpscr_t fpu_cfg);
+	// background: called from the compiler thread. CPU state isn't modified and protection isn't set.
+	bool Setup(u32 pc, fpscr_t fpu_cfg, bool background = false);
 
 	u32 addr;
 	DynarecCodeEntryPtr code;
@@ -32,6 +29,7 @@ struct RuntimeBlockInfo
 	bool has_fpu_op;
 	u32 blockcheck_failures;
 	bool temp_block;
+	bool trace;			// decoded across unconditional branches
 
 	u32 BranchBlock; //if not 0xFFFFFFFF then jump target
 	u32 NextBlock;   //if not 0xFFFFFFFF then next block (by position)
@@ -58,23 +56,35 @@ struct RuntimeBlockInfo
 	virtual u32 Relink()=0;
 	
 	//predecessors references
-	std::vector<RuntimeBlockInfoPtr> pre_refs;
+	std::vector<RuntimeBlockInfo*> pre_refs;
 
-	void AddRef(const RuntimeBlockInfoPtr& other);
-	void RemRef(const RuntimeBlockInfoPtr& other);
+	void AddRef(RuntimeBlockInfo* other);
+	void RemRef(RuntimeBlockInfo* other);
 
 	void Discard();
 	void SetProtectedFlags();
 
 	bool read_only;
+
+	// Links in the per-page lists of protected blocks. A protected block spans 2 pages at most.
+	struct PageLink
+	{
+		RuntimeBlockInfo *prev;
+		RuntimeBlockInfo *next;
+	};
+	PageLink pageLinks[2] {};
+
+	// Block infos are allocated from a slab allocator
+	static void *operator new(size_t size);
+	static void operator delete(void *p, size_t size);
 };
 
 void bm_WriteBlockMap(const std::string& file);
 
 DynarecCodeEntryPtr DYNACALL bm_GetCodeByVAddr(u32 addr);
-RuntimeBlockInfoPtr bm_GetBlock(void* dynarec_code);
-RuntimeBlockInfoPtr bm_GetStaleBlock(void* dynarec_code);
-RuntimeBlockInfoPtr DYNACALL bm_GetBlock(u32 addr);
+RuntimeBlockInfo* bm_GetBlock(void* dynarec_code);
+RuntimeBlockInfo* bm_GetStaleBlock(void* dynarec_code);
+RuntimeBlockInfo* DYNACALL bm_GetBlock(u32 addr);
 
 void bm_AddBlock(RuntimeBlockInfo* blk);
 void bm_DiscardBlock(RuntimeBlockInfo* block);
@@ -95,6 +105,8 @@ static inline bool bm_IsRamPageProtected(u32 addr)
 	addr &= RAM_MASK;
 	return !unprotected_pages[addr / PAGE_SIZE];
 }
+// Returns true if the given code range can be write-protected
+bool bm_CanProtect(u32 addr, u32 size);
 void bm_LockPage(u32 addr, u32 size = PAGE_SIZE);
 void bm_UnlockPage(u32 addr, u32 size = PAGE_SIZE);
 u32 bm_getRamOffset(void *p);
@@ -947,7 +947,30 @@ void dec_updateBlockCycles(RuntimeBlockInfo *block, u16 op)
 	block->guest_cycles += cycleCounter.countCycles(op);
 }
 
-bool dec_DecodeBlock(RuntimeBlockInfo* rbi,u32 max_cycles)
+// Continue decoding a trace block at the target of the static branch that just ended it
+static bool dec_ExtendTrace(u32 max_cycles)
+{
+	if (state.BlockType != BET_StaticJump && state.BlockType != BET_StaticCall)
+		return false;
+	// Only delayed branches (bra, bsr). Other static jumps end blocks when they're too long or after an fpscr change.
+	if (!state.cpu.is_delayslot || OpDesc[IReadMem16(state.cpu.rpc - 2)]->SetFPSCR())
+		return false;
+	// Only forward branches so that the block code is a single range
+	if (state.JumpAddr < state.cpu.rpc || state.JumpAddr - blk->vaddr >= TRACE_MAX_SIZE)
+		return false;
+	if (blk->oplist.size() >= BLOCK_MAX_SH_OPS_SOFT || blk->guest_cycles >= max_cycles)
+		return false;
+
+	state.cpu.rpc = state.JumpAddr;
+	state.cpu.is_delayslot = false;
+	state.NextOp = NDO_NextOp;
+	state.BlockType = BET_SCL_Intr;
+	state.JumpAddr = NullAddress;
+	state.NextAddr = NullAddress;
+	return true;
+}
+
+bool dec_DecodeBlock(RuntimeBlockInfo* rbi, u32 max_cycles, bool checkFpuDisabled)
 {
 	blk=rbi;
 	state_Setup(blk->vaddr, blk->fpu_cfg);
@@ -981,7 +1004,7 @@ bool dec_DecodeBlock(RuntimeBlockInfo* rbi,u32 max_cycles)
 
 					if (OpDesc[op]->IsFloatingPoint())
 					{
-						if (sr.FD == 1)
+						if (checkFpuDisabled && sr.FD == 1)
 						{
 							// We need to know FPSCR to compile the block, so let the exception handler run first
 							// as it may change the fp registers
@@ -1019,6 +1042,8 @@ bool dec_DecodeBlock(RuntimeBlockInfo* rbi,u32 max_cycles)
 			break;
 
 		case NDO_End:
+			if (blk->trace && dec_ExtendTrace(max_cycles))
+				continue;
 			// Disabled for now since we need to know if the block is read-only,
 			// which isn't determined until after the decoding.
 			// This is a relatively rare optimization anyway
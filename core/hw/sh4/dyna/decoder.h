@@ -37,8 +37,13 @@ enum NextDecoderOperation
 	NDO_Delayslot,  //pc+=2, NextOp=DelayOp
 };
 
+// Trace blocks follow forward unconditional branches up to this distance from the block start
+#define TRACE_MAX_SIZE 1024
+
 struct RuntimeBlockInfo;
-bool dec_DecodeBlock(RuntimeBlockInfo* rbi,u32 max_cycles);
+// checkFpuDisabled: raise the FPU disabled exception if the block contains fpu ops and sr.FD is set.
+// Must be false when not decoding on the emulator thread.
+bool dec_DecodeBlock(RuntimeBlockInfo* rbi, u32 max_cycles, bool checkFpuDisabled = true);
 void dec_updateBlockCycles(RuntimeBlockInfo *block, u16 op);
 
 struct state_t
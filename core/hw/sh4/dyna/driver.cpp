@@ -1,9 +1,16 @@
 #include "types.h"
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
 #include <unordered_set>
+#include <xxhash.h>
 
 #include "hw/sh4/sh4_interpreter.h"
 #include "hw/sh4/sh4_core.h"
 #include "hw/sh4/sh4_interrupts.h"
+#include "hw/sh4/sh4_opcode_list.h"
+#include "hw/sh4/sh4_cycles.h"
 
 #include "hw/sh4/sh4_mem.h"
 #include "hw/sh4/modules/mmu.h"
@@ -11,9 +18,11 @@
 #include <ctime>
 
 #include "blockmanager.h"
+#include "blockcache.h"
 #include "ngen.h"
 #include "decoder.h"
 #include "oslib/virtmem.h"
+#include "cfg/option.h"
 
 #if FEAT_SHREC != DYNAREC_NONE
 
@@ -42,11 +51,288 @@ static u32 *emit_ptr;
 static u32 *emit_ptr_limit;
 
 static std::unordered_set<u32> smc_hotspots;
+// Hot blocks to be recompiled as traces
+static std::unordered_set<u32> trace_blocks;
+#if !defined(NDEBUG) || defined(DEBUGFAST)
+u64 rdv_dispatchCount;
+#endif
+// Held while using the decoder, the SSA optimizer, the code generator and the code buffer
+static std::mutex compileMutex;
 
 static sh4_if sh4Interp;
 
 void* emit_GetCCPtr() { return emit_ptr==0?(void*)&CodeCache[LastAddr]:(void*)emit_ptr; }
 
+static void ngen_FailedToFindBlock_internal();
+
+static bool isCacheClearPC(u32 pc) {
+	return pc == 0x8c0000e0 || pc == 0xac010000 || pc == 0xac008300;
+}
+
+static bool isResetPC(u32 pc) {
+	return (pc & 0xFFFFFF) == 0x08300 || (pc & 0xFFFFFF) == 0x10000;
+}
+
+//
+// Background block compilation.
+// When a block isn't found, it is queued for compilation on a worker thread and
+// the guest code is interpreted until the compiled block is available.
+// Blocks are validated again on the emulator thread before being added to the block manager.
+//
+class AsyncCompiler
+{
+	struct Request
+	{
+		u32 pc;
+		fpscr_t fpu_cfg;
+		u32 generation;
+		u64 codeHash;
+	};
+	struct Result
+	{
+		Request request;
+		RuntimeBlockInfo *block;	// null if compilation failed
+	};
+
+public:
+	~AsyncCompiler() {
+		stop();
+	}
+
+	// Requires a dispatcher that returns to the main loop on block misses, and
+	// is disabled when deterministic execution is needed (netplay)
+	bool isActive() const
+	{
+		return config::DynarecAsyncCompile && !config::GGPOEnable && !mmu_enabled()
+				&& ngen_FailedToFindBlock == &ngen_FailedToFindBlock_internal;
+	}
+
+	// Called on the emulator thread when no block exists for pc.
+	// Returns false if the block must be compiled synchronously.
+	bool handleMiss(u32 pc)
+	{
+		publish();
+		if (bm_GetCodeByVAddr(pc) != ngen_FailedToFindBlock)
+			return true;
+		if (pending.count(pc) == 0 && (!canCompile(pc) || !enqueue(pc)))
+			return false;
+		interpret();
+		return true;
+	}
+
+	// Drops all queued and compiled blocks. compileMutex must be held.
+	void reset()
+	{
+		std::lock_guard<std::mutex> lock(queueMutex);
+		generation++;
+		requests.clear();
+		for (const Result& result : results)
+			discard(result.block);
+		results.clear();
+		pending.clear();
+		syncOnly.clear();
+	}
+
+	void stop()
+	{
+		if (!thread.joinable())
+			return;
+		{
+			std::lock_guard<std::mutex> lock(queueMutex);
+			stopping = true;
+		}
+		cond.notify_one();
+		thread.join();
+		stopping = false;
+		std::lock_guard<std::mutex> lock(compileMutex);
+		reset();
+	}
+
+private:
+	static constexpr size_t MaxRequests = 64;
+	static constexpr int MaxInterpretedOps = 64;
+	// 4K page of the block start and the next one: a block never spans more than 2 pages
+	static constexpr u32 CodeWindowSize = 8192;
+
+	static u32 codeWindowOffset(u32 pc) {
+		return pc & RAM_MASK & ~0xfff;
+	}
+
+	// The decoder reads the block code and the SSA passes may read constants
+	// and branch targets in the block pages
+	static u64 hashCodeWindow(u32 pc) {
+		return XXH64(&mem_b[codeWindowOffset(pc)], CodeWindowSize, 0);
+	}
+
+	bool canCompile(u32 pc) const
+	{
+		return (pc & 1) == 0
+				&& IsOnRam(pc)
+				&& codeWindowOffset(pc) + CodeWindowSize <= RAM_SIZE
+				// the decoder must raise the fpu disabled exception
+				&& sr.FD == 0
+				&& !isCacheClearPC(pc)
+				&& trace_blocks.count(pc) == 0
+				&& syncOnly.count(pc) == 0;
+	}
+
+	bool enqueue(u32 pc)
+	{
+		{
+			std::lock_guard<std::mutex> lock(queueMutex);
+			if (requests.size() >= MaxRequests)
+				return false;
+			requests.push_back({ pc, fpscr, generation, hashCodeWindow(pc) });
+		}
+		pending.insert(pc);
+		if (!thread.joinable())
+			thread = std::thread(&AsyncCompiler::run, this);
+		cond.notify_one();
+		return true;
+	}
+
+	// Adds the compiled blocks to the block manager if they are still valid
+	void publish()
+	{
+		std::vector<Result> completed;
+		{
+			std::lock_guard<std::mutex> lock(queueMutex);
+			if (results.empty())
+				return;
+			std::swap(completed, results);
+		}
+		for (const Result& result : completed)
+		{
+			const Request& request = result.request;
+			pending.erase(request.pc);
+			RuntimeBlockInfo *block = result.block;
+			if (block == nullptr)
+			{
+				syncOnly.insert(request.pc);
+				continue;
+			}
+			if (request.generation != generation
+					|| bm_GetCodeByVAddr(request.pc) != ngen_FailedToFindBlock)
+			{
+				discard(block);
+				continue;
+			}
+			if (((block->fpu_cfg.full ^ fpscr.full) & 0x00180003) != 0
+					|| (block->has_fpu_op && sr.FD == 1)
+					|| bm_CanProtect(block->addr, block->sh4_code_size) != block->read_only
+					|| hashCodeWindow(request.pc) != request.codeHash)
+			{
+				// the guest state changed while the block was compiled
+				discard(block);
+				syncOnly.insert(request.pc);
+				continue;
+			}
+			block->SetProtectedFlags();
+			bm_AddBlock(block);
+		}
+	}
+
+	static void discard(RuntimeBlockInfo *block)
+	{
+		if (block == nullptr)
+			return;
+		// protection flags haven't been set
+		block->sh4_code_size = 0;
+		delete block;
+	}
+
+	// Interprets guest code up to the next branch or SR change
+	void interpret()
+	{
+		cycles.reset();
+		int cycleCount = 0;
+		try {
+			for (int i = 0; i < MaxInterpretedOps; i++)
+			{
+				u16 op = IReadMem16(next_pc);
+				next_pc += 2;
+				sh4_opcodelistentry *desc = OpDesc[op];
+				cycleCount += cycles.countCycles(op);
+				if (sr.FD == 1 && desc->IsFloatingPoint())
+					RaiseFPUDisableException();
+				OpPtr[op](op);
+				if (desc->SetSR())
+				{
+					UpdateINTC();
+					break;
+				}
+				if (desc->SetPC())
+					break;
+			}
+		} catch (const SH4ThrownException& ex) {
+			Do_Exception(ex.epc, ex.expEvn);
+			// an exception requires the instruction pipeline to drain, so approx 5 cycles
+			cycleCount += 5;
+		}
+		// Same scaling as the dynarec blocks
+		Sh4cntx.cycle_counter -= (int)std::round(cycleCount * 200.f / std::max(1.f, (float)config::Sh4Clock));
+	}
+
+	void run()
+	{
+		for (;;)
+		{
+			Request request;
+			{
+				std::unique_lock<std::mutex> lock(queueMutex);
+				cond.wait(lock, [this]() { return stopping || !requests.empty(); });
+				if (stopping)
+					return;
+				request = requests.front();
+				requests.pop_front();
+			}
+			RuntimeBlockInfo *block = compile(request);
+			std::lock_guard<std::mutex> lock(queueMutex);
+			if (request.generation == generation)
+				results.push_back({ request, block });
+			else
+				discard(block);
+		}
+	}
+
+	RuntimeBlockInfo *compile(const Request& request)
+	{
+		std::lock_guard<std::mutex> lock(compileMutex);
+		// the emulator thread will clear the cache if needed
+		if (request.generation != generation || emit_FreeSpace() < 16 * 1024)
+			return nullptr;
+
+		RuntimeBlockInfo *block = ngen_AllocateBlock();
+		if (!block->Setup(request.pc, request.fpu_cfg, true))
+		{
+			discard(block);
+			return nullptr;
+		}
+		block->blockcheck_failures = 0;
+		block->staging_runs = 100;
+		ngen_Compile(block, !block->read_only, isResetPC(request.pc), false, true);
+		if (block->code == nullptr || hashCodeWindow(request.pc) != request.codeHash)
+		{
+			discard(block);
+			return nullptr;
+		}
+		return block;
+	}
+
+	std::thread thread;
+	std::mutex queueMutex;
+	std::condition_variable cond;
+	bool stopping = false;
+	u32 generation = 0;				// incremented when the code cache is cleared
+	std::deque<Request> requests;
+	std::vector<Result> results;
+	// emulator thread only
+	std::unordered_set<u32> pending;
+	std::unordered_set<u32> syncOnly;	// blocks that failed to compile or were rejected
+	Sh4Cycles cycles;
+};
+static AsyncCompiler asyncCompiler;
+
 static void clear_temp_cache(bool full)
 {
 	//printf("recSh4:Temp Code Cache clear at %08X\n", curr_pc);
@@ -54,13 +340,22 @@ static void clear_temp_cache(bool full)
 	bm_ResetTempCache(full);
 }
 
-static void recSh4_ClearCache()
+// compileMutex must be held
+static void clearCache()
 {
 	INFO_LOG(DYNAREC, "recSh4:Dynarec Cache clear at %08X free space %d", next_pc, emit_FreeSpace());
 	LastAddr = 0;
 	bm_ResetCache();
 	smc_hotspots.clear();
+	trace_blocks.clear();
 	clear_temp_cache(true);
+	asyncCompiler.reset();
+}
+
+static void recSh4_ClearCache()
+{
+	std::lock_guard<std::mutex> lock(compileMutex);
+	clearCache();
 }
 
 static void recSh4_Run()
@@ -94,7 +389,7 @@ u32 emit_FreeSpace()
 
 void AnalyseBlock(RuntimeBlockInfo* blk);
 
-bool RuntimeBlockInfo::Setup(u32 rpc,fpscr_t rfpu_cfg)
+bool RuntimeBlockInfo::Setup(u32 rpc, fpscr_t rfpu_cfg, bool background)
 {
 	staging_runs=addr=lookups=runs=host_code_size=0;
 	guest_cycles=guest_opcodes=host_opcodes=0;
@@ -107,9 +402,15 @@ bool RuntimeBlockInfo::Setup(u32 rpc,fpscr_t rfpu_cfg)
 	BlockType = BET_SCL_Intr;
 	has_fpu_op = false;
 	temp_block = false;
+	trace = false;
 	
 	vaddr = rpc;
-	if (vaddr & 1)
+	if (background)
+	{
+		// odd and mmu-translated addresses are never compiled in the background
+		addr = vaddr;
+	}
+	else if (vaddr & 1)
 	{
 		// read address error
 		Do_Exception(vaddr, Sh4Ex_AddressErrorRead);
@@ -132,27 +433,58 @@ bool RuntimeBlockInfo::Setup(u32 rpc,fpscr_t rfpu_cfg)
 	
 	oplist.clear();
 
-	try {
-		if (!dec_DecodeBlock(this, SH4_TIMESLICE / 2))
+	// trace_blocks is only used on the emulator thread
+	trace = !background && trace_blocks.count(addr) != 0;
+	if (!trace && blockcache::lookup(this))
+	{
+		if (background)
+			read_only = bm_CanProtect(addr, sh4_code_size);
+		else
+			SetProtectedFlags();
+		return true;
+	}
+	auto frontendStart = std::chrono::steady_clock::now();
+
+	if (background)
+	{
+		// Let the emulator thread handle exceptions when compiling the block
+		try {
+			if (!dec_DecodeBlock(this, SH4_TIMESLICE / 2, false))
+				return false;
+		} catch (const SH4ThrownException&) {
 			return false;
+		} catch (const FlycastException&) {
+			return false;
+		}
+		read_only = bm_CanProtect(addr, sh4_code_size);
 	}
-	catch (const SH4ThrownException& ex) {
-		Do_Exception(rpc, ex.expEvn);
-		return false;
+	else
+	{
+		try {
+			if (!dec_DecodeBlock(this, SH4_TIMESLICE / 2))
+				return false;
+		}
+		catch (const SH4ThrownException& ex) {
+			Do_Exception(rpc, ex.expEvn);
+			return false;
+		}
+		SetProtectedFlags();
 	}
-	SetProtectedFlags();
 
 	AnalyseBlock(this);
 
+	blockcache::record(this, std::chrono::steady_clock::now() - frontendStart);
+
 	return true;
 }
 
 DynarecCodeEntryPtr rdv_CompilePC(u32 blockcheck_failures)
 {
 	u32 pc=next_pc;
+	std::lock_guard<std::mutex> lock(compileMutex);
 
-	if (emit_FreeSpace()<16*1024 || pc==0x8c0000e0 || pc==0xac010000 || pc==0xac008300)
-		recSh4_ClearCache();
+	if (emit_FreeSpace() < 16 * 1024 || isCacheClearPC(pc))
+		clearCache();
 
 	RuntimeBlockInfo* rbi = ngen_AllocateBlock();
 
@@ -175,7 +507,7 @@ DynarecCodeEntryPtr rdv_CompilePC(u32 blockcheck_failures)
 	bool do_opts = !rbi->temp_block;
 	rbi->staging_runs=do_opts?100:-100;
 	bool block_check = !rbi->read_only;
-	ngen_Compile(rbi, block_check, (pc & 0xFFFFFF) == 0x08300 || (pc & 0xFFFFFF) == 0x10000, false, do_opts);
+	ngen_Compile(rbi, block_check, isResetPC(pc), false, do_opts);
 	verify(rbi->code!=0);
 
 	bm_AddBlock(rbi);
@@ -207,12 +539,35 @@ DynarecCodeEntryPtr DYNACALL rdv_FailedToFindBlock(u32 pc)
 	return code;
 }
 
-static void ngen_FailedToFindBlock_internal() {
+static void ngen_FailedToFindBlock_internal()
+{
+	if (asyncCompiler.isActive() && asyncCompiler.handleMiss(Sh4cntx.pc))
+		return;
 	rdv_FailedToFindBlock(Sh4cntx.pc);
 }
 
 void (*ngen_FailedToFindBlock)() = &ngen_FailedToFindBlock_internal;
 
+bool rdv_IsTraceCandidate(const RuntimeBlockInfo* block)
+{
+	return config::DynarecTraceCompile && !block->trace && !mmu_enabled()
+			&& (block->BlockType == BET_StaticJump || block->BlockType == BET_StaticCall)
+			&& block->BranchBlock > block->vaddr
+			&& block->BranchBlock - block->vaddr < TRACE_MAX_SIZE;
+}
+
+// addr must be the physical address of the start of the block
+void DYNACALL rdv_HotBlock(u32 addr)
+{
+	RuntimeBlockInfo *block = bm_GetBlock(addr);
+	if (block == nullptr)
+		return;
+	DEBUG_LOG(DYNAREC, "rdv_HotBlock: recompiling %08x as a trace", addr);
+	trace_blocks.insert(addr);
+	// The block code stays valid until the next cleanup
+	bm_DiscardBlock(block);
+}
+
 // addr must be the physical address of the start of the block
 DynarecCodeEntryPtr DYNACALL rdv_BlockCheckFail(u32 addr)
 {
@@ -220,7 +575,7 @@ DynarecCodeEntryPtr DYNACALL rdv_BlockCheckFail(u32 addr)
 	u32 blockcheck_failures = 0;
 	if (mmu_enabled())
 	{
-		RuntimeBlockInfoPtr block = bm_GetBlock(addr);
+		RuntimeBlockInfo *block = bm_GetBlock(addr);
 		if (block)
 		{
 			blockcheck_failures = block->blockcheck_failures + 1;
@@ -230,7 +585,7 @@ DynarecCodeEntryPtr DYNACALL rdv_BlockCheckFail(u32 addr)
 				if (inserted)
 					DEBUG_LOG(DYNAREC, "rdv_BlockCheckFail SMC hotspot @ %08x fails %d", addr, blockcheck_failures);
 			}
-			bm_DiscardBlock(block.get());
+			bm_DiscardBlock(block);
 		}
 	}
 	else
@@ -254,7 +609,7 @@ void* DYNACALL rdv_LinkBlock(u8* code,u32 dpc)
 {
 	// code is the RX addr to return after, however bm_GetBlock returns RW
 	//DEBUG_LOG(DYNAREC, "rdv_LinkBlock %p pc %08x", code, dpc);
-	RuntimeBlockInfoPtr rbi = bm_GetBlock(code);
+	RuntimeBlockInfo *rbi = bm_GetBlock(code);
 	bool stale_block = false;
 	if (!rbi)
 	{
@@ -301,13 +656,13 @@ void* DYNACALL rdv_LinkBlock(u8* code,u32 dpc)
 			}
 			else if (rbi->relink_data == 0)
 			{
-				rbi->pBranchBlock = bm_GetBlock(next_pc).get();
+				rbi->pBranchBlock = bm_GetBlock(next_pc);
 				rbi->pBranchBlock->AddRef(rbi);
 			}
 		}
 		else
 		{
-			RuntimeBlockInfo* nxt = bm_GetBlock(next_pc).get();
+			RuntimeBlockInfo* nxt = bm_GetBlock(next_pc);
 
 			if (rbi->BranchBlock == next_pc)
 				rbi->pBranchBlock = nxt;
@@ -369,11 +724,14 @@ static void recSh4_Init()
 	TempCodeCache = CodeCache + CODE_SIZE;
 	ngen_init();
 	bm_ResetCache();
+	blockcache::init();
 }
 
 static void recSh4_Term()
 {
 	INFO_LOG(DYNAREC, "recSh4 Term");
+	asyncCompiler.stop();
+	blockcache::term();
 #ifdef FEAT_NO_RWX_PAGES
 	if (CodeCache != nullptr)
 		virtmem::release_jit_block(CodeCache, (u8 *)CodeCache + cc_rx_offset, CODE_SIZE + TEMP_CODE_SIZE);
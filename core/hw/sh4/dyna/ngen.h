@@ -72,6 +72,16 @@ DynarecCodeEntryPtr DYNACALL rdv_FailedToFindBlock(u32 pc);
 DynarecCodeEntryPtr DYNACALL rdv_FailedToFindBlock_pc();
 //Called when a block check failed, and the block needs to be invalidated
 DynarecCodeEntryPtr DYNACALL rdv_BlockCheckFail(u32 addr);
+//Called when a trace candidate block has run TRACE_HOT_RUNS times. The block is discarded and
+//must exit immediately without updating next_pc so that it's recompiled as a trace.
+void DYNACALL rdv_HotBlock(u32 addr);
+//Returns true if the block can be extended into a trace and should count its runs
+bool rdv_IsTraceCandidate(const RuntimeBlockInfo* block);
+#define TRACE_HOT_RUNS 500
+#if !defined(NDEBUG) || defined(DEBUGFAST)
+//Number of blocks dispatched by the main loop, for stats
+extern u64 rdv_dispatchCount;
+#endif
 //Called to compile code @pc
 DynarecCodeEntryPtr rdv_CompilePC(u32 blockcheck_failures);
 //Finds or compiles code @pc
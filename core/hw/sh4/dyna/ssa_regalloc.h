@@ -24,6 +24,7 @@
 #include "hw/sh4/modules/mmu.h"
 #include "ssa.h"
 
+#include <algorithm>
 #include <deque>
 #include <map>
 #include <vector>
@@ -37,7 +38,9 @@ public:
 	RegAlloc() = default;
 	virtual ~RegAlloc() = default;
 
-	void DoAlloc(RuntimeBlockInfo* block, const nreg_t* regs_avail, const nregf_t* regsf_avail)
+	// If selfLoop is true, the block branches back to its start and the general registers it uses are
+	// kept in host registers across iterations when possible. See LoadLoopRegs() and WritebackLoopRegs().
+	void DoAlloc(RuntimeBlockInfo* block, const nreg_t* regs_avail, const nregf_t* regsf_avail, bool selfLoop = false)
 	{
 		this->block = block;
 		SSAOptimizer optim(block);
@@ -50,6 +53,30 @@ public:
 		verify(host_fregs.empty());
 		while (*regsf_avail != (nregf_t)-1)
 			host_fregs.push_back(*regsf_avail++);
+
+		loop_regs.clear();
+		if (selfLoop)
+			AllocLoopRegs();
+	}
+
+	// Loads the registers kept across loop iterations. Must be called before the loop entry point.
+	void LoadLoopRegs()
+	{
+		for (const auto& reg : loop_regs)
+		{
+			ssa_printf("PL %s -> %cx (loop)", name_reg(reg.first).c_str(), 'a' + reg.second);
+			Preload(reg.first, reg.second);
+		}
+	}
+
+	// Writes back the registers kept across loop iterations. Must be called on each loop exit, after Cleanup().
+	void WritebackLoopRegs()
+	{
+		for (const auto& reg : loop_regs)
+		{
+			ssa_printf("WB %s <- %cx (loop)", name_reg(reg.first).c_str(), 'a' + reg.second);
+			Writeback(reg.first, reg.second);
+		}
 	}
 
 	void OpBegin(shil_opcode* op, int opid)
@@ -248,6 +275,8 @@ public:
 		verify(final_opend || block->oplist.empty());
 		final_opend = false;
 		FlushAllRegs(true);
+		for (const auto& reg : loop_regs)
+			reg_alloced.erase(reg.first);
 		verify(reg_alloced.empty());
 		verify(pending_flushes.empty());
 		block = NULL;
@@ -328,8 +357,55 @@ private:
 		}
 	}
 
+	bool IsLoopReg(Sh4RegType reg)
+	{
+		for (const auto& loopReg : loop_regs)
+			if (loopReg.first == reg)
+				return true;
+		return false;
+	}
+
+	// Keeps the general registers used by a self-looping block in host registers if they all fit,
+	// leaving enough host registers for the other integer registers of each op.
+	void AllocLoopRegs()
+	{
+		if (mmu_enabled())
+			return;
+		std::vector<Sh4RegType> gprs;
+		u32 maxOtherRegs = 0;
+		for (const shil_opcode& op : block->oplist)
+		{
+			// These ops read or write guest registers in memory
+			if (op.op == shop_ifb || op.op == shop_sync_sr)
+				return;
+			std::vector<Sh4RegType> otherRegs;
+			for (const shil_param *param : { &op.rs1, &op.rs2, &op.rs3, &op.rd, &op.rd2 })
+			{
+				if (!param->is_r32i())
+					continue;
+				Sh4RegType reg = param->_reg;
+				std::vector<Sh4RegType>& regs = reg >= reg_r0 && reg <= reg_r15 ? gprs : otherRegs;
+				if (std::find(regs.begin(), regs.end(), reg) == regs.end())
+					regs.push_back(reg);
+			}
+			maxOtherRegs = std::max(maxOtherRegs, (u32)otherRegs.size());
+		}
+		if (gprs.empty() || gprs.size() + std::max(maxOtherRegs, 2u) > host_gregs.size())
+			return;
+		for (Sh4RegType reg : gprs)
+		{
+			nreg_t host_reg = host_gregs.back();
+			host_gregs.pop_back();
+			loop_regs.emplace_back(reg, host_reg);
+			// Never written back nor evicted until the loop exits
+			reg_alloced[reg] = { (u32)host_reg, 0, false, false };
+		}
+	}
+
 	void FlushReg(Sh4RegType reg_num, bool hard)
 	{
+		if (IsLoopReg(reg_num))
+			return;
 		auto reg = reg_alloced.find(reg_num);
 		if (reg != reg_alloced.end())
 		{
@@ -350,8 +426,12 @@ private:
 	{
 		if (hard)
 		{
-			while (!reg_alloced.empty())
-				FlushReg(reg_alloced.begin()->first, true);
+			for (auto it = reg_alloced.begin(); it != reg_alloced.end(); )
+			{
+				Sh4RegType reg = it->first;
+				++it;
+				FlushReg(reg, true);
+			}
 		}
 		else
 		{
@@ -479,7 +559,7 @@ private:
 			{
 				reg_alloc& reg = reg_alloced[sh4reg];
 				verify(!reg.write_back);
-				reg.write_back = NeedsWriteBack(sh4reg, param.version[i]);
+				reg.write_back = !IsLoopReg(sh4reg) && NeedsWriteBack(sh4reg, param.version[i]);
 				reg.dirty = true;
 				reg.version = param.version[i];
 			}
@@ -494,7 +574,7 @@ private:
 
 		for (auto const& reg : reg_alloced)
 		{
-			if (IsFloat(reg.first) != freg)
+			if (IsFloat(reg.first) != freg || IsLoopReg(reg.first))
 				continue;
 			// Don't spill already spilled regs
 			bool pending = false;
@@ -658,6 +738,8 @@ private:
 	std::deque<nregf_t> host_fregs;
 	std::vector<Sh4RegType> pending_flushes;
 	std::map<Sh4RegType, reg_alloc> reg_alloced;
+	// General registers kept in host registers across the iterations of a self-looping block
+	std::vector<std::pair<Sh4RegType, nreg_t>> loop_regs;
 	int opnum = 0;
 
 	bool final_opend = false;
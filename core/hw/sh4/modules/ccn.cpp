@@ -47,6 +47,9 @@ static void CCN_MMUCR_write(u32 addr, u32 value)
 
 		temp.TI = 0;
 	}
+	if (temp.SV != CCN_MMUCR.SV)
+		// ASID matching depends on the single virtual mode
+		mmu_instruction_cache_flush();
 	CCN_MMUCR = temp;
 
 	if (mmu_changed_state)
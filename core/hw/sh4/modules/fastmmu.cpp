@@ -189,6 +189,8 @@ bool UTLB_Sync(u32 entry)
 	lru_address = tlb_entry.Address.VPN << 10;
 
 	cache_entry(tlb_entry);
+	// the new entry takes precedence over the cached translations of its range
+	mmu_instruction_cache_invalidate(lru_address, ~lru_mask + 1);
 
 	if (!mmu_enabled() && (tlb_entry.Address.VPN & (0xFC000000 >> 10)) == (0xE0000000 >> 10))
 	{
@@ -321,6 +323,7 @@ void mmu_flush_table()
 {
 	lru_entry = nullptr;
 	flush_cache();
+	mmu_instruction_cache_flush();
 	mmuAddressLUTFlush(true);
 }
 #endif 	// FAST_MMU
@@ -54,11 +54,35 @@ constexpr u32 ITLB_LRU_AND[4] =
 };
 
 #ifndef FAST_MMU
+// TLB entries as of their last sync, to invalidate the cached instruction translations of replaced entries
+static TLB_Entry syncedUTLB[std::size(UTLB)];
+static TLB_Entry syncedITLB[std::size(ITLB)];
+
+// Invalidates the cached instruction translations of the previous and new values of a TLB entry
+static void syncInstructionCache(const TLB_Entry& entry, TLB_Entry& synced)
+{
+	for (const TLB_Entry *e : { (const TLB_Entry *)&synced, &entry })
+	{
+		if (e->Data.V == 0)
+			continue;
+		const u32 mask = mmu_mask[e->Data.SZ1 * 2 + e->Data.SZ0];
+		mmu_instruction_cache_invalidate((e->Address.VPN << 10) & mask, ~mask + 1);
+	}
+	synced = entry;
+}
+
+static void syncAllEntries()
+{
+	std::copy(std::begin(UTLB), std::end(UTLB), syncedUTLB);
+	std::copy(std::begin(ITLB), std::end(ITLB), syncedITLB);
+}
+
 //sync mem mapping to mmu , suspend compiled blocks if needed.entry is a UTLB entry # , -1 is for full sync
 bool UTLB_Sync(u32 entry)
 {
 	printf_mmu("UTLB MEM remap %d : 0x%X to 0x%X : %d asid %d size %d", entry, UTLB[entry].Address.VPN << 10, UTLB[entry].Data.PPN << 10, UTLB[entry].Data.V,
 			UTLB[entry].Address.ASID, UTLB[entry].Data.SZ0 + UTLB[entry].Data.SZ1 * 2);
+	syncInstructionCache(UTLB[entry], syncedUTLB[entry]);
 	if (UTLB[entry].Data.V == 0)
 		return true;
 
@@ -79,6 +103,7 @@ bool UTLB_Sync(u32 entry)
 void ITLB_Sync(u32 entry)
 {
 	printf_mmu("ITLB MEM remap %d : 0x%X to 0x%X : %d", entry, ITLB[entry].Address.VPN << 10, ITLB[entry].Data.PPN << 10, ITLB[entry].Data.V);
+	syncInstructionCache(ITLB[entry], syncedITLB[entry]);
 }
 #endif
 
@@ -455,12 +480,77 @@ void mmu_set_state()
 		mmuOn = false;
 	}
 
+	mmu_instruction_cache_flush();
 	SetMemoryHandlers();
 	setSqwHandler();
 }
 
 u32 mmuAddressLUT[0x100000];
 
+// 1K virtual page | ASID << 22 | MD << 30, and physical address of the page
+struct InstrCacheEntry
+{
+	u32 key;
+	u32 paddr;
+};
+static InstrCacheEntry instrCache[8192];
+constexpr u32 InstrCacheInvalidKey = ~0u;
+#if !defined(NDEBUG) || defined(DEBUGFAST)
+MmuDispatchStats mmuDispatchStats;
+#define DISPATCH_STAT(name) mmuDispatchStats.name++
+#else
+#define DISPATCH_STAT(name)
+#endif
+
+static inline InstrCacheEntry& instrCacheEntry(u32 va) {
+	return instrCache[(va >> 10) % std::size(instrCache)];
+}
+
+MmuError mmu_cached_instruction_translation(u32 va, u32& rv)
+{
+	if (fast_reg_lut[va >> 29] != 0)
+	{
+		// Not translated
+		DISPATCH_STAT(translations);
+		return mmu_instruction_translation(va, rv);
+	}
+	InstrCacheEntry& entry = instrCacheEntry(va);
+	const u32 key = (va >> 10) | (CCN_PTEH.ASID << 22) | (sr.MD << 30);
+	if (entry.key == key)
+	{
+		DISPATCH_STAT(hits);
+		rv = entry.paddr | (va & 0x3ff);
+		return MmuError::NONE;
+	}
+	DISPATCH_STAT(misses);
+	DISPATCH_STAT(translations);
+	MmuError err = mmu_instruction_translation(va, rv);
+	if (err == MmuError::NONE)
+	{
+		entry.key = key;
+		entry.paddr = rv & ~0x3ff;
+	}
+	return err;
+}
+
+void mmu_instruction_cache_invalidate(u32 va, u32 size)
+{
+	const u32 pages = std::min<u32>(size >> 10, std::size(instrCache));
+	for (u32 i = 0; i < pages; i++)
+	{
+		InstrCacheEntry& entry = instrCacheEntry(va + (i << 10));
+		// any ASID and mode
+		if ((entry.key & 0x3fffff) == ((va >> 10) + i))
+			entry.key = InstrCacheInvalidKey;
+	}
+}
+
+void mmu_instruction_cache_flush()
+{
+	for (InstrCacheEntry& entry : instrCache)
+		entry.key = InstrCacheInvalidKey;
+}
+
 void MMU_init()
 {
 	memset(ITLB_LRU_USE, 0xFF, sizeof(ITLB_LRU_USE));
@@ -492,19 +582,23 @@ void MMU_reset()
 	memset(ITLB, 0, sizeof(ITLB));
 	mmu_set_state();
 	mmu_flush_table();
+	mmumirror::reset();
 }
 
 void MMU_term()
 {
+	mmumirror::reset();
 }
 
 #ifndef FAST_MMU
 void mmu_flush_table()
 {
+	mmu_instruction_cache_flush();
 	for (TLB_Entry& entry : ITLB)
 		entry.Data.V = 0;
 	for (TLB_Entry& entry : UTLB)
 		entry.Data.V = 0;
+	syncAllEntries();
 }
 #endif
 
@@ -592,4 +686,7 @@ void mmu_deserialize(Deserializer& deser)
 			|| (deser.version() >= Deserializer::V11_LIBRETRO && deser.version() <= Deserializer::VLAST_LIBRETRO))
 		deser >> sq_remap;
 	deser.skip(64 * 4, Deserializer::V23); // ITLB_LRU_USE
+#ifndef FAST_MMU
+	syncAllEntries();
+#endif
 }
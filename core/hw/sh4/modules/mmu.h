@@ -90,6 +90,23 @@ static inline MmuError mmu_instruction_translation(u32 va, u32& rv)
 MmuError mmu_instruction_translation(u32 va, u32& rv);
 #endif
 
+// Instruction address translation for the dynarec dispatcher.
+// Translations are cached by virtual address, ASID and privilege mode so that they survive context switches.
+MmuError mmu_cached_instruction_translation(u32 va, u32& rv);
+// Invalidates the cached instruction translations of the given virtual address range
+void mmu_instruction_cache_invalidate(u32 va, u32 size);
+void mmu_instruction_cache_flush();
+
+#if !defined(NDEBUG) || defined(DEBUGFAST)
+struct MmuDispatchStats
+{
+	u64 hits;			// translations found in the cache
+	u64 misses;			// translations not found in the cache
+	u64 translations;	// calls to mmu_instruction_translation
+};
+extern MmuDispatchStats mmuDispatchStats;
+#endif
+
 template<u32 translation_type>
 MmuError mmu_data_translation(u32 va, u32& rv);
 void DoMMUException(u32 addr, MmuError mmu_error, u32 access_type);
@@ -121,14 +138,44 @@ void mmu_TranslateSQW(u32 adr, u32* out);
 // maps 4K virtual page number to physical address
 extern u32 mmuAddressLUT[0x100000];
 
+// Host address window mirroring the translations of mmuAddressLUT.
+// RAM pages are mapped on the first access to them.
+namespace mmumirror
+{
+
+enum class FaultResult {
+	Mapped,		// the page is now mapped and the access can be retried
+	Translate,	// the address can't be mapped yet and must be translated
+	NotRam,		// the address isn't in RAM and must always be translated
+};
+
+// Reserves the host window. Returns nullptr if the platform doesn't support it.
+u8 *init();
+// Unmaps all the pages
+void reset();
+// Unmaps the pages of the given virtual address range
+void flush(u32 vaddr, u32 size);
+// Unmaps the pages of the given virtual address range that depend on the current ASID
+void flushAsid(u32 vaddr, u32 size);
+// Write-protects the pages mapped to the given RAM range
+void lockRam(u32 addr, u32 size);
+// Handles an access fault at the given virtual address
+FaultResult handleFault(u32 vaddr, bool write);
+
+}
+
 static inline void mmuAddressLUTFlush(bool full)
 {
 	if (full)
+	{
 		memset(mmuAddressLUT, 0, sizeof(mmuAddressLUT) / 2);	// flush user memory
+		mmumirror::flush(0, 0x80000000);
+	}
 	else
 	{
 		constexpr u32 slotPages = (32 * 1024 * 1024) >> 12;
 		memset(mmuAddressLUT, 0, slotPages * sizeof(u32));		// flush slot 0
+		mmumirror::flushAsid(0, slotPages << 12);
 	}
 }
 
@@ -0,0 +1,199 @@
+/*
+	Copyright 2026 flyinghead
+
+	This file is part of Flycast.
+
+    Flycast is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 2 of the License, or
+    (at your option) any later version.
+
+    Flycast is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Flycast.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#include "mmu.h"
+#include "hw/mem/addrspace.h"
+#include "hw/mem/mem_watch.h"
+#include "hw/sh4/dyna/blockmanager.h"
+#include "oslib/virtmem.h"
+#include <algorithm>
+#include <map>
+#include <vector>
+
+namespace mmumirror
+{
+
+// Guest pages are mirrored with 4K host pages
+constexpr u32 MirrorPageSize = 4096;
+// The whole 32-bit address space plus one page for accesses crossing the end
+constexpr u64 WindowSize = 0x100000000ull + MirrorPageSize;
+
+struct Page
+{
+	u32 ramPage;
+	bool writable;
+	bool shared;	// mapped by a shared TLB entry, independent of the ASID
+};
+
+static u8 *base;
+// Mapped pages by virtual page number
+static std::map<u32, Page> pages;
+// Virtual page numbers mapped to each RAM page
+static std::vector<u32> aliases[RAM_SIZE_MAX / MirrorPageSize];
+
+u8 *init()
+{
+#if defined(FAST_MMU) && HOST_CPU == CPU_X64
+	if (base == nullptr && addrspace::virtmemEnabled())
+	{
+		base = (u8 *)virtmem::reserve_window(WindowSize);
+		if (base != nullptr)
+			INFO_LOG(VMEM, "MMU mirror window reserved at %p", base);
+	}
+#endif
+	return base;
+}
+
+static void removeAlias(u32 vpn, u32 ramPage)
+{
+	std::vector<u32>& vpns = aliases[ramPage];
+	*std::find(vpns.begin(), vpns.end(), vpn) = vpns.back();
+	vpns.pop_back();
+}
+
+static void unmapPages(u32 firstVpn, u32 endVpn)
+{
+	auto begin = pages.lower_bound(firstVpn);
+	auto end = pages.lower_bound(endVpn);
+	if (begin == end)
+		return;
+	firstVpn = begin->first;
+	endVpn = std::prev(end)->first + 1;
+	for (auto it = begin; it != end; ++it)
+		removeAlias(it->first, it->second.ramPage);
+	pages.erase(begin, end);
+	virtmem::unmap_window(base + (u64)firstVpn * MirrorPageSize, (u64)(endVpn - firstVpn) * MirrorPageSize);
+}
+
+void reset()
+{
+	unmapPages(0, WindowSize / MirrorPageSize);
+}
+
+void flush(u32 vaddr, u32 size)
+{
+	unmapPages(vaddr / MirrorPageSize, (vaddr + (u64)size) / MirrorPageSize);
+}
+
+void flushAsid(u32 vaddr, u32 size)
+{
+	auto it = pages.lower_bound(vaddr / MirrorPageSize);
+	auto end = pages.lower_bound((vaddr + (u64)size) / MirrorPageSize);
+	// Unmap each run of contiguous non-shared pages with a single call
+	u32 runStart = 0;
+	u32 runEnd = 0;
+	while (it != end)
+	{
+		if (it->second.shared)
+		{
+			++it;
+			continue;
+		}
+		if (it->first != runEnd)
+		{
+			if (runEnd != runStart)
+				virtmem::unmap_window(base + (u64)runStart * MirrorPageSize, (u64)(runEnd - runStart) * MirrorPageSize);
+			runStart = it->first;
+		}
+		runEnd = it->first + 1;
+		removeAlias(it->first, it->second.ramPage);
+		it = pages.erase(it);
+	}
+	if (runEnd != runStart)
+		virtmem::unmap_window(base + (u64)runStart * MirrorPageSize, (u64)(runEnd - runStart) * MirrorPageSize);
+}
+
+void lockRam(u32 addr, u32 size)
+{
+	if (pages.empty())
+		return;
+	const u32 endPage = std::min<u32>((addr + size) / MirrorPageSize, std::size(aliases));
+	for (u32 ramPage = addr / MirrorPageSize; ramPage < endPage; ramPage++)
+	{
+		for (u32 vpn : aliases[ramPage])
+		{
+			Page& page = pages[vpn];
+			if (page.writable)
+			{
+				virtmem::region_lock(base + (u64)vpn * MirrorPageSize, MirrorPageSize);
+				page.writable = false;
+			}
+		}
+	}
+}
+
+// Same as a write to the main RAM mapping: notifies the ram watcher and discards the blocks of the page
+static void ramWriteAccess(u32 ramPage)
+{
+	if (!memwatch::writeAccess(addrspace::ram_base + 0x0C000000 + ramPage * MirrorPageSize))
+		bm_RamWriteAccess(ramPage * MirrorPageSize);
+}
+
+FaultResult handleFault(u32 vaddr, bool write)
+{
+	if (vaddr >> 31 != 0)
+		// Only U0/P0 is mirrored, like the translations cached in mmuAddressLUT: P3 pages wouldn't be unmapped
+		// when translations are flushed, and P1/P2 accesses must raise address errors in user mode.
+		return FaultResult::NotRam;
+	const u32 vpn = vaddr / MirrorPageSize;
+	u8 *hostAddr = base + (u64)vpn * MirrorPageSize;
+	auto it = pages.find(vpn);
+	if (it != pages.end())
+	{
+		// Write to a read-only page
+		verify(write && !it->second.writable);
+		ramWriteAccess(it->second.ramPage);
+		virtmem::region_unlock(hostAddr, MirrorPageSize);
+		it->second.writable = true;
+		return FaultResult::Mapped;
+	}
+	u32 paddr = mmuAddressLUT[vpn];
+	if (paddr == 0)
+	{
+		MmuError rv;
+		if (write)
+			rv = mmu_data_translation<MMU_TT_DWRITE>(vaddr, paddr);
+		else
+			rv = mmu_data_translation<MMU_TT_DREAD>(vaddr, paddr);
+		if (rv != MmuError::NONE)
+			// Let the slow path raise the exception
+			return FaultResult::Translate;
+		mmuAddressLUT[vpn] = paddr & ~0xfff;
+	}
+	if ((paddr & 0x1C000000) != 0x0C000000)
+		return FaultResult::NotRam;
+
+	// Translations depend on the ASID unless the TLB entry is shared
+	bool shared = true;
+	const TLB_Entry *entry;
+	u32 tlbPaddr;
+	if (mmu_full_lookup(vaddr, &entry, tlbPaddr) == MmuError::NONE)
+		shared = entry->Data.SH == 1;
+	const u32 ramPage = (paddr & RAM_MASK) / MirrorPageSize;
+	// Pages are mapped read-only until written to so that code and memory watch protection still apply
+	if (write)
+		ramWriteAccess(ramPage);
+	if (!addrspace::mapRam(hostAddr, ramPage * MirrorPageSize, MirrorPageSize, write))
+		return FaultResult::Translate;
+	pages[vpn] = { ramPage, write, shared };
+	aliases[ramPage].push_back(vpn);
+
+	return FaultResult::Mapped;
+}
+
+}	// namespace mmumirror
@@ -27,14 +27,98 @@ struct sched_list
 	int tag;
 	int start;
 	int end;
+	int heapIndex;	// position in sch_heap, or -1 if not scheduled
 };
 
 static u64 sh4_sched_ffb;
 static std::vector<sched_list> sch_list;
+// Ids of all scheduled callbacks (end != -1), as a binary min-heap ordered by end time
+static std::vector<int> sch_heap;
 static int sh4_sched_next_id = -1;
 
 static u32 sh4_sched_now();
 
+/*
+	Heap order uses the wrapping difference between end times, which is
+	valid since all scheduled events are within SH4_MAIN_CLOCK of now.
+*/
+static bool sch_heap_before(int id1, int id2)
+{
+	return (int)((u32)sch_list[id1].end - (u32)sch_list[id2].end) < 0;
+}
+
+static void sch_heap_set(size_t pos, int id)
+{
+	sch_heap[pos] = id;
+	sch_list[id].heapIndex = pos;
+}
+
+static void sch_heap_up(size_t pos)
+{
+	int id = sch_heap[pos];
+	while (pos > 0)
+	{
+		size_t parent = (pos - 1) / 2;
+		if (!sch_heap_before(id, sch_heap[parent]))
+			break;
+		sch_heap_set(pos, sch_heap[parent]);
+		pos = parent;
+	}
+	sch_heap_set(pos, id);
+}
+
+static void sch_heap_down(size_t pos)
+{
+	int id = sch_heap[pos];
+	for (;;)
+	{
+		size_t child = pos * 2 + 1;
+		if (child >= sch_heap.size())
+			break;
+		if (child + 1 < sch_heap.size() && sch_heap_before(sch_heap[child + 1], sch_heap[child]))
+			child++;
+		if (!sch_heap_before(sch_heap[child], id))
+			break;
+		sch_heap_set(pos, sch_heap[child]);
+		pos = child;
+	}
+	sch_heap_set(pos, id);
+}
+
+// Must be called after the end time of a callback has been changed
+static void sch_heap_update(int id)
+{
+	sched_list& sched = sch_list[id];
+	if (sched.end == -1)
+	{
+		if (sched.heapIndex == -1)
+			return;
+		size_t pos = sched.heapIndex;
+		sched.heapIndex = -1;
+		int last = sch_heap.back();
+		sch_heap.pop_back();
+		if (pos < sch_heap.size())
+		{
+			sch_heap_set(pos, last);
+			sch_heap_up(pos);
+			sch_heap_down(sch_list[last].heapIndex);
+		}
+	}
+	else
+	{
+		if (sched.heapIndex == -1)
+		{
+			sch_heap.push_back(id);
+			sch_heap_up(sch_heap.size() - 1);
+		}
+		else
+		{
+			sch_heap_up(sched.heapIndex);
+			sch_heap_down(sched.heapIndex);
+		}
+	}
+}
+
 static u32 sh4_sched_remaining(const sched_list& sched, u32 reference)
 {
 	if (sched.end != -1)
@@ -49,13 +133,22 @@ void sh4_sched_ffts()
 	int slot = -1;
 
 	u32 now = sh4_sched_now();
-	for (const sched_list& sched : sch_list)
+	if (!sch_heap.empty() && (int)sh4_sched_remaining(sch_list[sch_heap[0]], now) >= 0)
+	{
+		slot = sch_heap[0];
+		diff = sh4_sched_remaining(sch_list[slot], now);
+	}
+	else if (!sch_heap.empty())
 	{
-		u32 remaining = sh4_sched_remaining(sched, now);
-		if (remaining < diff)
+		// Overdue event: it will never be selected. Look for the nearest one in the future.
+		for (int id : sch_heap)
 		{
-			slot = &sched - &sch_list[0];
-			diff = remaining;
+			u32 remaining = sh4_sched_remaining(sch_list[id], now);
+			if (remaining < diff || (remaining == diff && id < slot))
+			{
+				slot = id;
+				diff = remaining;
+			}
 		}
 	}
 
@@ -72,7 +165,7 @@ void sh4_sched_ffts()
 
 int sh4_sched_register(int tag, sh4_sched_callback* ssc)
 {
-	sched_list t{ ssc, tag, -1, -1};
+	sched_list t{ ssc, tag, -1, -1, -1 };
 	for (sched_list& sched : sch_list)
 		if (sched.cb == nullptr)
 		{
@@ -90,13 +183,12 @@ void sh4_sched_unregister(int id)
 	if (id == -1)
 		return;
 	verify(id < (int)sch_list.size());
+	sch_list[id].end = -1;
+	sch_heap_update(id);
 	if (id == (int)sch_list.size() - 1)
 		sch_list.resize(sch_list.size() - 1);
 	else
-	{
 		sch_list[id].cb = nullptr;
-		sch_list[id].end = -1;
-	}
 	sh4_sched_ffts();
 }
 
@@ -133,6 +225,7 @@ void sh4_sched_request(int id, int cycles)
 		if (sched.end == -1)
 			sched.end++;
 	}
+	sch_heap_update(id);
 
 	sh4_sched_ffts();
 }
@@ -156,11 +249,41 @@ static void handle_cb(sched_list& sched)
 	int elapsd = sh4_sched_elapsed(sched);
 	int jitter = elapsd - remain;
 
+	int id = &sched - &sch_list[0];
 	sched.end = -1;
+	sch_heap_update(id);
 	int re_sch = sched.cb(sched.tag, remain, jitter);
 
 	if (re_sch > 0)
-		sh4_sched_request(&sched - &sch_list[0], std::max(0, re_sch - jitter));
+		sh4_sched_request(id, std::max(0, re_sch - jitter));
+}
+
+/*
+	Returns the lowest id greater than lastId whose callback expires between
+	fztime and fztime + cycles, or -1.
+	Only the heap nodes expiring before now need to be visited.
+*/
+static int sh4_sched_next_expired(int lastId, u32 fztime, int cycles)
+{
+	u32 now = fztime + cycles;
+	int found = -1;
+	size_t stack[32];
+	size_t depth = 0;
+	if (!sch_heap.empty())
+		stack[depth++] = 0;
+	while (depth > 0)
+	{
+		size_t pos = stack[--depth];
+		int id = sch_heap[pos];
+		if ((int)sh4_sched_remaining(sch_list[id], now) > 0)
+			continue;
+		int remaining = sh4_sched_remaining(sch_list[id], fztime);
+		if (remaining >= 0 && remaining <= cycles && id > lastId && (found == -1 || id < found))
+			found = id;
+		for (size_t child = pos * 2 + 1; child <= pos * 2 + 2 && child < sch_heap.size(); child++)
+			stack[depth++] = child;
+	}
+	return found;
 }
 
 void sh4_sched_tick(int cycles)
@@ -171,12 +294,10 @@ void sh4_sched_tick(int cycles)
 	u32 fztime = sh4_sched_now() - cycles;
 	if (sh4_sched_next_id != -1)
 	{
-		for (sched_list& sched : sch_list)
-		{
-			int remaining = sh4_sched_remaining(sched, fztime);
-			if (remaining >= 0 && remaining <= (int)cycles)
-				handle_cb(sched);
-		}
+		// Callbacks are called in id order, including the ones scheduled by a previous callback
+		int id = -1;
+		while ((id = sh4_sched_next_expired(id, fztime, cycles)) != -1)
+			handle_cb(sch_list[id]);
 	}
 	sh4_sched_ffts();
 }
@@ -188,7 +309,11 @@ void sh4_sched_reset(bool hard)
 		sh4_sched_ffb = 0;
 		sh4_sched_next_id = -1;
 		for (sched_list& sched : sch_list)
+		{
 			sched.start = sched.end = -1;
+			sched.heapIndex = -1;
+		}
+		sch_heap.clear();
 		Sh4cntx.sh4_sched_next = 0;
 	}
 }
@@ -205,6 +330,7 @@ void sh4_sched_deserialize(Deserializer& deser, int id)
 	deser >> sch_list[id].tag;
 	deser >> sch_list[id].start;
 	deser >> sch_list[id].end;
+	sch_heap_update(id);
 }
 
 // FIXME modules should save their scheduling data so that it doesn't depend on their scheduler id
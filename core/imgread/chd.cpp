@@ -1,8 +1,10 @@
 #include "common.h"
+#include "hunkcache.h"
 #include "stdclass.h"
 #include "oslib/storage.h"
 
 #include <libchdr/chd.h>
+#include <memory>
 
 struct CHDDisc : Disc
 {
@@ -11,10 +13,14 @@ struct CHDDisc : Disc
 	// lead out, lead in and pregap between 2 sessions of MIL-CDs
 	static constexpr u32 SESSION_GAP = 11400;
 
+	// number of read-ahead worker threads
+	static constexpr u32 MAX_WORKERS = 2;
+
 	chd_file *chd = nullptr;
 	FILE *fp = nullptr;
-	u8* hunk_mem = nullptr;
-	u32 old_hunk = 0;
+	// read-ahead workers need their own chd handle
+	std::vector<std::pair<FILE *, chd_file *>> workerChds;
+	std::unique_ptr<HunkCache> cache;
 
 	u32 hunkbytes = 0;
 	u32 sph = 0;
@@ -23,8 +29,12 @@ struct CHDDisc : Disc
 
 	~CHDDisc()
 	{
-		delete[] hunk_mem;
-
+		cache.reset();
+		for (auto& pair : workerChds)
+		{
+			chd_close(pair.second);
+			std::fclose(pair.first);
+		}
 		if (chd)
 			chd_close(chd);
 		if (fp)
@@ -51,16 +61,10 @@ struct CHDTrack : TrackFile
 	{
 		u32 fad_offs = FAD + Offset;
 		u32 hunk=(fad_offs)/disc->sph;
-		if (disc->old_hunk!=hunk)
-		{
-			if (chd_read(disc->chd,hunk,disc->hunk_mem) != CHDERR_NONE)
-				return false;
-			disc->old_hunk = hunk;
-		}
-
 		u32 hunk_ofs = fad_offs%disc->sph;
 
-		memcpy(dst, disc->hunk_mem + hunk_ofs * (2352+96), fmt);
+		if (!disc->cache->read(hunk, hunk_ofs * (2352+96), dst, fmt))
+			return false;
 
 		if (swap_bytes)
 		{
@@ -128,14 +132,35 @@ void CHDDisc::tryOpen(const char* file)
 	const chd_header* head = chd_get_header(chd);
 
 	hunkbytes = head->hunkbytes;
-	hunk_mem = new u8[hunkbytes];
-	old_hunk=0xFFFFFFF;
 
 	sph = hunkbytes/(2352+96);
 
 	if (hunkbytes % (2352 + 96) != 0)
 		throw FlycastException(std::string("Invalid hunkbytes for CHD file ") + file);
 
+	std::vector<HunkCache::Reader> readers;
+	readers.push_back([this](u32 hunk, u8 *dest) {
+		return chd_read(chd, hunk, dest) == CHDERR_NONE;
+	});
+	const u32 workers = std::min(std::max(std::thread::hardware_concurrency(), 2u) - 1, MAX_WORKERS);
+	for (u32 i = 0; i < workers; i++)
+	{
+		FILE *workerFp = hostfs::storage().openFile(file, "rb");
+		if (workerFp == nullptr)
+			break;
+		chd_file *workerChd;
+		if (chd_open_file(workerFp, CHD_OPEN_READ, 0, &workerChd) != CHDERR_NONE)
+		{
+			std::fclose(workerFp);
+			break;
+		}
+		workerChds.emplace_back(workerFp, workerChd);
+		readers.push_back([workerChd](u32 hunk, u8 *dest) {
+			return chd_read(workerChd, hunk, dest) == CHDERR_NONE;
+		});
+	}
+	cache = std::make_unique<HunkCache>(hunkbytes, head->totalhunks, std::move(readers));
+
 	u32 tag;
 	u8 flags;
 	char temp[512];
@@ -1,4 +1,5 @@
 #include "common.h"
+#include "prefetch.h"
 #include "hw/gdrom/gdromv3.h"
 #include "cfg/option.h"
 #include "stdclass.h"
@@ -25,16 +26,31 @@ constexpr Disc* (*drivers[])(const char* path, std::vector<u8> *digest)
 
 u8 q_subchannel[96];
 
-static bool convertSector(u8* in_buff , u8* out_buff , int from , int to,int sector)
+static SectorPrefetcher prefetcher([](u32 fad, u8 *dest, u32 sectorSize, u8 *subchannel) {
+		if (disc != nullptr)
+			disc->ReadSectors(fad, 1, dest, sectorSize, nullptr, subchannel);
+	},
+	[](u32 fad) {
+		if (disc != nullptr)
+			for (const Track& track : disc->tracks)
+			{
+				const u32 endFad = track.EndFAD != 0 ? track.EndFAD : disc->EndFAD;
+				if (fad >= track.StartFAD && fad <= endFad)
+					return endFad + 1;
+			}
+		return fad;
+	});
+
+static bool convertSector(u8* in_buff , u8* out_buff , int from , int to,int sector, u8 *subchannel)
 {
 	//get subchannel data, if any
 	if (from == 2448)
 	{
-		memcpy(q_subchannel, in_buff + 2352, 96);
+		memcpy(subchannel, in_buff + 2352, 96);
 		from -= 96;
 	}
 	else
-		memset(q_subchannel, 0, sizeof(q_subchannel));
+		memset(subchannel, 0, 96);
 
 	//if no conversion
 	if (to == from)
@@ -165,6 +181,7 @@ bool DiscSwap(const std::string& path)
 
 void TermDrive()
 {
+	prefetcher.reset();
 	delete disc;
 	disc = NULL;
 }
@@ -193,7 +210,17 @@ static u32 createTrackInfoFirstLast(const Track& track, u32 tracknum)
 void libGDR_ReadSector(u8 *buff, u32 startSector, u32 sectorCount, u32 sectorSize)
 {
 	if (disc != nullptr)
-		disc->ReadSectors(startSector, sectorCount, buff, sectorSize);
+		prefetcher.read(startSector, sectorCount, buff, sectorSize, q_subchannel);
+}
+
+std::mutex& libGDR_GetIoMutex() {
+	return prefetcher.getIoMutex();
+}
+
+void libGDR_Prefetch(u32 startSector, u32 sectorCount, u32 sectorSize)
+{
+	if (disc != nullptr)
+		prefetcher.prefetch(startSector, sectorCount, sectorSize);
 }
 
 void libGDR_GetToc(u32* to, DiskArea area)
@@ -250,8 +277,10 @@ DiscType GuessDiscType(bool m1, bool m2, bool da)
 		return CdRom;
 }
 
-void Disc::ReadSectors(u32 FAD, u32 count, u8* dst, u32 fmt, LoadProgress *progress)
+void Disc::ReadSectors(u32 FAD, u32 count, u8* dst, u32 fmt, LoadProgress *progress, u8 *subchannel)
 {
+	if (subchannel == nullptr)
+		subchannel = q_subchannel;
 	u8 temp[2448];
 	SectorFormat secfmt;
 	SubcodeFormat subfmt;
@@ -265,12 +294,12 @@ void Disc::ReadSectors(u32 FAD, u32 count, u8* dst, u32 fmt, LoadProgress *progr
 			progress->label = "Loading...";
 			progress->progress = (float)i / count;
 		}
-		if (ReadSector(FAD,temp,&secfmt,q_subchannel,&subfmt))
+		if (ReadSector(FAD,temp,&secfmt,subchannel,&subfmt))
 		{
 			//TODO: Proper sector conversions
 			if (secfmt==SECFMT_2352)
 			{
-				convertSector(temp,dst,2352,fmt,FAD);
+				convertSector(temp,dst,2352,fmt,FAD,subchannel);
 			}
 			else if (fmt == 2048 && secfmt==SECFMT_2336_MODE2)
 				memcpy(dst,temp+8,2048);
@@ -286,7 +315,7 @@ void Disc::ReadSectors(u32 FAD, u32 count, u8* dst, u32 fmt, LoadProgress *progr
 			else if (fmt==2048 && secfmt==SECFMT_2448_MODE2)
 			{
 				// Pier Solar and the Great Architects
-				convertSector(temp, dst, 2448, fmt, FAD);
+				convertSector(temp, dst, 2448, fmt, FAD, subchannel);
 			}
 			else
 			{
@@ -1,5 +1,6 @@
 #pragma once
 #include "types.h"
+#include <mutex>
 #include <vector>
 
 #include "emulator.h"
@@ -124,7 +125,8 @@ struct Disc
 		return false;
 	}
 
-	void ReadSectors(u32 FAD, u32 count, u8 *dst, u32 fmt, LoadProgress *progress = nullptr);
+	// The subchannel data of the last sector is copied to subchannel, or to the drive subchannel if null
+	void ReadSectors(u32 FAD, u32 count, u8 *dst, u32 fmt, LoadProgress *progress = nullptr, u8 *subchannel = nullptr);
 
 	virtual ~Disc() 
 	{
@@ -264,6 +266,10 @@ DiscType GuessDiscType(bool m1, bool m2, bool da);
 
 //IO
 void libGDR_ReadSector(u8 * buff,u32 StartSector,u32 SectorCount,u32 secsz);
+// Starts reading these sectors in the background
+void libGDR_Prefetch(u32 StartSector, u32 SectorCount, u32 secsz);
+// Must be held when reading a disc without libGDR_ReadSector
+std::mutex& libGDR_GetIoMutex();
 void libGDR_ReadSubChannel(u8 * buff, u32 len);
 void libGDR_GetToc(u32 *toc, DiskArea area);
 u32 libGDR_GetDiscType();
@@ -0,0 +1,253 @@
+/*
+	Copyright 2026 flyinghead
+
+	This file is part of Flycast.
+
+    Flycast is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 2 of the License, or
+    (at your option) any later version.
+
+    Flycast is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Flycast.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#include "hunkcache.h"
+
+#include <algorithm>
+#include <cstring>
+
+HunkCache::HunkCache(u32 hunkBytes, u32 hunkCount, std::vector<Reader> readers, u32 capacity)
+	: hunkBytes(hunkBytes), hunkCount(hunkCount), readers(std::move(readers))
+{
+	verify(!this->readers.empty());
+	// The caller and each worker can be decoding a hunk at the same time
+	capacity = std::max<u32>(capacity, (u32)this->readers.size() + 1);
+	slots.resize(capacity);
+	hunkMap.reserve(capacity);
+	for (size_t i = 1; i < this->readers.size(); i++)
+		workers.emplace_back(&HunkCache::workerThread, this, i);
+}
+
+HunkCache::~HunkCache()
+{
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		exitThreads = true;
+	}
+	workCond.notify_all();
+	for (std::thread& thread : workers)
+		thread.join();
+	DEBUG_LOG(GDROM, "Hunk cache: %d hits, %d read ahead, %d misses, %d waits", (int)stats.hits, (int)stats.prefetchHits,
+			(int)stats.misses, (int)stats.waits);
+}
+
+bool HunkCache::read(u32 hunk, u32 offset, u8 *dest, u32 size)
+{
+	if (hunk >= hunkCount || offset + size > hunkBytes)
+		return false;
+	std::unique_lock<std::mutex> lock(mutex);
+	Stream& stream = getStream(hunk);
+	bool waited = false;
+	Slot *slot;
+	for (;;)
+	{
+		auto it = hunkMap.find(hunk);
+		if (it == hunkMap.end())
+		{
+			slot = nullptr;
+			break;
+		}
+		slot = it->second;
+		if (slot->state == Ready)
+			break;
+		if (slot->state == Queued)
+		{
+			// Not started yet. Decode it now
+			queue.erase(std::find(queue.begin(), queue.end(), slot));
+			freeSlot(slot);
+			slot = nullptr;
+			break;
+		}
+		// A worker is decoding it
+		if (!waited)
+		{
+			stats.waits++;
+			waited = true;
+		}
+		readyCond.wait(lock);
+	}
+	if (slot != nullptr)
+	{
+		if (slot->prefetched)
+		{
+			stats.prefetchHits++;
+			slot->prefetched = false;
+		}
+		else {
+			stats.hits++;
+		}
+		slot->lastUse = ++useCounter;
+	}
+	else
+	{
+		stats.misses++;
+		slot = allocSlot(hunk, true);
+		slot->state = Decoding;
+		lock.unlock();
+		bool success = readers[0](hunk, slot->data.data());
+		lock.lock();
+		if (!success)
+		{
+			freeSlot(slot);
+			return false;
+		}
+		slot->state = Ready;
+	}
+	memcpy(dest, &slot->data[offset], size);
+	if (hunk != lastHunk)
+	{
+		readAhead(hunk, stream.sequentialReads);
+		lastHunk = hunk;
+	}
+
+	return true;
+}
+
+HunkCache::Stream& HunkCache::getStream(u32 hunk)
+{
+	Stream *oldest = &streams[0];
+	for (Stream& stream : streams)
+	{
+		if (stream.hunk != ~0u && (hunk == stream.hunk || hunk == stream.hunk + 1))
+		{
+			if (hunk != stream.hunk)
+			{
+				stream.hunk = hunk;
+				stream.sequentialReads++;
+			}
+			stream.lastUse = useCounter;
+			return stream;
+		}
+		if (stream.lastUse < oldest->lastUse)
+			oldest = &stream;
+	}
+	// seek: the hunks being read ahead are probably useless now
+	cancelReadAhead();
+	oldest->hunk = hunk;
+	oldest->sequentialReads = 0;
+	oldest->lastUse = useCounter;
+
+	return *oldest;
+}
+
+HunkCache::Slot *HunkCache::allocSlot(u32 hunk, bool evictQueued)
+{
+	// Use an empty slot or the least recently used one
+	Slot *victim = nullptr;
+	for (Slot& slot : slots)
+	{
+		if (slot.state == Empty)
+		{
+			victim = &slot;
+			break;
+		}
+		if (slot.state == Ready && (victim == nullptr || slot.lastUse < victim->lastUse))
+			victim = &slot;
+	}
+	if (victim == nullptr)
+	{
+		if (!evictQueued || queue.empty())
+			return nullptr;
+		// Drop the farthest hunk being read ahead
+		victim = queue.back();
+		queue.pop_back();
+	}
+	if (victim->state != Empty)
+		freeSlot(victim);
+	victim->hunk = hunk;
+	victim->lastUse = ++useCounter;
+	victim->prefetched = false;
+	victim->data.resize(hunkBytes);
+	hunkMap[hunk] = victim;
+
+	return victim;
+}
+
+void HunkCache::freeSlot(Slot *slot)
+{
+	hunkMap.erase(slot->hunk);
+	slot->state = Empty;
+	slot->prefetched = false;
+}
+
+void HunkCache::readAhead(u32 hunk, u32 sequentialReads)
+{
+	if (workers.empty() || sequentialReads == 0)
+		return;
+	// Read further ahead as the sequential run gets longer
+	const u32 depth = std::min(MaxReadAhead, sequentialReads * 2);
+	const u32 end = std::min(hunk + 1 + depth, hunkCount);
+	bool queued = false;
+	for (u32 h = hunk + 1; h < end; h++)
+	{
+		auto it = hunkMap.find(h);
+		if (it != hunkMap.end())
+		{
+			// Keep it until it's used
+			it->second->lastUse = ++useCounter;
+			continue;
+		}
+		Slot *slot = allocSlot(h, false);
+		if (slot == nullptr)
+			break;
+		slot->state = Queued;
+		slot->prefetched = true;
+		queue.push_back(slot);
+		queued = true;
+	}
+	if (queued)
+		workCond.notify_all();
+}
+
+void HunkCache::cancelReadAhead()
+{
+	for (Slot *slot : queue)
+		freeSlot(slot);
+	queue.clear();
+}
+
+void HunkCache::workerThread(size_t readerIndex)
+{
+	std::unique_lock<std::mutex> lock(mutex);
+	for (;;)
+	{
+		workCond.wait(lock, [this]() { return exitThreads || !queue.empty(); });
+		if (exitThreads)
+			break;
+		Slot *slot = queue.front();
+		queue.pop_front();
+		slot->state = Decoding;
+		const u32 hunk = slot->hunk;
+		lock.unlock();
+
+		bool success = readers[readerIndex](hunk, slot->data.data());
+
+		lock.lock();
+		if (success)
+			slot->state = Ready;
+		else
+			freeSlot(slot);
+		readyCond.notify_all();
+	}
+}
+
+HunkCache::Stats HunkCache::getStats()
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	return stats;
+}
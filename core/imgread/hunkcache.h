@@ -0,0 +1,109 @@
+/*
+	Copyright 2026 flyinghead
+
+	This file is part of Flycast.
+
+    Flycast is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 2 of the License, or
+    (at your option) any later version.
+
+    Flycast is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Flycast.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#pragma once
+#include "types.h"
+
+#include <array>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+//
+// LRU cache of decompressed disc image hunks.
+// When hunks are read sequentially, the following ones are decompressed ahead of time on worker threads.
+// Hunks that aren't available are decompressed on the calling thread.
+//
+class HunkCache
+{
+public:
+	// Decompresses a hunk. Each reader is only used by one thread at a time.
+	using Reader = std::function<bool(u32 hunk, u8 *dest)>;
+
+	struct Stats
+	{
+		u64 hits = 0;			// found in cache
+		u64 prefetchHits = 0;	// decompressed by a worker
+		u64 misses = 0;			// decompressed by the caller
+		u64 waits = 0;			// waited for a worker
+	};
+
+	// The first reader is used by the calling thread and the others by the read-ahead workers.
+	HunkCache(u32 hunkBytes, u32 hunkCount, std::vector<Reader> readers, u32 capacity = 64);
+	~HunkCache();
+
+	// Copies size bytes at offset in the hunk to dest. Must not be called concurrently.
+	bool read(u32 hunk, u32 offset, u8 *dest, u32 size);
+
+	Stats getStats();
+
+	// Maximum number of hunks read ahead
+	static constexpr u32 MaxReadAhead = 16;
+
+private:
+	enum State {
+		Empty,
+		Queued,
+		Decoding,
+		Ready
+	};
+	struct Slot
+	{
+		u32 hunk = 0;
+		State state = Empty;
+		u64 lastUse = 0;
+		bool prefetched = false;
+		std::vector<u8> data;
+	};
+
+	// Sequential reads. Games often stream audio and data at the same time.
+	struct Stream
+	{
+		u32 hunk = ~0u;
+		u32 sequentialReads = 0;
+		u64 lastUse = 0;
+	};
+
+	Stream& getStream(u32 hunk);
+	Slot *allocSlot(u32 hunk, bool evictQueued);
+	void freeSlot(Slot *slot);
+	void readAhead(u32 hunk, u32 sequentialReads);
+	void cancelReadAhead();
+	void workerThread(size_t readerIndex);
+
+	const u32 hunkBytes;
+	const u32 hunkCount;
+	std::vector<Reader> readers;
+	std::vector<Slot> slots;
+	std::unordered_map<u32, Slot *> hunkMap;
+	u64 useCounter = 0;
+	std::array<Stream, 4> streams;
+	u32 lastHunk = ~0u;
+	Stats stats;
+
+	std::vector<std::thread> workers;
+	std::mutex mutex;
+	std::condition_variable workCond;
+	std::condition_variable readyCond;
+	std::deque<Slot *> queue;
+	bool exitThreads = false;
+};
@@ -34,10 +34,16 @@ IsoFs::IsoFs(Disc *disc) : disc(disc)
 	baseFad = disc->GetBaseFAD();
 }
 
+void IsoFs::readSectors(u32 fad, u32 count, u8 *dest)
+{
+	std::lock_guard<std::mutex> lock(libGDR_GetIoMutex());
+	disc->ReadSectors(fad, count, dest, 2048);
+}
+
 IsoFs::Directory *IsoFs::getRoot()
 {
 	u8 temp[2048];
-	disc->ReadSectors(baseFad + 16, 1, temp, 2048);
+	readSectors(baseFad + 16, 1, temp);
 	// Primary Volume Descriptor
 	const iso9660_pvd_t *pvd = (const iso9660_pvd_t *)temp;
 
@@ -51,7 +57,7 @@ IsoFs::Directory *IsoFs::getRoot()
 		root->data.resize(len);
 
 		DEBUG_LOG(GDROM, "iso9660 root directory FAD: %d, len: %d", 150 + lba, len);
-		disc->ReadSectors(150 + lba, len / 2048, root->data.data(), 2048);
+		readSectors(150 + lba, len / 2048, root->data.data());
 	}
 	else {
 		WARN_LOG(GDROM, "iso9660 PVD NOT found");
@@ -88,7 +94,7 @@ IsoFs::Entry *IsoFs::Directory::getEntry(const std::string& name)
 			{
 				Directory *directory = new Directory(fs);
 				directory->data.resize(len);
-				fs->disc->ReadSectors(startFad, len / 2048, directory->data.data(), 2048);
+				fs->readSectors(startFad, len / 2048, directory->data.data());
 
 				return directory;
 			}
@@ -102,12 +108,12 @@ u32 IsoFs::File::read(u8 *buf, u32 size, u32 offset) const
 {
 	size = std::min(size, len - offset);
 	u32 sectors = size / 2048;
-	fs->disc->ReadSectors(startFad + offset / 2048, sectors, buf, 2048);
+	fs->readSectors(startFad + offset / 2048, sectors, buf);
 	size -= sectors * 2048;
 	if (size > 0)
 	{
 		u8 temp[2048];
-		fs->disc->ReadSectors(startFad + offset / 2048 + sectors, 1, temp, 2048);
+		fs->readSectors(startFad + offset / 2048 + sectors, 1, temp);
 		memcpy(buf + sectors * 2048, temp, size);
 	}
 	return sectors * 2048 + size;
@@ -71,6 +71,8 @@ public:
 	Directory *getRoot();
 
 private:
+	void readSectors(u32 fad, u32 count, u8 *dest);
+
 	Disc *disc;
 	u32 baseFad;
 };
@@ -0,0 +1,256 @@
+/*
+	Copyright 2026 flyinghead
+
+	This file is part of Flycast.
+
+    Flycast is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 2 of the License, or
+    (at your option) any later version.
+
+    Flycast is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Flycast.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#include "prefetch.h"
+
+#include <algorithm>
+#include <cstring>
+
+SectorPrefetcher::~SectorPrefetcher()
+{
+	if (thread.joinable())
+	{
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			exitThread = true;
+		}
+		cond.notify_all();
+		thread.join();
+	}
+}
+
+void SectorPrefetcher::read(u32 fad, u32 count, u8 *dest, u32 sectorSize, u8 *subchannel)
+{
+	if (count == 0)
+		return;
+	std::unique_lock<std::mutex> lock(mutex);
+	Stream *stream = findStream(fad, sectorSize);
+	if (stream != nullptr)
+	{
+		bool waited = false;
+		while (count > 0)
+		{
+			if (stream->ready > 0)
+			{
+				const u32 n = std::min(count, stream->ready);
+				for (u32 i = 0; i < n; i++)
+				{
+					memcpy(dest, &stream->data[(stream->first + i) % Capacity * sectorSize], sectorSize);
+					dest += sectorSize;
+				}
+				memcpy(subchannel, &stream->subchannels[(stream->first + n - 1) % Capacity * SubchannelSize], SubchannelSize);
+				stream->first = (stream->first + n) % Capacity;
+				stream->fad += n;
+				stream->ready -= n;
+				stats.hits += n;
+				fad += n;
+				count -= n;
+			}
+			else if (stream->inFlight > 0)
+			{
+				if (!waited)
+				{
+					stats.waits++;
+					waited = true;
+				}
+				cond.wait(lock);
+			}
+			else {
+				break;
+			}
+		}
+	}
+	if (count > 0)
+	{
+		stats.misses += count;
+		if (stream != nullptr)
+			// don't prefetch what is being read
+			stream->end = stream->fad;
+		lock.unlock();
+		readSync(fad, count, dest, sectorSize, subchannel);
+		lock.lock();
+		fad += count;
+	}
+	if (stream == nullptr)
+	{
+		// Start prefetching on the next sequential read
+		newStream(fad, sectorSize);
+		return;
+	}
+	stream->fad = fad;
+	stream->end = std::max(stream->end, prefetchEnd(fad, Capacity));
+	if (!thread.joinable())
+		thread = std::thread(&SectorPrefetcher::ioThread, this);
+	cond.notify_all();
+}
+
+void SectorPrefetcher::prefetch(u32 fad, u32 count, u32 sectorSize)
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	Stream *stream = findStream(fad, sectorSize);
+	if (stream == nullptr)
+		stream = &newStream(fad, sectorSize);
+	stream->end = std::max(stream->end, prefetchEnd(fad, count));
+	if (!thread.joinable())
+		thread = std::thread(&SectorPrefetcher::ioThread, this);
+	cond.notify_all();
+}
+
+void SectorPrefetcher::reset()
+{
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		for (Stream& stream : streams)
+		{
+			cancel(stream);
+			stream.sectorSize = 0;
+		}
+		cond.notify_all();
+	}
+	// Wait until the current batch is read
+	std::lock_guard<std::mutex> lock(ioMutex);
+}
+
+SectorPrefetcher::Stats SectorPrefetcher::getStats()
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	return stats;
+}
+
+SectorPrefetcher::Stream *SectorPrefetcher::findStream(u32 fad, u32 sectorSize)
+{
+	for (Stream& stream : streams)
+		if (stream.sectorSize == sectorSize && stream.fad == fad)
+		{
+			stream.lastUse = ++useCounter;
+			return &stream;
+		}
+	return nullptr;
+}
+
+SectorPrefetcher::Stream& SectorPrefetcher::newStream(u32 fad, u32 sectorSize)
+{
+	Stream *stream = &streams[0];
+	for (Stream& s : streams)
+		if (s.lastUse < stream->lastUse)
+			stream = &s;
+	cancel(*stream);
+	stream->sectorSize = sectorSize;
+	stream->fad = fad;
+	stream->end = fad;
+	stream->lastUse = ++useCounter;
+	stream->data.resize(Capacity * sectorSize);
+	stream->subchannels.resize(Capacity * SubchannelSize);
+
+	return *stream;
+}
+
+void SectorPrefetcher::cancel(Stream& stream)
+{
+	stats.cancelled += stream.ready;
+	// discard the sectors being read
+	stream.generation++;
+	stream.first = 0;
+	stream.ready = 0;
+	stream.inFlight = 0;
+	stream.end = stream.fad;
+}
+
+// Doesn't read past the end of the current track
+u32 SectorPrefetcher::prefetchEnd(u32 fad, u32 count)
+{
+	if (trackEnd == nullptr)
+		return fad + count;
+	return std::min(fad + count, std::max(fad, trackEnd(fad)));
+}
+
+void SectorPrefetcher::readSync(u32 fad, u32 count, u8 *dest, u32 sectorSize, u8 *subchannel)
+{
+	std::lock_guard<std::mutex> lock(ioMutex);
+	for (u32 i = 0; i < count; i++)
+	{
+		// Same as the I/O thread for sectors that can't be read
+		memset(dest, 0, sectorSize);
+		memset(subchannel, 0, SubchannelSize);
+		reader(fad + i, dest, sectorSize, subchannel);
+		dest += sectorSize;
+	}
+}
+
+SectorPrefetcher::Stream *SectorPrefetcher::nextBatch()
+{
+	// Fill the emptiest ring buffer first
+	Stream *next = nullptr;
+	for (Stream& stream : streams)
+		if (stream.sectorSize != 0 && stream.inFlight == 0 && stream.ready < Capacity
+				&& stream.fad + stream.ready < stream.end
+				&& (next == nullptr || stream.ready < next->ready))
+			next = &stream;
+	return next;
+}
+
+void SectorPrefetcher::ioThread()
+{
+	std::vector<u8> data;
+	std::vector<u8> subchannels;
+	std::unique_lock<std::mutex> lock(mutex);
+	for (;;)
+	{
+		Stream *stream = nullptr;
+		cond.wait(lock, [&]() {
+			if (exitThread)
+				return true;
+			stream = nextBatch();
+			return stream != nullptr;
+		});
+		if (exitThread)
+			break;
+		const u32 sectorSize = stream->sectorSize;
+		const u32 fad = stream->fad + stream->ready;
+		const u32 count = std::min({ BatchSize, Capacity - stream->ready, stream->end - fad });
+		const u32 generation = stream->generation;
+		stream->inFlight = count;
+		lock.unlock();
+
+		data.assign(count * sectorSize, 0);
+		subchannels.assign(count * SubchannelSize, 0);
+		{
+			std::lock_guard<std::mutex> _(ioMutex);
+			for (u32 i = 0; i < count; i++)
+				reader(fad + i, &data[i * sectorSize], sectorSize, &subchannels[i * SubchannelSize]);
+		}
+
+		lock.lock();
+		if (stream->generation == generation && stream->fad + stream->ready == fad)
+		{
+			for (u32 i = 0; i < count; i++)
+			{
+				const u32 index = (stream->first + stream->ready + i) % Capacity;
+				memcpy(&stream->data[index * sectorSize], &data[i * sectorSize], sectorSize);
+				memcpy(&stream->subchannels[index * SubchannelSize], &subchannels[i * SubchannelSize], SubchannelSize);
+			}
+			stream->ready += count;
+			stream->inFlight = 0;
+		}
+		else
+		{
+			stats.cancelled += count;
+		}
+		cond.notify_all();
+	}
+}
@@ -0,0 +1,105 @@
+/*
+	Copyright 2026 flyinghead
+
+	This file is part of Flycast.
+
+    Flycast is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 2 of the License, or
+    (at your option) any later version.
+
+    Flycast is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Flycast.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#pragma once
+#include "types.h"
+
+#include <array>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+//
+// Reads disc sectors ahead of the emulated drive on an I/O thread.
+// Each stream of sequential reads has its own ring buffer. Reading elsewhere cancels the least recently used stream.
+// The data returned doesn't depend on what has been prefetched, only the time it takes to get it.
+//
+class SectorPrefetcher
+{
+public:
+	static constexpr u32 SubchannelSize = 96;
+	// Reads one sector and its subchannel data
+	using Reader = std::function<void(u32 fad, u8 *dest, u32 sectorSize, u8 *subchannel)>;
+	// Returns the fad following the track that contains fad, or fad if it isn't on the disc
+	using TrackEnd = std::function<u32(u32 fad)>;
+
+	struct Stats
+	{
+		u64 hits = 0;		// sectors read from a ring buffer
+		u64 misses = 0;		// sectors read synchronously
+		u64 waits = 0;		// waited for the I/O thread
+		u64 cancelled = 0;	// prefetched sectors that were never read
+	};
+
+	SectorPrefetcher(Reader reader, TrackEnd trackEnd = nullptr)
+		: reader(reader), trackEnd(trackEnd) {}
+	~SectorPrefetcher();
+
+	// Reads count sectors to dest. The subchannel data of the last one is copied to subchannel.
+	void read(u32 fad, u32 count, u8 *dest, u32 sectorSize, u8 *subchannel);
+	// Starts reading these sectors in the background
+	void prefetch(u32 fad, u32 count, u32 sectorSize);
+	// Drops all the prefetched sectors and waits until no sector is being read
+	void reset();
+	Stats getStats();
+	// Must be held by anything else reading from the disc
+	std::mutex& getIoMutex() { return ioMutex; }
+
+	// Ring buffer size of each stream, in sectors
+	static constexpr u32 Capacity = 128;
+	// Number of sectors read at once by the I/O thread
+	static constexpr u32 BatchSize = 16;
+
+private:
+	struct Stream
+	{
+		u32 sectorSize = 0;
+		u32 fad = 0;			// next sector to be read by the emulator
+		u32 first = 0;			// ring index of this sector
+		u32 ready = 0;			// number of sectors available from fad
+		u32 inFlight = 0;		// number of sectors being read after them
+		u32 end = 0;			// prefetch until this sector
+		u32 generation = 0;
+		u64 lastUse = 0;
+		std::vector<u8> data;
+		std::vector<u8> subchannels;
+	};
+
+	Stream *findStream(u32 fad, u32 sectorSize);
+	Stream& newStream(u32 fad, u32 sectorSize);
+	void cancel(Stream& stream);
+	u32 prefetchEnd(u32 fad, u32 count);
+	void readSync(u32 fad, u32 count, u8 *dest, u32 sectorSize, u8 *subchannel);
+	Stream *nextBatch();
+	void ioThread();
+
+	Reader reader;
+	TrackEnd trackEnd;
+	std::array<Stream, 2> streams;
+	u64 useCounter = 0;
+	Stats stats;
+
+	std::thread thread;
+	std::mutex mutex;
+	std::condition_variable cond;
+	bool exitThread = false;
+	// Held while reading from the disc
+	std::mutex ioMutex;
+};
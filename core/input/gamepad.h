@@ -50,6 +50,7 @@ enum DreamcastKey
 	EMU_BTN_ESCAPE,
 	EMU_BTN_LOADSTATE,
 	EMU_BTN_SAVESTATE,
+	EMU_BTN_REWIND,
 
 	// Real axes
 	DC_AXIS_TRIGGERS	= 0x1000000,
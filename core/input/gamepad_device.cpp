@@ -22,6 +22,7 @@
 #include "oslib/oslib.h"
 #include "rend/gui.h"
 #include "emulator.h"
+#include "rewind.h"
 #include "hw/maple/maple_devs.h"
 #include "mouse.h"
 
@@ -99,6 +100,9 @@ bool GamepadDevice::handleButtonInput(int port, DreamcastKey key, bool pressed)
 			if (pressed)
 				gui_saveState();
 			break;
+		case EMU_BTN_REWIND:
+			rewindBuffer.setRewinding(pressed && !gui_is_open());
+			break;
 		case DC_AXIS_LT:
 			if (port >= 0)
 				lt[port] = pressed ? 255 : 0;
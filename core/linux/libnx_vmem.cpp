@@ -250,6 +250,29 @@ void release_jit_block(void *code_area1, void *code_area2, size_t size)
 	virtmemUnlock();
 }
 
+void *map_file(FILE *file, size_t size)
+{
+	return nullptr;
+}
+
+void unmap_file(void *start, size_t size)
+{
+}
+
+void *reserve_window(size_t size)
+{
+	return nullptr;
+}
+
+bool map_window(void *dest, size_t size, size_t memoffset, bool allow_writes)
+{
+	return false;
+}
+
+void unmap_window(void *start, size_t size)
+{
+}
+
 } // namespace virtmem
 
 #ifndef TARGET_NO_EXCEPTIONS
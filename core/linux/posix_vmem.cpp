@@ -324,6 +324,41 @@ void release_jit_block(void *code_area1, void *code_area2, size_t size)
 	munmap(code_area2, size);
 }
 
+void *map_file(FILE *file, size_t size)
+{
+	void *p = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fileno(file), 0);
+	if (p == MAP_FAILED)
+	{
+		WARN_LOG(VMEM, "map_file: mmap failed. errno %d", errno);
+		return nullptr;
+	}
+	return p;
+}
+
+void unmap_file(void *start, size_t size)
+{
+	munmap(start, size);
+}
+
+void *reserve_window(size_t size)
+{
+	if (vmem_fd < 0)
+		return nullptr;
+	return mem_region_reserve(nullptr, size);
+}
+
+bool map_window(void *dest, size_t size, size_t memoffset, bool allow_writes)
+{
+	return mem_region_map_file((void*)(uintptr_t)vmem_fd, dest, size, memoffset, allow_writes) != nullptr;
+}
+
+void unmap_window(void *start, size_t size)
+{
+	// Replace the mappings with inaccessible memory so that the range stays reserved
+	void *p = mmap(start, size, PROT_NONE, MAP_PRIVATE | MAP_ANON | MAP_FIXED, -1, 0);
+	verify(p == start);
+}
+
 } // namespace virtmem
 
 #endif // !__SWITCH__
@@ -84,6 +84,8 @@ static void getLocalInput(MapleInputState inputState[4])
 #include "imgui/imgui.h"
 #include "miniupnp.h"
 #include "hw/naomi/naomi_cart.h"
+#include "serialize.h"
+#include <limits>
 
 //#define SYNC_TEST 1
 
@@ -146,6 +148,163 @@ struct MemPages
 static std::unordered_map<int, MemPages> deltaStates;
 static int lastSavedFrame = -1;
 
+//
+// Game state buffers given to GGPO.
+// Memory is saved separately in deltaStates so states are serialized in rollback mode and are much smaller than full savestates.
+// Buffers are sized from the actual state size and recycled once freed by GGPO.
+//
+class StatePool : public Serializer::Stream
+{
+public:
+	struct Stats
+	{
+		u64 savedFrames = 0;
+		u64 savedBytes = 0;
+		u32 lastSize = 0;
+		u32 buffers = 0;		// allocated buffers
+		u32 bufferSize = 0;
+	};
+
+	~StatePool() {
+		clear();
+	}
+
+	// Serializes the frame number and the current state in a buffer. Returns nullptr if out of memory.
+	u8 *save(int frame, int& len)
+	{
+		if (bufferSize == 0)
+		{
+			// dry run to get the state size
+			Serializer ser(nullptr, std::numeric_limits<size_t>::max(), true);
+			ser << frame;
+			dc_serialize(ser);
+			setBufferSize(ser.size());
+		}
+		buffer = acquire();
+		if (buffer == nullptr)
+			return nullptr;
+		blockCount = 0;
+		spill.clear();
+		Serializer ser(*this, bufferSize, true);
+		ser << frame;
+		dc_serialize(ser);
+		ser.flush();
+		len = (int)ser.size();
+		if (ser.size() > bufferSize)
+		{
+			// The state doesn't fit anymore: use larger buffers
+			u8 *first = buffer;
+			const size_t firstSize = bufferSize;
+			setBufferSize(ser.size());
+			buffer = acquire();
+			if (buffer != nullptr)
+			{
+				memcpy(buffer, first, firstSize);
+				memcpy(buffer + firstSize, spill.data(), ser.size() - firstSize);
+			}
+			release(first);
+			if (buffer == nullptr)
+				return nullptr;
+		}
+		stats.savedFrames++;
+		stats.savedBytes += len;
+		stats.lastSize = len;
+
+		return buffer;
+	}
+
+	void release(u8 *buffer)
+	{
+		u8 *p = buffer - HeaderSize;
+		if (*(size_t *)p == bufferSize)
+			freeBuffers.push_back(buffer);
+		else
+		{
+			free(p);
+			stats.buffers--;
+		}
+	}
+
+	// Frees the unused buffers. Buffers still in use are freed when released.
+	void clear()
+	{
+		for (u8 *buffer : freeBuffers)
+			free(buffer - HeaderSize);
+		stats.buffers -= freeBuffers.size();
+		freeBuffers.clear();
+		bufferSize = 0;
+		spill.clear();
+		spill.shrink_to_fit();
+	}
+
+	const Stats& getStats() const {
+		return stats;
+	}
+
+	void resetStats()
+	{
+		u32 buffers = stats.buffers;
+		stats = Stats();
+		stats.buffers = buffers;
+	}
+
+	u8 *allocBlock() override
+	{
+		if (blockCount++ == 0)
+			return buffer;
+		// overflow
+		size_t offset = spill.size();
+		spill.resize(offset + bufferSize);
+		return &spill[offset];
+	}
+
+	void writeBlock(u8 *block, size_t size) override
+	{
+		if (block != buffer)
+			spill.resize(block - spill.data() + size);
+	}
+
+private:
+	u8 *acquire()
+	{
+		if (!freeBuffers.empty())
+		{
+			u8 *buffer = freeBuffers.back();
+			freeBuffers.pop_back();
+			return buffer;
+		}
+		u8 *p = (u8 *)malloc(HeaderSize + bufferSize);
+		if (p == nullptr)
+		{
+			WARN_LOG(NETWORK, "Memory alloc failed");
+			return nullptr;
+		}
+		*(size_t *)p = bufferSize;
+		stats.buffers++;
+		return p + HeaderSize;
+	}
+
+	void setBufferSize(size_t size)
+	{
+		clear();
+		// Leave some room for the variable parts of the state
+		constexpr size_t Granularity = 64 * 1024;
+		bufferSize = (size + size / 8 + Granularity - 1) & ~(Granularity - 1);
+		stats.bufferSize = (u32)bufferSize;
+		DEBUG_LOG(NETWORK, "GGPO state size %d buffer size %d", (int)size, (int)bufferSize);
+	}
+
+	// Buffer capacity is stored before the data
+	static constexpr size_t HeaderSize = 16;
+	size_t bufferSize = 0;
+	std::vector<u8 *> freeBuffers;
+	u8 *buffer = nullptr;
+	int blockCount = 0;
+	std::vector<u8> spill;
+	Stats stats;
+};
+static StatePool statePool;
+
 static int timesyncOccurred;
 
 #pragma pack(push, 1)
@@ -332,22 +491,14 @@ static bool save_game_state(unsigned char **buffer, int *len, int *checksum, int
 {
 	verify(!sh4_cpu.IsCpuRunning());
 	lastSavedFrame = frame;
-	// TODO this is way too much memory
-	size_t allocSize = (settings.platform.isNaomi() ? 20 : 10) * 1024 * 1024;
-	*buffer = (unsigned char *)malloc(allocSize);
+	*buffer = statePool.save(frame, *len);
 	if (*buffer == nullptr)
 	{
-		WARN_LOG(NETWORK, "Memory alloc failed");
 		*len = 0;
 		return false;
 	}
-	Serializer ser(*buffer, allocSize, true);
-	ser << frame;
-	dc_serialize(ser);
-	verify(ser.size() < allocSize);
-	*len = ser.size();
 #ifdef SYNC_TEST
-	*checksum = XXH32(*buffer, usedSize, 7);
+	*checksum = XXH32(*buffer, *len, 7);
 #endif
 	memwatch::protect();
 	if (frame > 0)
@@ -444,7 +595,7 @@ static void free_buffer(void *buffer)
 		int frame;
 		deser >> frame;
 		deltaStates.erase(frame);
-		free(buffer);
+		statePool.release((u8 *)buffer);
 	}
 }
 
@@ -609,6 +760,12 @@ void stopSession()
 		return;
 	ggpo_close_session(ggpoSession);
 	ggpoSession = nullptr;
+	const StatePool::Stats& stats = statePool.getStats();
+	if (stats.savedFrames != 0)
+		INFO_LOG(NETWORK, "GGPO saved %d frames, %d bytes per frame, %d buffers of %d KB", (int)stats.savedFrames,
+				(int)(stats.savedBytes / stats.savedFrames), (int)stats.buffers, (int)(stats.bufferSize / 1024));
+	statePool.clear();
+	statePool.resetStats();
 	miniupnp.Term();
 	emu.setNetworkState(false);
 	memwatch::unprotect();
@@ -869,6 +1026,12 @@ void displayStats()
 	ImGui::Text("Send Q");
 	ImGui::ProgressBar(stats.network.send_queue_len / 10.f, ImVec2(-1, 10.f * settings.display.uiScale), "");
 
+	// Saved state size
+	ImGui::Text("State");
+	std::string stateSize = std::to_string(statePool.getStats().lastSize / 1024) + "K";
+	ImGui::SameLine(ImGui::GetContentRegionAvail().x - ImGui::CalcTextSize(stateSize.c_str()).x);
+	ImGui::Text("%s", stateSize.c_str());
+
 	// Frame Delay
 	ImGui::Text("Delay");
 	std::string delay = std::to_string(config::GGPODelay.get());
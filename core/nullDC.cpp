@@ -14,6 +14,7 @@
 #include "lua/lua.h"
 #include "stdclass.h"
 #include "serialize.h"
+#include "deltastate.h"
 
 int flycast_init(int argc, char* argv[])
 {
@@ -86,66 +87,76 @@ void flycast_term()
 	gui_cancel_load();
 	lua::term();
 	emu.term();
+	dc_waitSavestate();
 	gui_term();
 	os_TermInput();
 }
 
+// Savestate being compressed and written in the background
+static std::unique_ptr<RZipParallelWriter> pendingSave;
+// Last incremental savestate
+static deltastate::Chain savestateChain;
+static std::vector<u8> stateBuffer;
+
+void dc_waitSavestate()
+{
+	if (pendingSave != nullptr)
+	{
+		pendingSave->Wait();
+		pendingSave.reset();
+	}
+}
+
 void dc_savestate(int index)
 {
 	if (settings.network.online)
 		return;
+	dc_waitSavestate();
 
-	Serializer ser;
-	dc_serialize(ser);
-
-	void *data = malloc(ser.size());
-	if (data == nullptr)
+	std::string filename = hostfs::getSavestatePath(index, true);
+	std::unique_ptr<RZipParallelWriter> writer;
+	size_t size = 0;
+	if (config::IncrementalSavestates)
 	{
-		WARN_LOG(SAVESTATE, "Failed to save state - could not malloc %d bytes", (int)ser.size());
-		gui_display_notification("Save state failed - memory full", 2000);
-    	return;
+		deltastate::serialize(stateBuffer);
+		size = stateBuffer.size();
+		writer = savestateChain.save(filename, stateBuffer);
 	}
-
-	ser = Serializer(data, ser.size());
-	dc_serialize(ser);
-
-	std::string filename = hostfs::getSavestatePath(index, true);
-#if 0
-	FILE *f = nowide::fopen(filename.c_str(), "wb");
-
-	if ( f == NULL )
+	else
 	{
-		WARN_LOG(SAVESTATE, "Failed to save state - could not open %s for writing", filename.c_str());
-		gui_display_notification("Cannot open save file", 2000);
-		free(data);
-    	return;
+		savestateChain.reset();
+		writer = std::make_unique<RZipParallelWriter>();
+		if (writer->Open(filename))
+		{
+			Serializer ser(*writer, writer->ChunkSize());
+			dc_serialize(ser);
+			ser.flush();
+			size = ser.size();
+		}
+		else
+			writer.reset();
 	}
-
-	std::fwrite(data, 1, ser.size(), f);
-	std::fclose(f);
-#else
-	RZipFile zipFile;
-	if (!zipFile.Open(filename, true))
+	if (writer == nullptr)
 	{
 		WARN_LOG(SAVESTATE, "Failed to save state - could not open %s for writing", filename.c_str());
 		gui_display_notification("Cannot open save file", 2000);
-		free(data);
-    	return;
-	}
-	if (zipFile.Write(data, ser.size()) != ser.size())
-	{
-		WARN_LOG(SAVESTATE, "Failed to save state - error writing %s", filename.c_str());
-		gui_display_notification("Error saving state", 2000);
-		zipFile.Close();
-		free(data);
-    	return;
+		return;
 	}
-	zipFile.Close();
-#endif
 
-	free(data);
-	NOTICE_LOG(SAVESTATE, "Saved state to %s size %d", filename.c_str(), (int)ser.size());
-	gui_display_notification("State saved", 1000);
+	const u32 deltas = config::IncrementalSavestates ? savestateChain.getInfo().deltas : 0;
+	writer->Close([filename, size, deltas](bool success) {
+		if (success)
+		{
+			NOTICE_LOG(SAVESTATE, "Saved state to %s size %d deltas %d", filename.c_str(), (int)size, deltas);
+			gui_display_notification("State saved", 1000);
+		}
+		else
+		{
+			WARN_LOG(SAVESTATE, "Failed to save state - error writing %s", filename.c_str());
+			gui_display_notification("Error saving state", 2000);
+		}
+	});
+	pendingSave = std::move(writer);
 }
 
 void dc_loadstate(int index)
@@ -153,6 +164,8 @@ void dc_loadstate(int index)
 	u32 total_size = 0;
 	FILE *f = nullptr;
 
+	dc_waitSavestate();
+
 	std::string filename = hostfs::getSavestatePath(index, false);
 	RZipFile zipFile;
 	if (zipFile.Open(filename, false))
@@ -216,9 +229,27 @@ void dc_loadstate(int index)
 		return;
 	}
 
+	std::vector<u8> state;
+	deltastate::Info deltaInfo;
+	if (deltastate::isDeltaState(data, total_size))
+	{
+		bool restored = deltastate::restore((const u8 *)data, total_size, state, &deltaInfo);
+		free(data);
+		if (!restored)
+		{
+			WARN_LOG(SAVESTATE, "Failed to load state - corrupted incremental savestate %s", filename.c_str());
+			gui_display_notification("Failed to load state - invalid savestate", 2000);
+			return;
+		}
+		total_size = (u32)state.size();
+		data = state.data();
+	}
+
+	bool loaded = false;
 	try {
 		Deserializer deser(data, total_size);
 		dc_loadstate(deser);
+		loaded = true;
 	    NOTICE_LOG(SAVESTATE, "Loaded state ver %d from %s size %d", deser.version(), filename.c_str(), total_size);
 		if (deser.size() != total_size)
 			WARN_LOG(SAVESTATE, "Savestate size %d but only %d bytes used", total_size, (int)deser.size());
@@ -226,7 +257,11 @@ void dc_loadstate(int index)
 		ERROR_LOG(SAVESTATE, "%s", e.what());
 	}
 
-	free(data);
+	if (state.empty())
+		free(data);
+	else if (loaded && config::IncrementalSavestates)
+		// Following saves can be deltas of this state
+		savestateChain.loaded(hostfs::getSavestatePath(index, true), state, deltaInfo);
 	EventManager::event(Event::LoadState);
 }
 
@@ -124,6 +124,16 @@ std::string getShaderCachePath(const std::string& filename)
 	return get_writable_data_path(filename);
 }
 
+std::string getDynarecCachePath(const std::string& filename)
+{
+	return get_writable_data_path(filename);
+}
+
+std::string getDimmCachePath(const std::string& filename)
+{
+	return get_writable_data_path(filename);
+}
+
 std::string getTextureLoadPath(const std::string& gameId)
 {
 	if (gameId.length() > 0)
@@ -47,6 +47,8 @@ namespace hostfs
 	std::string getTextureDumpPath();
 
 	std::string getShaderCachePath(const std::string& filename);
+	std::string getDynarecCachePath(const std::string& filename);
+	std::string getDimmCachePath(const std::string& filename);
 }
 
 #ifdef _WIN64
@@ -39,4 +39,18 @@ bool region_lock(void *start, std::size_t len);
 bool region_unlock(void *start, std::size_t len);
 bool region_set_exec(void *start, std::size_t len);
 
+// Maps a whole file in memory. Pages are loaded on first access and copied on write.
+// Returns nullptr if the platform doesn't support it or if it fails.
+void *map_file(FILE *file, size_t size);
+// Releases a mapping created by map_file
+void unmap_file(void *start, size_t size);
+
+// Reserves an inaccessible address range in which parts of the emulated memory can be mapped.
+// Returns nullptr if the platform doesn't support it.
+void *reserve_window(size_t size);
+// Maps a part of the emulated memory at the given address of a window. Returns false on failure.
+bool map_window(void *dest, size_t size, size_t memoffset, bool allow_writes);
+// Makes a part of a window inaccessible again
+void unmap_window(void *start, size_t size);
+
 } // namespace vmem
@@ -56,12 +56,15 @@ namespace MemType {
 		Fast,
 		StoreQueue,
 		Slow,
+		MmuMirror,
+		MmuSlow,
 		Count
 	};
 }
 
 static const void *MemHandlers[MemType::Count][MemSize::Count][MemOp::Count];
 static const u8 *MemHandlerStart, *MemHandlerEnd;
+static u8 *mmuMirrorBase;
 static UnwindInfo unwinder;
 #ifndef _WIN32
 static float xmmSave[4];
@@ -160,6 +163,8 @@ public:
 		CheckBlock(force_checks, block);
 
 		sub(rsp, STACK_ALIGN);
+		// Translated RAM accesses use the host mirror of the guest virtual memory
+		const bool mmuMirror = optimise && mmu_enabled() && mmuMirrorBase != nullptr && config::DynarecMmuMirror;
 
 		if (mmu_enabled() && block->has_fpu_op)
 		{
@@ -173,11 +178,30 @@ public:
 			jmp(exit_block, T_NEAR);
 			L(fpu_enabled);
 		}
+		if (optimise && rdv_IsTraceCandidate(block))
+		{
+			// Count the block runs and have it recompiled as a trace when it gets hot
+			Xbyak::Label not_hot;
+			mov(rax, (uintptr_t)&block->runs);
+			inc(dword[rax]);
+			cmp(dword[rax], TRACE_HOT_RUNS);
+			jne(not_hot);
+			mov(call_regs[0], block->addr);
+			GenCall(rdv_HotBlock);
+			jmp(exit_block, T_NEAR);
+			L(not_hot);
+		}
+		// Blocks branching to themselves loop back here instead of returning to the main loop
+		const bool self_loop = !mmu_enabled() && block->read_only && block->BranchBlock == block->vaddr
+				&& (block->BlockType == BET_StaticJump || block->BlockType == BET_Cond_0 || block->BlockType == BET_Cond_1);
+		regalloc.DoAlloc(block, self_loop);
+		// The registers kept across iterations are only loaded once
+		regalloc.LoadLoopRegs();
+		Xbyak::Label loop_entry;
+		L(loop_entry);
 		mov(rax, (uintptr_t)&p_sh4rcb->cntx.cycle_counter);
 		sub(dword[rax], block->guest_cycles);
 
-		regalloc.DoAlloc(block);
-
 		for (current_opid = 0; current_opid < block->oplist.size(); current_opid++)
 		{
 			shil_opcode& op  = block->oplist[current_opid];
@@ -257,10 +281,17 @@ public:
 							add(call_regs[0], dword[rax]);
 						}
 					}
-					genMmuLookup(block, op, 0);
-
 					int size = op.size == 1 ? MemSize::S8 : op.size == 2 ? MemSize::S16 : op.size == 4 ? MemSize::S32 : MemSize::S64;
-					GenCall((void (*)())MemHandlers[optimise ? MemType::Fast : MemType::Slow][size][MemOp::R], mmu_enabled());
+					if (mmuMirror)
+					{
+						mov(call_regs[2], block->vaddr + op.guest_offs - (op.delay_slot ? 2 : 0));	// pc
+						GenCall((void (*)())MemHandlers[MemType::MmuMirror][size][MemOp::R], true);
+					}
+					else
+					{
+						genMmuLookup(block, op, 0);
+						GenCall((void (*)())MemHandlers[optimise ? MemType::Fast : MemType::Slow][size][MemOp::R], mmu_enabled());
+					}
 
 #if ALLOC_F64 == false
 					if (size == MemSize::S64)
@@ -294,7 +325,8 @@ public:
 							add(call_regs[0], dword[rax]);
 						}
 					}
-					genMmuLookup(block, op, 1);
+					if (!mmuMirror)
+						genMmuLookup(block, op, 1);
 
 #if ALLOC_F64 == false
 					if (op.size == 8)
@@ -307,7 +339,13 @@ public:
 						shil_param_to_host_reg(op.rs2, call_regs64[1]);
 
 					int size = op.size == 1 ? MemSize::S8 : op.size == 2 ? MemSize::S16 : op.size == 4 ? MemSize::S32 : MemSize::S64;
-					GenCall((void (*)())MemHandlers[optimise ? MemType::Fast : MemType::Slow][size][MemOp::W], mmu_enabled());
+					if (mmuMirror)
+					{
+						mov(call_regs[2], block->vaddr + op.guest_offs - (op.delay_slot ? 2 : 0));	// pc
+						GenCall((void (*)())MemHandlers[MemType::MmuMirror][size][MemOp::W], true);
+					}
+					else
+						GenCall((void (*)())MemHandlers[optimise ? MemType::Fast : MemType::Slow][size][MemOp::W], mmu_enabled());
 				}
 			}
 			break;
@@ -471,6 +509,11 @@ public:
 		case BET_StaticCall:
 			//next_pc = block->BranchBlock;
 			mov(dword[rax], block->BranchBlock);
+			if (self_loop)
+			{
+				genLoopBack(block, loop_entry);
+				regalloc.WritebackLoopRegs();
+			}
 			break;
 
 		case BET_Cond_0:
@@ -490,9 +533,13 @@ public:
 				cmp(dword[rdx], block->BlockType & 1);
 				Xbyak::Label branch_not_taken;
 
-				jne(branch_not_taken, T_SHORT);
+				jne(branch_not_taken, self_loop ? T_NEAR : T_SHORT);
 				mov(dword[rax], block->BranchBlock);
+				if (self_loop)
+					genLoopBack(block, loop_entry);
 				L(branch_not_taken);
+				if (self_loop)
+					regalloc.WritebackLoopRegs();
 			}
 			break;
 
@@ -687,6 +734,10 @@ public:
 		mov(rax, (size_t)&p_sh4rcb->cntx.pc);
 		mov(call_regs[0], dword[rax]);
 		call(bm_GetCodeByVAddr);
+#if !defined(NDEBUG) || defined(DEBUGFAST)
+		mov(rcx, (uintptr_t)&rdv_dispatchCount);
+		inc(qword[rcx]);
+#endif
 		call(rax);
 		mov(rax, (uintptr_t)&p_sh4rcb->cntx.cycle_counter);
 		mov(ecx, dword[rax]);
@@ -762,6 +813,8 @@ public:
 		{
 			for (int op = 0; op < MemOp::Count; op++)
 			{
+				if (mmuMirrorBase != nullptr && (void *)MemHandlers[MemType::MmuMirror][size][op] == ca)
+					return rewriteMmuMirrorAccess(context, retAddr, size, op);
 				if ((void *)MemHandlers[MemType::Fast][size][op] != ca)
 					continue;
 
@@ -796,6 +849,36 @@ public:
 	}
 
 private:
+	bool rewriteMmuMirrorAccess(host_context_t &context, u8 *retAddr, int size, int op)
+	{
+		switch (mmumirror::handleFault(context.r9, op == MemOp::W))
+		{
+		case mmumirror::FaultResult::Mapped:
+			// retry the access
+			break;
+
+		case mmumirror::FaultResult::Translate:
+			// use the slow path for this access only
+			context.pc = (uintptr_t)MemHandlers[MemType::MmuSlow][size][op];
+			break;
+
+		case mmumirror::FaultResult::NotRam:
+		{
+			const u8 *start = getCurr();
+			call(MemHandlers[MemType::MmuSlow][size][op]);
+			verify(getCurr() - start == 5);
+
+			ready();
+
+			context.pc = (uintptr_t)(retAddr - 5);
+			// remove the call from the stack
+			context.rsp += 8;
+			break;
+		}
+		}
+		return true;
+	}
+
 	void genMmuLookup(const RuntimeBlockInfo* block, const shil_opcode& op, u32 write)
 	{
 		if (mmu_enabled())
@@ -1038,6 +1121,21 @@ private:
 		return true;
 	}
 
+	// Jumps back to the start of the block if the timeslice isn't over and the block hasn't been discarded.
+	// Otherwise falls through so that the registers kept across iterations can be written back.
+	void genLoopBack(RuntimeBlockInfo* block, const Xbyak::Label& loop_entry)
+	{
+		Xbyak::Label loop_exit;
+		mov(rdx, (uintptr_t)&p_sh4rcb->cntx.cycle_counter);
+		cmp(dword[rdx], 0);
+		jle(loop_exit);
+		mov(rdx, (uintptr_t)&p_sh4rcb->fpcb[(block->addr >> 1) & FPCB_MASK]);
+		mov(rcx, (uintptr_t)CC_RW2RX(getCode()));
+		cmp(qword[rdx], rcx);
+		je(loop_entry, T_NEAR);
+		L(loop_exit);
+	}
+
 	void CheckBlock(bool force_checks, RuntimeBlockInfo* block)
 	{
 		if (mmu_enabled() || force_checks)
@@ -1096,6 +1194,7 @@ private:
 	{
 		// make sure the memory handlers are set
 		verify(ReadMem8 != nullptr);
+		mmuMirrorBase = mmumirror::init();
 
 		MemHandlerStart = getCurr();
 		for (int type = 0; type < MemType::Count; type++)
@@ -1110,37 +1209,51 @@ private:
 						mov(rax, (uintptr_t)addrspace::ram_base);
 						mov(r9, call_regs64[0]);
 						and_(call_regs[0], 0x1FFFFFFF);
-
-						switch (size)
-						{
-						case MemSize::S8:
-							if (op == MemOp::R)
-								movsx(eax, byte[rax + call_regs64[0]]);
-							else
-								mov(byte[rax + call_regs64[0]], call_regs[1].cvt8());
-							break;
-
-						case MemSize::S16:
-							if (op == MemOp::R)
-								movsx(eax, word[rax + call_regs64[0]]);
-							else
-								mov(word[rax + call_regs64[0]], call_regs[1].cvt16());
-							break;
-
-						case MemSize::S32:
-							if (op == MemOp::R)
-								mov(eax, dword[rax + call_regs64[0]]);
-							else
-								mov(dword[rax + call_regs64[0]], call_regs[1]);
-							break;
-
-						case MemSize::S64:
-							if (op == MemOp::R)
-								mov(rax, qword[rax + call_regs64[0]]);
-							else
-								mov(qword[rax + call_regs64[0]], call_regs64[1]);
-							break;
-						}
+						genHostMemAccess(size, op);
+					}
+					else if (type == MemType::MmuMirror)
+					{
+						if (mmuMirrorBase == nullptr)
+							continue;
+						// The virtual address is used as is in the mirror window
+						mov(rax, (uintptr_t)mmuMirrorBase);
+						mov(r9, call_regs64[0]);
+						genHostMemAccess(size, op);
+					}
+					else if (type == MemType::MmuSlow)
+					{
+						// Translate the virtual address then use the slow or store queue handler.
+						// call_regs[2] holds the guest pc.
+						Xbyak::Label inCache;
+						Xbyak::Label translated;
+
+						mov(eax, call_regs[0]);
+						shr(eax, 12);
+						mov(r9, (uintptr_t)mmuAddressLUT);
+						mov(eax, dword[r9 + rax * 4]);
+						test(eax, eax);
+						jne(inCache);
+
+						sub(rsp, STACK_ALIGN + 16);
+						if (op == MemOp::W)
+							mov(qword[rsp + STACK_ALIGN], call_regs64[1]);
+						mov(call_regs[1], op == MemOp::W);
+						call((const void *)mmuDynarecLookup);
+						if (op == MemOp::W)
+							mov(call_regs64[1], qword[rsp + STACK_ALIGN]);
+						add(rsp, STACK_ALIGN + 16);
+						mov(call_regs[0], eax);
+						jmp(translated);
+
+						L(inCache);
+						and_(call_regs[0], 0xFFF);
+						or_(call_regs[0], eax);
+						L(translated);
+						if (op == MemOp::W && size >= MemSize::S32)
+							jmp(MemHandlers[MemType::StoreQueue][size][op]);
+						else
+							jmp(MemHandlers[MemType::Slow][size][op]);
+						continue;
 					}
 					else if (type == MemType::StoreQueue)
 					{
@@ -1222,6 +1335,41 @@ private:
 		MemHandlerEnd = getCurr();
 	}
 
+	// Load or store at rax + arg0
+	void genHostMemAccess(int size, int op)
+	{
+		switch (size)
+		{
+		case MemSize::S8:
+			if (op == MemOp::R)
+				movsx(eax, byte[rax + call_regs64[0]]);
+			else
+				mov(byte[rax + call_regs64[0]], call_regs[1].cvt8());
+			break;
+
+		case MemSize::S16:
+			if (op == MemOp::R)
+				movsx(eax, word[rax + call_regs64[0]]);
+			else
+				mov(word[rax + call_regs64[0]], call_regs[1].cvt16());
+			break;
+
+		case MemSize::S32:
+			if (op == MemOp::R)
+				mov(eax, dword[rax + call_regs64[0]]);
+			else
+				mov(dword[rax + call_regs64[0]], call_regs[1]);
+			break;
+
+		case MemSize::S64:
+			if (op == MemOp::R)
+				mov(rax, qword[rax + call_regs64[0]]);
+			else
+				mov(qword[rax + call_regs64[0]], call_regs64[1]);
+			break;
+		}
+	}
+
 	void saveXmmRegisters()
 	{
 #ifndef _WIN32
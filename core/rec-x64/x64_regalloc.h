@@ -40,9 +40,9 @@ struct X64RegAlloc : RegAlloc<Xbyak::Operand::Code, s8, ALLOC_F64>
 {
 	X64RegAlloc(BlockCompiler *compiler) : compiler(compiler) {}
 
-	void DoAlloc(RuntimeBlockInfo* block)
+	void DoAlloc(RuntimeBlockInfo* block, bool selfLoop = false)
 	{
-		RegAlloc::DoAlloc(block, alloc_regs, alloc_fregs);
+		RegAlloc::DoAlloc(block, alloc_regs, alloc_fregs, selfLoop);
 	}
 
 	void Preload(u32 reg, Xbyak::Operand::Code nreg) override;
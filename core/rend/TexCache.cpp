@@ -5,14 +5,17 @@
 #include "hw/mem/addrspace.h"
 
 #include <algorithm>
+#include <condition_variable>
+#include <deque>
 #include <mutex>
+#include <thread>
 #include <xxhash.h>
 
 #ifdef _OPENMP
 #include <omp.h>
 #endif
 
-const u8 *vq_codebook;
+thread_local const u8 *vq_codebook;
 u32 palette_index;
 bool KillTex=false;
 u32 palette16_ram[1024];
@@ -20,6 +23,7 @@ u32 palette32_ram[1024];
 u32 pal_hash_256[4];
 u32 pal_hash_16[64];
 bool palette_updated;
+TextureCacheStats texCacheStats;
 extern bool pal_needs_update;
 
 // Rough approximation of LoD bias from D adjust param, only used to increase LoD
@@ -298,6 +302,65 @@ void UpscalexBRZ(int factor, u32* source, u32* dest, int width, int height, bool
 #endif
 }
 
+// Worker threads decoding and upscaling textures in the background
+class TextureConverterPool
+{
+public:
+	~TextureConverterPool()
+	{
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			stopping = true;
+		}
+		cond.notify_all();
+		for (std::thread& thread : threads)
+			thread.join();
+	}
+
+	void submit(const std::shared_ptr<TextureConversion>& conv)
+	{
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			if (threads.empty())
+			{
+				int count = std::clamp((int)config::MaxThreads, 1, 8);
+				for (int i = 0; i < count; i++)
+					threads.emplace_back(&TextureConverterPool::run, this);
+			}
+			queue.push_back(conv);
+		}
+		cond.notify_one();
+	}
+
+private:
+	void run()
+	{
+		std::unique_lock<std::mutex> lock(mutex);
+		for (;;)
+		{
+			cond.wait(lock, [this]() { return stopping || !queue.empty(); });
+			if (stopping)
+				break;
+			std::shared_ptr<TextureConversion> conv = std::move(queue.front());
+			queue.pop_front();
+			// Skip conversions that have been superseded or whose texture has been deleted
+			if (conv.use_count() == 1)
+				continue;
+			lock.unlock();
+			conv->convert(conv->vramCopy.data());
+			conv->done = true;
+			lock.lock();
+		}
+	}
+
+	std::vector<std::thread> threads;
+	std::deque<std::shared_ptr<TextureConversion>> queue;
+	std::mutex mutex;
+	std::condition_variable cond;
+	bool stopping = false;
+};
+static TextureConverterPool textureConverters;
+
 struct PvrTexInfo
 {
 	const char* name;
@@ -460,6 +523,13 @@ bool BaseTextureCacheData::Delete()
 
 	free(custom_image_data);
 	custom_image_data = nullptr;
+	asyncConversion.reset();
+	if (gpuSize != 0)
+	{
+		texCacheStats.residentBytes -= gpuSize;
+		texCacheStats.residentTextures--;
+		gpuSize = 0;
+	}
 
 	return true;
 }
@@ -475,6 +545,8 @@ BaseTextureCacheData::BaseTextureCacheData(TSP tsp, TCW tcw)
 	//Reset state info ..
 	Updates = 0;
 	dirty = FrameCount;
+	lastUsed = FrameCount;
+	gpuSize = 0;
 	lock_block = nullptr;
 	custom_image_data = nullptr;
 	custom_load_in_progress = 0;
@@ -578,6 +650,7 @@ bool BaseTextureCacheData::Update()
 	Updates++;
 	dirty = 0;
 	gpuPalette = false;
+	const TextureType previousType = tex_type;
 	tex_type = tex->type;
 
 	bool has_alpha = false;
@@ -596,7 +669,7 @@ bool BaseTextureCacheData::Update()
 		}
 
 		// Get the palette hash to check for future updates
-		// TODO get rid of ::palette_index and ::vq_codebook
+		// TODO get rid of ::palette_index
 		if (tcw.PixelFmt == PixelPal4)
 		{
 			palette_hash = pal_hash_16[tcw.PalSelect];
@@ -609,9 +682,6 @@ bool BaseTextureCacheData::Update()
 		}
 	}
 
-	if (tcw.VQ_Comp)
-		::vq_codebook = &vram[sa_tex];    // might be used if VQ tex
-
 	//texture conversion work
 	u32 stride = width;
 
@@ -645,143 +715,217 @@ bool BaseTextureCacheData::Update()
 	if (config::CustomTextures)
 		custom_texture.LoadCustomTextureAsync(this);
 
-	void *temp_tex_buffer = NULL;
-	u32 upscaled_w = width;
-	u32 upscaled_h = height;
-
-	PixelBuffer<u16> pb16;
-	PixelBuffer<u32> pb32;
-	PixelBuffer<u8> pb8;
-
 	// Figure out if we really need to use a 32-bit pixel buffer
 	bool textureUpscaling = config::TextureUpscale > 1
 			// Don't process textures that are too big
 			&& (int)(width * height) <= config::MaxFilteredTextureSize * config::MaxFilteredTextureSize
 			// Don't process YUV textures
 			&& tcw.PixelFmt != PixelYUV;
-	bool need_32bit_buffer = true;
-	if (!textureUpscaling
-		&& (!IsPaletted() || tex_type != TextureType::_8888)
-		&& texconv != NULL
-		&& !Force32BitTexture(tex_type))
-		need_32bit_buffer = false;
 	// TODO avoid upscaling/depost. textures that change too often
+	std::shared_ptr<TextureConversion> conv = newConversion(stride, has_alpha, textureUpscaling ? (int)config::TextureUpscale : 1);
+
+	// Palette textures depend on the current palette so they are always converted immediately
+	const bool async = !config::StrictTextureUpdates && !IsPaletted() && !config::DumpTextures;
+	// Convert immediately if the texture changes faster than the workers can keep up
+	const bool busy = asyncConversion != nullptr && !asyncConversion->done;
+	asyncConversion.reset();
+	if (async && !busy && (Updates > 1 || textureUpscaling))
+	{
+		if (Updates == 1)
+		{
+			// Use the texture without upscaling until the upscaled version is ready
+			std::shared_ptr<TextureConversion> placeholder = newConversion(stride, has_alpha, 1);
+			placeholder->convert(&vram[sa_tex]);
+			tex_type = placeholder->texType;
+			upload(placeholder->outWidth, placeholder->outHeight, placeholder->data, placeholder->mipmapped);
+		}
+		else
+		{
+			// Keep using the previous version of the texture until the new one is ready
+			tex_type = previousType;
+		}
+		// The size of VQ textures doesn't include all their data
+		const u32 dataSize = tcw.VQ_Comp ? 256 * 8 + width * height / 4 : size;
+		conv->vramCopy.assign(&vram[sa_tex], &vram[std::min(sa + dataSize, VRAM_SIZE)]);
+		asyncConversion = conv;
+		textureConverters.submit(conv);
+		height = original_h;
+		protectVRam();
+		PrintTextureName();
+
+		return true;
+	}
 
-	bool mipmapped = IsMipmapped() && !config::DumpTextures;
+	conv->convert(&vram[sa_tex]);
+	tex_type = conv->texType;
+	// Restore the original texture height if it was constrained to VRAM limits above
+	height = original_h;
 
-	if (texconv32 != NULL && need_32bit_buffer)
+	//lock the texture to detect changes in it
+	protectVRam();
+
+	upload(conv->outWidth, conv->outHeight, conv->data, conv->mipmapped);
+	if (config::DumpTextures)
+	{
+		ComputeHash();
+		custom_texture.DumpTexture(texture_hash, conv->outWidth, conv->outHeight, tex_type, (void *)conv->data);
+		NOTICE_LOG(RENDERER, "Dumped texture %x.png. Old hash %x", texture_hash, old_texture_hash);
+	}
+	PrintTextureName();
+
+	return true;
+}
+
+std::shared_ptr<TextureConversion> BaseTextureCacheData::newConversion(u32 stride, bool hasAlpha, int upscale)
+{
+	std::shared_ptr<TextureConversion> conv = std::make_shared<TextureConversion>();
+	conv->tex = tex;
+	conv->texconv = texconv;
+	conv->texconv32 = texconv32;
+	conv->texconv8 = texconv8;
+	conv->tcw = tcw;
+	conv->texU = tsp.TexU;
+	conv->dataOffset = sa - sa_tex;
+	conv->width = width;
+	conv->height = height;
+	conv->stride = stride;
+	conv->upscale = upscale;
+	conv->hasAlpha = hasAlpha;
+	conv->need32bit = upscale > 1
+		|| (IsPaletted() && tex_type == TextureType::_8888)
+		|| texconv == nullptr
+		|| Force32BitTexture(tex_type);
+	conv->mipmapped = IsMipmapped() && !config::DumpTextures;
+	conv->texType = tex_type;
+
+	return conv;
+}
+
+void TextureConversion::convert(const u8 *texData)
+{
+	if (tcw.VQ_Comp)
+		::vq_codebook = texData;    // might be used if VQ tex
+	const u8 *data = texData + dataOffset;
+	outWidth = width;
+	outHeight = height;
+
+	if (texconv32 != NULL && need32bit)
 	{
-		if (textureUpscaling)
+		if (upscale > 1)
 			// don't use mipmaps if upscaling
 			mipmapped = false;
 		// Force the texture type since that's the only 32-bit one we know
-		tex_type = TextureType::_8888;
+		texType = TextureType::_8888;
 
 		if (mipmapped)
 		{
 			pb32.init(width, height, true);
-			for (u32 i = 0; i <= tsp.TexU + 3u; i++)
+			for (u32 i = 0; i <= texU + 3u; i++)
 			{
 				pb32.set_mipmap(i);
-				u32 vram_addr;
+				u32 offset;
 				if (tcw.VQ_Comp)
 				{
-					vram_addr = sa_tex + VQMipPoint[i];
+					offset = VQMipPoint[i];
 					if (i == 0)
 					{
 						PixelBuffer<u32> pb0;
 						pb0.init(2, 2 ,false);
-						texconv32(&pb0, (u8*)&vram[vram_addr], 2, 2);
+						texconv32(&pb0, &texData[offset], 2, 2);
 						*pb32.data() = *pb0.data(1, 1);
 						continue;
 					}
 				}
 				else
-					vram_addr = sa_tex + OtherMipPoint[i] * tex->bpp / 8;
+					offset = OtherMipPoint[i] * tex->bpp / 8;
 				if (tcw.PixelFmt == PixelYUV && i == 0)
 					// Special case for YUV at 1x1 LoD
-					pvrTexInfo[Pixel565].TW32(&pb32, &vram[vram_addr], 1, 1);
+					pvrTexInfo[Pixel565].TW32(&pb32, &texData[offset], 1, 1);
 				else
-					texconv32(&pb32, &vram[vram_addr], 1 << i, 1 << i);
+					texconv32(&pb32, &texData[offset], 1 << i, 1 << i);
 			}
 			pb32.set_mipmap(0);
 		}
 		else
 		{
 			pb32.init(width, height);
-			texconv32(&pb32, (u8*)&vram[sa], stride, height);
+			texconv32(&pb32, data, stride, height);
 
 			// xBRZ scaling
-			if (textureUpscaling)
+			if (upscale > 1)
 			{
 				PixelBuffer<u32> tmp_buf;
-				tmp_buf.init(width * config::TextureUpscale, height * config::TextureUpscale);
+				tmp_buf.init(width * upscale, height * upscale);
 
 				if (tcw.PixelFmt == Pixel1555 || tcw.PixelFmt == Pixel4444)
 					// Alpha channel formats. Palettes with alpha are already handled
-					has_alpha = true;
-				UpscalexBRZ(config::TextureUpscale, pb32.data(), tmp_buf.data(), width, height, has_alpha);
+					hasAlpha = true;
+				if (vramCopy.empty())
+					UpscalexBRZ(upscale, pb32.data(), tmp_buf.data(), width, height, hasAlpha);
+				else
+					// Worker threads already run in parallel
+					xbrz::scale(upscale, pb32.data(), tmp_buf.data(), width, height,
+							hasAlpha ? xbrz::ColorFormat::ARGB : xbrz::ColorFormat::RGB, xbrz_cfg);
 				pb32.steal_data(tmp_buf);
-				upscaled_w *= config::TextureUpscale;
-				upscaled_h *= config::TextureUpscale;
+				outWidth *= upscale;
+				outHeight *= upscale;
 			}
 		}
-		temp_tex_buffer = pb32.data();
+		this->data = (const u8 *)pb32.data();
 	}
-	else if (texconv8 != NULL && tex_type == TextureType::_8)
+	else if (texconv8 != NULL && texType == TextureType::_8)
 	{
 		if (mipmapped)
 		{
 			// This shouldn't happen since mipmapped palette textures are converted to rgba
 			pb8.init(width, height, true);
-			for (u32 i = 0; i <= tsp.TexU + 3u; i++)
+			for (u32 i = 0; i <= texU + 3u; i++)
 			{
 				pb8.set_mipmap(i);
-				u32 vram_addr = sa_tex + OtherMipPoint[i] * tex->bpp / 8;
-				texconv8(&pb8, &vram[vram_addr], 1 << i, 1 << i);
+				texconv8(&pb8, &texData[OtherMipPoint[i] * tex->bpp / 8], 1 << i, 1 << i);
 			}
 			pb8.set_mipmap(0);
 		}
 		else
 		{
 			pb8.init(width, height);
-			texconv8(&pb8, &vram[sa], stride, height);
+			texconv8(&pb8, data, stride, height);
 		}
-		temp_tex_buffer = pb8.data();
+		this->data = pb8.data();
 	}
 	else if (texconv != NULL)
 	{
 		if (mipmapped)
 		{
 			pb16.init(width, height, true);
-			for (u32 i = 0; i <= tsp.TexU + 3u; i++)
+			for (u32 i = 0; i <= texU + 3u; i++)
 			{
 				pb16.set_mipmap(i);
-				u32 vram_addr;
+				u32 offset;
 				if (tcw.VQ_Comp)
 				{
-					vram_addr = sa_tex + VQMipPoint[i];
+					offset = VQMipPoint[i];
 					if (i == 0)
 					{
 						PixelBuffer<u16> pb0;
 						pb0.init(2, 2 ,false);
-						texconv(&pb0, (u8*)&vram[vram_addr], 2, 2);
+						texconv(&pb0, &texData[offset], 2, 2);
 						*pb16.data() = *pb0.data(1, 1);
 						continue;
 					}
 				}
 				else
-					vram_addr = sa_tex + OtherMipPoint[i] * tex->bpp / 8;
-				texconv(&pb16, (u8*)&vram[vram_addr], 1 << i, 1 << i);
+					offset = OtherMipPoint[i] * tex->bpp / 8;
+				texconv(&pb16, &texData[offset], 1 << i, 1 << i);
 			}
 			pb16.set_mipmap(0);
 		}
 		else
 		{
 			pb16.init(width, height);
-			texconv(&pb16,(u8*)&vram[sa],stride,height);
+			texconv(&pb16, data, stride, height);
 		}
-		temp_tex_buffer = pb16.data();
+		this->data = (const u8 *)pb16.data();
 	}
 	else
 	{
@@ -789,25 +933,35 @@ bool BaseTextureCacheData::Update()
 		WARN_LOG(RENDERER, "UNHANDLED TEXTURE");
 		pb16.init(width, height);
 		memset(pb16.data(), 0x80, width * height * 2);
-		temp_tex_buffer = pb16.data();
+		this->data = (const u8 *)pb16.data();
 		mipmapped = false;
 	}
-	// Restore the original texture height if it was constrained to VRAM limits above
-	height = original_h;
-
-	//lock the texture to detect changes in it
-	protectVRam();
+}
 
-	UploadToGPU(upscaled_w, upscaled_h, (const u8 *)temp_tex_buffer, IsMipmapped(), mipmapped);
-	if (config::DumpTextures)
+void BaseTextureCacheData::CheckAsyncConversion()
+{
+	if (IsAsyncConversionReady())
 	{
-		ComputeHash();
-		custom_texture.DumpTexture(texture_hash, upscaled_w, upscaled_h, tex_type, temp_tex_buffer);
-		NOTICE_LOG(RENDERER, "Dumped texture %x.png. Old hash %x", texture_hash, old_texture_hash);
+		std::shared_ptr<TextureConversion> conv = std::move(asyncConversion);
+		tex_type = conv->texType;
+		gpuPalette = false;
+		upload(conv->outWidth, conv->outHeight, conv->data, conv->mipmapped);
 	}
-	PrintTextureName();
+}
 
-	return true;
+void BaseTextureCacheData::upload(int width, int height, const u8 *data, bool mipmapsIncluded)
+{
+	const bool mipmapped = IsMipmapped();
+	UploadToGPU(width, height, data, mipmapped, mipmapsIncluded);
+
+	u32 texelSize = tex_type == TextureType::_8888 ? 4 : tex_type == TextureType::_8 ? 1 : 2;
+	u32 newSize = width * height * texelSize;
+	if (mipmapped)
+		newSize += newSize / 3;
+	if (gpuSize == 0)
+		texCacheStats.residentTextures++;
+	texCacheStats.residentBytes = texCacheStats.residentBytes - gpuSize + newSize;
+	gpuSize = newSize;
 }
 
 void BaseTextureCacheData::CheckCustomTexture()
@@ -816,7 +970,7 @@ void BaseTextureCacheData::CheckCustomTexture()
 	{
 		tex_type = TextureType::_8888;
 		gpuPalette = false;
-		UploadToGPU(custom_width, custom_height, custom_image_data, IsMipmapped(), false);
+		upload(custom_width, custom_height, custom_image_data, false);
 		free(custom_image_data);
 		custom_image_data = nullptr;
 	}
@@ -2,16 +2,18 @@
 #include "oslib/oslib.h"
 #include "hw/pvr/Renderer_if.h"
 #include "cfg/option.h"
+#include "TexConv.h"
 
 #include <algorithm>
 #include <array>
 #include <atomic>
+#include <memory>
 #include <string>
 #include <unordered_map>
 #include <vector>
 #include <utility>
 
-extern const u8 *vq_codebook;
+extern thread_local const u8 *vq_codebook;
 extern u32 palette_index;
 extern u32 palette16_ram[1024];
 extern u32 palette32_ram[1024];
@@ -461,14 +463,135 @@ void texture_VQ(PixelBuffer<typename PixelConvertor::unpacked_type>* pb, const u
 	}
 }
 
+// texconv row format of the 16-bit texel unpackers and convertors
+template<typename Unpacker> struct UnpackerRowFormat;
+template<> struct UnpackerRowFormat<UnpackerNop<u16>> { static constexpr texconv::RowFormat value = texconv::RowCopy16; };
+template<> struct UnpackerRowFormat<Unpacker1555> { static constexpr texconv::RowFormat value = texconv::Row1555; };
+template<> struct UnpackerRowFormat<Unpacker4444> { static constexpr texconv::RowFormat value = texconv::Row4444; };
+template<> struct UnpackerRowFormat<Unpacker565_32<RGBAPacker>> { static constexpr texconv::RowFormat value = texconv::Row565_RGBA; };
+template<> struct UnpackerRowFormat<Unpacker1555_32<RGBAPacker>> { static constexpr texconv::RowFormat value = texconv::Row1555_RGBA; };
+template<> struct UnpackerRowFormat<Unpacker4444_32<RGBAPacker>> { static constexpr texconv::RowFormat value = texconv::Row4444_RGBA; };
+template<> struct UnpackerRowFormat<Unpacker565_32<BGRAPacker>> { static constexpr texconv::RowFormat value = texconv::Row565_BGRA; };
+template<> struct UnpackerRowFormat<Unpacker1555_32<BGRAPacker>> { static constexpr texconv::RowFormat value = texconv::Row1555_BGRA; };
+template<> struct UnpackerRowFormat<Unpacker4444_32<BGRAPacker>> { static constexpr texconv::RowFormat value = texconv::Row4444_BGRA; };
+
+template<typename PixelConvertor> struct ConvertorRowFormat;
+template<typename Unpacker> struct ConvertorRowFormat<ConvertPlanar<Unpacker>> : UnpackerRowFormat<Unpacker> {};
+template<typename Unpacker> struct ConvertorRowFormat<ConvertTwiddle<Unpacker>> : UnpackerRowFormat<Unpacker> {};
+template<> struct ConvertorRowFormat<ConvertPlanarYUV<RGBAPacker>> { static constexpr texconv::RowFormat value = texconv::RowYUV_RGBA; };
+template<> struct ConvertorRowFormat<ConvertPlanarYUV<BGRAPacker>> { static constexpr texconv::RowFormat value = texconv::RowYUV_BGRA; };
+template<> struct ConvertorRowFormat<ConvertTwiddleYUV<RGBAPacker>> { static constexpr texconv::RowFormat value = texconv::RowYUV_RGBA; };
+template<> struct ConvertorRowFormat<ConvertTwiddleYUV<BGRAPacker>> { static constexpr texconv::RowFormat value = texconv::RowYUV_BGRA; };
+
+// Vectorized handler functions for 16-bit texel formats.
+// They fall back to the scalar version if texconv is disabled or the texture is too small.
+template<class PixelConvertor>
+void texture_PL_simd(PixelBuffer<typename PixelConvertor::unpacked_type>* pb, const u8* p_in, u32 Width, u32 Height)
+{
+	if (!texconv::enabled())
+	{
+		texture_PL<PixelConvertor>(pb, p_in, Width, Height);
+		return;
+	}
+	const texconv::RowConverter convert = texconv::converters->rows[ConvertorRowFormat<PixelConvertor>::value];
+	const u16 *src = (const u16 *)p_in;
+	Width &= ~3;
+	for (u32 y = 0; y < Height; y++, src += Width)
+		convert(pb->data(0, y), src, Width);
+}
+
+template<class PixelConvertor>
+void texture_TW_simd(PixelBuffer<typename PixelConvertor::unpacked_type>* pb, const u8* p_in, u32 Width, u32 Height)
+{
+	if (!texconv::enabled() || Width < 4 || Height < 4 || Width > 1024)
+	{
+		texture_TW<PixelConvertor>(pb, p_in, Width, Height);
+		return;
+	}
+	constexpr texconv::RowFormat format = ConvertorRowFormat<PixelConvertor>::value;
+	const texconv::Converters& conv = *texconv::converters;
+	const u32 bcx = bitscanrev(Width);
+	const u32 bcy = bitscanrev(Height);
+	const u16 *src = (const u16 *)p_in;
+	// 4 rows are de-twiddled then converted
+	u16 strip[4 * 1024];
+
+	for (u32 y = 0; y < Height; y += 4)
+	{
+		if constexpr (format == texconv::RowCopy16)
+		{
+			u16 *dst = (u16 *)pb->data(0, y);
+			const u32 stride = (u16 *)pb->data(0, y + 1) - dst;
+			for (u32 x = 0; x < Width; x += 4)
+				conv.detwiddleTile(dst + x, stride, &src[twop(x, y, bcx, bcy)]);
+		}
+		else
+		{
+			for (u32 x = 0; x < Width; x += 4)
+				conv.detwiddleTile(&strip[x], Width, &src[twop(x, y, bcx, bcy)]);
+			for (u32 i = 0; i < 4; i++)
+				conv.rows[format](pb->data(0, y + i), &strip[i * Width], Width);
+		}
+	}
+}
+
+template<class PixelConvertor>
+void texture_VQ_simd(PixelBuffer<typename PixelConvertor::unpacked_type>* pb, const u8* p_in, u32 Width, u32 Height)
+{
+	// Converting the whole codebook isn't worth it for small textures
+	if (!texconv::enabled() || Width < 4 || Height < 4 || Width * Height < 1024)
+	{
+		texture_VQ<PixelConvertor>(pb, p_in, Width, Height);
+		return;
+	}
+	using Pixel = typename PixelConvertor::unpacked_type;
+	const texconv::RowConverter convert = texconv::converters->rows[ConvertorRowFormat<PixelConvertor>::value];
+
+	// Each codebook entry is a 2x2 twiddled block, converted as a top and a bottom row of 2 texels
+	const u16 *codebook = (const u16 *)vq_codebook;
+	u16 cbRows[2][512];
+	for (u32 i = 0; i < 256; i++)
+	{
+		cbRows[0][i * 2] = codebook[i * 4];
+		cbRows[0][i * 2 + 1] = codebook[i * 4 + 2];
+		cbRows[1][i * 2] = codebook[i * 4 + 1];
+		cbRows[1][i * 2 + 1] = codebook[i * 4 + 3];
+	}
+	Pixel blocks[2][512];
+	convert(blocks[0], cbRows[0], 512);
+	convert(blocks[1], cbRows[1], 512);
+
+	p_in += 256 * 4 * 2;	// Skip VQ codebook
+	const u32 bcx = bitscanrev(Width);
+	const u32 bcy = bitscanrev(Height);
+
+	for (u32 y = 0; y < Height; y += 4)
+	{
+		Pixel *rows[4] { pb->data(0, y), pb->data(0, y + 1), pb->data(0, y + 2), pb->data(0, y + 3) };
+		for (u32 x = 0; x < Width; x += 4)
+		{
+			// 4 indexes per 4x4 tile, in twiddled order
+			const u8 *index = &p_in[twop(x, y, bcx, bcy) / 4];
+			memcpy(&rows[0][x], &blocks[0][index[0] * 2], sizeof(Pixel) * 2);
+			memcpy(&rows[1][x], &blocks[1][index[0] * 2], sizeof(Pixel) * 2);
+			memcpy(&rows[2][x], &blocks[0][index[1] * 2], sizeof(Pixel) * 2);
+			memcpy(&rows[3][x], &blocks[1][index[1] * 2], sizeof(Pixel) * 2);
+			memcpy(&rows[0][x + 2], &blocks[0][index[2] * 2], sizeof(Pixel) * 2);
+			memcpy(&rows[1][x + 2], &blocks[1][index[2] * 2], sizeof(Pixel) * 2);
+			memcpy(&rows[2][x + 2], &blocks[0][index[3] * 2], sizeof(Pixel) * 2);
+			memcpy(&rows[3][x + 2], &blocks[1][index[3] * 2], sizeof(Pixel) * 2);
+		}
+	}
+}
+
 typedef void (*TexConvFP)(PixelBuffer<u16> *pb, const u8 *p_in, u32 width, u32 height);
 typedef void (*TexConvFP8)(PixelBuffer<u8> *pb, const u8 *p_in, u32 width, u32 height);
 typedef void (*TexConvFP32)(PixelBuffer<u32> *pb, const u8 *p_in, u32 width, u32 height);
 
 //Planar
-constexpr TexConvFP tex565_PL = texture_PL<ConvertPlanar<UnpackerNop<u16>>>;
+constexpr TexConvFP tex565_PL = texture_PL_simd<ConvertPlanar<UnpackerNop<u16>>>;
 //Twiddle
-constexpr TexConvFP tex565_TW = texture_TW<ConvertTwiddle<UnpackerNop<u16>>>;
+constexpr TexConvFP tex565_TW = texture_TW_simd<ConvertTwiddle<UnpackerNop<u16>>>;
 // Palette
 constexpr TexConvFP texPAL4_TW = texture_TW<ConvertTwiddlePal4<UnpackerPalToRgb<u16>>>;
 constexpr TexConvFP texPAL8_TW = texture_TW<ConvertTwiddlePal8<UnpackerPalToRgb<u16>>>;
@@ -477,7 +600,7 @@ constexpr TexConvFP32 texPAL8_TW32 = texture_TW<ConvertTwiddlePal8<UnpackerPalTo
 constexpr TexConvFP8 texPAL4PT_TW = texture_TW<ConvertTwiddlePal4<UnpackerNop<u8>>>;
 constexpr TexConvFP8 texPAL8PT_TW = texture_TW<ConvertTwiddlePal8<UnpackerNop<u8>>>;
 //VQ
-constexpr TexConvFP tex565_VQ = texture_VQ<ConvertTwiddle<UnpackerNop<u16>>>;
+constexpr TexConvFP tex565_VQ = texture_VQ_simd<ConvertTwiddle<UnpackerNop<u16>>>;
 // According to the documentation, a texture cannot be compressed and use
 // a palette at the same time. However the hardware displays them
 // just fine.
@@ -490,68 +613,68 @@ namespace opengl {
 // OpenGL
 
 //Planar
-constexpr TexConvFP tex1555_PL = texture_PL<ConvertPlanar<Unpacker1555>>;
-constexpr TexConvFP tex4444_PL = texture_PL<ConvertPlanar<Unpacker4444>>;
+constexpr TexConvFP tex1555_PL = texture_PL_simd<ConvertPlanar<Unpacker1555>>;
+constexpr TexConvFP tex4444_PL = texture_PL_simd<ConvertPlanar<Unpacker4444>>;
 constexpr TexConvFP texBMP_PL = tex4444_PL;
-constexpr TexConvFP32 texYUV422_PL = texture_PL<ConvertPlanarYUV<RGBAPacker>>;
+constexpr TexConvFP32 texYUV422_PL = texture_PL_simd<ConvertPlanarYUV<RGBAPacker>>;
 
-constexpr TexConvFP32 tex565_PL32 = texture_PL<ConvertPlanar<Unpacker565_32<RGBAPacker>>>;
-constexpr TexConvFP32 tex1555_PL32 = texture_PL<ConvertPlanar<Unpacker1555_32<RGBAPacker>>>;
-constexpr TexConvFP32 tex4444_PL32 = texture_PL<ConvertPlanar<Unpacker4444_32<RGBAPacker>>>;
+constexpr TexConvFP32 tex565_PL32 = texture_PL_simd<ConvertPlanar<Unpacker565_32<RGBAPacker>>>;
+constexpr TexConvFP32 tex1555_PL32 = texture_PL_simd<ConvertPlanar<Unpacker1555_32<RGBAPacker>>>;
+constexpr TexConvFP32 tex4444_PL32 = texture_PL_simd<ConvertPlanar<Unpacker4444_32<RGBAPacker>>>;
 
 //Twiddle
-constexpr TexConvFP tex1555_TW = texture_TW<ConvertTwiddle<Unpacker1555>>;
-constexpr TexConvFP tex4444_TW = texture_TW<ConvertTwiddle<Unpacker4444>>;
+constexpr TexConvFP tex1555_TW = texture_TW_simd<ConvertTwiddle<Unpacker1555>>;
+constexpr TexConvFP tex4444_TW = texture_TW_simd<ConvertTwiddle<Unpacker4444>>;
 constexpr TexConvFP texBMP_TW = tex4444_TW;
-constexpr TexConvFP32 texYUV422_TW = texture_TW<ConvertTwiddleYUV<RGBAPacker>>;
+constexpr TexConvFP32 texYUV422_TW = texture_TW_simd<ConvertTwiddleYUV<RGBAPacker>>;
 
-constexpr TexConvFP32 tex565_TW32 = texture_TW<ConvertTwiddle<Unpacker565_32<RGBAPacker>>>;
-constexpr TexConvFP32 tex1555_TW32 = texture_TW<ConvertTwiddle<Unpacker1555_32<RGBAPacker>>>;
-constexpr TexConvFP32 tex4444_TW32 = texture_TW<ConvertTwiddle<Unpacker4444_32<RGBAPacker>>>;
+constexpr TexConvFP32 tex565_TW32 = texture_TW_simd<ConvertTwiddle<Unpacker565_32<RGBAPacker>>>;
+constexpr TexConvFP32 tex1555_TW32 = texture_TW_simd<ConvertTwiddle<Unpacker1555_32<RGBAPacker>>>;
+constexpr TexConvFP32 tex4444_TW32 = texture_TW_simd<ConvertTwiddle<Unpacker4444_32<RGBAPacker>>>;
 
 //VQ
-constexpr TexConvFP tex1555_VQ = texture_VQ<ConvertTwiddle<Unpacker1555>>;
-constexpr TexConvFP tex4444_VQ = texture_VQ<ConvertTwiddle<Unpacker4444>>;
+constexpr TexConvFP tex1555_VQ = texture_VQ_simd<ConvertTwiddle<Unpacker1555>>;
+constexpr TexConvFP tex4444_VQ = texture_VQ_simd<ConvertTwiddle<Unpacker4444>>;
 constexpr TexConvFP texBMP_VQ = tex4444_VQ;
-constexpr TexConvFP32 texYUV422_VQ = texture_VQ<ConvertTwiddleYUV<RGBAPacker>>;
+constexpr TexConvFP32 texYUV422_VQ = texture_VQ_simd<ConvertTwiddleYUV<RGBAPacker>>;
 
-constexpr TexConvFP32 tex565_VQ32 = texture_VQ<ConvertTwiddle<Unpacker565_32<RGBAPacker>>>;
-constexpr TexConvFP32 tex1555_VQ32 = texture_VQ<ConvertTwiddle<Unpacker1555_32<RGBAPacker>>>;
-constexpr TexConvFP32 tex4444_VQ32 = texture_VQ<ConvertTwiddle<Unpacker4444_32<RGBAPacker>>>;
+constexpr TexConvFP32 tex565_VQ32 = texture_VQ_simd<ConvertTwiddle<Unpacker565_32<RGBAPacker>>>;
+constexpr TexConvFP32 tex1555_VQ32 = texture_VQ_simd<ConvertTwiddle<Unpacker1555_32<RGBAPacker>>>;
+constexpr TexConvFP32 tex4444_VQ32 = texture_VQ_simd<ConvertTwiddle<Unpacker4444_32<RGBAPacker>>>;
 }
 
 namespace directx {
 // DirectX
 
 //Planar
-constexpr TexConvFP tex1555_PL = texture_PL<ConvertPlanar<UnpackerNop<u16>>>;
-constexpr TexConvFP tex4444_PL = texture_PL<ConvertPlanar<UnpackerNop<u16>>>;
+constexpr TexConvFP tex1555_PL = texture_PL_simd<ConvertPlanar<UnpackerNop<u16>>>;
+constexpr TexConvFP tex4444_PL = texture_PL_simd<ConvertPlanar<UnpackerNop<u16>>>;
 constexpr TexConvFP texBMP_PL = tex4444_PL;
-constexpr TexConvFP32 texYUV422_PL = texture_PL<ConvertPlanarYUV<BGRAPacker>>;
+constexpr TexConvFP32 texYUV422_PL = texture_PL_simd<ConvertPlanarYUV<BGRAPacker>>;
 
-constexpr TexConvFP32 tex565_PL32 = texture_PL<ConvertPlanar<Unpacker565_32<BGRAPacker>>>;
-constexpr TexConvFP32 tex1555_PL32 = texture_PL<ConvertPlanar<Unpacker1555_32<BGRAPacker>>>;
-constexpr TexConvFP32 tex4444_PL32 = texture_PL<ConvertPlanar<Unpacker4444_32<BGRAPacker>>>;
+constexpr TexConvFP32 tex565_PL32 = texture_PL_simd<ConvertPlanar<Unpacker565_32<BGRAPacker>>>;
+constexpr TexConvFP32 tex1555_PL32 = texture_PL_simd<ConvertPlanar<Unpacker1555_32<BGRAPacker>>>;
+constexpr TexConvFP32 tex4444_PL32 = texture_PL_simd<ConvertPlanar<Unpacker4444_32<BGRAPacker>>>;
 
 //Twiddle
-constexpr TexConvFP tex1555_TW = texture_TW<ConvertTwiddle<UnpackerNop<u16>>>;
-constexpr TexConvFP tex4444_TW = texture_TW<ConvertTwiddle<UnpackerNop<u16>>>;
+constexpr TexConvFP tex1555_TW = texture_TW_simd<ConvertTwiddle<UnpackerNop<u16>>>;
+constexpr TexConvFP tex4444_TW = texture_TW_simd<ConvertTwiddle<UnpackerNop<u16>>>;
 constexpr TexConvFP texBMP_TW = tex4444_TW;
-constexpr TexConvFP32 texYUV422_TW = texture_TW<ConvertTwiddleYUV<BGRAPacker>>;
+constexpr TexConvFP32 texYUV422_TW = texture_TW_simd<ConvertTwiddleYUV<BGRAPacker>>;
 
-constexpr TexConvFP32 tex565_TW32 = texture_TW<ConvertTwiddle<Unpacker565_32<BGRAPacker>>>;
-constexpr TexConvFP32 tex1555_TW32 = texture_TW<ConvertTwiddle<Unpacker1555_32<BGRAPacker>>>;
-constexpr TexConvFP32 tex4444_TW32 = texture_TW<ConvertTwiddle<Unpacker4444_32<BGRAPacker>>>;
+constexpr TexConvFP32 tex565_TW32 = texture_TW_simd<ConvertTwiddle<Unpacker565_32<BGRAPacker>>>;
+constexpr TexConvFP32 tex1555_TW32 = texture_TW_simd<ConvertTwiddle<Unpacker1555_32<BGRAPacker>>>;
+constexpr TexConvFP32 tex4444_TW32 = texture_TW_simd<ConvertTwiddle<Unpacker4444_32<BGRAPacker>>>;
 
 //VQ
-constexpr TexConvFP tex1555_VQ = texture_VQ<ConvertTwiddle<UnpackerNop<u16>>>;
-constexpr TexConvFP tex4444_VQ = texture_VQ<ConvertTwiddle<UnpackerNop<u16>>>;
+constexpr TexConvFP tex1555_VQ = texture_VQ_simd<ConvertTwiddle<UnpackerNop<u16>>>;
+constexpr TexConvFP tex4444_VQ = texture_VQ_simd<ConvertTwiddle<UnpackerNop<u16>>>;
 constexpr TexConvFP texBMP_VQ = tex4444_VQ;
-constexpr TexConvFP32 texYUV422_VQ = texture_VQ<ConvertTwiddleYUV<BGRAPacker>>;
+constexpr TexConvFP32 texYUV422_VQ = texture_VQ_simd<ConvertTwiddleYUV<BGRAPacker>>;
 
-constexpr TexConvFP32 tex565_VQ32 = texture_VQ<ConvertTwiddle<Unpacker565_32<BGRAPacker>>>;
-constexpr TexConvFP32 tex1555_VQ32 = texture_VQ<ConvertTwiddle<Unpacker1555_32<BGRAPacker>>>;
-constexpr TexConvFP32 tex4444_VQ32 = texture_VQ<ConvertTwiddle<Unpacker4444_32<BGRAPacker>>>;
+constexpr TexConvFP32 tex565_VQ32 = texture_VQ_simd<ConvertTwiddle<Unpacker565_32<BGRAPacker>>>;
+constexpr TexConvFP32 tex1555_VQ32 = texture_VQ_simd<ConvertTwiddle<Unpacker1555_32<BGRAPacker>>>;
+constexpr TexConvFP32 tex4444_VQ32 = texture_VQ_simd<ConvertTwiddle<Unpacker4444_32<BGRAPacker>>>;
 }
 
 class BaseTextureCacheData;
@@ -572,6 +695,48 @@ void UpscalexBRZ(int factor, u32* source, u32* dest, int width, int height, bool
 struct PvrTexInfo;
 enum class TextureType { _565, _5551, _4444, _8888, _8 };
 
+struct TextureCacheStats
+{
+	u64 hits;				// lookups of a cached texture
+	u64 misses;				// lookups creating a new texture
+	u64 evictions;			// textures deleted to fit in the memory budget
+	u64 residentBytes;		// estimated gpu memory used by uploaded textures
+	u32 residentTextures;
+};
+extern TextureCacheStats texCacheStats;
+
+// Decodes and optionally upscales the vram data of a texture.
+// Doesn't reference the texture cache entry so that it can run on a worker thread.
+struct TextureConversion
+{
+	const PvrTexInfo* tex;
+	TexConvFP texconv;
+	TexConvFP32 texconv32;
+	TexConvFP8 texconv8;
+	TCW tcw;
+	u32 texU;
+	u32 dataOffset;			// offset of the max level mipmap data from the texture start
+	u32 width, height;
+	u32 stride;
+	int upscale;			// xBRZ scaling factor, 1 if disabled
+	bool hasAlpha;
+	bool need32bit;
+	bool mipmapped;
+	std::vector<u8> vramCopy;	// texture data copied from vram for asynchronous conversions
+
+	// Result
+	TextureType texType;
+	u32 outWidth, outHeight;
+	const u8 *data = nullptr;
+	PixelBuffer<u16> pb16;
+	PixelBuffer<u32> pb32;
+	PixelBuffer<u8> pb8;
+	std::atomic_bool done { false };
+
+	// texData points to the texture start address in vram or to vramCopy
+	void convert(const u8 *texData);
+};
+
 class BaseTextureCacheData
 {
 protected:
@@ -603,6 +768,10 @@ public:
 		custom_height = other.custom_height;
 		custom_load_in_progress = 0;
 		gpuPalette = other.gpuPalette;
+		std::swap(asyncConversion, other.asyncConversion);
+		lastUsed = other.lastUsed;
+		gpuSize = other.gpuSize;
+		other.gpuSize = 0;
 	}
 
 	TSP tsp;        	//dreamcast texture parameters
@@ -613,6 +782,8 @@ public:
 	u32 sa_tex;			// texture data start address in vram
 
 	u32 dirty;			// frame number at which texture was overwritten
+	u32 lastUsed;		// frame number at which texture was last looked up
+	u32 gpuSize;		// size in bytes of the uploaded texture
 	vram_block* lock_block;
 
 	u32 sa;         	// pixel data start address of max level mipmap
@@ -635,6 +806,7 @@ public:
 	u32 custom_height;
 	std::atomic_int custom_load_in_progress;
 	bool gpuPalette;
+	std::shared_ptr<TextureConversion> asyncConversion;	// pending background conversion
 
 	void PrintTextureName();
 	virtual std::string GetId() = 0;
@@ -669,11 +841,17 @@ public:
 		return custom_load_in_progress == 0 && custom_image_data != NULL;
 	}
 
+	bool IsAsyncConversionReady()
+	{
+		return asyncConversion != nullptr && asyncConversion->done;
+	}
+
 	void ComputeHash();
 	bool Update();
 	virtual void UploadToGPU(int width, int height, const u8 *temp_tex_buffer, bool mipmapped, bool mipmapsIncluded = false) = 0;
 	virtual bool Force32BitTexture(TextureType type) const { return false; }
 	void CheckCustomTexture();
+	void CheckAsyncConversion();
 	//true if : dirty or paletted texture and hashes don't match
 	bool NeedsUpdate();
 	virtual bool Delete();
@@ -695,6 +873,10 @@ public:
 				&& !tcw.VQ_Comp;
 	}
 	static void SetDirectXColorOrder(bool enabled);
+
+private:
+	std::shared_ptr<TextureConversion> newConversion(u32 stride, bool hasAlpha, int upscale);
+	void upload(int width, int height, const u8 *data, bool mipmapsIncluded);
 };
 
 // TODO Split the texture cache in a separate header
@@ -704,6 +886,8 @@ template<typename Texture>
 class BaseTextureCache
 {
 public:
+	virtual ~BaseTextureCache() = default;
+
 	Texture *getTextureCacheData(TSP tsp, TCW tcw)
 	{
 		u64 key = tsp.full & TSPTextureCacheMask.full;
@@ -730,11 +914,14 @@ public:
 			texture = &it->second;
 			// Needed if the texture is updated
 			texture->tcw.StrideSel = tcw.StrideSel;
+			texCacheStats.hits++;
 		}
 		else //create if not existing
 		{
 			texture = &cache.emplace(std::make_pair(key, Texture(tsp, tcw))).first->second;
+			texCacheStats.misses++;
 		}
+		texture->lastUsed = FrameCount;
 
 		return texture;
 	}
@@ -779,9 +966,24 @@ public:
 		}
 
 		for (u64 id : list)
+			deleteTexture(id);
+
+		// Evict the least recently used textures until the cache fits in its memory budget
+		const u64 budget = (u64)config::TextureCacheBudget * 1024 * 1024;
+		if (budget == 0 || texCacheStats.residentBytes <= budget)
+			return;
+		std::vector<std::pair<u32, u64>> lru;
+		for (const auto& [id, texture] : cache)
+			// Don't evict textures used by the frames being rendered
+			if (FrameCount - texture.lastUsed > MinIdleFrames)
+				lru.emplace_back(texture.lastUsed, id);
+		std::sort(lru.begin(), lru.end());
+		for (const auto& [frame, id] : lru)
 		{
-			if (cache.find(id)->second.Delete())
-				cache.erase(id);
+			if (texCacheStats.residentBytes <= budget)
+				break;
+			if (deleteTexture(id))
+				texCacheStats.evictions++;
 		}
 	}
 
@@ -797,6 +999,10 @@ public:
 	}
 
 protected:
+	virtual bool clearTexture(Texture *texture) {
+		return texture->Delete();
+	}
+
 	std::unordered_map<u64, Texture> cache;
 	// Only use TexU and TexV from TSP in the cache key
 	//     TexV : 7, TexU : 7
@@ -805,6 +1011,18 @@ protected:
 	const TCW TCWTextureCacheMask = { { 0x1FFFFF, 0, 0, 1, 7, 1, 1 } };
 	//     TexAddr : 0x1FFFFF, PalSelect : 0, PixelFmt : 7, VQ_Comp : 1, MipMapped : 1
 	const TCW TCWPalTextureCacheMask = { { 0x1FFFFF, 0, 0, 0, 7, 1, 1 } };
+
+private:
+	bool deleteTexture(u64 id)
+	{
+		auto it = cache.find(id);
+		if (!clearTexture(&it->second))
+			return false;
+		cache.erase(it);
+		return true;
+	}
+
+	static constexpr u32 MinIdleFrames = 10;
 };
 
 template<typename Packer = RGBAPacker>
@@ -0,0 +1,590 @@
+/*
+	Copyright 2026 flyinghead
+
+	This file is part of Flycast.
+
+    Flycast is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 2 of the License, or
+    (at your option) any later version.
+
+    Flycast is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Flycast.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#include "TexConv.h"
+#include "TexCache.h"
+
+#include <cstring>
+#include <type_traits>
+
+#if (HOST_CPU == CPU_X86 || HOST_CPU == CPU_X64) && (defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2))
+#define TEXCONV_SSE2
+#include <emmintrin.h>
+#if defined(__GNUC__) && !defined(__ANDROID__)
+#define TEXCONV_AVX2
+#include <immintrin.h>
+#endif
+#elif HOST_CPU == CPU_ARM64 || (HOST_CPU == CPU_ARM && defined(__ARM_NEON__))
+#define TEXCONV_NEON
+#include <arm_neon.h>
+#endif
+
+namespace texconv
+{
+
+//
+// Scalar implementation, used for the end of rows
+//
+template<typename Unpacker>
+static void convertRow(void *dst, const u16 *src, u32 count)
+{
+	auto *d = (typename Unpacker::unpacked_type *)dst;
+	for (u32 i = 0; i < count; i++)
+		d[i] = Unpacker::unpack(src[i]);
+}
+
+static void copyRow(void *dst, const u16 *src, u32 count)
+{
+	memcpy(dst, src, count * sizeof(u16));
+}
+
+// Each 32-bit word holds 2 texels: U, Y0, V, Y1
+template<typename Packer>
+static void convertRowYUV(void *dst, const u16 *src, u32 count)
+{
+	u32 *d = (u32 *)dst;
+	for (u32 i = 0; i < count; i += 2)
+	{
+		s32 Yu = src[i] & 0xff;
+		s32 Y0 = src[i] >> 8;
+		s32 Yv = src[i + 1] & 0xff;
+		s32 Y1 = src[i + 1] >> 8;
+		d[i] = YUV422<Packer>(Y0, Yu, Yv);
+		d[i + 1] = YUV422<Packer>(Y1, Yu, Yv);
+	}
+}
+
+// Twiddled texels are stored in Morton order, y being the least significant bit
+static void detwiddleTile(u16 *dst, u32 dstStride, const u16 *src)
+{
+	for (u32 y = 0; y < 4; y++, dst += dstStride)
+	{
+		const u16 *row = src + (y & 1) + (y >> 1) * 4;
+		dst[0] = row[0];
+		dst[1] = row[2];
+		dst[2] = row[8];
+		dst[3] = row[10];
+	}
+}
+
+static const Converters scalarConverters {
+	Isa::Scalar,
+	{
+		copyRow,
+		convertRow<Unpacker1555>,
+		convertRow<Unpacker4444>,
+		convertRow<Unpacker565_32<RGBAPacker>>,
+		convertRow<Unpacker1555_32<RGBAPacker>>,
+		convertRow<Unpacker4444_32<RGBAPacker>>,
+		convertRowYUV<RGBAPacker>,
+		convertRow<Unpacker565_32<BGRAPacker>>,
+		convertRow<Unpacker1555_32<BGRAPacker>>,
+		convertRow<Unpacker4444_32<BGRAPacker>>,
+		convertRowYUV<BGRAPacker>,
+	},
+	detwiddleTile
+};
+
+#ifdef TEXCONV_SSE2
+//
+// SSE2: 8 texels per iteration
+//
+static inline __m128i expand4(__m128i v) {
+	return _mm_or_si128(_mm_slli_epi16(v, 4), v);
+}
+static inline __m128i expand5(__m128i v) {
+	return _mm_or_si128(_mm_slli_epi16(v, 3), _mm_srli_epi16(v, 2));
+}
+static inline __m128i expand6(__m128i v) {
+	return _mm_or_si128(_mm_slli_epi16(v, 2), _mm_srli_epi16(v, 4));
+}
+
+// 8-bit components in 16-bit lanes
+template<typename Packer>
+static inline void storeRGBA(u32 *dst, __m128i r, __m128i g, __m128i b, __m128i a)
+{
+	if (std::is_same<Packer, BGRAPacker>::value)
+		std::swap(r, b);
+	__m128i rg = _mm_or_si128(r, _mm_slli_epi16(g, 8));
+	__m128i ba = _mm_or_si128(b, _mm_slli_epi16(a, 8));
+	_mm_storeu_si128((__m128i *)dst, _mm_unpacklo_epi16(rg, ba));
+	_mm_storeu_si128((__m128i *)(dst + 4), _mm_unpackhi_epi16(rg, ba));
+}
+
+template<typename Packer>
+static void convertRow565_sse2(void *dst, const u16 *src, u32 count)
+{
+	u32 *d = (u32 *)dst;
+	u32 i = 0;
+	for (; i + 8 <= count; i += 8)
+	{
+		__m128i w = _mm_loadu_si128((const __m128i *)(src + i));
+		__m128i r = expand5(_mm_srli_epi16(w, 11));
+		__m128i g = expand6(_mm_and_si128(_mm_srli_epi16(w, 5), _mm_set1_epi16(0x3f)));
+		__m128i b = expand5(_mm_and_si128(w, _mm_set1_epi16(0x1f)));
+		storeRGBA<Packer>(d + i, r, g, b, _mm_set1_epi16(0xff));
+	}
+	convertRow<Unpacker565_32<Packer>>(d + i, src + i, count - i);
+}
+
+template<typename Packer>
+static void convertRow1555_sse2(void *dst, const u16 *src, u32 count)
+{
+	u32 *d = (u32 *)dst;
+	u32 i = 0;
+	const __m128i mask = _mm_set1_epi16(0x1f);
+	for (; i + 8 <= count; i += 8)
+	{
+		__m128i w = _mm_loadu_si128((const __m128i *)(src + i));
+		__m128i r = expand5(_mm_and_si128(_mm_srli_epi16(w, 10), mask));
+		__m128i g = expand5(_mm_and_si128(_mm_srli_epi16(w, 5), mask));
+		__m128i b = expand5(_mm_and_si128(w, mask));
+		__m128i a = _mm_and_si128(_mm_srai_epi16(w, 15), _mm_set1_epi16(0xff));
+		storeRGBA<Packer>(d + i, r, g, b, a);
+	}
+	convertRow<Unpacker1555_32<Packer>>(d + i, src + i, count - i);
+}
+
+template<typename Packer>
+static void convertRow4444_sse2(void *dst, const u16 *src, u32 count)
+{
+	u32 *d = (u32 *)dst;
+	u32 i = 0;
+	const __m128i mask = _mm_set1_epi16(0xf);
+	for (; i + 8 <= count; i += 8)
+	{
+		__m128i w = _mm_loadu_si128((const __m128i *)(src + i));
+		__m128i r = expand4(_mm_and_si128(_mm_srli_epi16(w, 8), mask));
+		__m128i g = expand4(_mm_and_si128(_mm_srli_epi16(w, 4), mask));
+		__m128i b = expand4(_mm_and_si128(w, mask));
+		__m128i a = expand4(_mm_srli_epi16(w, 12));
+		storeRGBA<Packer>(d + i, r, g, b, a);
+	}
+	convertRow<Unpacker4444_32<Packer>>(d + i, src + i, count - i);
+}
+
+// ARGB1555 to RGBA5551 and ARGB4444 to RGBA4444 are 16-bit rotations
+template<int Shift, typename Unpacker>
+static void rotateRow_sse2(void *dst, const u16 *src, u32 count)
+{
+	u16 *d = (u16 *)dst;
+	u32 i = 0;
+	for (; i + 8 <= count; i += 8)
+	{
+		__m128i w = _mm_loadu_si128((const __m128i *)(src + i));
+		w = _mm_or_si128(_mm_slli_epi16(w, Shift), _mm_srli_epi16(w, 16 - Shift));
+		_mm_storeu_si128((__m128i *)(d + i), w);
+	}
+	convertRow<Unpacker>(d + i, src + i, count - i);
+}
+
+// Signed division by 2^Shift, rounding toward zero like the scalar code
+template<int Shift>
+static inline __m128i sdiv(__m128i v)
+{
+	__m128i bias = _mm_and_si128(_mm_srai_epi16(v, 15), _mm_set1_epi16((1 << Shift) - 1));
+	return _mm_srai_epi16(_mm_add_epi16(v, bias), Shift);
+}
+
+static inline __m128i clamp255(__m128i v) {
+	return _mm_max_epi16(_mm_min_epi16(v, _mm_set1_epi16(255)), _mm_setzero_si128());
+}
+
+template<typename Packer>
+static void convertRowYUV_sse2(void *dst, const u16 *src, u32 count)
+{
+	u32 *d = (u32 *)dst;
+	u32 i = 0;
+	const __m128i lo16 = _mm_set1_epi32(0xffff);
+	const __m128i c128 = _mm_set1_epi16(128);
+	for (; i + 8 <= count; i += 8)
+	{
+		__m128i w = _mm_loadu_si128((const __m128i *)(src + i));
+		__m128i y = _mm_srli_epi16(w, 8);
+		// U in even lanes, V in odd lanes
+		__m128i uv = _mm_and_si128(w, _mm_set1_epi16(0xff));
+		__m128i u = _mm_or_si128(_mm_and_si128(uv, lo16), _mm_slli_epi32(uv, 16));
+		__m128i v = _mm_or_si128(_mm_srli_epi32(uv, 16), _mm_andnot_si128(lo16, uv));
+		u = _mm_sub_epi16(u, c128);
+		v = _mm_sub_epi16(v, c128);
+
+		__m128i r = _mm_add_epi16(y, sdiv<3>(_mm_mullo_epi16(v, _mm_set1_epi16(11))));
+		__m128i g = _mm_sub_epi16(y, sdiv<5>(_mm_add_epi16(_mm_mullo_epi16(u, _mm_set1_epi16(11)),
+				_mm_mullo_epi16(v, _mm_set1_epi16(22)))));
+		__m128i b = _mm_add_epi16(y, sdiv<6>(_mm_mullo_epi16(u, _mm_set1_epi16(110))));
+		storeRGBA<Packer>(d + i, clamp255(r), clamp255(g), clamp255(b), _mm_set1_epi16(0xff));
+	}
+	convertRowYUV<Packer>(d + i, src + i, count - i);
+}
+
+static void detwiddleTile_sse2(u16 *dst, u32 dstStride, const u16 *src)
+{
+	__m128i a = _mm_loadu_si128((const __m128i *)src);
+	__m128i b = _mm_loadu_si128((const __m128i *)(src + 8));
+	// even texels first in each 32-bit pair: 0 2 1 3 4 6 5 7
+	a = _mm_shufflehi_epi16(_mm_shufflelo_epi16(a, _MM_SHUFFLE(3, 1, 2, 0)), _MM_SHUFFLE(3, 1, 2, 0));
+	b = _mm_shufflehi_epi16(_mm_shufflelo_epi16(b, _MM_SHUFFLE(3, 1, 2, 0)), _MM_SHUFFLE(3, 1, 2, 0));
+	__m128i rows01 = _mm_unpacklo_epi32(a, b);
+	__m128i rows23 = _mm_unpackhi_epi32(a, b);
+	_mm_storel_epi64((__m128i *)dst, rows01);
+	_mm_storel_epi64((__m128i *)(dst + dstStride), _mm_unpackhi_epi64(rows01, rows01));
+	_mm_storel_epi64((__m128i *)(dst + dstStride * 2), rows23);
+	_mm_storel_epi64((__m128i *)(dst + dstStride * 3), _mm_unpackhi_epi64(rows23, rows23));
+}
+
+static const Converters sse2Converters {
+	Isa::SSE2,
+	{
+		copyRow,
+		rotateRow_sse2<1, Unpacker1555>,
+		rotateRow_sse2<4, Unpacker4444>,
+		convertRow565_sse2<RGBAPacker>,
+		convertRow1555_sse2<RGBAPacker>,
+		convertRow4444_sse2<RGBAPacker>,
+		convertRowYUV_sse2<RGBAPacker>,
+		convertRow565_sse2<BGRAPacker>,
+		convertRow1555_sse2<BGRAPacker>,
+		convertRow4444_sse2<BGRAPacker>,
+		convertRowYUV_sse2<BGRAPacker>,
+	},
+	detwiddleTile_sse2
+};
+#endif // TEXCONV_SSE2
+
+#ifdef TEXCONV_AVX2
+//
+// AVX2: 16 texels per iteration for the 16 to 32 bpp conversions
+//
+#define AVX2_FUNC __attribute__((target("avx2")))
+
+AVX2_FUNC static inline __m256i expand4_avx2(__m256i v) {
+	return _mm256_or_si256(_mm256_slli_epi16(v, 4), v);
+}
+AVX2_FUNC static inline __m256i expand5_avx2(__m256i v) {
+	return _mm256_or_si256(_mm256_slli_epi16(v, 3), _mm256_srli_epi16(v, 2));
+}
+AVX2_FUNC static inline __m256i expand6_avx2(__m256i v) {
+	return _mm256_or_si256(_mm256_slli_epi16(v, 2), _mm256_srli_epi16(v, 4));
+}
+
+template<typename Packer>
+AVX2_FUNC static inline void storeRGBA_avx2(u32 *dst, __m256i r, __m256i g, __m256i b, __m256i a)
+{
+	if (std::is_same<Packer, BGRAPacker>::value)
+		std::swap(r, b);
+	__m256i rg = _mm256_or_si256(r, _mm256_slli_epi16(g, 8));
+	__m256i ba = _mm256_or_si256(b, _mm256_slli_epi16(a, 8));
+	// unpack works on each 128-bit lane: texels 0-3 and 8-11, then 4-7 and 12-15
+	__m256i lo = _mm256_unpacklo_epi16(rg, ba);
+	__m256i hi = _mm256_unpackhi_epi16(rg, ba);
+	_mm256_storeu_si256((__m256i *)dst, _mm256_permute2x128_si256(lo, hi, 0x20));
+	_mm256_storeu_si256((__m256i *)(dst + 8), _mm256_permute2x128_si256(lo, hi, 0x31));
+}
+
+template<typename Packer>
+AVX2_FUNC static void convertRow565_avx2(void *dst, const u16 *src, u32 count)
+{
+	u32 *d = (u32 *)dst;
+	u32 i = 0;
+	for (; i + 16 <= count; i += 16)
+	{
+		__m256i w = _mm256_loadu_si256((const __m256i *)(src + i));
+		__m256i r = expand5_avx2(_mm256_srli_epi16(w, 11));
+		__m256i g = expand6_avx2(_mm256_and_si256(_mm256_srli_epi16(w, 5), _mm256_set1_epi16(0x3f)));
+		__m256i b = expand5_avx2(_mm256_and_si256(w, _mm256_set1_epi16(0x1f)));
+		storeRGBA_avx2<Packer>(d + i, r, g, b, _mm256_set1_epi16(0xff));
+	}
+	convertRow565_sse2<Packer>(d + i, src + i, count - i);
+}
+
+template<typename Packer>
+AVX2_FUNC static void convertRow1555_avx2(void *dst, const u16 *src, u32 count)
+{
+	u32 *d = (u32 *)dst;
+	u32 i = 0;
+	const __m256i mask = _mm256_set1_epi16(0x1f);
+	for (; i + 16 <= count; i += 16)
+	{
+		__m256i w = _mm256_loadu_si256((const __m256i *)(src + i));
+		__m256i r = expand5_avx2(_mm256_and_si256(_mm256_srli_epi16(w, 10), mask));
+		__m256i g = expand5_avx2(_mm256_and_si256(_mm256_srli_epi16(w, 5), mask));
+		__m256i b = expand5_avx2(_mm256_and_si256(w, mask));
+		__m256i a = _mm256_and_si256(_mm256_srai_epi16(w, 15), _mm256_set1_epi16(0xff));
+		storeRGBA_avx2<Packer>(d + i, r, g, b, a);
+	}
+	convertRow1555_sse2<Packer>(d + i, src + i, count - i);
+}
+
+template<typename Packer>
+AVX2_FUNC static void convertRow4444_avx2(void *dst, const u16 *src, u32 count)
+{
+	u32 *d = (u32 *)dst;
+	u32 i = 0;
+	const __m256i mask = _mm256_set1_epi16(0xf);
+	for (; i + 16 <= count; i += 16)
+	{
+		__m256i w = _mm256_loadu_si256((const __m256i *)(src + i));
+		__m256i r = expand4_avx2(_mm256_and_si256(_mm256_srli_epi16(w, 8), mask));
+		__m256i g = expand4_avx2(_mm256_and_si256(_mm256_srli_epi16(w, 4), mask));
+		__m256i b = expand4_avx2(_mm256_and_si256(w, mask));
+		__m256i a = expand4_avx2(_mm256_srli_epi16(w, 12));
+		storeRGBA_avx2<Packer>(d + i, r, g, b, a);
+	}
+	convertRow4444_sse2<Packer>(d + i, src + i, count - i);
+}
+
+static const Converters avx2Converters {
+	Isa::AVX2,
+	{
+		copyRow,
+		rotateRow_sse2<1, Unpacker1555>,
+		rotateRow_sse2<4, Unpacker4444>,
+		convertRow565_avx2<RGBAPacker>,
+		convertRow1555_avx2<RGBAPacker>,
+		convertRow4444_avx2<RGBAPacker>,
+		convertRowYUV_sse2<RGBAPacker>,
+		convertRow565_avx2<BGRAPacker>,
+		convertRow1555_avx2<BGRAPacker>,
+		convertRow4444_avx2<BGRAPacker>,
+		convertRowYUV_sse2<BGRAPacker>,
+	},
+	detwiddleTile_sse2
+};
+#endif // TEXCONV_AVX2
+
+#ifdef TEXCONV_NEON
+//
+// NEON: 8 texels per iteration
+//
+static inline uint16x8_t expand4(uint16x8_t v) {
+	return vorrq_u16(vshlq_n_u16(v, 4), v);
+}
+static inline uint16x8_t expand5(uint16x8_t v) {
+	return vorrq_u16(vshlq_n_u16(v, 3), vshrq_n_u16(v, 2));
+}
+static inline uint16x8_t expand6(uint16x8_t v) {
+	return vorrq_u16(vshlq_n_u16(v, 2), vshrq_n_u16(v, 4));
+}
+
+template<typename Packer>
+static inline void storeRGBA(u32 *dst, uint8x8_t r, uint8x8_t g, uint8x8_t b, uint8x8_t a)
+{
+	uint8x8x4_t texels;
+	const bool bgra = std::is_same<Packer, BGRAPacker>::value;
+	texels.val[0] = bgra ? b : r;
+	texels.val[1] = g;
+	texels.val[2] = bgra ? r : b;
+	texels.val[3] = a;
+	vst4_u8((u8 *)dst, texels);
+}
+
+template<typename Packer>
+static void convertRow565_neon(void *dst, const u16 *src, u32 count)
+{
+	u32 *d = (u32 *)dst;
+	u32 i = 0;
+	for (; i + 8 <= count; i += 8)
+	{
+		uint16x8_t w = vld1q_u16(src + i);
+		uint16x8_t r = expand5(vshrq_n_u16(w, 11));
+		uint16x8_t g = expand6(vandq_u16(vshrq_n_u16(w, 5), vdupq_n_u16(0x3f)));
+		uint16x8_t b = expand5(vandq_u16(w, vdupq_n_u16(0x1f)));
+		storeRGBA<Packer>(d + i, vmovn_u16(r), vmovn_u16(g), vmovn_u16(b), vdup_n_u8(0xff));
+	}
+	convertRow<Unpacker565_32<Packer>>(d + i, src + i, count - i);
+}
+
+template<typename Packer>
+static void convertRow1555_neon(void *dst, const u16 *src, u32 count)
+{
+	u32 *d = (u32 *)dst;
+	u32 i = 0;
+	const uint16x8_t mask = vdupq_n_u16(0x1f);
+	for (; i + 8 <= count; i += 8)
+	{
+		uint16x8_t w = vld1q_u16(src + i);
+		uint16x8_t r = expand5(vandq_u16(vshrq_n_u16(w, 10), mask));
+		uint16x8_t g = expand5(vandq_u16(vshrq_n_u16(w, 5), mask));
+		uint16x8_t b = expand5(vandq_u16(w, mask));
+		uint16x8_t a = vreinterpretq_u16_s16(vshrq_n_s16(vreinterpretq_s16_u16(w), 15));
+		storeRGBA<Packer>(d + i, vmovn_u16(r), vmovn_u16(g), vmovn_u16(b), vmovn_u16(a));
+	}
+	convertRow<Unpacker1555_32<Packer>>(d + i, src + i, count - i);
+}
+
+template<typename Packer>
+static void convertRow4444_neon(void *dst, const u16 *src, u32 count)
+{
+	u32 *d = (u32 *)dst;
+	u32 i = 0;
+	const uint16x8_t mask = vdupq_n_u16(0xf);
+	for (; i + 8 <= count; i += 8)
+	{
+		uint16x8_t w = vld1q_u16(src + i);
+		uint16x8_t r = expand4(vandq_u16(vshrq_n_u16(w, 8), mask));
+		uint16x8_t g = expand4(vandq_u16(vshrq_n_u16(w, 4), mask));
+		uint16x8_t b = expand4(vandq_u16(w, mask));
+		uint16x8_t a = expand4(vshrq_n_u16(w, 12));
+		storeRGBA<Packer>(d + i, vmovn_u16(r), vmovn_u16(g), vmovn_u16(b), vmovn_u16(a));
+	}
+	convertRow<Unpacker4444_32<Packer>>(d + i, src + i, count - i);
+}
+
+template<int Shift, typename Unpacker>
+static void rotateRow_neon(void *dst, const u16 *src, u32 count)
+{
+	u16 *d = (u16 *)dst;
+	u32 i = 0;
+	for (; i + 8 <= count; i += 8)
+	{
+		uint16x8_t w = vld1q_u16(src + i);
+		vst1q_u16(d + i, vorrq_u16(vshlq_n_u16(w, Shift), vshrq_n_u16(w, 16 - Shift)));
+	}
+	convertRow<Unpacker>(d + i, src + i, count - i);
+}
+
+// Signed division by 2^Shift, rounding toward zero like the scalar code
+template<int Shift>
+static inline int16x8_t sdiv(int16x8_t v)
+{
+	int16x8_t bias = vandq_s16(vshrq_n_s16(v, 15), vdupq_n_s16((1 << Shift) - 1));
+	return vshrq_n_s16(vaddq_s16(v, bias), Shift);
+}
+
+template<typename Packer>
+static void convertRowYUV_neon(void *dst, const u16 *src, u32 count)
+{
+	u32 *d = (u32 *)dst;
+	u32 i = 0;
+	for (; i + 8 <= count; i += 8)
+	{
+		uint16x8_t w = vld1q_u16(src + i);
+		int16x8_t y = vreinterpretq_s16_u16(vshrq_n_u16(w, 8));
+		uint16x8_t uv = vandq_u16(w, vdupq_n_u16(0xff));
+		// duplicate U (even lanes) and V (odd lanes) for both texels
+		uint16x8x2_t dup = vtrnq_u16(uv, uv);
+		int16x8_t u = vsubq_s16(vreinterpretq_s16_u16(dup.val[0]), vdupq_n_s16(128));
+		int16x8_t v = vsubq_s16(vreinterpretq_s16_u16(dup.val[1]), vdupq_n_s16(128));
+
+		int16x8_t r = vaddq_s16(y, sdiv<3>(vmulq_n_s16(v, 11)));
+		int16x8_t g = vsubq_s16(y, sdiv<5>(vaddq_s16(vmulq_n_s16(u, 11), vmulq_n_s16(v, 22))));
+		int16x8_t b = vaddq_s16(y, sdiv<6>(vmulq_n_s16(u, 110)));
+		// saturating narrow clamps to [0, 255]
+		storeRGBA<Packer>(d + i, vqmovun_s16(r), vqmovun_s16(g), vqmovun_s16(b), vdup_n_u8(0xff));
+	}
+	convertRowYUV<Packer>(d + i, src + i, count - i);
+}
+
+static void detwiddleTile_neon(u16 *dst, u32 dstStride, const u16 *src)
+{
+	// even texels: rows 0 and 2, odd texels: rows 1 and 3
+	uint16x8x2_t eo = vuzpq_u16(vld1q_u16(src), vld1q_u16(src + 8));
+	uint32x4x2_t even = vuzpq_u32(vreinterpretq_u32_u16(eo.val[0]), vreinterpretq_u32_u16(eo.val[0]));
+	uint32x4x2_t odd = vuzpq_u32(vreinterpretq_u32_u16(eo.val[1]), vreinterpretq_u32_u16(eo.val[1]));
+	vst1_u16(dst, vget_low_u16(vreinterpretq_u16_u32(even.val[0])));
+	vst1_u16(dst + dstStride, vget_low_u16(vreinterpretq_u16_u32(odd.val[0])));
+	vst1_u16(dst + dstStride * 2, vget_low_u16(vreinterpretq_u16_u32(even.val[1])));
+	vst1_u16(dst + dstStride * 3, vget_low_u16(vreinterpretq_u16_u32(odd.val[1])));
+}
+
+static const Converters neonConverters {
+	Isa::NEON,
+	{
+		copyRow,
+		rotateRow_neon<1, Unpacker1555>,
+		rotateRow_neon<4, Unpacker4444>,
+		convertRow565_neon<RGBAPacker>,
+		convertRow1555_neon<RGBAPacker>,
+		convertRow4444_neon<RGBAPacker>,
+		convertRowYUV_neon<RGBAPacker>,
+		convertRow565_neon<BGRAPacker>,
+		convertRow1555_neon<BGRAPacker>,
+		convertRow4444_neon<BGRAPacker>,
+		convertRowYUV_neon<BGRAPacker>,
+	},
+	detwiddleTile_neon
+};
+#endif // TEXCONV_NEON
+
+static const Converters *getConverters(Isa isa)
+{
+	switch (isa)
+	{
+	case Isa::Scalar:
+		return &scalarConverters;
+#ifdef TEXCONV_SSE2
+	case Isa::SSE2:
+		return &sse2Converters;
+#endif
+#ifdef TEXCONV_AVX2
+	case Isa::AVX2:
+		return &avx2Converters;
+#endif
+#ifdef TEXCONV_NEON
+	case Isa::NEON:
+		return &neonConverters;
+#endif
+	default:
+		return nullptr;
+	}
+}
+
+Isa detectIsa()
+{
+#ifdef TEXCONV_AVX2
+	// may be called before static constructors
+	__builtin_cpu_init();
+	if (__builtin_cpu_supports("avx2"))
+		return Isa::AVX2;
+#endif
+#if defined(TEXCONV_SSE2)
+	return Isa::SSE2;
+#elif defined(TEXCONV_NEON)
+	return Isa::NEON;
+#else
+	return Isa::Scalar;
+#endif
+}
+
+bool setIsa(Isa isa)
+{
+	const Converters *conv = getConverters(isa);
+	if (conv == nullptr || (isa == Isa::AVX2 && detectIsa() != Isa::AVX2))
+		return false;
+	converters = conv;
+	return true;
+}
+
+const char *isaName(Isa isa)
+{
+	switch (isa)
+	{
+	case Isa::SSE2:
+		return "SSE2";
+	case Isa::AVX2:
+		return "AVX2";
+	case Isa::NEON:
+		return "NEON";
+	default:
+		return "scalar";
+	}
+}
+
+const Converters *converters = getConverters(detectIsa());
+
+}
@@ -0,0 +1,76 @@
+/*
+	Copyright 2026 flyinghead
+
+	This file is part of Flycast.
+
+    Flycast is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 2 of the License, or
+    (at your option) any later version.
+
+    Flycast is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Flycast.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#pragma once
+#include "types.h"
+
+//
+// Vectorized texture conversion helpers.
+// Rows of 16-bit texels are converted with SSE2/AVX2 or NEON depending on the host cpu,
+// and twiddled textures are de-twiddled 4x4 texels at a time.
+// The scalar Unpacker/Convert functors in TexCache.h remain the reference implementation.
+//
+namespace texconv
+{
+
+enum class Isa {
+	Scalar,	// use the scalar texture converters
+	SSE2,
+	AVX2,
+	NEON
+};
+
+enum RowFormat {
+	RowCopy16,			// no conversion
+	Row1555,			// ARGB1555 to RGBA5551
+	Row4444,			// ARGB4444 to RGBA4444
+	Row565_RGBA,
+	Row1555_RGBA,
+	Row4444_RGBA,
+	RowYUV_RGBA,
+	Row565_BGRA,
+	Row1555_BGRA,
+	Row4444_BGRA,
+	RowYUV_BGRA,
+	RowFormatCount
+};
+
+// Converts count 16-bit texels (count must be even)
+using RowConverter = void (*)(void *dst, const u16 *src, u32 count);
+
+struct Converters
+{
+	Isa isa;
+	RowConverter rows[RowFormatCount];
+	// Copies a 4x4 twiddled tile (16 consecutive texels) to 4 rows of dst
+	void (*detwiddleTile)(u16 *dst, u32 dstStride, const u16 *src);
+};
+
+extern const Converters *converters;
+
+// Best instruction set supported by the host cpu
+Isa detectIsa();
+// Returns false if the instruction set isn't supported
+bool setIsa(Isa isa);
+const char *isaName(Isa isa);
+
+static inline bool enabled() {
+	return converters->isa != Isa::Scalar;
+}
+
+}
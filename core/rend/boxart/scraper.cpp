@@ -105,7 +105,10 @@ void OfflineScraper::scrape(GameBoxart& item)
 		}
 
 		u8 sector[2048];
-		disc->ReadSectors(disc->GetBaseFAD(), 1, sector, sizeof(sector));
+		{
+			std::lock_guard<std::mutex> lock(libGDR_GetIoMutex());
+			disc->ReadSectors(disc->GetBaseFAD(), 1, sector, sizeof(sector));
+		}
 		ip_meta_t diskId;
 		memcpy(&diskId, sector, sizeof(diskId));
 		// Sanity check
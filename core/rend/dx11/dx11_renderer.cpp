@@ -306,6 +306,12 @@ BaseTextureCacheData *DX11Renderer::GetTexture(TSP tsp, TCW tcw)
 		// FIXME textureView
 		tf->loadCustomTexture();
 	}
+	else if (tf->IsAsyncConversionReady())
+	{
+		texCache.DeleteLater(tf->texture);
+		tf->texture.reset();
+		tf->CheckAsyncConversion();
+	}
 	return tf;
 }
 
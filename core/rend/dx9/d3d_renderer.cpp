@@ -232,6 +232,12 @@ BaseTextureCacheData *D3DRenderer::GetTexture(TSP tsp, TCW tcw)
 		tf->texture.reset();
 		tf->loadCustomTexture();
 	}
+	else if (tf->IsAsyncConversionReady())
+	{
+		texCache.DeleteLater(tf->texture);
+		tf->texture.reset();
+		tf->CheckAsyncConversion();
+	}
 	return tf;
 }
 
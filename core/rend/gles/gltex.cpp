@@ -340,6 +340,12 @@ BaseTextureCacheData *OpenGLRenderer::GetTexture(TSP tsp, TCW tcw)
 		tf->texID = glcache.GenTexture();
 		tf->CheckCustomTexture();
 	}
+	else if (tf->IsAsyncConversionReady())
+	{
+		TexCache.DeleteLater(tf->texID);
+		tf->texID = glcache.GenTexture();
+		tf->CheckAsyncConversion();
+	}
 
 	return tf;
 }
@@ -43,6 +43,8 @@
 #include "boxart/boxart.h"
 #include "profiler/fc_profiler.h"
 #include "hw/naomi/card_reader.h"
+#include "rend/TexCache.h"
+#include "rewind.h"
 #if defined(USE_SDL)
 #include "sdl/sdl.h"
 #endif
@@ -826,6 +828,7 @@ const Mapping dcButtons[] = {
 	{ EMU_BTN_FFORWARD, "Fast-forward" },
 	{ EMU_BTN_LOADSTATE, "Load State" },
 	{ EMU_BTN_SAVESTATE, "Save State" },
+	{ EMU_BTN_REWIND, "Rewind" },
 
 	{ EMU_BTN_NONE, nullptr }
 };
@@ -876,6 +879,7 @@ const Mapping arcadeButtons[] = {
 	{ EMU_BTN_FFORWARD, "Fast-forward" },
 	{ EMU_BTN_LOADSTATE, "Load State" },
 	{ EMU_BTN_SAVESTATE, "Save State" },
+	{ EMU_BTN_REWIND, "Rewind" },
 
 	{ EMU_BTN_NONE, nullptr }
 };
@@ -1605,6 +1609,17 @@ static void gui_display_settings()
 			ImGui::SameLine();
 			OptionCheckbox("Save", config::AutoSaveState,
 					"Save the state of the game when stopping");
+			OptionCheckbox("Incremental Savestates", config::IncrementalSavestates,
+					"Only save the changes since the previous save of the same slot. Makes frequent saves faster and smaller");
+			OptionCheckbox("Rewind", config::Rewind,
+					"Keep the recent states of the game in memory to rewind it with the Rewind button. Not available online");
+			{
+				DisabledScope scope(!config::Rewind);
+				OptionSlider("Rewind Interval", config::RewindInterval, 1, 10,
+						"Number of frames between two rewind states. Lower values rewind more smoothly but use more memory");
+				OptionSlider("Rewind Buffer Size", config::RewindBufferSize, 16, 1024,
+						"Maximum memory used by the rewind states, in MB. The oldest states are dropped first");
+			}
 			OptionCheckbox("Naomi Free Play", config::ForceFreePlay, "Configure Naomi games in Free Play mode.");
 
 			ImGui::PopStyleVar();
@@ -1964,6 +1979,8 @@ static void gui_display_settings()
 		    	}
 #endif
 		    	OptionCheckbox("Show FPS Counter", config::ShowFPS, "Show on-screen frame/sec counter");
+		    	OptionCheckbox("Show Texture Cache Statistics", config::ShowTextureStats,
+		    			"Show the number of cached textures, their estimated memory usage and the cache hit rate");
 		    	OptionCheckbox("Show VMU In-game", config::FloatVMUs, "Show the VMU LCD screens while in-game");
 		    	OptionCheckbox("Rotate Screen 90°", config::Rotate90, "Rotate the screen 90° counterclockwise");
 		    	OptionCheckbox("Delay Frame Swapping", config::DelayFrameSwapping,
@@ -2142,6 +2159,10 @@ static void gui_display_settings()
 #endif
 		    	OptionCheckbox("Load Custom Textures", config::CustomTextures,
 		    			"Load custom/high-res textures from data/textures/<game id>");
+		    	OptionCheckbox("Strict Texture Updates", config::StrictTextureUpdates,
+		    			"Convert updated textures before rendering. Disable to decode and upscale them in the background, showing the previous version until they're ready");
+		    	OptionSlider("Texture Cache Size", config::TextureCacheBudget, 0, 2048,
+		    			"Maximum GPU memory used by cached textures, in MB. The least recently used textures are deleted first. 0 means unlimited");
 		    }
 			ImGui::PopStyleVar();
 			ImGui::EndTabItem();
@@ -2168,6 +2189,8 @@ static void gui_display_settings()
 			OptionCheckbox("Enable DSP", config::DSPEnabled,
 					"Enable the Dreamcast Digital Sound Processor. Only recommended on fast platforms");
             OptionCheckbox("Enable VMU Sounds", config::VmuSound, "Play VMU beeps when enabled.");
+            OptionCheckbox("Batch Rendering", config::BatchAudioRendering,
+            		"Generate several audio samples at once. Faster but sample RAM written by the sound CPU may be read a few samples late");
 
 			if (OptionSlider("Volume Level", config::AudioVolume, 0, 100, "Adjust the emulator's audio level"))
 			{
@@ -2292,6 +2315,18 @@ static void gui_display_settings()
 				OptionSlider("SH4 Clock", config::Sh4Clock, 100, 300,
 						"Over/Underclock the main SH4 CPU. Default is 200 MHz. Other values may crash, freeze or trigger unexpected nuclear reactions.",
 						"%d MHz");
+				{
+					DisabledScope scope(game_started || !config::DynarecEnabled);
+
+					OptionCheckbox("Persistent Dynarec Cache", config::DynarecPersistentCache,
+							"Save translated SH4 code to disk and reuse it the next time the game is started. Reduces stuttering in the first minutes of play");
+					OptionCheckbox("Background Compilation", config::DynarecAsyncCompile,
+							"Translate SH4 code on a separate thread and interpret it in the meantime. Disabled during netplay");
+					OptionCheckbox("Trace Compilation", config::DynarecTraceCompile,
+							"Recompile frequently executed code across unconditional branches to reduce dispatching overhead");
+					OptionCheckbox("Fast MMU Memory Access", config::DynarecMmuMirror,
+							"Map the guest virtual memory in host memory so that Windows CE games access RAM directly");
+				}
 		    }
 	    	ImGui::Spacing();
 		    header("Network");
@@ -2389,6 +2424,8 @@ static void gui_display_settings()
 #endif
 	            OptionCheckbox("Dump Textures", config::DumpTextures,
 	            		"Dump all textures into data/texdump/<game id>");
+	            OptionCheckbox("Cache Decrypted DIMM Data", config::NaomiDimmCache,
+	            		"Save the decrypted data of Naomi GD-ROM games to disk so that they start faster. Uses as much disk space as the DIMM memory");
 
 	            bool logToFile = cfgLoadBool("log", "LogToFile", false);
 	            bool newLogToFile = logToFile;
@@ -3011,13 +3048,46 @@ static std::string getFPSNotification()
 	return std::string(settings.input.fastForwardMode ? ">>" : "");
 }
 
+static std::string getTextureStatsNotification()
+{
+	if (!config::ShowTextureStats)
+		return std::string();
+	const u64 lookups = texCacheStats.hits + texCacheStats.misses;
+	char text[64];
+	snprintf(text, sizeof(text), "T:%u %.1fM H:%.1f%% E:%u", texCacheStats.residentTextures,
+			texCacheStats.residentBytes / 1048576.0, lookups == 0 ? 0.0 : texCacheStats.hits * 100.0 / lookups,
+			(u32)texCacheStats.evictions);
+
+	return std::string(text);
+}
+
+static std::string getRewindNotification()
+{
+	if (!rewindBuffer.isRewinding())
+		return std::string();
+	RewindBuffer::Stats stats = rewindBuffer.getStats();
+	// memory used per second of rewind and restore time
+	char text[64];
+	snprintf(text, sizeof(text), "<< %.1fs %.1fM/s %.1fms", stats.seconds,
+			stats.seconds > 0.f ? stats.memoryUsed / 1048576.0 / stats.seconds : 0.0, stats.restoreTime);
+
+	return std::string(text);
+}
+
 void gui_display_osd()
 {
 	if (gui_state == GuiState::VJoyEdit)
 		return;
 	std::string message = get_notification();
 	if (message.empty())
-		message = getFPSNotification();
+	{
+		message = getRewindNotification();
+		if (message.empty())
+			message = getFPSNotification();
+		std::string texStats = getTextureStatsNotification();
+		if (!texStats.empty())
+			message += (message.empty() ? "" : " ") + texStats;
+	}
 
 //	if (!message.empty() || config::FloatVMUs || crosshairsNeeded() || (ggpo::active() && config::NetworkStats))
 	{
@@ -3075,6 +3145,17 @@ void gui_display_profiler()
 		ImGui::Unindent();
 	}
 
+	ImGui::Text("Texture cache: %u textures, %.1f MB, %" PRIu64 " hits, %" PRIu64 " misses, %" PRIu64 " evictions",
+			texCacheStats.residentTextures, texCacheStats.residentBytes / 1048576.0,
+			texCacheStats.hits, texCacheStats.misses, texCacheStats.evictions);
+	ImGui::Text("TA context allocations: %" PRIu64, tactx_AllocationCount());
+	if (rewindBuffer.isActive())
+	{
+		RewindBuffer::Stats stats = rewindBuffer.getStats();
+		ImGui::Text("Rewind buffer: %u states, %.1f s, %.1f MB, restore time %.2f ms", stats.entries,
+				stats.seconds, stats.memoryUsed / 1048576.0, stats.restoreTime);
+	}
+
 	ImGui::PopStyleColor();
 	
 	for (const fc_profiler::ProfileThread* profileThread : fc_profiler::ProfileThread::s_allThreads)
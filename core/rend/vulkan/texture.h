@@ -212,7 +212,9 @@ public:
 		texture->format = vk::Format::eUndefined;
 	}
 
-	void Cleanup();
+	void Cleanup() {
+		CollectCleanup();
+	}
 
 	void Clear()
 	{
@@ -230,7 +232,7 @@ public:
 	}
 
 private:
-	bool clearTexture(Texture *tex)
+	bool clearTexture(Texture *tex) override
 	{
 		for (auto& set : inFlightTextures)
 			set.erase(tex);
@@ -113,6 +113,12 @@ public:
 			tf->SetCommandBuffer(texCommandBuffer);
 			tf->CheckCustomTexture();
 		}
+		else if (tf->IsAsyncConversionReady())
+		{
+			textureCache.DestroyLater(tf);
+			tf->SetCommandBuffer(texCommandBuffer);
+			tf->CheckAsyncConversion();
+		}
 		tf->SetCommandBuffer(nullptr);
 		textureCache.SetInFlight(tf);
 
@@ -0,0 +1,310 @@
+/*
+	Copyright 2026 flyinghead
+
+	This file is part of Flycast.
+
+    Flycast is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 2 of the License, or
+    (at your option) any later version.
+
+    Flycast is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Flycast.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#include "rewind.h"
+#include "deltastate.h"
+#include "serialize.h"
+#include "cfg/option.h"
+#include "hw/mem/mem_watch.h"
+#include "hw/pvr/Renderer_if.h"
+#include "hw/sh4/dyna/blockmanager.h"
+#include "oslib/oslib.h"
+#include "rend/TexCache.h"
+#include <zlib.h>
+
+#include <cstring>
+
+RewindBuffer rewindBuffer;
+
+static void invalidateRam(u32 offset) {
+	bm_RamWriteAccess(offset);
+}
+
+static void invalidateVram(u32 offset) {
+	VramLockedWriteOffset(offset);
+}
+
+static void invalidateNone(u32 offset) {
+}
+
+// Moves the pages written since the last capture, with their content at the time of the capture, to out
+static void encodePages(std::vector<u8>& out)
+{
+	auto encode = [&out](auto& watcher) {
+		memwatch::PageMap pages;
+		watcher.getPages(pages);
+		const u32 count = (u32)pages.size();
+		out.insert(out.end(), (const u8 *)&count, (const u8 *)&count + sizeof(count));
+		for (const auto& pair : pages)
+		{
+			out.insert(out.end(), (const u8 *)&pair.first, (const u8 *)&pair.first + sizeof(pair.first));
+			out.insert(out.end(), &pair.second.data[0], &pair.second.data[PAGE_SIZE]);
+		}
+	};
+	encode(memwatch::ramWatcher);
+	encode(memwatch::vramWatcher);
+	encode(memwatch::aramWatcher);
+	encode(memwatch::elanWatcher);
+}
+
+static void applyPages(const std::vector<u8>& in)
+{
+	const u8 *p = in.data();
+	auto apply = [&p](auto& watcher, void (*invalidate)(u32)) {
+		u32 count;
+		memcpy(&count, p, sizeof(count));
+		p += sizeof(count);
+		for (u32 i = 0; i < count; i++)
+		{
+			u32 offset;
+			memcpy(&offset, p, sizeof(offset));
+			p += sizeof(offset);
+			memcpy(watcher.getMemPage(offset), p, PAGE_SIZE);
+			p += PAGE_SIZE;
+			invalidate(offset);
+		}
+	};
+	apply(memwatch::ramWatcher, invalidateRam);
+	apply(memwatch::vramWatcher, invalidateVram);
+	apply(memwatch::aramWatcher, invalidateNone);
+	apply(memwatch::elanWatcher, invalidateNone);
+}
+
+// Restores the content of the pages written since the last capture
+static void restoreWatchedPages()
+{
+	auto restore = [](auto& watcher, void (*invalidate)(u32)) {
+		memwatch::PageMap pages;
+		watcher.getPages(pages);
+		for (const auto& pair : pages)
+		{
+			memcpy(watcher.getMemPage(pair.first), &pair.second.data[0], PAGE_SIZE);
+			invalidate(pair.first);
+		}
+	};
+	restore(memwatch::ramWatcher, invalidateRam);
+	restore(memwatch::vramWatcher, invalidateVram);
+	restore(memwatch::aramWatcher, invalidateNone);
+	restore(memwatch::elanWatcher, invalidateNone);
+}
+
+RewindBuffer::~RewindBuffer()
+{
+	if (thread.joinable())
+	{
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			exitThread = true;
+		}
+		cond.notify_one();
+		thread.join();
+	}
+}
+
+void RewindBuffer::start()
+{
+	const bool enabled = config::Rewind && !config::GGPOEnable && !settings.network.online && !settings.naomi.multiboard;
+	if (enabled == active)
+		return;
+	if (!enabled)
+	{
+		// Stop tracking memory writes. Code pages aren't protected anymore so blocks must be discarded.
+		memwatch::unprotect();
+		memwatch::reset();
+#if FEAT_SHREC != DYNAREC_NONE
+		bm_Reset();
+#endif
+	}
+	active = enabled;
+	reset();
+	if (active && !thread.joinable())
+		thread = std::thread(&RewindBuffer::compressThread, this);
+}
+
+void RewindBuffer::reset()
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	queue.clear();
+	entries.clear();
+	frames = 0;
+}
+
+bool RewindBuffer::vblank()
+{
+	if (!active)
+		return false;
+	frameCount++;
+	if (rewinding)
+		// Restore a state every frame
+		return true;
+	return ++frames >= (u32)config::RewindInterval;
+}
+
+void RewindBuffer::update()
+{
+	if (rewinding)
+	{
+		if (stepBack())
+			wasRewinding = true;
+	}
+	else
+	{
+		if (wasRewinding)
+		{
+			Stats stats = getStats();
+			INFO_LOG(COMMON, "Rewind buffer: %d states, %.1f s, %.1f MB, restore time %.2f ms", stats.entries,
+					stats.seconds, stats.memoryUsed / 1024.0 / 1024.0, stats.restoreTime);
+			wasRewinding = false;
+		}
+		capture();
+	}
+	frames = 0;
+}
+
+void RewindBuffer::capture()
+{
+	// Protect the pages written since the last capture again and get their previous content
+	memwatch::protect();
+	buffer.clear();
+	encodePages(buffer);
+	BlobPtr pages = entries.empty() ? nullptr : addBlob(buffer);
+	deltastate::serialize(buffer, true);
+	BlobPtr state = addBlob(buffer);
+
+	std::lock_guard<std::mutex> lock(mutex);
+	if (!entries.empty())
+		entries.back().pages = pages;
+	entries.push_back({ state, nullptr, frameCount });
+
+	// Drop the oldest entries to stay within the budget
+	const size_t budget = (size_t)config::RewindBufferSize * 1024 * 1024;
+	size_t used = 0;
+	for (const Entry& entry : entries)
+		used += entry.state->data.size() + (entry.pages != nullptr ? entry.pages->data.size() : 0);
+	while (used > budget && entries.size() > 1)
+	{
+		const Entry& entry = entries.front();
+		used -= entry.state->data.size() + entry.pages->data.size();
+		entries.pop_front();
+	}
+}
+
+// Returns false if there is no state to restore
+bool RewindBuffer::stepBack()
+{
+	if (entries.empty())
+		return false;
+	const double start = os_GetSeconds();
+	rend_start_rollback();
+	memwatch::unprotect();
+	// Back to the last captured state
+	restoreWatchedPages();
+	if (entries.size() >= 2)
+	{
+		// and to the previous one
+		decode(entries[entries.size() - 2].pages, buffer);
+		applyPages(buffer);
+		std::lock_guard<std::mutex> lock(mutex);
+		entries.pop_back();
+	}
+	Entry& entry = entries.back();
+	entry.pages.reset();
+	decode(entry.state, buffer);
+	Deserializer deser(buffer.data(), buffer.size(), true);
+	dc_deserialize(deser);
+	rend_allow_rollback();
+	memwatch::reset();
+	memwatch::protect();
+	restoreTime = (float)((os_GetSeconds() - start) * 1000.0);
+
+	return true;
+}
+
+RewindBuffer::BlobPtr RewindBuffer::addBlob(std::vector<u8>& data)
+{
+	BlobPtr blob = std::make_shared<Blob>();
+	blob->size = (u32)data.size();
+	std::swap(blob->data, data);
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		queue.push_back(blob);
+	}
+	cond.notify_one();
+	return blob;
+}
+
+void RewindBuffer::decode(const BlobPtr& blob, std::vector<u8>& data)
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	if (!blob->compressed)
+	{
+		data = blob->data;
+		return;
+	}
+	data.resize(blob->size);
+	uLongf size = blob->size;
+	int rc = uncompress(data.data(), &size, blob->data.data(), blob->data.size());
+	verify(rc == Z_OK && size == blob->size);
+}
+
+void RewindBuffer::compressThread()
+{
+	std::unique_lock<std::mutex> lock(mutex);
+	while (true)
+	{
+		cond.wait(lock, [this]() { return exitThread || !queue.empty(); });
+		if (exitThread)
+			break;
+		BlobPtr blob = queue.front();
+		queue.pop_front();
+		if (blob.use_count() == 1)
+			// dropped already
+			continue;
+		lock.unlock();
+
+		uLongf size = compressBound(blob->size);
+		std::vector<u8> zipped(size);
+		int rc = compress2(zipped.data(), &size, blob->data.data(), blob->size, Z_BEST_SPEED);
+
+		lock.lock();
+		if (rc == Z_OK)
+		{
+			zipped.resize(size);
+			zipped.shrink_to_fit();
+			std::swap(blob->data, zipped);
+			blob->compressed = true;
+		}
+		else
+		{
+			WARN_LOG(COMMON, "Rewind buffer compression error %d", rc);
+		}
+	}
+}
+
+RewindBuffer::Stats RewindBuffer::getStats()
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	Stats stats {};
+	stats.entries = (u32)entries.size();
+	for (const Entry& entry : entries)
+		stats.memoryUsed += entry.state->data.size() + (entry.pages != nullptr ? entry.pages->data.size() : 0);
+	if (!entries.empty())
+		stats.seconds = (entries.back().frame - entries.front().frame) / 60.f;
+	stats.restoreTime = restoreTime;
+	return stats;
+}
@@ -0,0 +1,107 @@
+/*
+	Copyright 2026 flyinghead
+
+	This file is part of Flycast.
+
+    Flycast is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 2 of the License, or
+    (at your option) any later version.
+
+    Flycast is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Flycast.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#pragma once
+#include "types.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+//
+// Rewind buffer.
+// The device state is captured every few frames, serialized in rollback mode.
+// Memory pages are tracked with the memwatch write watchers, like GGPO rollbacks:
+// each entry holds the content of the pages that have been written until the next entry.
+// Entries are compressed on a background thread and the oldest ones are dropped to stay within the memory budget.
+//
+class RewindBuffer
+{
+public:
+	struct Stats
+	{
+		u32 entries;
+		size_t memoryUsed;
+		float seconds;			// duration covered by the buffer
+		float restoreTime;		// last restore duration in ms
+	};
+
+	~RewindBuffer();
+
+	// Called when the emulator starts
+	void start();
+	// Drops all the entries
+	void reset();
+	bool isActive() const { return active; }
+	// Called on the emu thread at the end of each frame.
+	// Returns true if the cpu must be stopped to call update().
+	bool vblank();
+	// Captures or restores a state. Called on the emu thread with the cpu stopped.
+	void update();
+	// Rewinds while set
+	void setRewinding(bool rewinding) {
+		this->rewinding = rewinding;
+	}
+	bool isRewinding() const {
+		return active && rewinding;
+	}
+	Stats getStats();
+
+private:
+	struct Blob
+	{
+		std::vector<u8> data;
+		u32 size = 0;			// uncompressed size
+		bool compressed = false;
+	};
+	using BlobPtr = std::shared_ptr<Blob>;
+
+	struct Entry
+	{
+		BlobPtr state;			// device state
+		BlobPtr pages;			// content of the pages written until the next entry
+		u64 frame;
+	};
+
+	void capture();
+	bool stepBack();
+	BlobPtr addBlob(std::vector<u8>& data);
+	void decode(const BlobPtr& blob, std::vector<u8>& data);
+	void compressThread();
+
+	bool active = false;
+	std::atomic_bool rewinding { false };
+	bool wasRewinding = false;
+	u32 frames = 0;
+	u64 frameCount = 0;
+	float restoreTime = 0.f;
+	std::deque<Entry> entries;
+	std::vector<u8> buffer;
+
+	std::thread thread;
+	std::mutex mutex;
+	std::condition_variable cond;
+	std::deque<BlobPtr> queue;
+	bool exitThread = false;
+};
+
+extern RewindBuffer rewindBuffer;
@@ -20,6 +20,44 @@
 extern u32 NullDriveDiscType;
 extern u8 q_subchannel[96];
 
+void Serializer::nextBlock()
+{
+	blockStart = data = stream->allocBlock();
+	blockEnd = data + blockSize;
+}
+
+void Serializer::streamData(const void *src, size_t size)
+{
+	const u8 *p = (const u8 *)src;
+	while (size > 0)
+	{
+		size_t len = std::min(size, (size_t)(blockEnd - data));
+		if (p != nullptr)
+		{
+			memcpy(data, p, len);
+			p += len;
+		}
+		else
+			memset(data, 0, len);
+		data += len;
+		size -= len;
+		if (data == blockEnd)
+		{
+			stream->writeBlock(blockStart, blockSize);
+			nextBlock();
+		}
+	}
+}
+
+void Serializer::flush()
+{
+	if (stream == nullptr)
+		return;
+	stream->writeBlock(blockStart, data - blockStart);
+	stream = nullptr;
+	data = blockStart = blockEnd = nullptr;
+}
+
 void dc_serialize(Serializer& ser)
 {
 	aica::serialize(ser);
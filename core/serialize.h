@@ -150,6 +150,17 @@ private:
 class Serializer : public SerializeBase
 {
 public:
+	// Receives the serialized data block by block as it is produced
+	class Stream
+	{
+	public:
+		virtual ~Stream() = default;
+		// Returns a buffer of at least blockSize bytes
+		virtual u8 *allocBlock() = 0;
+		// Takes ownership of a block returned by allocBlock(). The last block may be partially filled or empty.
+		virtual void writeBlock(u8 *block, size_t size) = 0;
+	};
+
 	Serializer()
 		: Serializer(nullptr, std::numeric_limits<size_t>::max(), false) {}
 
@@ -160,6 +171,15 @@ public:
 		serialize(v);
 	}
 
+	// Serializes to a stream. flush() must be called once serialization is complete.
+	Serializer(Stream& stream, size_t blockSize, bool rollback = false)
+		: SerializeBase(std::numeric_limits<size_t>::max(), rollback), stream(&stream), blockSize(blockSize)
+	{
+		nextBlock();
+		Version v = Current;
+		serialize(v);
+	}
+
 	template<typename T>
 	void serialize(const T& obj)
 	{
@@ -178,24 +198,38 @@ public:
 	}
 	void skip(size_t size)
 	{
-		if (data != nullptr)
+		if (stream != nullptr)
+			streamData(nullptr, size);
+		else if (data != nullptr)
 			data += size;
 		this->_size += size;
 	}
 	bool dryrun() const { return data == nullptr; }
+	void flush();
 
 private:
 	void doSerialize(const void *src, size_t size)
 	{
 		if (data != nullptr)
 		{
-			memcpy(data, src, size);
-			data += size;
+			if (stream != nullptr && data + size > blockEnd)
+				streamData(src, size);
+			else
+			{
+				memcpy(data, src, size);
+				data += size;
+			}
 		}
 		this->_size += size;
 	}
+	void streamData(const void *src, size_t size);
+	void nextBlock();
 
 	u8 *data;
+	Stream *stream = nullptr;
+	size_t blockSize = 0;
+	u8 *blockStart = nullptr;
+	u8 *blockEnd = nullptr;
 };
 
 template<typename T>
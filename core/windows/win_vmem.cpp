@@ -3,6 +3,7 @@
 #include "oslib/virtmem.h"
 
 #include <windows.h>
+#include <io.h>
 
 namespace virtmem
 {
@@ -273,4 +274,46 @@ void jit_set_exec(void* code, size_t size, bool enable)
 #endif
 }
 
+void *map_file(FILE *file, size_t size)
+{
+#ifdef TARGET_UWP
+	return nullptr;
+#else
+	HANDLE fileHandle = (HANDLE)_get_osfhandle(_fileno(file));
+	if (fileHandle == INVALID_HANDLE_VALUE)
+		return nullptr;
+	HANDLE mapping = CreateFileMapping(fileHandle, nullptr, PAGE_WRITECOPY, 0, 0, nullptr);
+	if (mapping == nullptr)
+	{
+		WARN_LOG(VMEM, "map_file: CreateFileMapping failed. error %d", (int)GetLastError());
+		return nullptr;
+	}
+	void *p = MapViewOfFile(mapping, FILE_MAP_COPY, 0, 0, size);
+	// The view keeps the mapping alive
+	CloseHandle(mapping);
+	if (p == nullptr)
+		WARN_LOG(VMEM, "map_file: MapViewOfFile failed. error %d", (int)GetLastError());
+	return p;
+#endif
+}
+
+void unmap_file(void *start, size_t size)
+{
+	UnmapViewOfFile(start);
+}
+
+void *reserve_window(size_t size)
+{
+	return nullptr;
+}
+
+bool map_window(void *dest, size_t size, size_t memoffset, bool allow_writes)
+{
+	return false;
+}
+
+void unmap_window(void *start, size_t size)
+{
+}
+
 }	// namespace virtmem
@@ -24,6 +24,10 @@ namespace config {
 // Dynarec
 
 Option<bool> DynarecEnabled("", true);
+Option<bool> DynarecPersistentCache("", false);
+Option<bool> DynarecAsyncCompile("", false);
+Option<bool> DynarecTraceCompile("", false);
+Option<bool> DynarecMmuMirror("", false);
 IntOption Sh4Clock(CORE_OPTION_NAME "_sh4clock", 200);
 
 // General
@@ -35,12 +39,17 @@ Option<int> Language(CORE_OPTION_NAME "_language", 1);		// English
 Option<bool> ForceWindowsCE(CORE_OPTION_NAME "_force_wince");
 Option<bool> AutoLoadState("");
 Option<bool> AutoSaveState("");
+Option<bool> IncrementalSavestates("");
+Option<bool> Rewind("");
+Option<int> RewindInterval("", 2);
+Option<int> RewindBufferSize("", 64);
 Option<int, false> SavestateSlot("");
 Option<bool> ForceFreePlay(CORE_OPTION_NAME "_force_freeplay", true);
 
 // Sound
 
 Option<bool> DSPEnabled(CORE_OPTION_NAME "_enable_dsp", false);
+Option<bool> BatchAudioRendering("", false);
 #if HOST_CPU == CPU_ARM
 Option<int> AudioBufferSize("", 5644);	// 128 ms
 #else
@@ -58,6 +67,7 @@ Option<bool> UseMipmaps(CORE_OPTION_NAME "_mipmapping", true);
 Option<bool> Widescreen(CORE_OPTION_NAME "_widescreen_hack");
 Option<bool> SuperWidescreen("");
 Option<bool> ShowFPS("");
+Option<bool> ShowTextureStats("");
 Option<bool> RenderToTextureBuffer(CORE_OPTION_NAME "_enable_rttb");
 Option<bool> TranslucentPolygonDepthMask("");
 Option<bool> ModifierVolumes(CORE_OPTION_NAME "_volume_modifier_enable", true);
@@ -66,6 +76,8 @@ IntOption MaxFilteredTextureSize(CORE_OPTION_NAME "_texupscale_max_filtered_text
 Option<float> ExtraDepthScale("", 1.f);
 Option<bool> CustomTextures(CORE_OPTION_NAME "_custom_textures");
 Option<bool> DumpTextures(CORE_OPTION_NAME "_dump_textures");
+Option<bool> StrictTextureUpdates("", true);
+Option<int> TextureCacheBudget("", 512);
 Option<int> ScreenStretching("", 100);
 Option<bool> Fog(CORE_OPTION_NAME "_fog", true);
 Option<bool> FloatVMUs("");
@@ -101,6 +113,7 @@ Option<bool> UseReios(CORE_OPTION_NAME "_hle_bios");
 
 Option<bool> OpenGlChecks("", false);
 Option<bool> FastGDRomLoad(CORE_OPTION_NAME "_gdrom_fast_loading", false);
+Option<bool> NaomiDimmCache("", false);
 
 //Option<std::vector<std::string>, false> ContentPath("");
 //Option<bool, false> HideLegacyNaomiRoms("", true);
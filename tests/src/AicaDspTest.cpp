@@ -0,0 +1,153 @@
+/*
+	Copyright 2026 flyinghead
+
+	This file is part of Flycast.
+
+    Flycast is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 2 of the License, or
+    (at your option) any later version.
+
+    Flycast is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Flycast.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#include "gtest/gtest.h"
+#include "types.h"
+#include "emulator.h"
+#include "serialize.h"
+#include "hw/mem/addrspace.h"
+#include "hw/aica/aica.h"
+#include "hw/aica/dsp.h"
+#include <chrono>
+#include <random>
+
+using namespace aica;
+
+class AicaDspTest : public ::testing::Test {
+protected:
+	void SetUp() override
+	{
+		if (!addrspace::reserve())
+			die("addrspace::reserve failed");
+		emu.init();
+		dc_reset(true);
+	}
+
+	static void loadProgram(const u32 *mpro, int steps)
+	{
+		memset(DSPData->MPRO, 0, sizeof(DSPData->MPRO));
+		memcpy(DSPData->MPRO, mpro, steps * 4 * sizeof(u32));
+		dsp::writeProg(0x3400);
+	}
+
+	// Random program with empty instruction ranges, similar in size to what games use
+	static void randomProgram(u32 seed, int steps)
+	{
+		std::mt19937 random(seed);
+		u32 mpro[128 * 4] {};
+		for (int step = 0; step < steps; step++)
+		{
+			if (random() % 4 == 0)
+				continue;
+			for (int i = 0; i < 4; i++)
+				mpro[step * 4 + i] = random() & 0xffff;
+			if (random() % 3 != 0)
+				// fewer memory accesses
+				mpro[step * 4 + 2] &= ~0x6000;
+		}
+		for (u32& coef : DSPData->COEF)
+			coef = random() & 0xfff8;
+		for (u32& madrs : DSPData->MADRS)
+			madrs = random() & 0xffff;
+		loadProgram(mpro, steps);
+	}
+};
+
+TEST_F(AicaDspTest, PassThrough)
+{
+	const u32 mpro[] {
+		// X = MIXS[0], Y = COEF[0], ZERO
+		0, 0x8000 | (0x20 << 7) | (1 << 13), 2, 0,
+		// empty
+		0, 0, 0, 0,
+		0, 0, 0, 0,
+		// X = MIXS[1], Y = COEF[3], B = TEMP[0], EFREG[0] = SHIFTED
+		0, 0x8000 | (0x21 << 7) | (1 << 13), 0x1000, 0,
+		// EFREG[1] = SHIFTED
+		0, 0, 0x1100, 0,
+	};
+	DSPData->COEF[0] = 0x800 << 3;	// 0.5
+	DSPData->COEF[3] = 0x400 << 3;	// 0.25
+	loadProgram(mpro, std::size(mpro) / 4);
+	dsp::state.MIXS[0] = 0x1000;
+	dsp::state.MIXS[1] = -0x2000;
+	dsp::step();
+	// Results are delayed by one step, and the empty instructions in between overwrite ACC
+	ASSERT_EQ(0, (s32)DSPData->EFREG[0]);
+	ASSERT_EQ((-0x20000 / 4) >> 8, (s32)DSPData->EFREG[1]);
+
+	dsp::state.MIXS[0] = 0x2000;
+	dsp::state.MIXS[1] = 0x400;
+	dsp::step();
+	ASSERT_EQ(0, (s32)DSPData->EFREG[0]);
+	ASSERT_EQ((0x4000 / 4) >> 8, (s32)DSPData->EFREG[1]);
+}
+
+// Loading a state must reload its DSP program
+TEST_F(AicaDspTest, Deserialize)
+{
+	u32 mpro[] {
+		// X = MIXS[1], Y = COEF[0], ZERO
+		0, 0x8000 | (0x21 << 7) | (1 << 13), 2, 0,
+		// EFREG[1] = SHIFTED
+		0, 0, 0x1100, 0,
+	};
+	DSPData->COEF[0] = 0x800 << 3;	// 0.5
+	loadProgram(mpro, std::size(mpro) / 4);
+	dsp::step();
+
+	Serializer dryrun;
+	dc_serialize(dryrun);
+	std::vector<u8> data(dryrun.size());
+	Serializer ser(data.data(), data.size());
+	dc_serialize(ser);
+
+	// EFREG[2] = SHIFTED
+	mpro[6] = 0x1200;
+	loadProgram(mpro, std::size(mpro) / 4);
+	dsp::step();
+
+	Deserializer deser(data.data(), data.size());
+	dc_deserialize(deser);
+	DSPData->EFREG[1] = 0;
+	DSPData->EFREG[2] = 0;
+	dsp::state.MIXS[1] = 0x1000;
+	dsp::step();
+	ASSERT_EQ((0x10000 / 2) >> 8, (s32)DSPData->EFREG[1]);
+	ASSERT_EQ(0, (s32)DSPData->EFREG[2]);
+}
+
+TEST_F(AicaDspTest, DISABLED_Benchmark)
+{
+	using clock = std::chrono::steady_clock;
+	constexpr int samples = 44100;
+	for (int steps : { 32, 64, 128 })
+	{
+		randomProgram(steps, steps);
+		std::mt19937 random(42);
+		auto start = clock::now();
+		for (int i = 0; i < samples; i++)
+		{
+			for (s32& mixs : dsp::state.MIXS)
+				mixs = (s32)(random() << 12) >> 12;
+			dsp::step();
+		}
+		const double duration = std::chrono::duration<double>(clock::now() - start).count();
+		printf("%3d steps  %.2f Msamples/s\n", steps, samples / duration / 1e6);
+	}
+}
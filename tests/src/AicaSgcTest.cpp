@@ -0,0 +1,237 @@
+/*
+	Copyright 2026 flyinghead
+
+	This file is part of Flycast.
+
+    Flycast is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 2 of the License, or
+    (at your option) any later version.
+
+    Flycast is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Flycast.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#include "gtest/gtest.h"
+#include "types.h"
+#include "emulator.h"
+#include "serialize.h"
+#include "cfg/option.h"
+#include "hw/mem/addrspace.h"
+#include "hw/aica/aica.h"
+#include "hw/aica/aica_if.h"
+#include "hw/aica/aica_mem.h"
+#include "hw/aica/sgc_if.h"
+#include "oslib/audiostream.h"
+#include <chrono>
+#include <random>
+#include <vector>
+
+// Keeps all the generated samples
+class CaptureAudioBackend : public AudioBackend
+{
+public:
+	CaptureAudioBackend()
+		: AudioBackend("capture", "Capture") {}
+
+	bool init() override {
+		return true;
+	}
+
+	u32 push(const void *data, u32 frames, bool wait) override
+	{
+		const s16 *p = (const s16 *)data;
+		samples.insert(samples.end(), p, p + frames * 2);
+		return frames;
+	}
+
+	std::vector<s16> samples;
+};
+static CaptureAudioBackend captureBackend;
+
+class AicaSgcTest : public ::testing::Test {
+protected:
+	void SetUp() override
+	{
+		if (!addrspace::reserve())
+			die("addrspace::reserve failed");
+		emu.init();
+		dc_reset(true);
+		config::AudioBackend.override("capture");
+		InitAudio();
+	}
+
+	void TearDown() override
+	{
+		TermAudio();
+		config::AudioBackend.reset();
+		config::BatchAudioRendering.reset();
+		config::DSPEnabled.reset();
+	}
+
+	static void writeChannelReg(u32 channel, u32 reg, u16 v)
+	{
+		*(u16 *)&aica::aica_reg[channel * 0x80 + reg] = v;
+		aica::sgc::WriteChannelReg(channel, reg, 2);
+	}
+
+	// Random sample data and channel parameters
+	static void setupChannels(int channels, u32 seed)
+	{
+		std::mt19937 random(seed);
+		for (u32 i = 0; i < 0x100000; i++)
+			aica::aica_ram[i] = (u8)random();
+		aica::CommonData->MVOL = 15;
+		for (int ch = 0; ch < channels; ch++)
+		{
+			const u32 pcms = random() % 4;
+			const u32 sa = (random() % 0x80000) & ~1;
+			writeChannelReg(ch, 0x04, sa & 0xffff);
+			writeChannelReg(ch, 0x08, random() % 2000);			// LSA
+			writeChannelReg(ch, 0x0c, 2000 + random() % 20000);	// LEA
+			writeChannelReg(ch, 0x10, (random() % 32) | ((random() % 32) << 6) | ((random() % 8) << 11));	// AR D1R D2R
+			writeChannelReg(ch, 0x14, (random() % 32) | ((random() % 32) << 5) | ((random() % 2) << 14));	// RR DL LPSLNK
+			writeChannelReg(ch, 0x18, (random() % 1024) | (((random() % 5 + 14) & 0xf) << 11));			// FNS OCT
+			writeChannelReg(ch, 0x1c, random() & 0xffff);									// LFO
+			writeChannelReg(ch, 0x20, (random() % 16) | ((random() % 16) << 4));			// ISEL IMXL
+			writeChannelReg(ch, 0x24, (random() % 32) | ((random() % 16) << 8));			// DIPAN DISDL
+			writeChannelReg(ch, 0x28, (random() % 32) | ((random() % 2) << 5) | ((random() % 64) << 8));	// Q LPOFF TL
+			for (u32 reg = 0x2c; reg <= 0x3c; reg += 4)
+				writeChannelReg(ch, reg, random() % 0x2000);								// FEG
+			writeChannelReg(ch, 0x40, random() & 0x1f1f);
+			writeChannelReg(ch, 0x44, random() & 0x1f1f);
+			writeChannelReg(ch, 0x00, ((sa >> 16) & 0x7f) | (pcms << 7) | ((random() % 2) << 9)
+					| ((random() % 8 == 0) << 10) | (1 << 14));								// SA PCMS LPCTL SSCTL KYONB
+		}
+		// KYONEX
+		writeChannelReg(0, 0x00, *(u16 *)&aica::aica_reg[0] | (1 << 15));
+	}
+
+	// Generates the given number of samples, with a register write every 1000 samples
+	static void render(int channels, u32 samples)
+	{
+		for (u32 i = 0; i < samples; i++)
+		{
+			aica::sgc::AICA_Sample();
+			if (i % 1000 == 999)
+			{
+				aica::sgc::flushSamples();
+				const u32 ch = i / 1000 % channels;
+				writeChannelReg(ch, 0x28, *(u16 *)&aica::aica_reg[ch * 0x80 + 0x28] ^ 0x100);
+			}
+		}
+		aica::sgc::flushSamples();
+	}
+
+	std::vector<s16> run(bool batch, const std::vector<u8>& state, int channels, u32 samples)
+	{
+		Deserializer deser(state.data(), state.size());
+		dc_deserialize(deser);
+		config::BatchAudioRendering = batch;
+		captureBackend.samples.clear();
+		render(channels, samples);
+		return captureBackend.samples;
+	}
+
+	static std::vector<u8> saveState()
+	{
+		Serializer dryrun;
+		dc_serialize(dryrun);
+		std::vector<u8> state(dryrun.size());
+		Serializer ser(state.data(), state.size());
+		dc_serialize(ser);
+		return state;
+	}
+};
+
+// Batch rendering must be bit-exact
+TEST_F(AicaSgcTest, Batch)
+{
+	for (int dsp = 0; dsp < 2; dsp++)
+	{
+		config::DSPEnabled = dsp == 1;
+		for (u32 seed = 1; seed <= 5; seed++)
+		{
+			dc_reset(true);
+			setupChannels(64, seed);
+			const std::vector<u8> state = saveState();
+			std::vector<s16> ref = run(false, state, 64, 512 * 40);
+			std::vector<s16> batch = run(true, state, 64, 512 * 40);
+			ASSERT_EQ(512u * 40 * 2, ref.size());
+			ASSERT_TRUE(ref == batch) << "seed " << seed << " dsp " << dsp;
+		}
+	}
+}
+
+// ARM writes to sample RAM aren't sync points. In batch mode, a channel can see them up to a batch early but never late.
+TEST_F(AicaSgcTest, ArmWrite)
+{
+	constexpr u32 SampleAddr = 0x10000;
+	constexpr u32 LoopEnd = 1000;
+	constexpr u32 WriteSample = 100;
+	dc_reset(true);
+	memset(&aica::aica_ram[SampleAddr], 0, LoopEnd * 2);
+	aica::CommonData->MVOL = 15;
+	writeChannelReg(0, 0x04, SampleAddr & 0xffff);
+	writeChannelReg(0, 0x08, 0);			// LSA
+	writeChannelReg(0, 0x0c, LoopEnd);		// LEA
+	writeChannelReg(0, 0x10, 31);			// AR
+	writeChannelReg(0, 0x14, 0);
+	writeChannelReg(0, 0x18, 0);			// 1 input sample per output sample
+	writeChannelReg(0, 0x24, 0xf << 8);		// DISDL
+	writeChannelReg(0, 0x28, 1 << 5);		// LPOFF
+	// 16-bit PCM, loop, KYONB, KYONEX
+	writeChannelReg(0, 0x00, (SampleAddr >> 16) | (1 << 9) | (1 << 14) | (1 << 15));
+	const std::vector<u8> state = saveState();
+
+	auto firstSound = [&state](bool batch) -> u32 {
+		Deserializer deser(state.data(), state.size());
+		dc_deserialize(deser);
+		config::BatchAudioRendering = batch;
+		captureBackend.samples.clear();
+		for (u32 i = 0; i < 512; i++)
+		{
+			if (i == WriteSample)
+				for (u32 j = 0; j < LoopEnd; j++)
+					*(s16 *)&aica::aica_ram[SampleAddr + j * 2] = 0x4000;
+			aica::sgc::AICA_Sample();
+		}
+		aica::sgc::flushSamples();
+		for (u32 i = 0; i < captureBackend.samples.size(); i += 2)
+			if (captureBackend.samples[i] != 0)
+				return i / 2;
+		return ~0u;
+	};
+	const u32 ref = firstSound(false);
+	const u32 batch = firstSound(true);
+	ASSERT_LE(WriteSample, ref);
+	ASSERT_NE(~0u, ref);
+	ASSERT_LE(batch, ref);
+	ASSERT_LT(ref - batch, 32u);
+	// the samples rendered before the write are silent
+	ASSERT_LE(WriteSample / 32 * 32, batch);
+}
+
+TEST_F(AicaSgcTest, DISABLED_Benchmark)
+{
+	using clock = std::chrono::steady_clock;
+	constexpr u32 samples = 512 * 400;
+	for (int channels : { 8, 32, 64 })
+	{
+		dc_reset(true);
+		setupChannels(channels, 7);
+		const std::vector<u8> state = saveState();
+		double rate[2];
+		for (int batch = 0; batch < 2; batch++)
+		{
+			auto start = clock::now();
+			run(batch == 1, state, channels, samples);
+			rate[batch] = samples / std::chrono::duration<double>(clock::now() - start).count();
+		}
+		printf("%2d channels  per-sample %.2f Msamples/s  batch %.2f Msamples/s\n", channels, rate[0] / 1e6, rate[1] / 1e6);
+	}
+}
@@ -0,0 +1,175 @@
+/*
+	Copyright 2026 flyinghead
+
+	This file is part of Flycast.
+
+    Flycast is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 2 of the License, or
+    (at your option) any later version.
+
+    Flycast is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Flycast.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#include "gtest/gtest.h"
+#include "types.h"
+#include "emulator.h"
+#include "cfg/option.h"
+#include "hw/mem/addrspace.h"
+#include "hw/sh4/sh4_mem.h"
+#include "oslib/oslib.h"
+
+#if FEAT_SHREC != DYNAREC_NONE
+#include "hw/sh4/dyna/blockcache.h"
+#include "hw/sh4/dyna/blockmanager.h"
+
+struct CachedBlock : RuntimeBlockInfo
+{
+	u32 Relink() override {
+		return 0;
+	}
+};
+
+class BlockCacheTest : public ::testing::Test {
+protected:
+	static constexpr u32 StartAddr = 0x8c010000;
+	static constexpr const char *GameId = "BLOCKCACHE-TEST";
+
+	void SetUp() override
+	{
+		if (!addrspace::reserve())
+			die("addrspace::reserve failed");
+		// fpcb pages are allocated on first access by the fault handler
+		os_InstallFaultHandler();
+		emu.init();
+		mem_map_default();
+		dc_reset(true);
+		config::DynarecPersistentCache = true;
+		// mov #1, r0; add r0, r1; rts; nop
+		const u16 code[] { 0xE001, 0x310C, 0x000B, 0x0009 };
+		for (size_t i = 0; i < std::size(code); i++)
+			addrspace::write16(StartAddr + i * 2, code[i]);
+	}
+
+	void TearDown() override
+	{
+		blockcache::clear();
+		nowide::remove(cachePath().c_str());
+		config::DynarecPersistentCache.reset();
+		os_UninstallFaultHandler();
+	}
+
+	static std::string cachePath() {
+		return hostfs::getDynarecCachePath(std::string(GameId) + ".dyncache");
+	}
+
+	static void initBlock(CachedBlock& block)
+	{
+		block.addr = StartAddr;
+		block.fpu_cfg.full = 0;
+		block.trace = false;
+	}
+
+	// Records a decoded block and saves the cache file
+	static void saveBlock(bool trace = false)
+	{
+		CachedBlock block;
+		initBlock(block);
+		block.trace = trace;
+		block.sh4_code_size = 8;
+		block.guest_opcodes = 4;
+		block.guest_cycles = 4;
+		block.BlockType = BET_DynamicRet;
+		block.BranchBlock = 0xFFFFFFFF;
+		block.NextBlock = 0xFFFFFFFF;
+		block.has_fpu_op = false;
+		block.has_jcond = false;
+		block.read_only = bm_CanProtect(block.addr, block.sh4_code_size);
+
+		shil_opcode op {};
+		op.op = shop_mov32;
+		op.rd = shil_param(reg_r0);
+		op.rs1 = shil_param(1u);
+		block.oplist.push_back(op);
+		op.op = shop_add;
+		op.rd = shil_param(reg_r1);
+		op.rs1 = shil_param(reg_r1);
+		op.rs2 = shil_param(reg_r0);
+		op.guest_offs = 2;
+		block.oplist.push_back(op);
+
+		blockcache::load(GameId);
+		blockcache::record(&block, std::chrono::milliseconds(1));
+		blockcache::save();
+		blockcache::clear();
+	}
+};
+
+TEST_F(BlockCacheTest, RoundTrip)
+{
+	saveBlock();
+	blockcache::load(GameId);
+	CachedBlock block;
+	initBlock(block);
+	ASSERT_TRUE(blockcache::lookup(&block));
+	ASSERT_EQ(8u, block.sh4_code_size);
+	ASSERT_EQ(4u, block.guest_opcodes);
+	ASSERT_EQ(BET_DynamicRet, block.BlockType);
+	ASSERT_EQ(2u, block.oplist.size());
+	ASSERT_EQ(shop_mov32, block.oplist[0].op);
+	ASSERT_TRUE(block.oplist[0].rs1.is_imm());
+	ASSERT_EQ(1u, block.oplist[0].rs1._imm);
+	ASSERT_EQ(shop_add, block.oplist[1].op);
+	ASSERT_EQ((u32)reg_r1, block.oplist[1].rd._imm);
+	ASSERT_EQ((u32)reg_r0, block.oplist[1].rs2._imm);
+	ASSERT_EQ(2, block.oplist[1].guest_offs);
+	ASSERT_EQ(1u, blockcache::getStats().hits);
+}
+
+TEST_F(BlockCacheTest, GuestCodeChanged)
+{
+	saveBlock();
+	// mov #2, r0
+	addrspace::write16(StartAddr, 0xE002);
+	blockcache::load(GameId);
+	CachedBlock block;
+	initBlock(block);
+	ASSERT_FALSE(blockcache::lookup(&block));
+	ASSERT_EQ(1u, blockcache::getStats().rejected);
+}
+
+TEST_F(BlockCacheTest, TraceNotRecorded)
+{
+	saveBlock(true);
+	blockcache::load(GameId);
+	CachedBlock block;
+	initBlock(block);
+	ASSERT_FALSE(blockcache::lookup(&block));
+	ASSERT_EQ(1u, blockcache::getStats().misses);
+}
+
+TEST_F(BlockCacheTest, OtherBuild)
+{
+	saveBlock();
+	// Overwrite the build id, following the magic and version
+	FILE *f = nowide::fopen(cachePath().c_str(), "r+b");
+	ASSERT_NE(nullptr, f);
+	std::fseek(f, 8, SEEK_SET);
+	const char otherBuild[16] = "0000000";
+	std::fwrite(otherBuild, sizeof(otherBuild), 1, f);
+	std::fclose(f);
+
+	blockcache::load(GameId);
+	CachedBlock block;
+	initBlock(block);
+	ASSERT_FALSE(blockcache::lookup(&block));
+	ASSERT_EQ(0u, blockcache::getStats().rejected);
+	ASSERT_EQ(1u, blockcache::getStats().misses);
+}
+
+#endif // FEAT_SHREC != DYNAREC_NONE
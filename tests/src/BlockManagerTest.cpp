@@ -0,0 +1,269 @@
+/*
+	Copyright 2026 flyinghead
+
+	This file is part of Flycast.
+
+    Flycast is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 2 of the License, or
+    (at your option) any later version.
+
+    Flycast is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Flycast.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#include "gtest/gtest.h"
+#include "types.h"
+#include "hw/mem/addrspace.h"
+#include "emulator.h"
+#include "oslib/oslib.h"
+
+#if FEAT_SHREC != DYNAREC_NONE
+#include "hw/sh4/dyna/blockmanager.h"
+#include <chrono>
+#include <map>
+#include <memory>
+#include <random>
+#include <set>
+
+struct TestBlock : RuntimeBlockInfo
+{
+	u32 Relink() override {
+		return 0;
+	}
+};
+
+class BlockManagerTest : public ::testing::Test {
+protected:
+	static constexpr u32 BlockCount = 16384;
+	static constexpr u32 HostBlockSize = 64;
+	static constexpr u32 StartAddr = 0x8c010000;
+
+	void SetUp() override
+	{
+		if (!addrspace::reserve())
+			die("addrspace::reserve failed");
+		// fpcb pages are allocated on first access by the fault handler
+		os_InstallFaultHandler();
+		emu.init();
+		dc_reset(true);
+		hostCode.resize(BlockCount * HostBlockSize);
+	}
+
+	void TearDown() override
+	{
+		bm_ResetCache();
+		bm_Reset();
+		os_UninstallFaultHandler();
+	}
+
+	TestBlock *addBlock(u32 i, u32 guestSize = 32, bool protect = false)
+	{
+		TestBlock *block = new TestBlock();
+		block->vaddr = block->addr = StartAddr + i * guestSize;
+		block->code = (DynarecCodeEntryPtr)&hostCode[i * HostBlockSize];
+		block->host_code_size = HostBlockSize - 16;
+		block->sh4_code_size = guestSize;
+		block->temp_block = false;
+		block->pNextBlock = nullptr;
+		block->pBranchBlock = nullptr;
+		block->relink_data = 0;
+		if (protect)
+			block->SetProtectedFlags();
+		else
+		{
+			block->read_only = false;
+			block->sh4_code_size = 0;
+		}
+		bm_AddBlock(block);
+		return block;
+	}
+
+	static double elapsedNs(std::chrono::steady_clock::time_point start, u32 count) {
+		return std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count() / count;
+	}
+
+	std::vector<u8> hostCode;
+};
+
+TEST_F(BlockManagerTest, Lookup)
+{
+	std::vector<TestBlock *> blocks;
+	// add blocks out of order
+	for (u32 i = 0; i < BlockCount; i += 2)
+		blocks.push_back(addBlock(i));
+	for (u32 i = 1; i < BlockCount; i += 2)
+		blocks.push_back(addBlock(i));
+
+	for (u32 i = 0; i < BlockCount; i++)
+	{
+		u8 *code = &hostCode[i * HostBlockSize];
+		RuntimeBlockInfo *block = bm_GetBlock(code);
+		ASSERT_NE(nullptr, block);
+		ASSERT_EQ((void *)code, (void *)block->code);
+		ASSERT_EQ(block, bm_GetBlock(code + 10));
+		// gap between blocks
+		ASSERT_EQ(nullptr, bm_GetBlock(code + HostBlockSize - 8));
+		ASSERT_EQ(block, bm_GetBlock(block->addr));
+	}
+	ASSERT_EQ(nullptr, bm_GetBlock(hostCode.data() + hostCode.size()));
+
+	for (u32 i = 0; i < BlockCount; i += 3)
+		bm_DiscardBlock(bm_GetBlock(&hostCode[i * HostBlockSize]));
+	for (u32 i = 0; i < BlockCount; i++)
+	{
+		RuntimeBlockInfo *block = bm_GetBlock(&hostCode[i * HostBlockSize + 4]);
+		if (i % 3 == 0)
+		{
+			ASSERT_EQ(nullptr, block);
+			ASSERT_NE(nullptr, bm_GetStaleBlock(&hostCode[i * HostBlockSize + 4]));
+		}
+		else {
+			ASSERT_NE(nullptr, block);
+		}
+	}
+}
+
+TEST_F(BlockManagerTest, Invalidate)
+{
+	// 2 blocks per page, the second one spanning 2 pages
+	constexpr u32 guestSize = PAGE_SIZE / 2 + 16;
+	constexpr u32 count = 512;
+	for (u32 i = 0; i < count; i++)
+		addBlock(i, guestSize, true);
+	for (u32 i = 0; i < count; i++)
+		ASSERT_TRUE(bm_GetBlock(&hostCode[i * HostBlockSize])->read_only);
+
+	u32 page = (StartAddr & RAM_MASK) + 5 * PAGE_SIZE;
+	bm_RamWriteAccess(page);
+	ASSERT_FALSE(bm_IsRamPageProtected(page));
+	for (u32 i = 0; i < count; i++)
+	{
+		u32 addr = StartAddr + i * guestSize;
+		bool overlaps = (addr & RAM_MASK) < page + PAGE_SIZE && (addr & RAM_MASK) + guestSize > page;
+		ASSERT_EQ(overlaps, bm_GetBlock(&hostCode[i * HostBlockSize]) == nullptr) << "block " << i;
+	}
+	// remaining blocks are still linked in their pages
+	bm_RamWriteAccess((StartAddr & RAM_MASK) + 6 * PAGE_SIZE);
+	for (u32 i = 0; i < count; i++)
+	{
+		u32 addr = (StartAddr + i * guestSize) & RAM_MASK;
+		if (addr + guestSize > page && addr < page + 2 * PAGE_SIZE) {
+			ASSERT_EQ(nullptr, bm_GetBlock(&hostCode[i * HostBlockSize]));
+		}
+	}
+}
+
+// Code of discarded temp blocks is reused by new blocks
+TEST_F(BlockManagerTest, CodeReuse)
+{
+	TestBlock *first = addBlock(0);
+	TestBlock *second = addBlock(1);
+	bm_DiscardBlock(first);
+	bm_DiscardBlock(second);
+
+	// same code address as a discarded block
+	TestBlock *block = addBlock(0);
+	ASSERT_EQ(block, bm_GetBlock(&hostCode[10]));
+	bm_DiscardBlock(block);
+
+	// code overlapping 2 discarded blocks
+	block = new TestBlock();
+	block->vaddr = block->addr = StartAddr;
+	block->code = (DynarecCodeEntryPtr)&hostCode[8];
+	block->host_code_size = HostBlockSize * 2;
+	block->sh4_code_size = 0;
+	block->temp_block = false;
+	block->read_only = false;
+	block->pNextBlock = nullptr;
+	block->pBranchBlock = nullptr;
+	block->relink_data = 0;
+	bm_AddBlock(block);
+	ASSERT_EQ(nullptr, bm_GetBlock(&hostCode[4]));
+	ASSERT_EQ(block, bm_GetBlock(&hostCode[8]));
+	ASSERT_EQ(block, bm_GetBlock(&hostCode[HostBlockSize + 4]));
+	ASSERT_EQ(block, bm_GetBlock(&hostCode[HostBlockSize * 2 + 4]));
+	ASSERT_EQ(nullptr, bm_GetBlock(&hostCode[HostBlockSize * 2 + 8]));
+}
+
+// Compares lookup and invalidation throughput with std::map/std::set based indexes
+TEST_F(BlockManagerTest, DISABLED_Benchmark)
+{
+	struct RefBlock {
+		u8 *code;
+		u32 size;
+	};
+	std::map<void *, std::shared_ptr<RefBlock>> refMap;
+	for (u32 i = 0; i < BlockCount; i++)
+	{
+		addBlock(i);
+		auto ref = std::make_shared<RefBlock>();
+		ref->code = &hostCode[i * HostBlockSize];
+		ref->size = HostBlockSize - 16;
+		refMap[ref->code] = ref;
+	}
+	constexpr u32 lookups = 1000000;
+	std::mt19937 random(42);
+	std::vector<u8 *> pointers(lookups);
+	for (u8 *& p : pointers)
+		p = &hostCode[random() % hostCode.size()];
+
+	u32 found = 0;
+	auto start = std::chrono::steady_clock::now();
+	for (u8 *p : pointers)
+		found += bm_GetBlock(p) != nullptr;
+	double flatLookup = elapsedNs(start, lookups);
+
+	u32 refFound = 0;
+	start = std::chrono::steady_clock::now();
+	for (u8 *p : pointers)
+	{
+		auto it = refMap.upper_bound(p);
+		if (it != refMap.begin())
+		{
+			--it;
+			refFound += (u32)(p - it->second->code) < it->second->size;
+		}
+	}
+	double mapLookup = elapsedNs(start, lookups);
+	ASSERT_EQ(refFound, found);
+
+	bm_ResetCache();
+	bm_Periodical_1s();
+
+	// discard of 4 protected blocks per page, without the page unlocking
+	constexpr u32 guestSize = PAGE_SIZE / 4;
+	constexpr u32 pages = 1024;
+	std::vector<TestBlock *> blocks;
+	for (u32 i = 0; i < pages * 4; i++)
+		blocks.push_back(addBlock(i, guestSize, true));
+	start = std::chrono::steady_clock::now();
+	for (TestBlock *block : blocks)
+		bm_DiscardBlock(block);
+	double flatDiscard = elapsedNs(start, pages * 4);
+	bm_Periodical_1s();
+
+	std::vector<std::set<RefBlock *>> refPages(pages);
+	for (u32 i = 0; i < pages * 4; i++)
+		refPages[i / 4].insert(refMap[&hostCode[i * HostBlockSize]].get());
+	start = std::chrono::steady_clock::now();
+	for (auto& blockSet : refPages)
+	{
+		std::vector<RefBlock *> copy(blockSet.begin(), blockSet.end());
+		for (RefBlock *block : copy)
+		{
+			blockSet.erase(block);
+			refMap.erase(block->code);
+		}
+	}
+	double setDiscard = elapsedNs(start, pages * 4);
+
+	printf("Block lookup: %.1f ns (std::map: %.1f ns)\n", flatLookup, mapLookup);
+	printf("Block discard: %.1f ns (std::map + std::set: %.1f ns)\n", flatDiscard, setDiscard);
+}
+
+#endif // FEAT_SHREC != DYNAREC_NONE
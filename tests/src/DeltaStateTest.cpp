@@ -0,0 +1,179 @@
+/*
+	Copyright 2026 flyinghead
+
+	This file is part of Flycast.
+
+    Flycast is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 2 of the License, or
+    (at your option) any later version.
+
+    Flycast is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Flycast.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#include "gtest/gtest.h"
+#include "types.h"
+#include "deltastate.h"
+#include "archive/rzip.h"
+#include <cstdio>
+#include <random>
+
+class DeltaStateTest : public ::testing::Test {
+protected:
+	void SetUp() override
+	{
+		state.resize(100 * deltastate::PageSize + 123);
+		for (u8& b : state)
+			b = random();
+	}
+
+	void TearDown() override {
+		std::remove(Path);
+	}
+
+	// Modifies a few bytes of the state
+	void modify(int count)
+	{
+		for (int i = 0; i < count; i++)
+			state[random() % state.size()]++;
+	}
+
+	std::vector<u8> readFile()
+	{
+		RZipFile zipFile;
+		if (!zipFile.Open(Path, false))
+			return {};
+		std::vector<u8> data(zipFile.Size());
+		data.resize(zipFile.Read(data.data(), data.size()));
+		return data;
+	}
+
+	void save()
+	{
+		std::vector<u8> copy = state;
+		std::unique_ptr<RZipParallelWriter> writer = chain.save(Path, copy);
+		ASSERT_NE(nullptr, writer);
+		writer->Close();
+		writer->Wait();
+	}
+
+	static constexpr const char *Path = "deltastate_test.state";
+	std::vector<u8> state;
+	std::mt19937 random{ 42 };
+	deltastate::Chain chain;
+};
+
+TEST_F(DeltaStateTest, Delta)
+{
+	std::vector<u8> previous = state;
+	modify(3);
+	state.resize(state.size() + 5000);
+	std::vector<u8> record;
+	deltastate::makeDelta(previous, state, record);
+	ASSERT_GE(5u * deltastate::PageSize + 1000, record.size());
+
+	const u8 *p = record.data();
+	deltastate::Record header;
+	ASSERT_TRUE(deltastate::apply(p, record.data() + record.size(), previous, &header));
+	ASSERT_EQ(record.data() + record.size(), p);
+	ASSERT_EQ(deltastate::Delta, header.type);
+	ASSERT_TRUE(state == previous);
+
+	// shrink
+	state.resize(10 * deltastate::PageSize + 1);
+	deltastate::makeDelta(previous, state, record);
+	ASSERT_EQ(0u, ((deltastate::Record *)record.data())->pageCount);
+	p = record.data();
+	ASSERT_TRUE(deltastate::apply(p, record.data() + record.size(), previous));
+	ASSERT_TRUE(state == previous);
+}
+
+TEST_F(DeltaStateTest, Chain)
+{
+	save();
+	ASSERT_EQ(0u, chain.getInfo().deltas);
+	for (int i = 1; i <= 10; i++)
+	{
+		modify(2);
+		save();
+		ASSERT_EQ((u32)i, chain.getInfo().deltas);
+	}
+	std::vector<u8> data = readFile();
+	ASSERT_TRUE(deltastate::isDeltaState(data.data(), data.size()));
+	ASSERT_EQ(chain.getInfo().size, data.size());
+	std::vector<u8> restored;
+	deltastate::Info info;
+	ASSERT_TRUE(deltastate::restore(data.data(), data.size(), restored, &info));
+	ASSERT_TRUE(state == restored);
+	ASSERT_EQ(10u, info.deltas);
+	ASSERT_EQ(chain.getInfo().deltaSize, info.deltaSize);
+	// Much smaller than 10 full states
+	ASSERT_GT(state.size() * 2, data.size());
+
+	// Compaction
+	modify(1000);
+	save();
+	ASSERT_EQ(0u, chain.getInfo().deltas);
+	data = readFile();
+	ASSERT_EQ(state.size() + sizeof(deltastate::Record), data.size());
+	ASSERT_TRUE(deltastate::restore(data.data(), data.size(), restored));
+	ASSERT_TRUE(state == restored);
+}
+
+TEST_F(DeltaStateTest, Loaded)
+{
+	save();
+	modify(10);
+	save();
+	std::vector<u8> data = readFile();
+	std::vector<u8> restored;
+	deltastate::Info info;
+	ASSERT_TRUE(deltastate::restore(data.data(), data.size(), restored, &info));
+
+	deltastate::Chain other;
+	other.loaded(Path, restored, info);
+	std::swap(chain, other);
+	modify(10);
+	save();
+	ASSERT_EQ(2u, chain.getInfo().deltas);
+	data = readFile();
+	ASSERT_TRUE(deltastate::restore(data.data(), data.size(), restored));
+	ASSERT_TRUE(state == restored);
+}
+
+TEST_F(DeltaStateTest, Corrupted)
+{
+	save();
+	modify(10);
+	save();
+	std::vector<u8> data = readFile();
+	std::vector<u8> restored;
+	data[data.size() - 10]++;
+	ASSERT_FALSE(deltastate::restore(data.data(), data.size(), restored));
+	data.resize(data.size() - 20);
+	ASSERT_FALSE(deltastate::restore(data.data(), data.size(), restored));
+	ASSERT_FALSE(deltastate::isDeltaState(state.data(), state.size()));
+}
+
+TEST_F(DeltaStateTest, ModifiedFile)
+{
+	save();
+	// Overwritten by a full savestate
+	{
+		RZipFile zipFile;
+		ASSERT_TRUE(zipFile.Open(Path, true));
+		zipFile.Write(state.data(), 1000);
+	}
+	modify(10);
+	save();
+	ASSERT_EQ(0u, chain.getInfo().deltas);
+	std::vector<u8> data = readFile();
+	std::vector<u8> restored;
+	ASSERT_TRUE(deltastate::restore(data.data(), data.size(), restored));
+	ASSERT_TRUE(state == restored);
+}
@@ -0,0 +1,128 @@
+/*
+	Copyright 2026 flyinghead
+
+	This file is part of Flycast.
+
+    Flycast is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 2 of the License, or
+    (at your option) any later version.
+
+    Flycast is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Flycast.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#include "gtest/gtest.h"
+#include "types.h"
+#include "hw/naomi/gdcartridge.h"
+#include "oslib/oslib.h"
+#include "stdclass.h"
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <random>
+#include <vector>
+
+// Gives access to the decrypted data cache
+class TestGDCartridge : public GDCartridge
+{
+public:
+	TestGDCartridge() : GDCartridge(0) {
+		SetGDRomName("dimmcache_test", nullptr);
+	}
+
+	// Sets the encrypted data read from the GD-ROM
+	void setData(const std::vector<u8>& data)
+	{
+		if (dimm_data == nullptr)
+			dimm_data = (u8 *)malloc(data.size());
+		dimm_data_size = (u32)data.size();
+		memcpy(dimm_data, data.data(), data.size());
+	}
+
+	// Fake decryption then save
+	void decryptAndSave(u64 key)
+	{
+		const u64 hash = hashEncryptedData(key, dimm_data_size);
+		for (u32 i = 0; i < dimm_data_size; i++)
+			dimm_data[i] ^= 0x5a;
+		saveDimmCache(key, hash, FileStart, dimm_data_size);
+	}
+
+	bool load(u64 key) {
+		return loadDimmCache(key, hashEncryptedData(key, dimm_data_size), FileStart, dimm_data_size);
+	}
+
+	std::vector<u8> getData() const {
+		return std::vector<u8>(dimm_data, dimm_data + dimm_data_size);
+	}
+
+	static constexpr u32 FileStart = 1234;
+};
+
+class DimmCacheTest : public ::testing::Test {
+protected:
+	void SetUp() override
+	{
+		// cache files are written in the data directory
+		dataDir = std::filesystem::temp_directory_path() / ("flycast-dimmcache-" + std::to_string(std::random_device()()));
+		std::filesystem::create_directories(dataDir);
+		previousDataDir = get_writable_data_path("");
+		set_user_data_dir(dataDir.string() + "/");
+
+		std::mt19937 random(42);
+		encrypted.resize(64 * 2048);
+		for (u8& b : encrypted)
+			b = (u8)random();
+		decrypted = encrypted;
+		for (u8& b : decrypted)
+			b ^= 0x5a;
+		TestGDCartridge cart;
+		cart.setData(encrypted);
+		cart.decryptAndSave(Key);
+	}
+
+	void TearDown() override
+	{
+		set_user_data_dir(previousDataDir);
+		std::error_code ec;
+		std::filesystem::remove_all(dataDir, ec);
+	}
+
+	static constexpr u64 Key = 0x0123456789abcdefull;
+	std::vector<u8> encrypted;
+	std::vector<u8> decrypted;
+	std::filesystem::path dataDir;
+	std::string previousDataDir;
+};
+
+TEST_F(DimmCacheTest, Hit)
+{
+	TestGDCartridge cart;
+	cart.setData(encrypted);
+	ASSERT_TRUE(cart.load(Key));
+	ASSERT_TRUE(cart.getData() == decrypted);
+}
+
+// Any change to the encrypted data invalidates the cache, not only in the first and last sectors
+TEST_F(DimmCacheTest, DataChanged)
+{
+	std::vector<u8> updated = encrypted;
+	updated[32 * 2048 + 100]++;
+	TestGDCartridge cart;
+	cart.setData(updated);
+	ASSERT_FALSE(cart.load(Key));
+	ASSERT_TRUE(cart.getData() == updated);
+}
+
+TEST_F(DimmCacheTest, OtherKey)
+{
+	TestGDCartridge cart;
+	cart.setData(encrypted);
+	ASSERT_FALSE(cart.load(Key + 1));
+	ASSERT_TRUE(cart.getData() == encrypted);
+}
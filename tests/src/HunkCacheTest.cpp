@@ -0,0 +1,199 @@
+/*
+	Copyright 2026 flyinghead
+
+	This file is part of Flycast.
+
+    Flycast is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 2 of the License, or
+    (at your option) any later version.
+
+    Flycast is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Flycast.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#include "gtest/gtest.h"
+#include "types.h"
+#include "imgread/hunkcache.h"
+#include <zlib.h>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <random>
+
+class HunkCacheTest : public ::testing::Test {
+protected:
+	static constexpr u32 SectorSize = 2352 + 96;
+	static constexpr u32 SectorsPerHunk = 8;
+	static constexpr u32 HunkBytes = SectorSize * SectorsPerHunk;
+
+	// Fills the hunk with its number
+	HunkCache::Reader reader(u32 failingHunk = ~0u)
+	{
+		return [this, failingHunk](u32 hunk, u8 *dest) {
+			reads++;
+			if (hunk == failingHunk)
+				return false;
+			memset(dest, (u8)hunk, HunkBytes);
+			return true;
+		};
+	}
+
+	u8 readByte(HunkCache& cache, u32 hunk)
+	{
+		u8 b = 0xff;
+		EXPECT_TRUE(cache.read(hunk, 123, &b, 1));
+		return b;
+	}
+
+	std::atomic<int> reads { 0 };
+};
+
+TEST_F(HunkCacheTest, LeastRecentlyUsed)
+{
+	HunkCache cache(HunkBytes, 100, { reader() }, 8);
+	for (u32 hunk = 10; hunk < 18; hunk += 2)
+		ASSERT_EQ(hunk, readByte(cache, hunk));
+	ASSERT_EQ(4, reads);
+	ASSERT_EQ(10, readByte(cache, 10));
+	ASSERT_EQ(4, reads);
+	for (u32 hunk = 20; hunk < 25; hunk++)
+		readByte(cache, hunk);
+	ASSERT_EQ(9, reads);
+	// 12 has been evicted but not 10
+	readByte(cache, 10);
+	ASSERT_EQ(9, reads);
+	readByte(cache, 12);
+	ASSERT_EQ(10, reads);
+
+	HunkCache::Stats stats = cache.getStats();
+	ASSERT_EQ(2u, stats.hits);
+	ASSERT_EQ(10u, stats.misses);
+	ASSERT_EQ(0u, stats.prefetchHits);
+}
+
+TEST_F(HunkCacheTest, ReadAhead)
+{
+	HunkCache cache(HunkBytes, 100, { reader(), reader(), reader() });
+	for (u32 hunk = 0; hunk < 4; hunk++)
+		ASSERT_EQ(hunk, readByte(cache, hunk));
+	// Let the workers decode the next hunks
+	std::this_thread::sleep_for(std::chrono::milliseconds(100));
+	for (u32 hunk = 4; hunk < 8; hunk++)
+		ASSERT_EQ(hunk, readByte(cache, hunk));
+	HunkCache::Stats stats = cache.getStats();
+	ASSERT_LE(4u, stats.prefetchHits);
+
+	// Read-ahead doesn't go past the last hunk
+	for (u32 hunk = 90; hunk < 100; hunk++)
+		ASSERT_EQ(hunk, readByte(cache, hunk));
+	u8 b;
+	ASSERT_FALSE(cache.read(100, 0, &b, 1));
+	ASSERT_FALSE(cache.read(99, HunkBytes - 1, &b, 2));
+}
+
+TEST_F(HunkCacheTest, Errors)
+{
+	HunkCache cache(HunkBytes, 100, { reader(5), reader(5) });
+	u8 b;
+	for (u32 hunk = 0; hunk < 5; hunk++)
+		ASSERT_TRUE(cache.read(hunk, 0, &b, 1));
+	ASSERT_FALSE(cache.read(5, 0, &b, 1));
+	ASSERT_FALSE(cache.read(5, 0, &b, 1));
+	ASSERT_EQ(6, readByte(cache, 6));
+}
+
+// Replays GD-ROM access patterns with zlib-compressed hunks, with and without the cache
+TEST_F(HunkCacheTest, DISABLED_Benchmark)
+{
+	constexpr u32 HunkCount = 600;
+	std::mt19937 random(42);
+	std::vector<std::vector<u8>> hunks(HunkCount);
+	std::vector<u8> data(HunkBytes);
+	for (std::vector<u8>& hunk : hunks)
+	{
+		for (u32 i = 0; i < HunkBytes; i++)
+			data[i] = (u8)((i * i) >> 9) ^ (random() & 7);
+		uLongf size = compressBound(HunkBytes);
+		hunk.resize(size);
+		compress2(hunk.data(), &size, data.data(), HunkBytes, Z_BEST_COMPRESSION);
+		hunk.resize(size);
+	}
+	auto inflate = [&hunks](u32 hunk, u8 *dest) {
+		uLongf size = HunkBytes;
+		return uncompress(dest, &size, hunks[hunk].data(), hunks[hunk].size()) == Z_OK;
+	};
+
+	// Sector traces
+	std::vector<std::pair<const char *, std::vector<u32>>> traces;
+	std::vector<u32> trace;
+	// Movie streaming
+	for (u32 fad = 0; fad < HunkCount * SectorsPerHunk; fad++)
+		trace.push_back(fad);
+	traces.emplace_back("stream", trace);
+	// Audio track and data read alternately
+	trace.clear();
+	for (u32 fad = 0; fad < HunkCount * SectorsPerHunk / 2; fad += 16)
+		for (u32 i = 0; i < 16; i++)
+		{
+			trace.push_back(fad + i);
+			trace.push_back(HunkCount * SectorsPerHunk / 2 + fad + i);
+		}
+	traces.emplace_back("interleaved", trace);
+	// Random loads of 1 to 32 sectors
+	trace.clear();
+	while (trace.size() < HunkCount * SectorsPerHunk)
+	{
+		u32 fad = random() % (HunkCount * SectorsPerHunk - 32);
+		u32 count = random() % 32 + 1;
+		for (u32 i = 0; i < count; i++)
+			trace.push_back(fad + i);
+	}
+	traces.emplace_back("random", trace);
+
+	using clock = std::chrono::steady_clock;
+	// Emulation time between two sector reads
+	auto emulate = []() {
+		auto end = clock::now() + std::chrono::microseconds(20);
+		while (clock::now() < end)
+			;
+	};
+	u8 sector[SectorSize];
+	for (const auto& trace : traces)
+	{
+		// Single hunk, decompressed synchronously
+		auto start = clock::now();
+		u32 lastHunk = ~0u;
+		for (u32 fad : trace.second)
+		{
+			u32 hunk = fad / SectorsPerHunk;
+			if (hunk != lastHunk)
+			{
+				ASSERT_TRUE(inflate(hunk, data.data()));
+				lastHunk = hunk;
+			}
+			memcpy(sector, &data[(fad % SectorsPerHunk) * SectorSize], SectorSize);
+			emulate();
+		}
+		double single = std::chrono::duration<double, std::milli>(clock::now() - start).count();
+
+		// Same number of workers as CHD discs
+		std::vector<HunkCache::Reader> readers(1 + std::min(std::max(std::thread::hardware_concurrency(), 2u) - 1, 2u), inflate);
+		HunkCache cache(HunkBytes, HunkCount, readers);
+		start = clock::now();
+		for (u32 fad : trace.second)
+		{
+			ASSERT_TRUE(cache.read(fad / SectorsPerHunk, (fad % SectorsPerHunk) * SectorSize, sector, SectorSize));
+			emulate();
+		}
+		double cached = std::chrono::duration<double, std::milli>(clock::now() - start).count();
+		HunkCache::Stats stats = cache.getStats();
+		printf("%-12s %d sectors  single hunk %.1f ms  cache %.1f ms with %d workers  (%d hits, %d read ahead, %d misses, %d waits)\n",
+				trace.first, (int)trace.second.size(), single, cached, (int)readers.size() - 1, (int)stats.hits, (int)stats.prefetchHits,
+				(int)stats.misses, (int)stats.waits);
+	}
+}
@@ -0,0 +1,228 @@
+/*
+	Copyright 2026 flyinghead
+
+	This file is part of Flycast.
+
+    Flycast is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 2 of the License, or
+    (at your option) any later version.
+
+    Flycast is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Flycast.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#include "gtest/gtest.h"
+#include "types.h"
+#include "emulator.h"
+#include "cfg/option.h"
+#include "hw/mem/addrspace.h"
+#include "hw/sh4/sh4_if.h"
+#include "hw/sh4/sh4_mem.h"
+#include "hw/sh4/sh4_sched.h"
+#include "hw/sh4/modules/mmu.h"
+#include "oslib/oslib.h"
+#include <chrono>
+
+#if FEAT_SHREC != DYNAREC_NONE
+
+// Runs guest code accessing translated RAM with and without the host mirror of the guest virtual memory
+class MmuMirrorTest : public ::testing::Test {
+protected:
+	static constexpr u32 START_PC = 0x8c010000;
+	static constexpr u32 DATA_VADDR = 0x00100000;
+	static constexpr u32 DATA_PADDR = 0x0c200000;
+
+	void SetUp() override
+	{
+		if (!addrspace::reserve())
+			die("addrspace::reserve failed");
+		// Handles fpcb and host mirror faults
+		os_InstallFaultHandler();
+		emu.init();
+		mem_map_default();
+		dc_reset(true);
+		ctx = &p_sh4rcb->cntx;
+	}
+
+	void TearDown() override
+	{
+		config::DynarecMmuMirror.reset();
+		CCN_MMUCR.AT = 0;
+		MMU_reset();
+		os_UninstallFaultHandler();
+	}
+
+	void LoadProgram(const std::vector<u16>& code)
+	{
+		for (size_t i = 0; i < code.size(); i++)
+			addrspace::write16(START_PC + i * 2, code[i]);
+	}
+
+	static void EnableMmu()
+	{
+		// Full MMU emulation is only enabled for Windows CE
+		static const char magic[] = { 'S', 0, 'H', 0, '-', 0, '4', 0, ' ', 0, 'K', 0, 'e', 0, 'r', 0, 'n', 0, 'e', 0, 'l', 0 };
+		memcpy(GetMemPtr(0x8c0110a8, sizeof(magic)), magic, sizeof(magic));
+		CCN_MMUCR.AT = 1;
+		MMU_reset();
+		ASSERT_TRUE(mmu_enabled());
+
+		SetTlbEntry(0, DATA_VADDR, DATA_PADDR, 0, false);
+	}
+
+	// Maps a 4K page
+	static void SetTlbEntry(u32 index, u32 vaddr, u32 paddr, u32 asid, bool shared)
+	{
+		UTLB[index].Address.VPN = vaddr >> 10;
+		UTLB[index].Address.ASID = asid;
+		UTLB[index].Data.SZ0 = 1;
+		UTLB[index].Data.V = 1;
+		UTLB[index].Data.PR = 3;
+		UTLB[index].Data.D = 1;
+		UTLB[index].Data.SH = shared;
+		UTLB[index].Data.PPN = paddr >> 10;
+		UTLB_Sync(index);
+	}
+
+	static int stopCpu(int tag, int cycles, int jitter)
+	{
+		p_sh4rcb->cntx.CpuRunning = 0;
+		return 0;
+	}
+
+	// Runs the program for the given number of cycles. Returns the duration in seconds.
+	double RunDynarec(bool mirror, int cycles)
+	{
+		config::DynarecMmuMirror = mirror;
+		for (u32 i = 0; i < 4; i++)
+			addrspace::write32(DATA_PADDR + i * 4, 0);
+		for (int i = 0; i < 16; i++)
+			ctx->r[i] = 0;
+		sh4_sr_SetFull(0x700000F0);
+		ctx->pc = START_PC;
+
+		sh4_if sh4;
+		Get_Sh4Recompiler(&sh4);
+		sh4.ResetCache();
+		int schedId = sh4_sched_register(0, &stopCpu);
+		sh4_sched_request(schedId, cycles);
+		auto start = std::chrono::steady_clock::now();
+		sh4.Run();
+		const double duration = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+		sh4_sched_unregister(schedId);
+
+		return duration;
+	}
+
+	Sh4Context *ctx = nullptr;
+};
+
+TEST_F(MmuMirrorTest, DISABLED_Benchmark)
+{
+	LoadProgram({
+		0xE110,	// mov #16, r1
+		0x4128,	// shll16 r1
+		0xE000,	// mov #0, r0
+		// loop:
+		0x6212,	// mov.l @r1, r2
+		0x7201,	// add #1, r2
+		0x2122,	// mov.l r2, @r1
+		0x5311,	// mov.l @(4, r1), r3
+		0x1132,	// mov.l r3, @(8, r1)
+		0x7001,	// add #1, r0
+		0xAFF8,	// bra loop
+		0x0009,	// nop
+	});
+	EnableMmu();
+	constexpr int cycles = 20'000'000;
+	constexpr int memOpsPerLoop = 4;
+
+	const double duration = RunDynarec(false, cycles);
+	const u32 loops = ctx->r[0];
+	ASSERT_NE(0u, loops);
+	ASSERT_EQ(loops, addrspace::read32(DATA_PADDR));
+
+	const double mirrorDuration = RunDynarec(true, cycles);
+	ASSERT_EQ(ctx->r[0], addrspace::read32(DATA_PADDR));
+	// Mapping the pages on the first accesses can cost a few cycles
+	ASSERT_NEAR(loops, ctx->r[0], 2);
+
+	printf("LUT lookup %.1f Mops/s  host mirror %.1f Mops/s\n",
+			loops * memOpsPerLoop / duration / 1e6, loops * memOpsPerLoop / mirrorDuration / 1e6);
+}
+
+// The same virtual page is mapped to a different physical page for each ASID
+TEST_F(MmuMirrorTest, AsidSwitch)
+{
+	LoadProgram({
+		0xE120,	// mov #32, r1
+		0x4128,	// shll16 r1
+		0xE4FF,	// mov #-1, r4
+		0x4428,	// shll16 r4
+		0x4418,	// shll8 r4
+		0xE601,	// mov #1, r6
+		0xE211,	// mov #0x11, r2
+		0x2122,	// mov.l r2, @r1
+		0x2462,	// mov.l r6, @r4		PTEH.ASID = 1
+		0xE222,	// mov #0x22, r2
+		0x2122,	// mov.l r2, @r1
+		0xE600,	// mov #0, r6
+		0x2462,	// mov.l r6, @r4		PTEH.ASID = 0
+		0x6312,	// mov.l @r1, r3
+		0xAFFE,	// bra .
+		0x0009,	// nop
+	});
+	EnableMmu();
+	SetTlbEntry(1, 0x00200000, 0x0c300000, 0, false);
+	SetTlbEntry(2, 0x00200000, 0x0c310000, 1, false);
+
+	RunDynarec(true, 1000);
+	ASSERT_EQ(0x11u, addrspace::read32(0x0c300000));
+	ASSERT_EQ(0x22u, addrspace::read32(0x0c310000));
+	ASSERT_EQ(0x11u, ctx->r[3]);
+}
+
+// Shared pages aren't affected by ASID changes
+TEST_F(MmuMirrorTest, DISABLED_AsidBenchmark)
+{
+	LoadProgram({
+		0xE110,	// mov #16, r1
+		0x4128,	// shll16 r1
+		0xE4FF,	// mov #-1, r4
+		0x4428,	// shll16 r4
+		0x4418,	// shll8 r4
+		0xE000,	// mov #0, r0
+		0xE600,	// mov #0, r6
+		0xE701,	// mov #1, r7
+		// loop:
+		0x6212,	// mov.l @r1, r2
+		0x7201,	// add #1, r2
+		0x2122,	// mov.l r2, @r1
+		0x267A,	// xor r7, r6
+		0x2462,	// mov.l r6, @r4		PTEH.ASID ^= 1
+		0x7001,	// add #1, r0
+		0xAFF8,	// bra loop
+		0x0009,	// nop
+	});
+	EnableMmu();
+	SetTlbEntry(0, DATA_VADDR, DATA_PADDR, 0, true);
+	constexpr int cycles = 20'000'000;
+
+	const double duration = RunDynarec(false, cycles);
+	const u32 loops = ctx->r[0];
+	ASSERT_NE(0u, loops);
+	ASSERT_EQ(loops, addrspace::read32(DATA_PADDR));
+
+	const double mirrorDuration = RunDynarec(true, cycles);
+	ASSERT_EQ(ctx->r[0], addrspace::read32(DATA_PADDR));
+
+	printf("LUT lookup %.1f Mloops/s  host mirror %.1f Mloops/s\n",
+			loops / duration / 1e6, ctx->r[0] / mirrorDuration / 1e6);
+}
+
+#endif // FEAT_SHREC != DYNAREC_NONE
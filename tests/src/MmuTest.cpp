@@ -156,6 +156,115 @@ TEST_F(MmuTest, TestMiss)
 	ASSERT_EQ(MmuError::TLB_MISS, err);
 }
 
+TEST_F(MmuTest, TestInstructionCache)
+{
+	u32 pa;
+	UTLB[0].Address.VPN = 0x02000000 >> 10;
+	UTLB[0].Data.SZ0 = 1;
+	UTLB[0].Data.V = 1;
+	UTLB[0].Data.PR = 3;
+	UTLB[0].Data.D = 1;
+	UTLB[0].Data.PPN = 0x0C000000 >> 10;
+	UTLB_Sync(0);
+#if !defined(NDEBUG) || defined(DEBUGFAST)
+	const MmuDispatchStats stats = mmuDispatchStats;
+#endif
+	MmuError err = mmu_cached_instruction_translation(0x02000046, pa);
+	ASSERT_EQ(MmuError::NONE, err);
+	ASSERT_EQ(0x0C000046u, pa);
+	// same 1K page
+	err = mmu_cached_instruction_translation(0x02000102, pa);
+	ASSERT_EQ(MmuError::NONE, err);
+	ASSERT_EQ(0x0C000102u, pa);
+#if !defined(NDEBUG) || defined(DEBUGFAST)
+	ASSERT_EQ(stats.hits + 1, mmuDispatchStats.hits);
+	ASSERT_EQ(stats.misses + 1, mmuDispatchStats.misses);
+	ASSERT_EQ(stats.translations + 1, mmuDispatchStats.translations);
+#endif
+
+	// other ASID
+	CCN_PTEH.ASID = 1;
+	err = mmu_cached_instruction_translation(0x02000046, pa);
+	ASSERT_EQ(MmuError::TLB_MISS, err);
+	// the translation is still cached when switching back
+	CCN_PTEH.ASID = 0;
+	err = mmu_cached_instruction_translation(0x02000046, pa);
+	ASSERT_EQ(MmuError::NONE, err);
+	ASSERT_EQ(0x0C000046u, pa);
+#if !defined(NDEBUG) || defined(DEBUGFAST)
+	ASSERT_EQ(stats.hits + 2, mmuDispatchStats.hits);
+#endif
+
+	// remapped page. The ITLB still has a copy of the old entry.
+	UTLB[0].Data.PPN = 0x0C100000 >> 10;
+	UTLB_Sync(0);
+	for (u32 i = 0; i < std::size(ITLB); i++)
+	{
+		ITLB[i].Data.V = 0;
+		ITLB_Sync(i);
+	}
+	err = mmu_cached_instruction_translation(0x02000046, pa);
+	ASSERT_EQ(MmuError::NONE, err);
+	ASSERT_EQ(0x0C100046u, pa);
+
+	// not translated
+	err = mmu_cached_instruction_translation(0x8C000046, pa);
+	ASSERT_EQ(MmuError::NONE, err);
+	ASSERT_EQ(0x8C000046u, pa);
+#if !defined(NDEBUG) || defined(DEBUGFAST)
+	ASSERT_EQ(stats.hits + 2, mmuDispatchStats.hits);
+	ASSERT_EQ(stats.misses + 3, mmuDispatchStats.misses);
+	ASSERT_EQ(stats.translations + 4, mmuDispatchStats.translations);
+#endif
+
+	// flush
+	mmu_flush_table();
+	err = mmu_cached_instruction_translation(0x02000046, pa);
+#if !defined(NDEBUG) || defined(DEBUGFAST)
+	ASSERT_EQ(stats.misses + 4, mmuDispatchStats.misses);
+#endif
+}
+
+// Replacing a TLB entry only invalidates the cached translations of its ranges
+TEST_F(MmuTest, TestInstructionCacheSync)
+{
+	u32 pa;
+	for (u32 i = 0; i < 2; i++)
+	{
+		UTLB[i].Address.VPN = (0x02000000 + i * 0x100000) >> 10;
+		UTLB[i].Data.SZ0 = 1;
+		UTLB[i].Data.V = 1;
+		UTLB[i].Data.PR = 3;
+		UTLB[i].Data.D = 1;
+		UTLB[i].Data.PPN = (0x0C000000 + i * 0x100000) >> 10;
+		UTLB_Sync(i);
+	}
+	MmuError err = mmu_cached_instruction_translation(0x02000046, pa);
+	ASSERT_EQ(MmuError::NONE, err);
+	err = mmu_cached_instruction_translation(0x02100046, pa);
+	ASSERT_EQ(MmuError::NONE, err);
+	ASSERT_EQ(0x0C100046u, pa);
+
+	// not synced so only the cache can translate to the old addresses
+	UTLB[0].Data.PPN = 0x0C200000 >> 10;
+	for (TLB_Entry& entry : ITLB)
+		entry.Data.V = 0;
+	// the second entry now maps another page
+	UTLB[1].Address.VPN = 0x02300000 >> 10;
+	UTLB_Sync(1);
+	err = mmu_cached_instruction_translation(0x02000046, pa);
+	ASSERT_EQ(MmuError::NONE, err);
+	ASSERT_EQ(0x0C000046u, pa);
+	err = mmu_cached_instruction_translation(0x02300046, pa);
+	ASSERT_EQ(MmuError::NONE, err);
+	ASSERT_EQ(0x0C100046u, pa);
+#ifndef FAST_MMU
+	// translations of the replaced range are gone
+	err = mmu_cached_instruction_translation(0x02100046, pa);
+	ASSERT_EQ(MmuError::TLB_MISS, err);
+#endif
+}
+
 TEST_F(MmuTest, TestErrors)
 {
 #ifndef FAST_MMU
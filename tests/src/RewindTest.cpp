@@ -0,0 +1,142 @@
+/*
+	Copyright 2026 flyinghead
+
+	This file is part of Flycast.
+
+    Flycast is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 2 of the License, or
+    (at your option) any later version.
+
+    Flycast is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Flycast.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#include "gtest/gtest.h"
+#include "types.h"
+#include "emulator.h"
+#include "rewind.h"
+#include "deltastate.h"
+#include "cfg/option.h"
+#include "hw/mem/addrspace.h"
+#include "hw/sh4/sh4_if.h"
+#include "hw/sh4/sh4_mem.h"
+#include "oslib/oslib.h"
+
+class RewindTest : public ::testing::Test {
+protected:
+	static constexpr u32 Addr = 0x8c100000;
+
+	void SetUp() override
+	{
+		if (!addrspace::reserve())
+			die("addrspace::reserve failed");
+		// Memory writes are tracked by the fault handler
+		os_InstallFaultHandler();
+		emu.init();
+		mem_map_default();
+		dc_reset(true);
+		config::ThreadedRendering = false;
+		config::Rewind = true;
+		rewindBuffer.start();
+		ASSERT_TRUE(rewindBuffer.isActive());
+	}
+
+	void TearDown() override
+	{
+		rewindBuffer.setRewinding(false);
+		config::Rewind = false;
+		rewindBuffer.start();
+		config::Rewind.reset();
+		config::RewindBufferSize.reset();
+		config::ThreadedRendering.reset();
+		os_UninstallFaultHandler();
+	}
+
+	void capture()
+	{
+		rewindBuffer.setRewinding(false);
+		rewindBuffer.update();
+	}
+
+	void stepBack()
+	{
+		rewindBuffer.setRewinding(true);
+		rewindBuffer.update();
+	}
+};
+
+TEST_F(RewindTest, StepBack)
+{
+	addrspace::write32(Addr, 1);
+	p_sh4rcb->cntx.r[0] = 10;
+	capture();
+	addrspace::write32(Addr, 2);
+	p_sh4rcb->cntx.r[0] = 20;
+	capture();
+	addrspace::write32(Addr, 3);
+	addrspace::write32(Addr + PAGE_SIZE * 4, 3);
+	p_sh4rcb->cntx.r[0] = 30;
+	ASSERT_EQ(2u, rewindBuffer.getStats().entries);
+
+	// The last state has just been captured so we go back to the previous one
+	stepBack();
+	ASSERT_EQ(1u, addrspace::read32(Addr));
+	ASSERT_EQ(0u, addrspace::read32(Addr + PAGE_SIZE * 4));
+	ASSERT_EQ(10u, p_sh4rcb->cntx.r[0]);
+	ASSERT_EQ(1u, rewindBuffer.getStats().entries);
+
+	// The oldest state is kept
+	addrspace::write32(Addr, 4);
+	stepBack();
+	ASSERT_EQ(1u, addrspace::read32(Addr));
+	ASSERT_EQ(1u, rewindBuffer.getStats().entries);
+}
+
+TEST_F(RewindTest, Wrap)
+{
+	// Room for a few uncompressed states
+	std::vector<u8> state;
+	deltastate::serialize(state, true);
+	const u32 budget = (u32)(state.size() * 4 / (1024 * 1024) + 1);
+	config::RewindBufferSize = budget;
+
+	// Capture until the oldest entries are dropped
+	u32 captures = 0;
+	RewindBuffer::Stats stats {};
+	do {
+		// write a different page each time
+		addrspace::write32(Addr + (captures % 16) * PAGE_SIZE, captures);
+		addrspace::write32(Addr + 16 * PAGE_SIZE, captures);
+		capture();
+		captures++;
+		stats = rewindBuffer.getStats();
+	} while (stats.entries == captures && captures < 10000);
+	ASSERT_LT(stats.entries, captures);
+	ASSERT_GT(stats.entries, 1u);
+	ASSERT_LE(stats.memoryUsed, budget * 1024u * 1024u);
+
+	// Step back to the oldest state still in the buffer
+	for (u32 i = 0; i < stats.entries; i++)
+		stepBack();
+	ASSERT_EQ(1u, rewindBuffer.getStats().entries);
+	const u32 oldest = captures - stats.entries;
+	ASSERT_EQ(oldest, addrspace::read32(Addr + 16 * PAGE_SIZE));
+	ASSERT_EQ(oldest, addrspace::read32(Addr + (oldest % 16) * PAGE_SIZE));
+}
+
+TEST_F(RewindTest, Empty)
+{
+	addrspace::write32(Addr, 1);
+	stepBack();
+	ASSERT_EQ(1u, addrspace::read32(Addr));
+	ASSERT_EQ(0u, rewindBuffer.getStats().entries);
+
+	// Capturing works afterwards
+	capture();
+	ASSERT_EQ(1u, rewindBuffer.getStats().entries);
+}
@@ -0,0 +1,110 @@
+/*
+	Copyright 2026 flyinghead
+
+	This file is part of Flycast.
+
+    Flycast is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 2 of the License, or
+    (at your option) any later version.
+
+    Flycast is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Flycast.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#include "gtest/gtest.h"
+#include "types.h"
+#include "emulator.h"
+#include "serialize.h"
+#include "archive/rzip.h"
+#include "hw/mem/addrspace.h"
+#include "oslib/oslib.h"
+#include <chrono>
+#include <cstdio>
+#include <vector>
+
+class SavestateTest : public ::testing::Test {
+protected:
+	void SetUp() override
+	{
+		if (!addrspace::reserve())
+			die("addrspace::reserve failed");
+		emu.init();
+		settings.content.fileName = "savestate_test";
+	}
+
+	void TearDown() override
+	{
+		dc_waitSavestate();
+		std::remove(hostfs::getSavestatePath(Slot, true).c_str());
+		settings.content.fileName.clear();
+		setPlatform(DC_PLATFORM_DREAMCAST);
+		dc_reset(true);
+	}
+
+	static constexpr int Slot = 99;
+};
+
+// The streamed savestate must be identical to an in-memory one
+TEST_F(SavestateTest, Stream)
+{
+	dc_reset(true);
+	Serializer dryrun;
+	dc_serialize(dryrun);
+	std::vector<u8> data(dryrun.size());
+	Serializer ser(data.data(), data.size());
+	dc_serialize(ser);
+
+	dc_savestate(Slot);
+	dc_waitSavestate();
+
+	RZipFile zipFile;
+	ASSERT_TRUE(zipFile.Open(hostfs::getSavestatePath(Slot, false), false));
+	ASSERT_EQ(data.size(), zipFile.Size());
+	std::vector<u8> saved(zipFile.Size());
+	ASSERT_EQ(saved.size(), zipFile.Read(saved.data(), saved.size()));
+	ASSERT_TRUE(data == saved);
+}
+
+TEST_F(SavestateTest, DISABLED_Benchmark)
+{
+	static const std::pair<int, const char *> platforms[] {
+		{ DC_PLATFORM_DREAMCAST, "Dreamcast" },
+		{ DC_PLATFORM_NAOMI, "NAOMI" },
+		{ DC_PLATFORM_NAOMI2, "NAOMI 2" },
+	};
+	using clock = std::chrono::steady_clock;
+	constexpr int loops = 5;
+	for (const auto& platform : platforms)
+	{
+		setPlatform(platform.first);
+		dc_reset(true);
+		Serializer dryrun;
+		dc_serialize(dryrun);
+		const double mb = dryrun.size() / 1024.0 / 1024.0;
+
+		double latency = 0, save = 0, load = 0;
+		for (int i = 0; i < loops; i++)
+		{
+			auto start = clock::now();
+			dc_savestate(Slot);
+			auto returned = clock::now();
+			dc_waitSavestate();
+			auto saved = clock::now();
+			dc_loadstate(Slot);
+			auto loaded = clock::now();
+			latency += std::chrono::duration<double, std::milli>(returned - start).count();
+			save += std::chrono::duration<double, std::milli>(saved - start).count();
+			load += std::chrono::duration<double, std::milli>(loaded - saved).count();
+		}
+		latency /= loops;
+		save /= loops;
+		load /= loops;
+		printf("%-10s %.1f MB  save latency %.1f ms  save %.1f ms (%.0f MB/s)  load %.1f ms (%.0f MB/s)\n", platform.second, mb,
+				latency, save, mb * 1000 / save, load, mb * 1000 / load);
+	}
+}
@@ -0,0 +1,157 @@
+/*
+	Copyright 2026 flyinghead
+
+	This file is part of Flycast.
+
+    Flycast is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 2 of the License, or
+    (at your option) any later version.
+
+    Flycast is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Flycast.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#include "gtest/gtest.h"
+#include "types.h"
+#include "imgread/prefetch.h"
+#include <atomic>
+#include <chrono>
+#include <random>
+
+class SectorPrefetchTest : public ::testing::Test {
+protected:
+	// Sectors and subchannels are filled with bytes derived from the fad. Some sectors can't be read.
+	static void readSector(u32 fad, u8 *dest, u32 sectorSize, u8 *subchannel)
+	{
+		if (fad % 100 == 42)
+			return;
+		for (u32 i = 0; i < sectorSize; i++)
+			dest[i] = (u8)(fad + i / 4);
+		if (sectorSize == 2352)
+			memset(subchannel, (u8)fad, SectorPrefetcher::SubchannelSize);
+	}
+
+	void checkRead(u32 fad, u32 count, u32 sectorSize)
+	{
+		std::vector<u8> data(count * sectorSize, 0xcc);
+		u8 subchannel[SectorPrefetcher::SubchannelSize];
+		prefetcher.read(fad, count, data.data(), sectorSize, subchannel);
+
+		std::vector<u8> ref(count * sectorSize, 0);
+		u8 refSub[SectorPrefetcher::SubchannelSize];
+		for (u32 i = 0; i < count; i++)
+		{
+			memset(refSub, 0, sizeof(refSub));
+			readSector(fad + i, &ref[i * sectorSize], sectorSize, refSub);
+		}
+		ASSERT_TRUE(ref == data) << "fad " << fad << " count " << count;
+		ASSERT_EQ(0, memcmp(subchannel, refSub, sizeof(subchannel)));
+	}
+
+	static void sleep(int ms) {
+		std::this_thread::sleep_for(std::chrono::milliseconds(ms));
+	}
+
+	SectorPrefetcher prefetcher { [](u32 fad, u8 *dest, u32 sectorSize, u8 *subchannel) {
+		// slow storage
+		std::this_thread::sleep_for(std::chrono::microseconds(100));
+		readSector(fad, dest, sectorSize, subchannel);
+	} };
+};
+
+TEST_F(SectorPrefetchTest, Sequential)
+{
+	prefetcher.prefetch(1000, 200, 2048);
+	sleep(50);
+	for (u32 fad = 1000; fad < 1200; fad += 32)
+	{
+		checkRead(fad, std::min(32u, 1200 - fad), 2048);
+		sleep(10);
+	}
+	SectorPrefetcher::Stats stats = prefetcher.getStats();
+	ASSERT_EQ(200u, stats.hits);
+	ASSERT_EQ(0u, stats.misses);
+}
+
+TEST_F(SectorPrefetchTest, Seek)
+{
+	checkRead(1000, 10, 2048);
+	checkRead(1010, 10, 2048);
+	sleep(50);
+	checkRead(5000, 10, 2048);
+	checkRead(5010, 10, 2048);
+	sleep(50);
+	// The first stream is dropped
+	checkRead(9000, 10, 2048);
+	// The second one is still there
+	checkRead(5020, 10, 2048);
+	SectorPrefetcher::Stats stats = prefetcher.getStats();
+	ASSERT_EQ(50u, stats.misses);
+	ASSERT_EQ(10u, stats.hits);
+	ASSERT_LT(0u, stats.cancelled);
+}
+
+TEST_F(SectorPrefetchTest, Interleaved)
+{
+	// Data and CDDA
+	for (int i = 0; i < 50; i++)
+	{
+		checkRead(10000 + i * 4, 4, 2048);
+		checkRead(20000 + i, 1, 2352);
+		if (i == 2)
+			sleep(50);
+	}
+	SectorPrefetcher::Stats stats = prefetcher.getStats();
+	ASSERT_LT(150u, stats.hits);
+}
+
+TEST_F(SectorPrefetchTest, Random)
+{
+	std::mt19937 random(42);
+	for (int i = 0; i < 200; i++)
+	{
+		u32 fad = random() % 1000 + 150;
+		u32 size = random() % 3 == 0 ? 2352 : 2048;
+		u32 count = random() % 40 + 1;
+		for (int j = random() % 4; j >= 0; j--)
+		{
+			checkRead(fad, count, size);
+			fad += count;
+		}
+		if (i % 50 == 0)
+			prefetcher.reset();
+	}
+}
+
+TEST_F(SectorPrefetchTest, TrackEnd)
+{
+	// Track from 150 to 1099
+	std::atomic<u32> lastFad { 0 };
+	SectorPrefetcher trackPrefetcher(
+		[&lastFad](u32 fad, u8 *dest, u32 sectorSize, u8 *subchannel) {
+			lastFad = std::max<u32>(lastFad, fad);
+			readSector(fad, dest, sectorSize, subchannel);
+		},
+		[](u32 fad) {
+			return fad >= 150 && fad < 1100 ? 1100 : fad;
+		});
+	u8 data[2048 * 10];
+	u8 subchannel[SectorPrefetcher::SubchannelSize];
+	trackPrefetcher.read(1000, 10, data, 2048, subchannel);
+	trackPrefetcher.read(1010, 10, data, 2048, subchannel);
+	trackPrefetcher.prefetch(1050, 200, 2048);
+	sleep(50);
+	ASSERT_EQ(1099u, lastFad);
+
+	// Nothing is prefetched past the end of the disc
+	trackPrefetcher.read(2000, 10, data, 2048, subchannel);
+	trackPrefetcher.read(2010, 10, data, 2048, subchannel);
+	sleep(50);
+	ASSERT_EQ(2019u, lastFad);
+	ASSERT_EQ(0u, trackPrefetcher.getStats().hits);
+}
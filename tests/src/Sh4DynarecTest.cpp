@@ -0,0 +1,273 @@
+/*
+	Copyright 2026 flyinghead
+
+	This file is part of Flycast.
+
+    Flycast is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 2 of the License, or
+    (at your option) any later version.
+
+    Flycast is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Flycast.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#include "gtest/gtest.h"
+#include "types.h"
+#include "emulator.h"
+#include "cfg/option.h"
+#include "hw/mem/addrspace.h"
+#include "hw/sh4/sh4_if.h"
+#include "hw/sh4/sh4_mem.h"
+#include "hw/sh4/sh4_sched.h"
+#include "hw/sh4/dyna/ngen.h"
+#include "oslib/oslib.h"
+#include <chrono>
+
+#if FEAT_SHREC != DYNAREC_NONE
+
+// Runs the same guest code with the interpreter and the dynarec and compares the results
+class Sh4DynarecTest : public ::testing::Test {
+protected:
+	static constexpr u32 START_PC = 0x8c010000;
+
+	void SetUp() override
+	{
+		if (!addrspace::reserve())
+			die("addrspace::reserve failed");
+		// fpcb pages are allocated on first access by the fault handler
+		os_InstallFaultHandler();
+		emu.init();
+		mem_map_default();
+		dc_reset(true);
+		ctx = &p_sh4rcb->cntx;
+	}
+
+	void TearDown() override {
+		os_UninstallFaultHandler();
+	}
+
+	void LoadProgram(const std::vector<u16>& code)
+	{
+		for (size_t i = 0; i < code.size(); i++)
+			addrspace::write16(START_PC + i * 2, code[i]);
+		endPc = START_PC + (code.size() - 2) * 2;
+	}
+
+	void ResetState()
+	{
+		for (int i = 0; i < 16; i++)
+			ctx->r[i] = 0;
+		sh4_sr_SetFull(0x700000F0);
+		ctx->pc = START_PC;
+	}
+
+	// The program must end with a "bra ." and nop delay slot
+	void RunInterpreter()
+	{
+		sh4_if sh4;
+		Get_Sh4Interpreter(&sh4);
+		ResetState();
+		for (int i = 0; i < 100000 && ctx->pc != endPc; i++)
+			sh4.Step();
+		ASSERT_EQ(endPc, ctx->pc);
+	}
+
+	static int stopCpu(int tag, int cycles, int jitter)
+	{
+		p_sh4rcb->cntx.CpuRunning = 0;
+		return 0;
+	}
+
+	// Returns the duration in seconds
+	double RunCycles(int cycles)
+	{
+		sh4_if sh4;
+		Get_Sh4Recompiler(&sh4);
+		sh4.ResetCache();
+		ResetState();
+		int schedId = sh4_sched_register(0, &stopCpu);
+		sh4_sched_request(schedId, cycles);
+		auto start = std::chrono::steady_clock::now();
+		sh4.Run();
+		const double duration = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+		sh4_sched_unregister(schedId);
+		return duration;
+	}
+
+	void RunDynarec()
+	{
+		RunCycles(1000000);
+		ASSERT_EQ(endPc, ctx->pc);
+	}
+
+	void CompareWithInterpreter(const std::vector<u16>& code)
+	{
+		LoadProgram(code);
+		RunInterpreter();
+		u32 expected[16];
+		memcpy(expected, ctx->r, sizeof(expected));
+		u32 expectedT = ctx->sr.T;
+
+		RunDynarec();
+		for (int i = 0; i < 16; i++)
+			ASSERT_EQ(expected[i], ctx->r[i]) << "r" << i;
+		ASSERT_EQ(expectedT, ctx->sr.T);
+	}
+
+	Sh4Context *ctx = nullptr;
+	u32 endPc = 0;
+};
+
+// Block looping on itself
+TEST_F(Sh4DynarecTest, SelfLoop)
+{
+	CompareWithInterpreter({
+		0xE000,	// mov #0, r0
+		0xE164,	// mov #100, r1
+		0xE203,	// mov #3, r2
+		// loop:
+		0x302C,	// add r2, r0
+		0x201A,	// xor r1, r0
+		0x4110,	// dt r1
+		0x8BFB,	// bf loop
+		0xAFFE,	// bra .
+		0x0009,	// nop
+	});
+}
+
+// Self loop keeping its registers in host registers, with memory accesses
+TEST_F(Sh4DynarecTest, SelfLoopRegs)
+{
+	CompareWithInterpreter({
+		0xE000,	// mov #0, r0
+		0xE164,	// mov #100, r1
+		0xE38C,	// mov #-116, r3
+		0x4328,	// shll16 r3
+		0x4318,	// shll8 r3
+		0xE410,	// mov #16, r4
+		0x4428,	// shll16 r4
+		0x334C,	// add r4, r3
+		// loop:
+		0x2302,	// mov.l r0, @r3
+		0x6536,	// mov.l @r3+, r5
+		0x305C,	// add r5, r0
+		0x7007,	// add #7, r0
+		0x4110,	// dt r1
+		0x8BF9,	// bf loop
+		0xAFFE,	// bra .
+		0x0009,	// nop
+	});
+}
+
+// Self loop using more registers than can be kept in host registers
+TEST_F(Sh4DynarecTest, SelfLoopManyRegs)
+{
+	CompareWithInterpreter({
+		0xE000,	// mov #0, r0
+		0xE164,	// mov #100, r1
+		0xE201,	// mov #1, r2
+		0xE302,	// mov #2, r3
+		0xE403,	// mov #3, r4
+		0xE504,	// mov #4, r5
+		0xE605,	// mov #5, r6
+		0xE706,	// mov #6, r7
+		// loop:
+		0x302C,	// add r2, r0
+		0x323C,	// add r3, r2
+		0x334C,	// add r4, r3
+		0x345C,	// add r5, r4
+		0x356C,	// add r6, r5
+		0x367C,	// add r7, r6
+		0x370C,	// add r0, r7
+		0x4110,	// dt r1
+		0x8BF6,	// bf loop
+		0xAFFE,	// bra .
+		0x0009,	// nop
+	});
+}
+
+// Loop made of several blocks linked by unconditional branches
+TEST_F(Sh4DynarecTest, MultiBlockLoop)
+{
+	CompareWithInterpreter({
+		0xE000,	// mov #0, r0
+		0xE132,	// mov #50, r1
+		0xE201,	// mov #1, r2
+		// loop:
+		0x302C,	// add r2, r0
+		0xA001,	// bra next
+		0x4200,	// shll r2 (delay slot)
+		0x0009,	// nop (skipped)
+		// next:
+		0x2209,	// and r0, r2
+		0x7201,	// add #1, r2
+		0x4110,	// dt r1
+		0x8BF7,	// bf loop
+		0xAFFE,	// bra .
+		0x0009,	// nop
+	});
+}
+
+// Dispatches and run time of a loop made of blocks linked by forward branches, with and without traces
+TEST_F(Sh4DynarecTest, DISABLED_TraceBenchmark)
+{
+	LoadProgram({
+		0xE000,	// mov #0, r0
+		// loop:
+		0x7001,	// add #1, r0
+		0xA000,	// bra a
+		0x0009,	// nop
+		// a:
+		0x7101,	// add #1, r1
+		0xA000,	// bra b
+		0x0009,	// nop
+		// b:
+		0x7201,	// add #1, r2
+		0xAFF7,	// bra loop
+		0x0009,	// nop
+	});
+	constexpr int cycles = 50'000'000;
+	for (bool trace : { false, true })
+	{
+		config::DynarecTraceCompile = trace;
+#if !defined(NDEBUG) || defined(DEBUGFAST)
+		const u64 dispatches = rdv_dispatchCount;
+#endif
+		const double duration = RunCycles(cycles);
+		const u32 loops = ctx->r[0];
+		ASSERT_NE(0u, loops);
+		// the time slice can end in the middle of an iteration
+		ASSERT_LE(loops - ctx->r[1], 1u);
+		printf("Traces %s: %.1f Mloops/s", trace ? "on" : "off", loops / duration / 1e6);
+#if !defined(NDEBUG) || defined(DEBUGFAST)
+		printf("  %.2f dispatches/loop", (double)(rdv_dispatchCount - dispatches) / loops);
+#endif
+		printf("\n");
+	}
+	config::DynarecTraceCompile.reset();
+}
+
+// Run time of a block looping on itself
+TEST_F(Sh4DynarecTest, DISABLED_SelfLoopBenchmark)
+{
+	LoadProgram({
+		0xE000,	// mov #0, r0
+		// loop:
+		0x7001,	// add #1, r0
+		0x320C,	// add r0, r2
+		0x232A,	// xor r2, r3
+		0xAFFB,	// bra loop
+		0x0009,	// nop
+	});
+	const double duration = RunCycles(200'000'000);
+	const u32 loops = ctx->r[0];
+	ASSERT_NE(0u, loops);
+	printf("%.1f Mloops/s\n", loops / duration / 1e6);
+}
+
+#endif // FEAT_SHREC != DYNAREC_NONE
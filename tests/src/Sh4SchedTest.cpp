@@ -0,0 +1,308 @@
+/*
+	Copyright 2026 flyinghead
+
+	This file is part of Flycast.
+
+    Flycast is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 2 of the License, or
+    (at your option) any later version.
+
+    Flycast is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Flycast.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#include "gtest/gtest.h"
+#include "types.h"
+#include "hw/mem/addrspace.h"
+#include "hw/sh4/sh4_if.h"
+#include "hw/sh4/sh4_sched.h"
+#include "hw/sh4/sh4_interpreter.h"
+#include <algorithm>
+#include <chrono>
+#include <random>
+
+namespace
+{
+
+// Linear scan scheduler, as implemented before the event heap. Used as a reference.
+class LinearSched
+{
+public:
+	void setSize(size_t size) {
+		list.resize(size, { nullptr, 0, -1, -1 });
+	}
+
+	void set(int id, sh4_sched_callback *cb, int tag) {
+		list[id] = { cb, tag, -1, -1 };
+	}
+
+	void request(int id, int cycles)
+	{
+		sched& s = list[id];
+		s.start = now();
+		if (cycles == -1)
+			s.end = -1;
+		else
+		{
+			s.end = s.start + cycles;
+			if (s.end == -1)
+				s.end++;
+		}
+		ffts();
+	}
+
+	void tick(int cycles)
+	{
+		if (next >= 0)
+			return;
+		u32 fztime = now() - cycles;
+		if (nextId != -1)
+		{
+			for (sched& s : list)
+			{
+				int remaining = remainingCycles(s, fztime);
+				if (remaining >= 0 && remaining <= cycles)
+					handle(s);
+			}
+		}
+		ffts();
+	}
+
+	u32 now() const {
+		return ffb - next;
+	}
+
+	int next = 0;
+
+private:
+	struct sched
+	{
+		sh4_sched_callback *cb;
+		int tag;
+		int start;
+		int end;
+	};
+
+	static u32 remainingCycles(const sched& s, u32 reference) {
+		return s.end != -1 ? s.end - reference : -1;
+	}
+
+	void ffts()
+	{
+		u32 diff = -1;
+		int slot = -1;
+		u32 t = now();
+		for (const sched& s : list)
+		{
+			u32 remaining = remainingCycles(s, t);
+			if (remaining < diff)
+			{
+				slot = &s - &list[0];
+				diff = remaining;
+			}
+		}
+		ffb -= next;
+		nextId = slot;
+		next = slot != -1 ? diff : SH4_MAIN_CLOCK;
+		ffb += next;
+	}
+
+	void handle(sched& s)
+	{
+		int remain = s.end - s.start;
+		int elapsed = now() - s.start;
+		s.start = now();
+		int jitter = elapsed - remain;
+		s.end = -1;
+		int reSched = s.cb(s.tag, remain, jitter);
+		if (reSched > 0)
+			request(&s - &list[0], std::max(0, reSched - jitter));
+	}
+
+	std::vector<sched> list;
+	u64 ffb = 0;
+	int nextId = -1;
+};
+
+struct Event
+{
+	int tag;
+	int cycles;
+	int jitter;
+	u32 now;
+
+	bool operator==(const Event& other) const {
+		return tag == other.tag && cycles == other.cycles && jitter == other.jitter && now == other.now;
+	}
+};
+
+// Random workload: callbacks reschedule themselves and occasionally other callbacks
+struct Workload
+{
+	static constexpr int Count = 24;
+
+	std::mt19937 random { 1234 };
+	std::vector<int> ids;
+	std::vector<Event> events;
+	bool record = true;
+	u32 count = 0;
+	void (*request)(int id, int cycles);
+	u32 (*now)();
+
+	static Workload *current;
+
+	static int callback(int tag, int cycles, int jitter)
+	{
+		Workload& w = *current;
+		w.count++;
+		if (w.record)
+			w.events.push_back({ tag, cycles, jitter, w.now() });
+		if (w.random() % 8 == 0)
+			w.request(w.ids[w.random() % Count], w.random() % 4 == 0 ? 0 : w.random() % 5000);
+		u32 r = w.random() % 16;
+		if (r == 0)
+			return 0;
+		if (r < 8)
+			return w.random() % 1000 + 1;
+		return w.random() % 100000 + 1;
+	}
+};
+Workload *Workload::current;
+
+LinearSched linearSched;
+
+}
+
+class Sh4SchedTest : public ::testing::Test {
+protected:
+	void SetUp() override
+	{
+		if (!addrspace::reserve())
+			die("addrspace::reserve failed");
+		sh4_sched_reset(true);
+	}
+
+	void TearDown() override
+	{
+		for (int id : ids)
+			sh4_sched_unregister(id);
+		sh4_sched_reset(true);
+	}
+
+	void registerAll(Workload& workload)
+	{
+		for (int i = 0; i < Workload::Count; i++)
+			ids.push_back(sh4_sched_register(i, &Workload::callback));
+		workload.ids = ids;
+		workload.request = sh4_sched_request;
+		workload.now = []() { return (u32)sh4_sched_now64(); };
+	}
+
+	void registerLinear(Workload& workload)
+	{
+		linearSched = LinearSched();
+		linearSched.setSize(*std::max_element(ids.begin(), ids.end()) + 1);
+		for (int i = 0; i < Workload::Count; i++)
+			linearSched.set(ids[i], &Workload::callback, i);
+		workload.ids = ids;
+		workload.request = [](int id, int cycles) { linearSched.request(id, cycles); };
+		workload.now = []() { return linearSched.now(); };
+	}
+
+	static void start(Workload& workload)
+	{
+		Workload::current = &workload;
+		for (int i = 0; i < Workload::Count; i++)
+			workload.request(workload.ids[i], workload.random() % 10000);
+	}
+
+	static void run(u32 slices)
+	{
+		for (u32 i = 0; i < slices; i++)
+		{
+			Sh4cntx.sh4_sched_next -= SH4_TIMESLICE;
+			if (Sh4cntx.sh4_sched_next < 0)
+				sh4_sched_tick(SH4_TIMESLICE);
+		}
+	}
+
+	static void runLinear(u32 slices)
+	{
+		for (u32 i = 0; i < slices; i++)
+		{
+			linearSched.next -= SH4_TIMESLICE;
+			if (linearSched.next < 0)
+				linearSched.tick(SH4_TIMESLICE);
+		}
+	}
+
+	static double eventsPerSecond(const Workload& workload, std::chrono::steady_clock::time_point start) {
+		return workload.count / std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+	}
+
+	std::vector<int> ids;
+};
+
+TEST_F(Sh4SchedTest, SameAsLinear)
+{
+	Workload heap;
+	registerAll(heap);
+	start(heap);
+	run(200000);
+
+	Workload linear;
+	registerLinear(linear);
+	start(linear);
+	runLinear(200000);
+
+	ASSERT_LT(1000u, heap.events.size());
+	ASSERT_EQ(linear.events.size(), heap.events.size());
+	for (size_t i = 0; i < heap.events.size(); i++)
+		ASSERT_TRUE(linear.events[i] == heap.events[i]) << "event " << i;
+}
+
+TEST_F(Sh4SchedTest, Cancel)
+{
+	Workload workload;
+	registerAll(workload);
+	for (int i = 0; i < Workload::Count; i++)
+		sh4_sched_request(ids[i], 1000 + i);
+	// cancel every other callback
+	for (int i = 0; i < Workload::Count; i += 2)
+		sh4_sched_request(ids[i], -1);
+	ASSERT_EQ(1001, Sh4cntx.sh4_sched_next);
+	// unregistering a scheduled callback
+	sh4_sched_unregister(ids[1]);
+	ids.erase(ids.begin() + 1);
+	ASSERT_EQ(1003, Sh4cntx.sh4_sched_next);
+}
+
+TEST_F(Sh4SchedTest, DISABLED_Benchmark)
+{
+	constexpr u32 slices = 1000000;
+	Workload heap;
+	heap.record = false;
+	registerAll(heap);
+	start(heap);
+	u64 startTime = sh4_sched_now64();
+	auto t0 = std::chrono::steady_clock::now();
+	run(slices);
+	double heapRate = eventsPerSecond(heap, t0);
+	ASSERT_EQ(startTime + (u64)slices * SH4_TIMESLICE, sh4_sched_now64());
+
+	Workload linear;
+	linear.record = false;
+	registerLinear(linear);
+	start(linear);
+	t0 = std::chrono::steady_clock::now();
+	runLinear(slices);
+	double linearRate = eventsPerSecond(linear, t0);
+
+	ASSERT_EQ(linear.count, heap.count);
+	printf("Scheduler: %.1f M events/s (linear scan: %.1f M events/s)\n", heapRate / 1e6, linearRate / 1e6);
+}
@@ -0,0 +1,488 @@
+/*
+	Copyright 2026 flyinghead
+
+	This file is part of Flycast.
+
+    Flycast is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 2 of the License, or
+    (at your option) any later version.
+
+    Flycast is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Flycast.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#include "gtest/gtest.h"
+#include "types.h"
+#include "emulator.h"
+#include "cfg/option.h"
+#include "hw/mem/addrspace.h"
+#include "hw/pvr/ta_ctx.h"
+#include "hw/pvr/ta_structs.h"
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <random>
+
+// Non-textured packed, floating and intensity, textured packed and intensity with 32 and 16-bit UVs
+static const u32 BatchedTypes[] { 0x00, 0x10, 0x20, 0x08, 0x09, 0x28, 0x29 };
+
+class TaParserTest : public ::testing::Test {
+protected:
+	void SetUp() override
+	{
+		if (!addrspace::reserve())
+			die("addrspace::reserve failed");
+		emu.init();
+		dc_reset(true);
+		SetCurrentTARC(0);
+		ta_ctx->Reset();
+		ta_parse_reset();
+	}
+
+	void TearDown() override
+	{
+		SetCurrentTARC(TACTX_NONE);
+		config::MaxThreads.reset();
+		config::PerStripSorting.reset();
+		config::RenderResolution.reset();
+	}
+
+	static u32 pcw(u32 paraType, u32 objCtrl, bool endOfStrip = false, u32 listType = ListType_Opaque)
+	{
+		PCW pcw{};
+		pcw.ParaType = paraType;
+		pcw.ListType = listType;
+		pcw.EndOfStrip = endOfStrip;
+		pcw.obj_ctrl = objCtrl;
+		return pcw.full;
+	}
+
+	// Polygon parameter and a strip of vertices
+	void addStrip(u32 objCtrl, const std::vector<std::array<u32, 7>>& vertices, u32 listType = ListType_Opaque)
+	{
+		std::array<u32, 8> param {};
+		param[0] = pcw(ParamType_Polygon_or_Modifier_Volume, objCtrl, false, listType);
+		// face color for intensity
+		const f32 faceColor[] { 1.f, 0.5f, 0.25f, 0.75f };
+		memcpy(&param[4], faceColor, sizeof(faceColor));
+		stream.insert(stream.end(), param.begin(), param.end());
+		for (size_t i = 0; i < vertices.size(); i++)
+		{
+			stream.push_back(pcw(ParamType_Vertex_Parameter, objCtrl, i == vertices.size() - 1, listType));
+			stream.insert(stream.end(), vertices[i].begin(), vertices[i].end());
+		}
+	}
+
+	void endList() {
+		stream.insert(stream.end(), 8, 0);
+	}
+
+	u32 parse()
+	{
+		return ta_add_ta_data(stream.data(), stream.size() * 4);
+	}
+
+	static std::array<u32, 7> randomVertex(std::mt19937& random)
+	{
+		std::array<u32, 7> words;
+		for (u32& w : words)
+		{
+			f32 f = std::uniform_real_distribution<f32>(-0.5f, 1.5f)(random);
+			if (random() % 16 == 0)
+				f = NAN;
+			memcpy(&w, &f, sizeof(w));
+		}
+		// packed colors and 16-bit UVs
+		for (u32& w : words)
+			if (random() % 2 == 0)
+				w = random();
+		return words;
+	}
+
+	// Opaque and translucent strips, some of them with textures and the same parameters
+	void randomFrame(u32 seed, int strips)
+	{
+		std::mt19937 random(seed);
+		for (u32 listType : { ListType_Opaque, ListType_Translucent })
+		{
+			for (int i = 0; i < strips; i++)
+			{
+				std::vector<std::array<u32, 7>> vertices;
+				for (u32 j = 3 + random() % 8; j > 0; j--)
+				{
+					vertices.push_back(randomVertex(random));
+					if (random() % 4 == 0)
+					{
+						// facing the camera, with U and V in [0, 1]
+						f32 zuv[] { 0.5f, (f32)(random() % 2), (f32)(random() % 2) };
+						memcpy(&vertices.back()[2], zuv, sizeof(zuv));
+					}
+				}
+				// packed color, intensity, textured
+				const u32 types[] { 0x00, 0x20, 0x08 };
+				addStrip(types[random() % std::size(types)], vertices, listType);
+			}
+			endList();
+		}
+	}
+
+	// Raw TA data, as passed to ta_add_ta_data, can be replayed from a file
+	void loadDump(bool& loaded)
+	{
+		loaded = false;
+		const char *dumpPath = getenv("FLYCAST_TA_DUMP");
+		if (dumpPath == nullptr)
+			return;
+		std::ifstream file(dumpPath, std::ios::binary | std::ios::ate);
+		ASSERT_TRUE(file.is_open()) << "Can't open " << dumpPath;
+		stream.resize(file.tellg() / 4);
+		file.seekg(0);
+		file.read((char *)stream.data(), stream.size() * 4);
+		loaded = true;
+	}
+
+	// Turns the translucent polygons into NAOMI 2 polygons using the same matrix
+	void makeNaomi2()
+	{
+		rend_context& rc = ta_ctx->rend;
+		N2Matrix matrix {};
+		for (int i = 0; i < 4; i++)
+			matrix.mat[i * 5] = 1.f;
+		// w = 0.1x + 0.2y + 0.3z + 2
+		const f32 zRow[] { 0.1f, 0.2f, 0.3f, 2.f };
+		for (int i = 0; i < 4; i++)
+			matrix.mat[i * 4 + 2] = zRow[i];
+		rc.matrices.push_back(matrix);
+		for (PolyParam& pp : rc.global_param_tr)
+		{
+			pp.mvMatrix = pp.projMatrix = rc.matrices.size() - 1;
+			for (u32 i = pp.first; i < pp.first + pp.count; i++)
+			{
+				// NAOMI 2 vertices are never culled. Keep them in [-1.5, 1.5] so that w isn't too small.
+				Vertex& v = rc.verts[i];
+				for (f32 *f : { &v.x, &v.y, &v.z })
+					if (!(std::fabs(*f) <= 1.5f))
+						*f = 0.5f;
+			}
+		}
+	}
+
+	static f32 projectedZ(const rend_context& rc, const PolyParam& pp, u32 vertex)
+	{
+		const f32 *mat = rc.matrices[pp.mvMatrix].mat;
+		const Vertex& v = rc.verts[vertex];
+		return -1.f / (mat[2] * v.x + mat[1 * 4 + 2] * v.y + mat[2 * 4 + 2] * v.z + mat[3 * 4 + 2]);
+	}
+
+	// Splits the polygons into render passes and processes them
+	void processPasses(u32 passCount, bool primRestart, bool radixSort = true)
+	{
+		rend_context& rc = ta_ctx->rend;
+		for (u32 i = 1; i <= passCount; i++)
+		{
+			RenderPass pass{};
+			pass.autosort = true;
+			pass.op_count = rc.global_param_op.size() * i / passCount;
+			pass.pt_count = rc.global_param_pt.size() * i / passCount;
+			pass.tr_count = rc.global_param_tr.size() * i / passCount;
+			rc.render_passes.push_back(pass);
+		}
+		processRenderPasses(rc, primRestart, radixSort);
+	}
+
+	std::vector<u32> stream;
+};
+
+TEST_F(TaParserTest, BatchedVertices)
+{
+	std::mt19937 random(42);
+	for (u32 objCtrl : BatchedTypes)
+	{
+		// the last 3 vertices repeat the first 3 and are decoded one at a time
+		std::vector<std::array<u32, 7>> vertices;
+		for (int i = 0; i < 4; i++)
+			vertices.push_back(randomVertex(random));
+		for (int i = 0; i < 3; i++)
+			vertices.push_back(vertices[i]);
+		addStrip(objCtrl, vertices);
+	}
+	endList();
+	ASSERT_EQ(stream.size() * 4, parse());
+
+	const rend_context& rc = ta_ctx->rend;
+	// background polygon and strips
+	ASSERT_EQ(1 + std::size(BatchedTypes), rc.global_param_op.size());
+	for (size_t i = 1; i < rc.global_param_op.size(); i++)
+	{
+		const PolyParam& pp = rc.global_param_op[i];
+		ASSERT_EQ(7u, pp.count);
+		for (u32 j = 0; j < 3; j++)
+			ASSERT_EQ(0, memcmp(&rc.verts[pp.first + j], &rc.verts[pp.first + j + 4], sizeof(Vertex))) << "type " << std::hex << BatchedTypes[i - 1] << " vertex " << j;
+	}
+}
+
+TEST_F(TaParserTest, PackedColor)
+{
+	std::vector<std::array<u32, 7>> vertices(5);
+	for (u32 i = 0; i < vertices.size(); i++)
+	{
+		f32 xyz[] { (f32)i, 2.f, 1.f / (i + 1) };
+		memcpy(&vertices[i][0], xyz, sizeof(xyz));
+		vertices[i][5] = 0x80ff4020;
+	}
+	addStrip(0, vertices);
+	endList();
+	parse();
+
+	const rend_context& rc = ta_ctx->rend;
+	const PolyParam& pp = rc.global_param_op.back();
+	ASSERT_EQ(5u, pp.count);
+	for (u32 i = 0; i < pp.count; i++)
+	{
+		const Vertex& v = rc.verts[pp.first + i];
+		ASSERT_EQ((f32)i, v.x);
+		ASSERT_EQ(2.f, v.y);
+		ASSERT_EQ(1.f / (i + 1), v.z);
+		const u8 color[] { 0xff, 0x40, 0x20, 0x80 };
+		ASSERT_EQ(0, memcmp(color, v.col, sizeof(color)));
+		ASSERT_EQ(0.f, v.u);
+	}
+	ASSERT_EQ(1.f, rc.fZ_max);
+}
+
+TEST_F(TaParserTest, ParallelRenderPasses)
+{
+	config::RenderResolution = 960;
+	randomFrame(42, 400);
+	for (bool perStrip : { false, true })
+	{
+		config::PerStripSorting = perStrip;
+		for (bool primRestart : { false, true })
+		{
+			config::MaxThreads = 1;
+			ta_ctx->Reset();
+			ta_parse_reset();
+			parse();
+			processPasses(3, primRestart);
+			const rend_context serial = ta_ctx->rend;
+			ASSERT_FALSE(serial.idx.empty());
+
+			config::MaxThreads = 4;
+			ta_ctx->Reset();
+			ta_parse_reset();
+			parse();
+			processPasses(3, primRestart);
+			const rend_context& parallel = ta_ctx->rend;
+
+			ASSERT_EQ(serial.idx, parallel.idx);
+			ASSERT_EQ(0, memcmp(serial.verts.data(), parallel.verts.data(), serial.verts.size() * sizeof(Vertex)));
+			for (auto list : { &rend_context::global_param_op, &rend_context::global_param_tr })
+			{
+				ASSERT_EQ((serial.*list).size(), (parallel.*list).size());
+				for (size_t i = 0; i < (serial.*list).size(); i++)
+				{
+					ASSERT_EQ((serial.*list)[i].first, (parallel.*list)[i].first);
+					ASSERT_EQ((serial.*list)[i].count, (parallel.*list)[i].count);
+				}
+			}
+			ASSERT_EQ(serial.sortedTriangles.size(), parallel.sortedTriangles.size());
+			for (size_t i = 0; i < serial.sortedTriangles.size(); i++)
+			{
+				ASSERT_EQ(serial.sortedTriangles[i].polyIndex, parallel.sortedTriangles[i].polyIndex);
+				ASSERT_EQ(serial.sortedTriangles[i].first, parallel.sortedTriangles[i].first);
+				ASSERT_EQ(serial.sortedTriangles[i].count, parallel.sortedTriangles[i].count);
+			}
+			for (size_t i = 0; i < serial.render_passes.size(); i++)
+				ASSERT_EQ(serial.render_passes[i].sorted_tr_count, parallel.render_passes[i].sorted_tr_count);
+		}
+	}
+}
+
+// Indexes of a small frame with 2 render passes, processed serially and in parallel
+TEST_F(TaParserTest, RenderPassIndexes)
+{
+	// 3 opaque strips with the same parameters, 2 translucent strips
+	for (u32 listType : { ListType_Opaque, ListType_Translucent })
+	{
+		for (int i = 0; i < (listType == ListType_Opaque ? 3 : 2); i++)
+		{
+			std::vector<std::array<u32, 7>> vertices(3);
+			for (u32 j = 0; j < vertices.size(); j++)
+			{
+				f32 xyz[] { (f32)j, (f32)i, 1.f };
+				memcpy(&vertices[j][0], xyz, sizeof(xyz));
+			}
+			addStrip(0, vertices, listType);
+		}
+		endList();
+	}
+	const u32 R = ~0u;
+	for (u32 threads : { 1, 4 })
+	{
+		config::MaxThreads = threads;
+		for (bool primRestart : { false, true })
+		{
+			ta_ctx->Reset();
+			ta_parse_reset();
+			parse();
+			rend_context& rc = ta_ctx->rend;
+			ASSERT_EQ(4u, rc.global_param_op.size());
+			ASSERT_EQ(2u, rc.global_param_tr.size());
+			// first pass: background, 2 opaque strips and 1 translucent strip
+			RenderPass pass{};
+			pass.op_count = 3;
+			pass.tr_count = 1;
+			rc.render_passes.push_back(pass);
+			pass.op_count = 4;
+			pass.tr_count = 2;
+			rc.render_passes.push_back(pass);
+			processRenderPasses(rc, primRestart, true);
+
+			// vertices 0 to 3 are reserved for the background polygon
+			if (primRestart)
+				ASSERT_EQ(std::vector<u32>({ 4, 5, 6, R, 7, 8, 9,  13, 14, 15,  10, 11, 12,  16, 17, 18 }), rc.idx);
+			else
+				ASSERT_EQ(std::vector<u32>({ 4, 5, 6, 6, 7, 7, 7, 8, 9,  13, 14, 15,  10, 11, 12,  16, 17, 18 }), rc.idx);
+			const u32 opCount = primRestart ? 7 : 9;
+			// the second strip is merged into the first one
+			ASSERT_EQ(0u, rc.global_param_op[1].first);
+			ASSERT_EQ(opCount, rc.global_param_op[1].count);
+			ASSERT_EQ(0u, rc.global_param_op[2].count);
+			ASSERT_EQ(opCount + 3, rc.global_param_op[3].first);
+			ASSERT_EQ(3u, rc.global_param_op[3].count);
+			ASSERT_EQ(opCount, rc.global_param_tr[0].first);
+			ASSERT_EQ(3u, rc.global_param_tr[0].count);
+			ASSERT_EQ(opCount + 6, rc.global_param_tr[1].first);
+			ASSERT_EQ(3u, rc.global_param_tr[1].count);
+			ASSERT_TRUE(rc.sortedTriangles.empty());
+		}
+	}
+}
+
+TEST_F(TaParserTest, RadixSort)
+{
+	randomFrame(42, 2000);
+	for (bool naomi2 : { false, true })
+	{
+		for (bool primRestart : { false, true })
+		{
+			ta_ctx->Reset();
+			ta_parse_reset();
+			parse();
+			if (naomi2)
+				makeNaomi2();
+			processPasses(2, primRestart, false);
+			const rend_context stableSort = ta_ctx->rend;
+			ASSERT_FALSE(stableSort.sortedTriangles.empty());
+
+			ta_ctx->Reset();
+			ta_parse_reset();
+			parse();
+			if (naomi2)
+				makeNaomi2();
+			processPasses(2, primRestart, true);
+			const rend_context& radixSort = ta_ctx->rend;
+
+			ASSERT_EQ(stableSort.idx, radixSort.idx);
+			ASSERT_EQ(stableSort.sortedTriangles.size(), radixSort.sortedTriangles.size());
+			for (size_t i = 0; i < stableSort.sortedTriangles.size(); i++)
+			{
+				ASSERT_EQ(stableSort.sortedTriangles[i].polyIndex, radixSort.sortedTriangles[i].polyIndex);
+				ASSERT_EQ(stableSort.sortedTriangles[i].first, radixSort.sortedTriangles[i].first);
+				ASSERT_EQ(stableSort.sortedTriangles[i].count, radixSort.sortedTriangles[i].count);
+			}
+			if (!naomi2)
+				continue;
+			// the triangles of each pass are sorted by their min projected z
+			size_t sorted = 0;
+			for (const RenderPass& pass : radixSort.render_passes)
+			{
+				f32 lastZ = -INFINITY;
+				for (; sorted < pass.sorted_tr_count; sorted++)
+				{
+					const SortedTriangle& tri = radixSort.sortedTriangles[sorted];
+					const PolyParam& pp = radixSort.global_param_tr[tri.polyIndex];
+					for (u32 i = tri.first; i < tri.first + tri.count; i += 3)
+					{
+						const f32 z = std::min({ projectedZ(radixSort, pp, radixSort.idx[i]),
+							projectedZ(radixSort, pp, radixSort.idx[i + 1]), projectedZ(radixSort, pp, radixSort.idx[i + 2]) });
+						// vectorized and scalar z may differ in the last bit
+						ASSERT_LE(lastZ, z + std::fabs(z) * 1e-6f);
+						lastZ = z;
+					}
+				}
+			}
+		}
+	}
+}
+
+TEST_F(TaParserTest, DISABLED_Benchmark)
+{
+	bool loaded;
+	ASSERT_NO_FATAL_FAILURE(loadDump(loaded));
+	if (!loaded)
+	{
+		// Geometry-heavy frame: 40k vertices in strips of 8
+		std::mt19937 random(42);
+		for (int i = 0; i < 5000; i++)
+		{
+			std::vector<std::array<u32, 7>> vertices;
+			for (int j = 0; j < 8; j++)
+				vertices.push_back(randomVertex(random));
+			addStrip(BatchedTypes[i % std::size(BatchedTypes)], vertices);
+		}
+		endList();
+	}
+	constexpr int frames = 100;
+	size_t vertexCount = 0;
+	double duration = 0;
+	for (int i = 0; i < frames; i++)
+	{
+		ta_ctx->Reset();
+		ta_parse_reset();
+		auto start = std::chrono::steady_clock::now();
+		parse();
+		duration += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+		vertexCount += ta_ctx->rend.verts.size();
+	}
+	printf("%zd vertices per frame  %.1f Mvertices/s\n", vertexCount / frames, vertexCount / duration / 1e6);
+}
+
+TEST_F(TaParserTest, DISABLED_SortBenchmark)
+{
+	bool loaded;
+	ASSERT_NO_FATAL_FAILURE(loadDump(loaded));
+	if (!loaded)
+		// Alpha-heavy frame: 10k translucent strips
+		randomFrame(42, 10000);
+	config::MaxThreads = 1;
+	constexpr int frames = 20;
+	size_t triangleCount = 0;
+	double duration[2] {};
+	for (int i = 0; i < frames; i++)
+	{
+		for (bool radixSort : { false, true })
+		{
+			ta_ctx->Reset();
+			ta_parse_reset();
+			parse();
+			auto start = std::chrono::steady_clock::now();
+			processPasses(1, false, radixSort);
+			duration[radixSort] += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+			triangleCount = 0;
+			for (const SortedTriangle& tri : ta_ctx->rend.sortedTriangles)
+				triangleCount += tri.count / 3;
+		}
+	}
+	printf("%zd sorted triangles  stable sort %.3f ms  radix sort %.3f ms\n", triangleCount,
+			duration[0] / frames * 1000, duration[1] / frames * 1000);
+}
@@ -0,0 +1,146 @@
+/*
+	Copyright 2026 flyinghead
+
+	This file is part of Flycast.
+
+    Flycast is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 2 of the License, or
+    (at your option) any later version.
+
+    Flycast is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Flycast.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#include "gtest/gtest.h"
+#include "types.h"
+#include "emulator.h"
+#include "hw/mem/addrspace.h"
+#include "rend/TexCache.h"
+
+namespace
+{
+
+class TestTexture final : public BaseTextureCacheData
+{
+public:
+	TestTexture(TSP tsp, TCW tcw) : BaseTextureCacheData(tsp, tcw) {}
+	TestTexture(TestTexture&& other) : BaseTextureCacheData(std::move(other)) {}
+
+	std::string GetId() override { return "test"; }
+	void UploadToGPU(int width, int height, const u8 *temp_tex_buffer, bool mipmapped, bool mipmapsIncluded) override {}
+};
+
+class TestTextureCache final : public BaseTextureCache<TestTexture>
+{
+public:
+	size_t size() const {
+		return cache.size();
+	}
+};
+
+// 256x256 twiddled RGB565 texture: 128 KB
+TestTexture *getTexture(TestTextureCache& cache, u32 index)
+{
+	TSP tsp{};
+	tsp.TexU = 5;
+	tsp.TexV = 5;
+	TCW tcw{};
+	tcw.PixelFmt = Pixel565;
+	tcw.TexAddr = index * 256 * 256 * 2 / 8;
+	TestTexture *texture = cache.getTextureCacheData(tsp, tcw);
+	if (texture->NeedsUpdate())
+		texture->Update();
+	return texture;
+}
+
+}
+
+class TexCacheTest : public ::testing::Test {
+protected:
+	void SetUp() override
+	{
+		if (!addrspace::reserve())
+			die("addrspace::reserve failed");
+		emu.init();
+		config::TextureCacheBudget = 1;
+		FrameCount = 1;
+		texCacheStats = {};
+	}
+
+	void TearDown() override
+	{
+		cache.Clear();
+		config::TextureCacheBudget = 512;
+	}
+
+	TestTextureCache cache;
+};
+
+TEST_F(TexCacheTest, Stats)
+{
+	getTexture(cache, 0);
+	getTexture(cache, 1);
+	getTexture(cache, 0);
+	ASSERT_EQ(1u, texCacheStats.hits);
+	ASSERT_EQ(2u, texCacheStats.misses);
+	ASSERT_EQ(2u, texCacheStats.residentTextures);
+	ASSERT_EQ(2u * 256 * 256 * 2, texCacheStats.residentBytes);
+	cache.Clear();
+	ASSERT_EQ(0u, texCacheStats.residentTextures);
+	ASSERT_EQ(0u, texCacheStats.residentBytes);
+}
+
+TEST_F(TexCacheTest, LeastRecentlyUsed)
+{
+	// 1 MB holds 8 textures. Texture 0 is used every frame, the others only once.
+	for (u32 i = 1; i <= 32; i++)
+	{
+		FrameCount++;
+		getTexture(cache, 0);
+		getTexture(cache, i);
+		cache.CollectCleanup();
+	}
+	ASSERT_LT(0u, texCacheStats.evictions);
+	ASSERT_EQ(cache.size(), texCacheStats.residentTextures);
+	// Only textures used during the last frames can exceed the budget
+	ASSERT_GE(12u, cache.size());
+	FrameCount += 100;
+	cache.CollectCleanup();
+	ASSERT_GE(1024u * 1024u, texCacheStats.residentBytes);
+
+	// Texture 0 must still be cached
+	u64 misses = texCacheStats.misses;
+	getTexture(cache, 0);
+	ASSERT_EQ(misses, texCacheStats.misses);
+}
+
+TEST_F(TexCacheTest, Unlimited)
+{
+	config::TextureCacheBudget = 0;
+	for (u32 i = 0; i < 32; i++)
+	{
+		FrameCount++;
+		getTexture(cache, i);
+	}
+	FrameCount += 100;
+	cache.CollectCleanup();
+	ASSERT_EQ(0u, texCacheStats.evictions);
+	ASSERT_EQ(32u, cache.size());
+}
+
+TEST_F(TexCacheTest, StaleTextures)
+{
+	// Overwritten textures are deleted after 120 frames but aren't evictions
+	config::TextureCacheBudget = 0;
+	for (u32 i = 0; i < 4; i++)
+		getTexture(cache, i)->dirty = FrameCount;
+	FrameCount += 200;
+	cache.CollectCleanup();
+	ASSERT_EQ(0u, cache.size());
+	ASSERT_EQ(0u, texCacheStats.evictions);
+}
@@ -0,0 +1,198 @@
+/*
+	Copyright 2026 flyinghead
+
+	This file is part of Flycast.
+
+    Flycast is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 2 of the License, or
+    (at your option) any later version.
+
+    Flycast is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Flycast.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#include "gtest/gtest.h"
+#include "types.h"
+#include "rend/TexCache.h"
+#include "rend/TexConv.h"
+#include <chrono>
+#include <cstring>
+#include <iterator>
+#include <random>
+
+template<typename Pixel>
+struct TexConvEntry
+{
+	const char *name;
+	void (*convert)(PixelBuffer<Pixel> *pb, const u8 *p_in, u32 width, u32 height);
+};
+
+#define ENTRY(f) { #f, f }
+
+// All 16-bit texel formats of the PvrTexInfo tables
+static const TexConvEntry<u16> Formats16[] {
+	ENTRY(tex565_PL), ENTRY(tex565_TW), ENTRY(tex565_VQ),
+	ENTRY(opengl::tex1555_PL), ENTRY(opengl::tex1555_TW), ENTRY(opengl::tex1555_VQ),
+	ENTRY(opengl::tex4444_PL), ENTRY(opengl::tex4444_TW), ENTRY(opengl::tex4444_VQ),
+	ENTRY(directx::tex1555_PL), ENTRY(directx::tex1555_TW), ENTRY(directx::tex1555_VQ),
+	ENTRY(directx::tex4444_PL), ENTRY(directx::tex4444_TW), ENTRY(directx::tex4444_VQ),
+};
+
+static const TexConvEntry<u32> Formats32[] {
+	ENTRY(opengl::tex565_PL32), ENTRY(opengl::tex565_TW32), ENTRY(opengl::tex565_VQ32),
+	ENTRY(opengl::tex1555_PL32), ENTRY(opengl::tex1555_TW32), ENTRY(opengl::tex1555_VQ32),
+	ENTRY(opengl::tex4444_PL32), ENTRY(opengl::tex4444_TW32), ENTRY(opengl::tex4444_VQ32),
+	ENTRY(opengl::texYUV422_PL), ENTRY(opengl::texYUV422_TW), ENTRY(opengl::texYUV422_VQ),
+	ENTRY(directx::tex565_PL32), ENTRY(directx::tex565_TW32), ENTRY(directx::tex565_VQ32),
+	ENTRY(directx::tex1555_PL32), ENTRY(directx::tex1555_TW32), ENTRY(directx::tex1555_VQ32),
+	ENTRY(directx::tex4444_PL32), ENTRY(directx::tex4444_TW32), ENTRY(directx::tex4444_VQ32),
+	ENTRY(directx::texYUV422_PL), ENTRY(directx::texYUV422_TW), ENTRY(directx::texYUV422_VQ),
+};
+
+#undef ENTRY
+
+class TexConvTest : public ::testing::Test {
+protected:
+	void SetUp() override
+	{
+		// VQ codebook followed by the indexes, or texels
+		data.resize(2048 + 1024 * 1024 * 2);
+		std::mt19937 random(42);
+		for (u8& b : data)
+			b = random();
+		vq_codebook = data.data();
+	}
+
+	void TearDown() override {
+		texconv::setIsa(texconv::detectIsa());
+	}
+
+	std::vector<texconv::Isa> supportedIsas()
+	{
+		std::vector<texconv::Isa> isas;
+		for (texconv::Isa isa : { texconv::Isa::SSE2, texconv::Isa::AVX2, texconv::Isa::NEON })
+			if (texconv::setIsa(isa))
+				isas.push_back(isa);
+		return isas;
+	}
+
+	template<typename Pixel>
+	std::vector<Pixel> convert(const TexConvEntry<Pixel>& entry, texconv::Isa isa, u32 width, u32 height)
+	{
+		texconv::setIsa(isa);
+		PixelBuffer<Pixel> pb;
+		pb.init(width, height);
+		entry.convert(&pb, data.data(), width, height);
+		return std::vector<Pixel>(pb.data(), pb.data() + width * height);
+	}
+
+	template<typename Pixel>
+	std::vector<Pixel> convertMipmaps(const TexConvEntry<Pixel>& entry, texconv::Isa isa, u32 size)
+	{
+		texconv::setIsa(isa);
+		PixelBuffer<Pixel> pb;
+		pb.init(size, size, true);
+		// 1x1 level is a special case handled by the caller
+		u32 count = 1;
+		for (u32 level = 1; (1u << level) <= size; level++)
+		{
+			pb.set_mipmap(level);
+			entry.convert(&pb, data.data(), 1 << level, 1 << level);
+			count += 1 << (level * 2);
+		}
+		pb.set_mipmap(0);
+		return std::vector<Pixel>(pb.data() + 1, pb.data() + count);
+	}
+
+	template<typename Pixel>
+	void compareAll(const TexConvEntry<Pixel> *entries, size_t count)
+	{
+		static const std::pair<u32, u32> sizes[] { { 8, 8 }, { 64, 32 }, { 32, 64 }, { 640, 8 }, { 1024, 1024 } };
+		for (texconv::Isa isa : supportedIsas())
+		{
+			for (size_t i = 0; i < count; i++)
+			{
+				const TexConvEntry<Pixel>& entry = entries[i];
+				for (const auto& size : sizes)
+				{
+					// planar textures only
+					if (size.first == 640 && strstr(entry.name, "_PL") == nullptr)
+						continue;
+					std::vector<Pixel> ref = convert(entry, texconv::Isa::Scalar, size.first, size.second);
+					std::vector<Pixel> out = convert(entry, isa, size.first, size.second);
+					ASSERT_TRUE(ref == out) << entry.name << " " << texconv::isaName(isa) << " " << size.first << "x" << size.second;
+				}
+				if (strstr(entry.name, "_PL") == nullptr)
+				{
+					std::vector<Pixel> ref = convertMipmaps(entry, texconv::Isa::Scalar, 256);
+					std::vector<Pixel> out = convertMipmaps(entry, isa, 256);
+					ASSERT_TRUE(ref == out) << entry.name << " " << texconv::isaName(isa) << " mipmaps";
+				}
+			}
+		}
+	}
+
+	template<typename Pixel>
+	void benchmark(const TexConvEntry<Pixel> *entries, size_t count)
+	{
+		constexpr u32 size = 512;
+		constexpr int loops = 20;
+		const texconv::Isa best = texconv::detectIsa();
+		for (size_t i = 0; i < count; i++)
+		{
+			double ns[2];
+			for (int j = 0; j < 2; j++)
+			{
+				texconv::setIsa(j == 0 ? texconv::Isa::Scalar : best);
+				PixelBuffer<Pixel> pb;
+				pb.init(size, size);
+				auto start = std::chrono::steady_clock::now();
+				for (int l = 0; l < loops; l++)
+					entries[i].convert(&pb, data.data(), size, size);
+				ns[j] = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count() / loops / (size * size);
+			}
+			printf("%-28s scalar %.2f ns/texel  %s %.2f ns/texel  x%.1f\n", entries[i].name, ns[0],
+					texconv::isaName(best), ns[1], ns[0] / ns[1]);
+		}
+	}
+
+	std::vector<u8> data;
+};
+
+TEST_F(TexConvTest, Detwiddle)
+{
+	for (texconv::Isa isa : supportedIsas())
+	{
+		u16 tile[16];
+		for (u32 i = 0; i < 16; i++)
+			tile[i] = i;
+		u16 rows[4 * 8] {};
+		texconv::setIsa(isa);
+		texconv::converters->detwiddleTile(&rows[4], 8, tile);
+		static const u16 expected[4][4] { { 0, 2, 8, 10 }, { 1, 3, 9, 11 }, { 4, 6, 12, 14 }, { 5, 7, 13, 15 } };
+		for (u32 y = 0; y < 4; y++)
+			for (u32 x = 0; x < 4; x++)
+				ASSERT_EQ(expected[y][x], rows[y * 8 + 4 + x]) << texconv::isaName(isa);
+	}
+}
+
+TEST_F(TexConvTest, BitExact16)
+{
+	compareAll(Formats16, std::size(Formats16));
+}
+
+TEST_F(TexConvTest, BitExact32)
+{
+	compareAll(Formats32, std::size(Formats32));
+}
+
+TEST_F(TexConvTest, DISABLED_Benchmark)
+{
+	benchmark(Formats16, std::size(Formats16));
+	benchmark(Formats32, std::size(Formats32));
+}